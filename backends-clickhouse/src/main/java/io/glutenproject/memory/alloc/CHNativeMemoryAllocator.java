@@ -57,6 +57,12 @@ public class CHNativeMemoryAllocator {
     return bytesAllocated(this.nativeInstanceId);
   }
 
+  /** Asks the native operators of the task to release the memory, returns the bytes released. */
+  public long spill(long size) {
+    if (this.nativeInstanceId == -1L) return 0;
+    return spill(this.nativeInstanceId, size);
+  }
+
   public void close() {
     if (this.nativeInstanceId == -1L) return;
     releaseAllocator(this.nativeInstanceId);
@@ -69,4 +75,6 @@ public class CHNativeMemoryAllocator {
   private static native void releaseAllocator(long allocatorId);
 
   private static native long bytesAllocated(long allocatorId);
+
+  private static native long spill(long allocatorId, long size);
 }
@@ -24,6 +24,8 @@ import io.glutenproject.memory.TaskMemoryMetrics;
 import org.apache.spark.memory.TaskMemoryManager;
 import org.apache.spark.util.TaskResources;
 
+import java.util.concurrent.atomic.AtomicReference;
+
 /**
  * Built-in toolkit for managing native memory allocations. To use the facility, one should import
  * Gluten's C++ library then create the c++ instance using following example code:
@@ -56,11 +58,14 @@ public abstract class CHNativeMemoryAllocators {
 
     final String id = CHNativeMemoryAllocatorManager.class.toString();
     if (!TaskResources.isResourceRegistered(id)) {
+      // The native operators of the task release their memory when spark asks the consumer to spill.
+      final AtomicReference<CHNativeMemoryAllocator> allocator = new AtomicReference<>();
       final CHNativeMemoryAllocatorManager manager =
           createNativeMemoryAllocatorManager(
               TaskResources.getLocalTaskContext().taskMemoryManager(),
-              Spiller.NO_OP,
+              (size, trigger) -> allocator.get() == null ? 0L : allocator.get().spill(size),
               TaskResources.getSharedMetrics());
+      allocator.set(manager.getManaged());
       TaskResources.addResource(id, manager);
     }
     return ((CHNativeMemoryAllocatorManager) TaskResources.getResource(id)).getManaged();
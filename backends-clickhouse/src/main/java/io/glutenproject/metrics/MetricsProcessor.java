@@ -18,6 +18,9 @@ package io.glutenproject.metrics;
 
 import com.fasterxml.jackson.annotation.JsonProperty;
 
+import java.util.HashMap;
+import java.util.Map;
+
 public class MetricsProcessor {
 
   protected String name;
@@ -39,6 +42,9 @@ public class MetricsProcessor {
   @JsonProperty("output_bytes")
   protected long outputBytes = 0;
 
+  @JsonProperty("extra_metrics")
+  protected Map<String, Long> extraMetrics = new HashMap<>();
+
   public String getName() {
     return name;
   }
@@ -102,4 +108,12 @@ public class MetricsProcessor {
   public void setOutputBytes(long outputBytes) {
     this.outputBytes = outputBytes;
   }
+
+  public Map<String, Long> getExtraMetrics() {
+    return extraMetrics;
+  }
+
+  public void setExtraMetrics(Map<String, Long> extraMetrics) {
+    this.extraMetrics = extraMetrics;
+  }
 }
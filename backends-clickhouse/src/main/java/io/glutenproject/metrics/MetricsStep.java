@@ -16,7 +16,11 @@
  */
 package io.glutenproject.metrics;
 
+import com.fasterxml.jackson.annotation.JsonProperty;
+
+import java.util.HashMap;
 import java.util.List;
+import java.util.Map;
 
 public class MetricsStep {
 
@@ -24,6 +28,9 @@ public class MetricsStep {
   protected String description;
   protected List<MetricsProcessor> processors;
 
+  @JsonProperty("extra_metrics")
+  protected Map<String, Long> extraMetrics = new HashMap<>();
+
   public String getName() {
     return name;
   }
@@ -47,4 +54,12 @@ public class MetricsStep {
   public void setProcessors(List<MetricsProcessor> processors) {
     this.processors = processors;
   }
+
+  public Map<String, Long> getExtraMetrics() {
+    return extraMetrics;
+  }
+
+  public void setExtraMetrics(Map<String, Long> extraMetrics) {
+    this.extraMetrics = extraMetrics;
+  }
 }
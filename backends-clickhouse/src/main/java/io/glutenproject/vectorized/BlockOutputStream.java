@@ -37,6 +37,8 @@ public class BlockOutputStream implements Closeable {
 
   private SQLMetric dataSize;
 
+  private final boolean compressionEnable;
+
   private boolean isClosed = false;
 
   public BlockOutputStream(
@@ -58,6 +60,7 @@ public class BlockOutputStream implements Closeable {
     this.defaultCompressionCodec = defaultCompressionCodec;
     this.buffer = buffer;
     this.bufferSize = bufferSize;
+    this.compressionEnable = compressionEnable;
     this.instance =
         nativeCreate(
             this.outputStream,
@@ -87,6 +90,19 @@ public class BlockOutputStream implements Closeable {
     nativeWrite(instance, block.blockAddress());
   }
 
+  /** Writes a block serialized by the native splitter, compressed like this stream or not at all. */
+  public void write(CHSerializedBlock block) throws IOException {
+    if (block.isCompressed() != compressionEnable) {
+      throw new IllegalStateException(
+          "The block is serialized with compression "
+              + block.isCompressed()
+              + ", but the stream is written with compression "
+              + compressionEnable);
+    }
+    dataSize.add(block.length());
+    outputStream.write(block.buffer(), 0, block.length());
+  }
+
   public void flush() throws IOException {
     nativeFlush(instance);
     this.outputStream.flush();
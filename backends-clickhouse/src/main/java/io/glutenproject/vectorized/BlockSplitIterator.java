@@ -26,7 +26,10 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
 
   private long instance = 0;
 
+  private final boolean compressed;
+
   public BlockSplitIterator(Iterator<Long> in, IteratorOptions options) {
+    this.compressed = options.isSerialized() && options.isCompressed();
     this.instance =
         nativeCreate(
             new IteratorWrapper(in),
@@ -34,7 +37,11 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
             options.getExpr(),
             options.getRequiredFields(),
             options.getPartitionNum(),
-            options.getBufferSize());
+            options.getBufferSize(),
+            options.getBufferBytes(),
+            options.isSerialized(),
+            options.isCompressed(),
+            options.getCodec());
   }
 
   private native long nativeCreate(
@@ -43,7 +50,11 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
       String expr,
       String schema,
       int partitionNum,
-      int bufferSize);
+      int bufferSize,
+      long bufferBytes,
+      boolean serialized,
+      boolean compressed,
+      String codec);
 
   private native void nativeClose(long instance);
 
@@ -62,6 +73,26 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
     return block.toColumnarBatch();
   }
 
+  private native int nativeNextSerialized(long instance, byte[] buffer);
+
+  private native int nativeNextRows(long instance);
+
+  private byte[] serializedBuffer = new byte[0];
+
+  /**
+   * Returns the next partition block serialized like {@link BlockOutputStream} writes it, used
+   * instead of {@link #next()} if the iterator is created with the serialized option. The bytes are
+   * in a buffer reused by the next call.
+   */
+  public CHSerializedBlock nextSerialized() {
+    int length = nativeNextSerialized(instance, serializedBuffer);
+    if (length < 0) {
+      serializedBuffer = new byte[-length];
+      length = nativeNextSerialized(instance, serializedBuffer);
+    }
+    return new CHSerializedBlock(serializedBuffer, length, nativeNextRows(instance), compressed);
+  }
+
   private native int nativeNextPartitionId(long instance);
 
   public int nextPartitionId() {
@@ -80,6 +111,10 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
     private int bufferSize;
     private String expr;
     private String requiredFields;
+    private long bufferBytes;
+    private boolean serialized;
+    private boolean compressed;
+    private String codec;
 
     public int getPartitionNum() {
       return partitionNum;
@@ -120,5 +155,37 @@ public class BlockSplitIterator implements Iterator<ColumnarBatch>, AutoCloseabl
     public void setRequiredFields(String requiredFields) {
       this.requiredFields = requiredFields;
     }
+
+    public long getBufferBytes() {
+      return bufferBytes;
+    }
+
+    public void setBufferBytes(long bufferBytes) {
+      this.bufferBytes = bufferBytes;
+    }
+
+    public boolean isSerialized() {
+      return serialized;
+    }
+
+    public void setSerialized(boolean serialized) {
+      this.serialized = serialized;
+    }
+
+    public boolean isCompressed() {
+      return compressed;
+    }
+
+    public void setCompressed(boolean compressed) {
+      this.compressed = compressed;
+    }
+
+    public String getCodec() {
+      return codec;
+    }
+
+    public void setCodec(String codec) {
+      this.codec = codec;
+    }
   }
 }
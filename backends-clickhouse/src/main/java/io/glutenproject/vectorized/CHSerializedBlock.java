@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package io.glutenproject.vectorized;
+
+/**
+ * A block already serialized by the native splitter, written to the shuffle output as it is by
+ * {@link BlockOutputStream}.
+ */
+public class CHSerializedBlock {
+  private final byte[] buffer;
+  private final int length;
+  private final int numRows;
+  private final boolean compressed;
+
+  public CHSerializedBlock(byte[] buffer, int length, int numRows, boolean compressed) {
+    this.buffer = buffer;
+    this.length = length;
+    this.numRows = numRows;
+    this.compressed = compressed;
+  }
+
+  public byte[] buffer() {
+    return buffer;
+  }
+
+  public int length() {
+    return length;
+  }
+
+  public int numRows() {
+    return numRows;
+  }
+
+  public boolean isCompressed() {
+    return compressed;
+  }
+}
@@ -31,6 +31,32 @@ public class CHShuffleSplitterJniWrapper {
       String dataFile,
       String localDirs,
       int subDirsPerLocalDir) {
+    return make(
+        part,
+        shuffleId,
+        mapId,
+        bufferSize,
+        codec,
+        dataFile,
+        localDirs,
+        subDirsPerLocalDir,
+        null);
+  }
+
+  /**
+   * Same as above, also writes the block index of the data file to blockIndexFile if it's not
+   * null, so a large partition can be read by several reducers.
+   */
+  public long make(
+      NativePartitioning part,
+      int shuffleId,
+      long mapId,
+      int bufferSize,
+      String codec,
+      String dataFile,
+      String localDirs,
+      int subDirsPerLocalDir,
+      String blockIndexFile) {
     return nativeMake(
         part.getShortName(),
         part.getNumPartitions(),
@@ -42,7 +68,8 @@ public class CHShuffleSplitterJniWrapper {
         codec,
         dataFile,
         localDirs,
-        subDirsPerLocalDir);
+        subDirsPerLocalDir,
+        blockIndexFile);
   }
 
   public native long nativeMake(
@@ -56,7 +83,8 @@ public class CHShuffleSplitterJniWrapper {
       String codec,
       String dataFile,
       String localDirs,
-      int subDirsPerLocalDir);
+      int subDirsPerLocalDir,
+      String blockIndexFile);
 
   public native void split(long splitterId, int numRows, long block);
 
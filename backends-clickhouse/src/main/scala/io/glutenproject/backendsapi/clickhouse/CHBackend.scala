@@ -72,6 +72,20 @@ object CHBackendSettings extends BackendSettingsApi with Logging {
   // unit: SECONDS, default 1 day
   val GLUTEN_CLICKHOUSE_BROADCAST_CACHE_EXPIRED_TIME_DEFAULT: Int = 86400
 
+  // When not 0, the native splitter emits a partition block once its rows take this many bytes,
+  // instead of once it has maxBatchSize rows.
+  val GLUTEN_CLICKHOUSE_SPLIT_BUFFER_BYTES: String =
+    GlutenConfig.GLUTEN_CONFIG_PREFIX + GlutenConfig.GLUTEN_CLICKHOUSE_BACKEND +
+      ".shuffle.split.buffer.bytes"
+  val GLUTEN_CLICKHOUSE_SPLIT_BUFFER_BYTES_DEFAULT = "0"
+
+  // The native splitter serializes the partition blocks, they are written to the shuffle output
+  // as they are.
+  val GLUTEN_CLICKHOUSE_SPLIT_SERIALIZED: String =
+    GlutenConfig.GLUTEN_CONFIG_PREFIX + GlutenConfig.GLUTEN_CLICKHOUSE_BACKEND +
+      ".shuffle.split.serialized"
+  val GLUTEN_CLICKHOUSE_SPLIT_SERIALIZED_DEFAULT = "false"
+
   val GLUTNE_CLICKHOUSE_SHUFFLE_SUPPORTED_CODEC: Set[String] = Set("lz4", "zstd", "snappy")
 
   override def supportFileFormatRead(
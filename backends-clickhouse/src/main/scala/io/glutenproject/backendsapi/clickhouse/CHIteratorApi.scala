@@ -60,8 +60,15 @@ class CHIteratorApi extends IteratorApi with Logging with LogLevelUtil {
         partitions(i) match {
           case p: GlutenMergeTreePartition =>
             (
-              ExtensionTableBuilder
-                .makeExtensionTable(p.minParts, p.maxParts, p.database, p.table, p.tablePath),
+              ExtensionTableBuilder.makeExtensionTable(
+                p.minParts,
+                p.maxParts,
+                p.database,
+                p.table,
+                p.tablePath,
+                p.orderByKey,
+                p.primaryKey,
+                p.skipIndexes),
               SoftAffinityUtil.getNativeMergeTreePartitionLocations(p))
           case f: FilePartition =>
             val paths = new java.util.ArrayList[String]()
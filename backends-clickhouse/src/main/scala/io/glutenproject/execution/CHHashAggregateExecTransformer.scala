@@ -265,6 +265,7 @@ case class CHHashAggregateExecTransformer(
         groupingList,
         aggregateFunctionList,
         aggFilterList,
+        genAggregateExtensionNode(),
         context,
         operatorId)
     } else {
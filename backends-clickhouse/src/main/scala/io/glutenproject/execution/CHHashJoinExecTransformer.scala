@@ -55,6 +55,20 @@ case class CHShuffledHashJoinExecTransformer(
     }
     super.doValidateInternal()
   }
+
+  // The native side uses a sort merge join when the inputs are sorted by the join keys, e.g. read
+  // from sorted bucketed tables. Its merge compares the keys with nulls last.
+  override def genExtraJoinParameters(): Seq[(String, Int)] = {
+    def isSorted(plan: SparkPlan, keys: Seq[Expression]): Boolean = {
+      val nullsLast = keys.map(SortOrder(_, Ascending, NullsLast, Seq.empty))
+      val nullsFirst = keys.map(SortOrder(_, Ascending))
+      SortOrder.orderingSatisfies(plan.outputOrdering, nullsLast) ||
+      (keys.forall(!_.nullable) && SortOrder.orderingSatisfies(plan.outputOrdering, nullsFirst))
+    }
+    Seq(
+      ("isStreamedSorted", if (isSorted(streamedPlan, streamedKeyExprs)) 1 else 0),
+      ("isBuildSorted", if (isSorted(buildPlan, buildKeyExprs)) 1 else 0))
+  }
 }
 
 case class CHBroadcastHashJoinExecTransformer(
@@ -83,7 +97,12 @@ case class CHBroadcastHashJoinExecTransformer(
 
   override protected def doValidateInternal(): ValidationResult = {
     val shouldFallback =
-      CHJoinValidateUtil.shouldFallback(joinType, left.outputSet, right.outputSet, condition)
+      CHJoinValidateUtil.shouldFallback(
+        joinType,
+        left.outputSet,
+        right.outputSet,
+        condition,
+        isBroadcast = true)
 
     if (shouldFallback) {
       return notOk("ch join validate fail")
@@ -19,6 +19,8 @@ package io.glutenproject.metrics
 import org.apache.spark.sql.execution.metric.SQLMetric
 import org.apache.spark.sql.utils.OASPackageBridge.InputMetricsWrapper
 
+import scala.collection.JavaConverters._
+
 /**
  * Note: "val metrics" is made transient to avoid sending driver-side metrics to tasks, e.g.
  * "pruning time" from scan.
@@ -35,6 +37,7 @@ class FileSourceScanMetricsUpdater(@transient val metrics: Map[String, SQLMetric
   val extraTime: SQLMetric = metrics("extraTime")
   val inputWaitTime: SQLMetric = metrics("inputWaitTime")
   val outputWaitTime: SQLMetric = metrics("outputWaitTime")
+  val skippedGranules: SQLMetric = metrics("skippedGranules")
 
   override def updateInputMetrics(inputMetrics: InputMetricsWrapper): Unit = {
     // inputMetrics.bridgeIncBytesRead(metrics("inputBytes").value)
@@ -50,6 +53,10 @@ class FileSourceScanMetricsUpdater(@transient val metrics: Map[String, SQLMetric
         inputWaitTime += (metricsData.inputWaitTime / 1000L).toLong
         outputWaitTime += (metricsData.outputWaitTime / 1000L).toLong
         outputVectors += metricsData.outputVectors
+        // Granules of the mergetree parts skipped by the primary key and the skip indexes.
+        metricsData.steps.asScala.foreach {
+          step => skippedGranules += step.extraMetrics.getOrDefault("skipped_marks", 0L)
+        }
 
         MetricsUtil.updateExtraTimeMetric(
           metricsData,
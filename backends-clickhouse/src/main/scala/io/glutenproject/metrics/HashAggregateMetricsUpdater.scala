@@ -91,6 +91,14 @@ class HashAggregateMetricsUpdater(val metrics: Map[String, SQLMetric])
 }
 
 object HashAggregateMetricsUpdater {
-  val INCLUDING_PROCESSORS = Array("AggregatingTransform", "MergingAggregatedTransform")
-  val CH_PLAN_NODE_NAME = Array("AggregatingTransform", "MergingAggregatedTransform")
+  val INCLUDING_PROCESSORS = Array(
+    "AggregatingTransform",
+    "MergingAggregatedTransform",
+    "AggregatingInOrderTransform",
+    "FinishAggregatingInOrderTransform",
+    "FinalizeAggregatedTransform")
+  // The in order aggregation reads its input in AggregatingInOrderTransform, the other two only
+  // merge and finalize its groups.
+  val CH_PLAN_NODE_NAME =
+    Array("AggregatingTransform", "MergingAggregatedTransform", "AggregatingInOrderTransform")
 }
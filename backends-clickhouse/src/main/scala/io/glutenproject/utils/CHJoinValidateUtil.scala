@@ -28,6 +28,9 @@ import org.apache.spark.sql.catalyst.plans.JoinType
  * join b on a.a1 = b.b1 and (a.a2 > 1 or b.b2 < 2) ) 2 tow join key for inequality comparison (!= ,
  * > , <), for example: (a join b on a.a1 > b.b1) There will be a fallback for Nullaware Jion For
  * Existence Join which is just an optimization of exist subquery, it will also fallback
+ *
+ * Such conditions are evaluated natively on the matched pairs of left, full, semi and anti joins.
+ * Only the broadcast semi and anti joins still fallback, their build side keeps one row per key.
  */
 
 object CHJoinValidateUtil extends Logging {
@@ -44,7 +47,8 @@ object CHJoinValidateUtil extends Logging {
       joinType: JoinType,
       leftOutputSet: AttributeSet,
       rightOutputSet: AttributeSet,
-      condition: Option[Expression]): Boolean = {
+      condition: Option[Expression],
+      isBroadcast: Boolean = false): Boolean = {
     var shouldFallback = false
     if (joinType.toString.contains("ExistenceJoin")) {
       return true
@@ -52,6 +56,9 @@ object CHJoinValidateUtil extends Logging {
     if (joinType.sql.equals("INNER")) {
       return shouldFallback
     }
+    if (!isBroadcast || !(joinType.sql.equals("LEFT SEMI") || joinType.sql.equals("LEFT ANTI"))) {
+      return shouldFallback
+    }
     if (condition.isDefined) {
       condition.get.transform {
         case Or(l, r) =>
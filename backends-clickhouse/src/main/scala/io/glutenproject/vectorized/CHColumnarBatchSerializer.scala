@@ -164,10 +164,13 @@ private class CHColumnarBatchSerializerInstance(
     }
 
     override def writeValue[T: ClassTag](value: T): SerializationStream = {
-      val cb = value.asInstanceOf[ColumnarBatch]
-
-      // Use for reading bytes array from block
-      dOut.write(cb)
+      value match {
+        // Already serialized by the native splitter.
+        case block: CHSerializedBlock => dOut.write(block)
+        case cb: ColumnarBatch =>
+          // Use for reading bytes array from block
+          dOut.write(cb)
+      }
       this
     }
 
@@ -41,7 +41,12 @@ object MergeTreePartsPartitionsUtil extends Logging {
       // for file_format.`file_path`
       ("default", "file_format")
     }
-    val engine = table.snapshot.metadata.configuration.get("engine").get
+    val configuration = table.snapshot.metadata.configuration
+    val engine = configuration.get("engine").get
+    // Tables created before the keys were supported don't have them in the configuration.
+    val orderByKey = configuration.getOrElse("order_by_key", "")
+    val primaryKey = configuration.getOrElse("primary_key", "")
+    val skipIndexes = configuration.getOrElse("skip_indexes", "")
     // TODO: remove `substring`
     val tablePath = table.deltaLog.dataPath.toString.substring(6)
     var currentMinPartsNum = -1L
@@ -59,7 +64,10 @@ object MergeTreePartsPartitionsUtil extends Logging {
           tableName,
           tablePath,
           currentMinPartsNum,
-          currentMaxPartsNum + 1)
+          currentMaxPartsNum + 1,
+          orderByKey,
+          primaryKey,
+          skipIndexes)
         partitions += newPartition
       }
       currentMinPartsNum = -1L
@@ -51,9 +51,15 @@ object ClickHouseConfig {
         configurations += ("engine" -> DEFAULT_ENGINE)
       }
     }
+    if (!configurations.contains("order_by_key")) {
+      configurations += ("order_by_key" -> "")
+    }
     if (!configurations.contains("primary_key")) {
       configurations += ("primary_key" -> "")
     }
+    if (!configurations.contains("skip_indexes")) {
+      configurations += ("skip_indexes" -> "")
+    }
     if (!configurations.contains("sampling_key")) {
       configurations += ("sampling_key" -> "")
     }
@@ -17,11 +17,12 @@
 package org.apache.spark.sql.execution.utils
 
 import io.glutenproject.GlutenConfig
+import io.glutenproject.backendsapi.clickhouse.CHBackendSettings
 import io.glutenproject.expression.ConverterUtils
 import io.glutenproject.vectorized._
 import io.glutenproject.vectorized.BlockSplitIterator.IteratorOptions
 
-import org.apache.spark.ShuffleDependency
+import org.apache.spark.{ShuffleDependency, TaskContext}
 import org.apache.spark.internal.Logging
 import org.apache.spark.rdd.RDD
 import org.apache.spark.serializer.Serializer
@@ -128,6 +129,33 @@ object CHExecUtil extends Logging {
     new CloseablePartitionedBlockIterator(iter)
   }
 
+  private def buildSerializedPartitionedBlockIterator(
+      cbIter: Iterator[ColumnarBatch],
+      options: IteratorOptions,
+      records_written_metric: SQLMetric): Iterator[Product2[Int, CHSerializedBlock]] = {
+    val splitIterator = new BlockSplitIterator(
+      cbIter
+        .map(
+          CHNativeBlock
+            .fromColumnarBatch(_)
+            .blockAddress()
+            .asInstanceOf[java.lang.Long])
+        .asJava,
+      options
+    )
+    TaskContext.get().addTaskCompletionListener[Unit](_ => splitIterator.close())
+    new Iterator[Product2[Int, CHSerializedBlock]] {
+      override def hasNext: Boolean = splitIterator.hasNext
+      override def next(): Product2[Int, CHSerializedBlock] = {
+        // The buffer of the block is reused by the next one, the shuffle writers serialize a
+        // record before pulling the next one.
+        val nextBlock = splitIterator.nextSerialized()
+        records_written_metric.add(nextBlock.numRows() - 1)
+        (splitIterator.nextPartitionId(), nextBlock)
+      }
+    }
+  }
+
   private def buildHashPartitioning(
       partitoining: HashPartitioning,
       childOutput: Seq[Attribute],
@@ -162,6 +190,25 @@ object CHExecUtil extends Logging {
   private def buildPartitioningOptions(nativePartitioning: NativePartitioning): IteratorOptions = {
     val options = new IteratorOptions
     options.setBufferSize(GlutenConfig.getConf.maxBatchSize)
+    options.setBufferBytes(
+      SQLConf.get
+        .getConfString(
+          CHBackendSettings.GLUTEN_CLICKHOUSE_SPLIT_BUFFER_BYTES,
+          CHBackendSettings.GLUTEN_CLICKHOUSE_SPLIT_BUFFER_BYTES_DEFAULT)
+        .toLong)
+    // The serialized blocks are not compressed natively, since whether the customized codec can
+    // compress the shuffle output is only known by the writer of each stream.
+    options.setSerialized(
+      SQLConf.get
+        .getConfString(
+          CHBackendSettings.GLUTEN_CLICKHOUSE_SPLIT_SERIALIZED,
+          CHBackendSettings.GLUTEN_CLICKHOUSE_SPLIT_SERIALIZED_DEFAULT)
+        .toBoolean &&
+        !SQLConf.get
+          .getConfString(
+            CHBackendSettings.GLUTEN_CLICKHOUSE_CUSTOMIZED_SHUFFLE_CODEC_ENABLE,
+            CHBackendSettings.GLUTEN_CLICKHOUSE_CUSTOMIZED_SHUFFLE_CODEC_ENABLE_DEFAULT)
+          .toBoolean)
     options.setName(nativePartitioning.getShortName)
     options.setPartitionNum(nativePartitioning.getNumPartitions)
     options.setExpr(new String(nativePartitioning.getExprList))
@@ -263,15 +310,30 @@ object CHExecUtil extends Logging {
         }
       } else {
         val options = buildPartitioningOptions(nativePartitioning)
-        rdd.mapPartitionsWithIndexInternal(
-          (_, cbIter) => {
-            buildPartitionedBlockIterator(
-              cbIter,
-              options,
-              writeMetrics(SQLShuffleWriteMetricsReporter.SHUFFLE_RECORDS_WRITTEN))
-          },
-          isOrderSensitive = isOrderSensitive
-        )
+        if (options.isSerialized) {
+          // The values are written by CHColumnarBatchSerializer as they are.
+          rdd
+            .mapPartitionsWithIndexInternal(
+              (_, cbIter) => {
+                buildSerializedPartitionedBlockIterator(
+                  cbIter,
+                  options,
+                  writeMetrics(SQLShuffleWriteMetricsReporter.SHUFFLE_RECORDS_WRITTEN))
+              },
+              isOrderSensitive = isOrderSensitive
+            )
+            .asInstanceOf[RDD[Product2[Int, ColumnarBatch]]]
+        } else {
+          rdd.mapPartitionsWithIndexInternal(
+            (_, cbIter) => {
+              buildPartitionedBlockIterator(
+                cbIter,
+                options,
+                writeMetrics(SQLShuffleWriteMetricsReporter.SHUFFLE_RECORDS_WRITTEN))
+            },
+            isOrderSensitive = isOrderSensitive
+          )
+        }
       }
 
     val dependency =
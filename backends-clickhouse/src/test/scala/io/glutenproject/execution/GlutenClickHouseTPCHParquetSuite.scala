@@ -1539,5 +1539,51 @@ class GlutenClickHouseTPCHParquetSuite extends GlutenClickHouseTPCHAbstractSuite
     compareResultsAgainstVanillaSpark(sql, true, { _ => })
   }
 
+  test("non-equi join conditions in outer/semi/anti joins") {
+    spark.sql("create table residual_1 (k int, a int, s string) using parquet")
+    spark.sql("create table residual_2 (k int, b int, t string) using parquet")
+    spark.sql("""
+                |insert overwrite residual_1 values
+                |(1, 1, 'a'), (1, 5, 'b'), (2, 3, 'c'), (3, 7, null), (4, null, 'd'), (null, 2, 'e')
+                |""".stripMargin)
+    spark.sql("""
+                |insert overwrite residual_2 values
+                |(1, 2, 'a'), (1, 4, 'x'), (1, 6, 'b'), (2, 1, 'c'), (3, 8, 'y'), (5, 1, 'z'), (null, 3, 'e')
+                |""".stripMargin)
+    val conditions = Seq("t1.a < t2.b", "(t1.a > t2.b or t1.s = t2.t)")
+    val joinTypes = Seq("left join", "full outer join", "left semi join", "left anti join")
+    for (condition <- conditions; joinType <- joinTypes) {
+      val columns = if (joinType.contains("semi") || joinType.contains("anti")) "t1.*" else "*"
+      compareResultsAgainstVanillaSpark(
+        s"""
+           |select /*+ SHUFFLE_HASH(t2) */ $columns from residual_1 t1 $joinType residual_2 t2
+           |on t1.k = t2.k and $condition
+           |""".stripMargin,
+        true,
+        {
+          df =>
+            assert(df.queryExecution.executedPlan.collect {
+              case shj: ShuffledHashJoinExecTransformerBase => shj
+            }.size == 1)
+        }
+      )
+    }
+    // The broadcast build side of semi/anti joins only keeps one row per key, so they fallback.
+    for (condition <- conditions; joinType <- joinTypes.filterNot(_.contains("full"))) {
+      val columns = if (joinType.contains("semi") || joinType.contains("anti")) "t1.*" else "*"
+      compareResultsAgainstVanillaSpark(
+        s"""
+           |select /*+ BROADCAST(t2) */ $columns from residual_1 t1 $joinType residual_2 t2
+           |on t1.k = t2.k and $condition
+           |""".stripMargin,
+        true,
+        { _ => },
+        noFallBack = joinType == "left join"
+      )
+    }
+    spark.sql("drop table residual_1")
+    spark.sql("drop table residual_2")
+  }
+
 }
 // scalastyle:on line.size.limit
@@ -375,6 +375,8 @@ class MetricsHandler extends MetricsApi with Logging{
         sparkContext, "total spilled partitions of hash build"),
       "hashBuildSpilledFiles" -> SQLMetrics.createMetric(
         sparkContext, "total spilled files of hash build"),
+      "hashBuildSpillLevels" -> SQLMetrics.createMetric(
+        sparkContext, "total spill levels reached by hash build"),
 
       "hashProbeInputRows" -> SQLMetrics.createMetric(
         sparkContext, "number of hash probe input rows"),
@@ -400,6 +402,8 @@ class MetricsHandler extends MetricsApi with Logging{
         sparkContext, "total spilled partitions of hash probe"),
       "hashProbeSpilledFiles" -> SQLMetrics.createMetric(
         sparkContext, "total spilled files of hash probe"),
+      "hashProbeSpillLevels" -> SQLMetrics.createMetric(
+        sparkContext, "total spill levels reached by hash probe"),
       "hashProbeReplacedWithDynamicFilterRows" -> SQLMetrics.createMetric(
         sparkContext, "number of hash probe replaced with dynamic filter rows"),
       "hashProbeDynamicFiltersProduced" -> SQLMetrics.createMetric(
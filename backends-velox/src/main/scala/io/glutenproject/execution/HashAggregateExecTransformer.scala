@@ -681,8 +681,8 @@ case class HashAggregateExecTransformer(
       }
       addFunctionNode(args, aggregateFunc, childrenNodes, aggExpr.mode, aggregateFunctionList)
     })
-    RelBuilder.makeAggregateRel(
-      projectRel, groupingList, aggregateFunctionList, aggFilterList, context, operatorId)
+    RelBuilder.makeAggregateRel(projectRel, groupingList, aggregateFunctionList, aggFilterList,
+      genAggregateExtensionNode(), context, operatorId)
   }
 
   /**
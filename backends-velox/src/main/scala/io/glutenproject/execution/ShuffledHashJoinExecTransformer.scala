@@ -158,6 +158,23 @@ case class ShuffledHashJoinExecTransformer(leftKeys: Seq[Expression],
       JoinRel.JoinType.UNRECOGNIZED
   }
 
+  /**
+   * The planner's estimate of the build side size per task in KB, -1 if unknown. The native side
+   * sets up the join spilling from it, and skips it when the build side is small. Without stats
+   * the size is spark.sql.defaultSizeInBytes, which is not an estimate.
+   */
+  override def genExtraJoinParameters(): Seq[(String, Int)] = {
+    val buildSizeKB = buildPlan.logicalLink
+      .map(_.stats.sizeInBytes)
+      .filter(_ < conf.defaultSizeInBytes)
+      .map { sizeInBytes =>
+        val numPartitions = math.max(buildPlan.outputPartitioning.numPartitions, 1)
+        (sizeInBytes / numPartitions / 1024).min(Int.MaxValue).toInt
+      }
+      .getOrElse(-1)
+    Seq(("buildSizeKB", buildSizeKB))
+  }
+
   override protected def withNewChildrenInternal(
       newLeft: SparkPlan, newRight: SparkPlan): ShuffledHashJoinExecTransformer =
     copy(left = newLeft, right = newRight)
@@ -34,6 +34,7 @@
 #include <Processors/QueryPlan/QueryPlan.h>
 #include <QueryPipeline/QueryPipelineBuilder.h>
 #include <QueryPipeline/printPipeline.h>
+#include <Shuffle/ParallelDecompressingReadBuffer.h>
 #include <Storages/Output/WriteBufferBuilder.h>
 #include <Storages/SubstraitSource/ReadBufferBuilder.h>
 #include <substrait/algebra.pb.h>
@@ -42,6 +43,7 @@
 #include <Poco/Util/MapConfiguration.h>
 #include <Common/Config/ConfigProcessor.h>
 #include <Common/Logger.h>
+#include <Common/SettingsChanges.h>
 #include <Common/logger_useful.h>
 #include <Common/typeid_cast.h>
 
@@ -643,7 +645,19 @@ void BackendInitializerUtil::applyConfig(
     DB::ContextMutablePtr context, DB::Context::ConfigurationPtr config, std::unique_ptr<DB::Settings> & settings)
 {
     context->setConfig(config);
-    context->setSettings(*settings);
+
+    /// The query context may be reused from a previous task of the thread, the settings differing from its
+    /// current ones are set only, which are a few instead of the whole settings.
+    const auto & current = context->getSettingsRef();
+    DB::SettingsChanges changes;
+    for (const auto & setting : settings->allChanged())
+        if (current.get(setting.getName()) != setting.getValue())
+            changes.emplace_back(setting.getName(), setting.getValue());
+    for (const auto & setting : current.allChanged())
+        if (!settings->isChanged(setting.getName()))
+            changes.emplace_back(setting.getName(), settings->get(setting.getName()));
+    for (const auto & change : changes)
+        context->setSetting(change.name, change.value);
 }
 
 extern void registerAggregateFunctionCombinatorPartialMerge(AggregateFunctionCombinatorFactory &);
@@ -725,6 +739,8 @@ void BackendInitializerUtil::init(std::string * plan)
                 active_parts_loading_threads,
                 0, // We don't need any threads one all the parts will be loaded
                 active_parts_loading_threads);
+
+            ParallelDecompressingReadBuffer::initializeSharedPool(config->getUInt64("shuffle.decompression_threads", 4));
         });
 }
 
@@ -739,6 +755,7 @@ void BackendFinalizerUtil::finalizeGlobally()
 {
     auto & global_context = SerializedPlanParser::global_context;
     auto & shared_context = SerializedPlanParser::shared_context;
+    ParallelDecompressingReadBuffer::shutdownSharedPool();
     if (global_context)
     {
         global_context->shutdown();
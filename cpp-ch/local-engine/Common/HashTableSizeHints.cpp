@@ -0,0 +1,102 @@
+#include "HashTableSizeHints.h"
+#include <cmath>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <Common/SipHash.h>
+
+namespace local_engine
+{
+HashTableSizeHints & HashTableSizeHints::instance()
+{
+    static HashTableSizeHints hints;
+    return hints;
+}
+
+void HashTableSizeHints::setMaxEntries(size_t max_entries_)
+{
+    std::lock_guard lock(mutex);
+    max_entries = max_entries_;
+    while (entries.size() > max_entries)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+}
+
+std::optional<size_t> HashTableSizeHints::get(UInt64 key)
+{
+    std::lock_guard lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        ++stats.misses;
+        return {};
+    }
+    ++stats.hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void HashTableSizeHints::update(UInt64 key, size_t size, size_t reserved)
+{
+    std::lock_guard lock(mutex);
+    stats.rehashes += estimateRehashes(size, reserved);
+    stats.rehashes_without_hints += estimateRehashes(size, 0);
+    if (!max_entries)
+        return;
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        it->second->second = size;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    entries.emplace_front(key, size);
+    index[key] = entries.begin();
+    if (entries.size() > max_entries)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+}
+
+HashTableSizeHints::Stats HashTableSizeHints::getStats() const
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+UInt64 HashTableSizeHints::fingerprint(const google::protobuf::Message & rel, const DB::Block & input_header)
+{
+    /// The serialization of maps, e.g. in the advanced extensions, is only stable when it's deterministic.
+    String serialized;
+    {
+        google::protobuf::io::StringOutputStream output(&serialized);
+        google::protobuf::io::CodedOutputStream coded_output(&output);
+        coded_output.SetSerializationDeterministic(true);
+        rel.SerializeToCodedStream(&coded_output);
+    }
+    SipHash hash;
+    hash.update(serialized);
+    hash.update(input_header.getNamesAndTypesList().toString());
+    return hash.get64();
+}
+
+size_t HashTableSizeHints::estimateRehashes(size_t size, size_t reserved)
+{
+    /// Follows HashTableGrower: 2^8 cells at first, at most half of them are filled, 4 times the cells on every
+    /// resize until 2^23 cells, then 2 times.
+    size_t degree = 8;
+    if (reserved > 1)
+        degree = std::max(degree, static_cast<size_t>(std::log2(reserved - 1)) + 2);
+    size_t rehashes = 0;
+    while (size > (1ULL << (degree - 1)))
+    {
+        degree += degree >= 23 ? 1 : 2;
+        ++rehashes;
+    }
+    return rehashes;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <Core/Block.h>
+#include <google/protobuf/message.h>
+
+namespace local_engine
+{
+/// Final hash table sizes of aggregations and shuffled hash joins seen by the tasks of this executor, keyed by
+/// a fingerprint of the plan node. The tasks of a stage run the same plan on similar data, a task can size its
+/// tables from what its siblings have seen instead of growing them from the default size.
+/// Bounded, the least recently used entries are evicted.
+class HashTableSizeHints
+{
+public:
+    struct Stats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        /// Estimated rehashes of the recorded tables, and what they would be without the hints.
+        size_t rehashes = 0;
+        size_t rehashes_without_hints = 0;
+    };
+
+    static HashTableSizeHints & instance();
+
+    void setMaxEntries(size_t max_entries_);
+    std::optional<size_t> get(UInt64 key);
+    /// Records the final size of a table, presized to reserved rows, or 0 if it was not.
+    void update(UInt64 key, size_t size, size_t reserved);
+    Stats getStats() const;
+
+    /// A fingerprint stable among the tasks of a stage: the plan node without its inputs, which carry the
+    /// splits of a task, and the structure of the input.
+    static UInt64 fingerprint(const google::protobuf::Message & rel, const DB::Block & input_header);
+    /// Rehashes of a hash table with the default grower to hold size rows, when it's presized to reserved rows.
+    static size_t estimateRehashes(size_t size, size_t reserved);
+
+private:
+    HashTableSizeHints() = default;
+
+    mutable std::mutex mutex;
+    size_t max_entries = 10000;
+    /// Most recently used first.
+    std::list<std::pair<UInt64, size_t>> entries;
+    std::unordered_map<UInt64, std::list<std::pair<UInt64, size_t>>::iterator> index;
+    Stats stats;
+};
+}
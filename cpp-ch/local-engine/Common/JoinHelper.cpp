@@ -11,17 +11,29 @@ JoinOptimizationInfo parseJoinOptimizationInfo(const std::string & optimization)
     JoinOptimizationInfo info;
     ReadBufferFromString in(optimization);
     assertString("JoinParameters:", in);
-    assertString("isBHJ=", in);
-    readBoolText(info.is_broadcast, in);
-    assertChar('\n', in);
-    if (info.is_broadcast)
+    /// One "key=value\n" line per parameter, unknown keys are skipped.
+    while (!in.eof())
     {
-        assertString("isNullAwareAntiJoin=", in);
-        readBoolText(info.is_null_aware_anti_join, in);
-        assertChar('\n', in);
-        assertString("buildHashTableId=", in);
-        readString(info.storage_join_key, in);
-        assertChar('\n', in);
+        String key;
+        String value;
+        readStringUntilEquals(key, in);
+        assertChar('=', in);
+        readString(value, in);
+        if (!in.eof())
+            assertChar('\n', in);
+
+        if (key == "isBHJ")
+            info.is_broadcast = value == "1";
+        else if (key == "isNullAwareAntiJoin")
+            info.is_null_aware_anti_join = value == "1";
+        else if (key == "buildHashTableId")
+            info.storage_join_key = value;
+        else if (key == "isExistenceJoin")
+            info.is_existence_join = value == "1";
+        else if (key == "isStreamedSorted")
+            info.is_left_sorted = value == "1";
+        else if (key == "isBuildSorted")
+            info.is_right_sorted = value == "1";
     }
     return info;
 }
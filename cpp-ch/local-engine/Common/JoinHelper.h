@@ -5,9 +5,13 @@ namespace local_engine
 {
 struct JoinOptimizationInfo
 {
-    bool is_broadcast;
-    bool is_null_aware_anti_join;
+    bool is_broadcast = false;
+    bool is_null_aware_anti_join = false;
+    bool is_existence_join = false;
     std::string storage_join_key;
+    /// Whether the left(streamed)/right(build) input is sorted ascending by the join keys with nulls last.
+    bool is_left_sorted = false;
+    bool is_right_sorted = false;
 };
 
 
@@ -3,12 +3,24 @@
 #include <IO/ReadHelpers.h>
 #include <IO/WriteBufferFromString.h>
 #include <IO/WriteHelpers.h>
+#include <Parsers/ExpressionListParsers.h>
+#include <Parsers/ParserCreateQuery.h>
+#include <Parsers/parseQuery.h>
+#include <Storages/IndicesDescription.h>
 
 using namespace DB;
 
 namespace local_engine
 {
-std::shared_ptr<DB::StorageInMemoryMetadata> buildMetaData(DB::NamesAndTypesList columns, ContextPtr context)
+static ASTPtr parseKeyExpression(const std::string & key)
+{
+    ParserExpressionList parser(false);
+    auto expression_list = parseQuery(parser, key, "key expression", 0, DBMS_DEFAULT_MAX_PARSER_DEPTH);
+    return makeASTFunction("tuple", expression_list->children);
+}
+
+std::shared_ptr<DB::StorageInMemoryMetadata>
+buildMetaData(DB::NamesAndTypesList columns, ContextPtr context, const MergeTreeTable & table)
 {
     std::shared_ptr<DB::StorageInMemoryMetadata> metadata = std::make_shared<DB::StorageInMemoryMetadata>();
     ColumnsDescription columns_description;
@@ -18,8 +30,34 @@ std::shared_ptr<DB::StorageInMemoryMetadata> buildMetaData(DB::NamesAndTypesList
     }
     metadata->setColumns(std::move(columns_description));
     metadata->partition_key.expression_list_ast = std::make_shared<ASTExpressionList>();
-    metadata->sorting_key = KeyDescription::getSortingKeyFromAST(makeASTFunction("tuple"), metadata->getColumns(), context, {});
-    metadata->primary_key.expression = std::make_shared<ExpressionActions>(std::make_shared<ActionsDAG>());
+    if (table.order_by_key.empty())
+    {
+        metadata->sorting_key = KeyDescription::getSortingKeyFromAST(makeASTFunction("tuple"), metadata->getColumns(), context, {});
+        metadata->primary_key.expression = std::make_shared<ExpressionActions>(std::make_shared<ActionsDAG>());
+    }
+    else
+    {
+        metadata->sorting_key
+            = KeyDescription::getSortingKeyFromAST(parseKeyExpression(table.order_by_key), metadata->getColumns(), context, {});
+        if (table.primary_key.empty())
+        {
+            /// Same as ch, the primary key defaults to the sorting key but has no definition of its own.
+            metadata->primary_key = KeyDescription::getKeyFromAST(metadata->sorting_key.definition_ast, metadata->getColumns(), context);
+            metadata->primary_key.definition_ast = nullptr;
+        }
+        else
+            metadata->primary_key = KeyDescription::getKeyFromAST(parseKeyExpression(table.primary_key), metadata->getColumns(), context);
+    }
+
+    if (!table.skip_indexes.empty())
+    {
+        ParserList parser(std::make_unique<ParserIndexDeclaration>(), std::make_unique<ParserToken>(TokenType::Comma), false);
+        auto indexes = parseQuery(parser, table.skip_indexes, "skip indexes", 0, DBMS_DEFAULT_MAX_PARSER_DEPTH);
+        IndicesDescription indices;
+        for (const auto & index : indexes->children)
+            indices.push_back(IndexDescription::getIndexFromAST(index, metadata->getColumns(), context));
+        metadata->setSecondaryIndices(std::move(indices));
+    }
     return metadata;
 }
 
@@ -28,6 +66,8 @@ std::unique_ptr<MergeTreeSettings> buildMergeTreeSettings()
     auto settings = std::make_unique<DB::MergeTreeSettings>();
     settings->set("min_bytes_for_wide_part", Field(0));
     settings->set("min_rows_for_wide_part", Field(0));
+    /// Almost all the columns from spark are nullable, the keys are built on them.
+    settings->set("allow_nullable_key", Field(1));
     return settings;
 }
 
@@ -57,6 +97,16 @@ MergeTreeTable parseMergeTreeTableString(const std::string & info)
     assertChar('\n', in);
     readIntText(table.max_block, in);
     assertChar('\n', in);
+    /// The keys and indexes are absent in the descriptors of the tables created without them.
+    if (!in.eof())
+    {
+        readString(table.order_by_key, in);
+        assertChar('\n', in);
+        readString(table.primary_key, in);
+        assertChar('\n', in);
+        readString(table.skip_indexes, in);
+        assertChar('\n', in);
+    }
     assertEOF(in);
     return table;
 }
@@ -75,6 +125,15 @@ std::string MergeTreeTable::toString() const
     writeChar('\n', out);
     writeIntText(max_block, out);
     writeChar('\n', out);
+    if (!order_by_key.empty() || !primary_key.empty() || !skip_indexes.empty())
+    {
+        writeString(order_by_key, out);
+        writeChar('\n', out);
+        writeString(primary_key, out);
+        writeChar('\n', out);
+        writeString(skip_indexes, out);
+        writeChar('\n', out);
+    }
     return out.str();
 }
 
@@ -16,11 +16,6 @@
 namespace local_engine
 {
 using namespace DB;
-std::shared_ptr<DB::StorageInMemoryMetadata> buildMetaData(DB::NamesAndTypesList columns, ContextPtr context);
-
-std::unique_ptr<MergeTreeSettings> buildMergeTreeSettings();
-
-std::unique_ptr<SelectQueryInfo> buildQueryInfo(NamesAndTypesList & names_and_types_list);
 
 struct MergeTreeTable
 {
@@ -29,10 +24,24 @@ struct MergeTreeTable
     std::string relative_path;
     int min_block;
     int max_block;
+    /// Optional, the expressions are in ch syntax, e.g. "a, b". The primary key must be a prefix of the
+    /// order by key, it's the order by key when empty.
+    std::string order_by_key;
+    std::string primary_key;
+    /// Optional, comma separated index declarations, e.g. "idx_a a TYPE minmax GRANULARITY 1".
+    std::string skip_indexes;
 
     std::string toString() const;
 };
 
+/// Without order by key the metadata has an empty sorting key, the parts are neither sorted nor indexed.
+std::shared_ptr<DB::StorageInMemoryMetadata>
+buildMetaData(DB::NamesAndTypesList columns, ContextPtr context, const MergeTreeTable & table = {});
+
+std::unique_ptr<MergeTreeSettings> buildMergeTreeSettings();
+
+std::unique_ptr<SelectQueryInfo> buildQueryInfo(NamesAndTypesList & names_and_types_list);
+
 MergeTreeTable parseMergeTreeTableString(const std::string & info);
 
 }
@@ -17,15 +17,80 @@ namespace ErrorCodes
 namespace local_engine
 {
 using namespace DB;
-thread_local std::weak_ptr<CurrentThread::QueryScope> query_scope;
-thread_local std::weak_ptr<ThreadStatus> thread_status;
 ConcurrentMap<int64_t, NativeAllocatorContextPtr> allocator_map;
+/// The allocators by the thread groups of their tasks.
+ConcurrentMap<ThreadGroup *, NativeAllocatorContextPtr> group_allocator_map;
 
-int64_t initializeQuery(ReservationListenerWrapperPtr listener)
+UInt64 SpillCallbackRegistry::add(Callback callback)
 {
-    auto query_context = Context::createCopy(SerializedPlanParser::global_context);
-    query_context->makeQueryContext();
+    std::lock_guard lock(mutex);
+    callbacks.emplace(next_id, std::move(callback));
+    return next_id++;
+}
+
+void SpillCallbackRegistry::remove(UInt64 id)
+{
+    std::lock_guard lock(mutex);
+    callbacks.erase(id);
+}
+
+size_t SpillCallbackRegistry::spill(size_t bytes)
+{
+    std::lock_guard lock(mutex);
+    size_t released = 0;
+    for (auto & [id, callback] : callbacks)
+    {
+        if (released >= bytes)
+            break;
+        released += callback(bytes - released);
+    }
+    return released;
+}
 
+static NativeAllocatorContextPtr currentAllocator()
+{
+    auto group = CurrentThread::getGroup();
+    if (!group)
+        return nullptr;
+    return group_allocator_map.get(group.get());
+}
+
+/// The hooks are global, they are installed once and reserve the memory through the listener of the task the
+/// current thread works for. Threads out of any task, e.g. the background ones, are not reserved.
+static void installMemoryHooks()
+{
+    static std::once_flag once;
+    std::call_once(
+        once,
+        []
+        {
+            CurrentMemoryTracker::before_alloc = [](Int64 size, bool throw_if_memory_exceed) -> void
+            {
+                auto allocator = currentAllocator();
+                if (!allocator)
+                    return;
+                if (throw_if_memory_exceed)
+                    allocator->listener->reserveOrThrow(size);
+                else
+                    allocator->listener->reserve(size);
+            };
+            CurrentMemoryTracker::before_free = [](Int64 size) -> void
+            {
+                if (auto allocator = currentAllocator())
+                    allocator->listener->free(size);
+            };
+        });
+}
+
+/// Tasks are short and spark runs them in a pool of long living threads, so a thread keeps the context of
+/// its last finished task and resets it for its next task instead of building a new one.
+thread_local NativeAllocatorContextPtr idle_allocator_context;
+/// The thread group keeps some bookkeeping for every thread ever attached to it, it's recreated once it
+/// served this many tasks.
+static constexpr size_t MAX_THREAD_GROUP_REUSES = 256;
+
+static void setQueryId(const ContextMutablePtr & query_context)
+{
     // empty input will trigger random query id to be set
     // FileCache will check if query id is set to decide whether to skip cache or not
     // check FileCache.isQueryInitialized()
@@ -33,42 +98,82 @@ int64_t initializeQuery(ReservationListenerWrapperPtr listener)
     // Notice:
     // this generated random query id a qualified global queryid for the spark query
     query_context->setCurrentQueryId("");
+}
+
+static NativeAllocatorContextPtr createAllocatorContext()
+{
+    auto query_context = Context::createCopy(SerializedPlanParser::global_context);
+    query_context->makeQueryContext();
+    setQueryId(query_context);
 
     auto allocator_context = std::make_shared<NativeAllocatorContext>();
     allocator_context->thread_status = std::make_shared<ThreadStatus>();
-    allocator_context->query_scope = std::make_shared<CurrentThread::QueryScope>(query_context);
-    allocator_context->group = std::make_shared<ThreadGroup>(query_context);
+    allocator_context->group = ThreadGroup::createForQuery(query_context);
     allocator_context->query_context = query_context;
+    return allocator_context;
+}
+
+/// Only the per task state is reset, the settings changed by the last task are reverted when the next task
+/// applies its own ones, see BackendInitializerUtil::updateConfig.
+static bool resetAllocatorContext(NativeAllocatorContext & allocator_context)
+{
+    /// Another ThreadStatus took over the thread meanwhile.
+    if (current_thread != allocator_context.thread_status.get())
+        return false;
+
+    setQueryId(allocator_context.query_context);
+    allocator_context.thread_status->memory_tracker.resetCounters();
+    if (++allocator_context.reuses % MAX_THREAD_GROUP_REUSES == 0)
+        allocator_context.group = ThreadGroup::createForQuery(allocator_context.query_context);
+    else
+    {
+        allocator_context.group->memory_tracker.resetCounters();
+        allocator_context.group->performance_counters.reset();
+    }
+    return true;
+}
+
+int64_t initializeQuery(ReservationListenerWrapperPtr listener)
+{
+    auto allocator_context = std::exchange(idle_allocator_context, nullptr);
+    if (!allocator_context || !resetAllocatorContext(*allocator_context))
+        allocator_context = createAllocatorContext();
+
+    CurrentThread::attachToGroup(allocator_context->group);
     allocator_context->listener = listener;
-    thread_status = std::weak_ptr<ThreadStatus>(allocator_context->thread_status);
-    query_scope = std::weak_ptr<CurrentThread::QueryScope>(allocator_context->query_scope);
+    allocator_context->spill_callbacks = std::make_shared<SpillCallbackRegistry>();
     auto allocator_id = reinterpret_cast<int64_t>(allocator_context.get());
-    CurrentMemoryTracker::before_alloc = [listener](Int64 size, bool throw_if_memory_exceed) -> void
-    {
-        if (throw_if_memory_exceed)
-            listener->reserveOrThrow(size);
-        else
-            listener->reserve(size);
-    };
-    CurrentMemoryTracker::before_free = [listener](Int64 size) -> void { listener->free(size); };
+    installMemoryHooks();
     allocator_map.insert(allocator_id, allocator_context);
+    group_allocator_map.insert(allocator_context->group.get(), allocator_context);
     return allocator_id;
 }
 
 void releaseAllocator(int64_t allocator_id)
 {
-    if (!allocator_map.get(allocator_id))
+    auto allocator_context = allocator_map.get(allocator_id);
+    if (!allocator_context)
     {
         throw DB::Exception(ErrorCodes::LOGICAL_ERROR, "allocator {} not found", allocator_id);
     }
-    auto status = allocator_map.get(allocator_id)->thread_status;
+    auto status = allocator_context->thread_status;
     status->detachFromGroup();
-    auto listener = allocator_map.get(allocator_id)->listener;
+    auto listener = allocator_context->listener;
     if (status->untracked_memory < 0)
         listener->free(-status->untracked_memory);
     else if (status->untracked_memory > 0)
         listener->reserve(status->untracked_memory);
+    status->untracked_memory = 0;
+    group_allocator_map.erase(allocator_context->group.get());
     allocator_map.erase(allocator_id);
+
+    /// Kept for the next task of this thread, unless it's released by another thread, or its query context or
+    /// thread group are still referenced, e.g. by an executor not destroyed yet.
+    allocator_context->listener.reset();
+    allocator_context->spill_callbacks.reset();
+    if (!idle_allocator_context && current_thread == status.get() && allocator_context->query_context.use_count() == 1
+        && allocator_context->group.use_count() == 1)
+        idle_allocator_context = std::move(allocator_context);
 }
 
 NativeAllocatorContextPtr getAllocator(int64_t allocator)
@@ -76,6 +181,20 @@ NativeAllocatorContextPtr getAllocator(int64_t allocator)
     return allocator_map.get(allocator);
 }
 
+SpillCallbackRegistryPtr currentSpillCallbackRegistry()
+{
+    auto allocator = currentAllocator();
+    return allocator ? allocator->spill_callbacks : nullptr;
+}
+
+int64_t spillAllocator(int64_t allocator_id, int64_t bytes)
+{
+    auto allocator = allocator_map.get(allocator_id);
+    if (!allocator)
+        throw DB::Exception(ErrorCodes::LOGICAL_ERROR, "allocator {} not found", allocator_id);
+    return allocator->spill_callbacks->spill(bytes);
+}
+
 int64_t allocatorMemoryUsage(int64_t allocator_id)
 {
     return allocator_map.get(allocator_id)->thread_status->memory_tracker.get();
@@ -1,4 +1,7 @@
 #pragma once
+#include <functional>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 #include <Interpreters/Context_fwd.h>
 #include <jni/ReservationListenerWrapper.h>
@@ -13,16 +16,48 @@ void releaseAllocator(int64_t allocator_id);
 
 int64_t allocatorMemoryUsage(int64_t allocator_id);
 
+/// Operators holding memory they can release, e.g. by spilling it to disk, register a callback in the task
+/// they run in, so that spark can ask the task to release memory when it can't grant a reservation.
+class SpillCallbackRegistry
+{
+public:
+    /// Releases up to the given bytes, returns the bytes released.
+    using Callback = std::function<size_t(size_t)>;
+
+    UInt64 add(Callback callback);
+    void remove(UInt64 id);
+    /// Calls the callbacks in the order they are registered, until the bytes are released.
+    size_t spill(size_t bytes);
+
+private:
+    /// Held while the callbacks run, so they are not removed meanwhile. A callback may allocate memory,
+    /// which may ask the task to spill again in the same thread.
+    std::recursive_mutex mutex;
+    UInt64 next_id = 0;
+    std::map<UInt64, Callback> callbacks;
+};
+
+using SpillCallbackRegistryPtr = std::shared_ptr<SpillCallbackRegistry>;
+
 struct NativeAllocatorContext
 {
-    std::shared_ptr<DB::CurrentThread::QueryScope> query_scope;
     std::shared_ptr<DB::ThreadStatus> thread_status;
     DB::ContextMutablePtr query_context;
+    /// The thread group of the task, the memory allocated by its threads is reserved through the listener.
     std::shared_ptr<DB::ThreadGroup> group;
     ReservationListenerWrapperPtr listener;
+    SpillCallbackRegistryPtr spill_callbacks;
+    /// The number of tasks this context was reused for.
+    size_t reuses = 0;
 };
 
 using NativeAllocatorContextPtr = std::shared_ptr<NativeAllocatorContext>;
 
 NativeAllocatorContextPtr getAllocator(int64_t allocator);
+
+/// The registry of the task the current thread works for, nullptr out of a task.
+SpillCallbackRegistryPtr currentSpillCallbackRegistry();
+
+/// Asks the operators of the task to release the bytes, returns the bytes released.
+int64_t spillAllocator(int64_t allocator_id, int64_t bytes);
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <bit>
+#include <cmath>
 #include <city.h>
 #include <base/types.h>
 
@@ -86,15 +88,40 @@ private:
         size_t size = vec_to.size();
         const typename ColVecType::Container & vec_from = col_from->getData();
 
-        auto update_hash = [&](const FromType & value, ToType & to)
+        if constexpr (sizeof(FromType) <= 8)
         {
-            if constexpr (std::is_arithmetic_v<FromType>)
-                to = applyNumber(value, to);
-            else if constexpr (is_decimal<FromType>)
+            /// Fixed-width values are hashed by the word kernels of Impl, which have no data dependent branch,
+            /// so the loops are vectorized. Null rows are hashed as well and blended out afterwards.
+            if (from_const)
             {
-                // std::cout << "decimal field:" << toString(DecimalField(value, 2)) << std::endl;
-                to = applyDecimal(value, to);
+                if (!null_map || !(*null_map)[0]) [[likely]]
+                {
+                    auto word = toHashWord(vec_from[0]);
+                    for (size_t i = 0; i < size; ++i)
+                        vec_to[i] = Impl::applyWord(word, vec_to[i]);
+                }
+            }
+            else if (null_map)
+            {
+                const UInt8 * nulls = null_map->data();
+                for (size_t i = 0; i < size; ++i)
+                {
+                    ToType hash = Impl::applyWord(toHashWord(vec_from[i]), vec_to[i]);
+                    vec_to[i] = nulls[i] ? vec_to[i] : hash;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < size; ++i)
+                    vec_to[i] = Impl::applyWord(toHashWord(vec_from[i]), vec_to[i]);
             }
+            return;
+        }
+
+        auto update_hash = [&](const FromType & value, ToType & to)
+        {
+            if constexpr (is_decimal<FromType>)
+                to = applyDecimal(value, to);
             else
                 throw Exception(
                     ErrorCodes::ILLEGAL_COLUMN, "Illegal column {} of argument of function {}", data_column->getName(), getName());
@@ -158,17 +185,23 @@ private:
         size_t size = vec_to.size();
         if (!from_const)
         {
-            const typename ColumnString::Chars & data = col_from->getChars();
+            const char * data = reinterpret_cast<const char *>(col_from->getChars().data());
             const typename ColumnString::Offsets & offsets = col_from->getOffsets();
 
-            ColumnString::Offset current_offset = 0;
-            for (size_t i = 0; i < size; ++i)
+            /// offsets[-1] is 0, the bytes of row i are [offsets[i - 1], offsets[i] - 1).
+            if (null_map)
             {
-                if (!null_map || !(*null_map)[i]) [[likely]]
-                    vec_to[i] = applyUnsafeBytes(
-                        reinterpret_cast<const char *>(&data[current_offset]), offsets[i] - current_offset - 1, vec_to[i]);
-
-                current_offset = offsets[i];
+                const UInt8 * nulls = null_map->data();
+                for (size_t i = 0; i < size; ++i)
+                {
+                    if (!nulls[i]) [[likely]]
+                        vec_to[i] = applyUnsafeBytes(data + offsets[i - 1], offsets[i] - offsets[i - 1] - 1, vec_to[i]);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < size; ++i)
+                    vec_to[i] = applyUnsafeBytes(data + offsets[i - 1], offsets[i] - offsets[i - 1] - 1, vec_to[i]);
             }
         }
         else
@@ -300,38 +333,22 @@ public:
         return Impl::apply(begin, size, seed);
     }
 
+    /// The value Spark hashes for a fixed-width type, as a 4 or 8 bytes word: integers narrower than 4
+    /// bytes are widened, decimals are hashed as their unscaled long, -0.0 as 0 and NaNs as the canonical
+    /// NaN of floatToIntBits/doubleToLongBits.
     template <typename T>
-        requires std::is_arithmetic_v<T>
-    static ToType applyNumber(T n, UInt64 seed)
+    static auto toHashWord(const T & n)
     {
-        if constexpr (std::is_integral_v<T>)
-        {
-            if constexpr (IntHashPromotion<T>::need_promotion_v)
-            {
-                using PromotedType = typename IntHashPromotion<T>::Type;
-                PromotedType v = n;
-                return Impl::apply(reinterpret_cast<const char *>(&v), sizeof(v), seed);
-            }
-            else
-                return Impl::apply(reinterpret_cast<const char *>(&n), sizeof(n), seed);
-        }
+        if constexpr (is_decimal<T>)
+            return static_cast<UInt64>(static_cast<Int64>(n.value));
+        else if constexpr (std::is_same_v<T, Float32>)
+            return n == 0.0f ? UInt32(0) : (std::isnan(n) ? UInt32(0x7fc00000) : std::bit_cast<UInt32>(n));
+        else if constexpr (std::is_same_v<T, Float64>)
+            return n == 0.0 ? UInt64(0) : (std::isnan(n) ? UInt64(0x7ff8000000000000ULL) : std::bit_cast<UInt64>(n));
+        else if constexpr (sizeof(T) <= 4)
+            return static_cast<UInt32>(static_cast<typename IntHashPromotion<T>::Type>(n));
         else
-        {
-            if constexpr (std::is_same_v<T, Float32>)
-            {
-                if (n == -0.0f) [[unlikely]]
-                    return applyNumber<Int32>(0, seed);
-                else
-                    return Impl::apply(reinterpret_cast<const char *>(&n), sizeof(n), seed);
-            }
-            else
-            {
-                if (n == -0.0) [[unlikely]]
-                    return applyNumber<Int64>(0, seed);
-                else
-                    return Impl::apply(reinterpret_cast<const char *>(&n), sizeof(n), seed);
-            }
-        }
+            return static_cast<UInt64>(n);
     }
 
     template <typename T>
@@ -428,6 +445,41 @@ struct SparkImplXxHash64
     static constexpr auto name = "sparkXxHash64";
     using ReturnType = UInt64;
     static auto apply(const char * s, size_t len, UInt64 seed) { return XXH_INLINE_XXH64(s, len, seed); }
+
+    static constexpr UInt64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static constexpr UInt64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr UInt64 PRIME64_3 = 0x165667B19E3779F9ULL;
+    static constexpr UInt64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr UInt64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    static ALWAYS_INLINE UInt64 rotl64(UInt64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static ALWAYS_INLINE UInt64 avalanche(UInt64 h)
+    {
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /// Same as apply() on the 4 or 8 bytes of value, i.e. XXH64.hashInt/hashLong of Spark.
+    static ALWAYS_INLINE UInt64 applyWord(UInt32 value, UInt64 seed)
+    {
+        UInt64 h = seed + PRIME64_5 + 4;
+        h ^= static_cast<UInt64>(value) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        return avalanche(h);
+    }
+
+    static ALWAYS_INLINE UInt64 applyWord(UInt64 value, UInt64 seed)
+    {
+        UInt64 h = seed + PRIME64_5 + 8;
+        h ^= rotl64(value * PRIME64_2, 31) * PRIME64_1;
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        return avalanche(h);
+    }
 };
 
 
@@ -476,7 +528,8 @@ static void SparkMurmurHash3_x86_32(const void * key, size_t len, uint32_t seed,
     uint32_t k1 = 0;
     while (tail != data + len)
     {
-        k1 = *tail;
+        /// Spark reads the tail as signed bytes.
+        k1 = static_cast<int8_t>(*tail);
 
         k1 *= c1;
         k1 = rotl32(k1, 15);
@@ -520,6 +573,41 @@ struct SparkMurmurHash3_32
         SparkMurmurHash3_x86_32(data, size, static_cast<UInt32>(seed), bytes);
         return h;
     }
+
+    static ALWAYS_INLINE UInt32 mixK1(UInt32 k1)
+    {
+        k1 *= 0xcc9e2d51;
+        k1 = rotl32(k1, 15);
+        return k1 * 0x1b873593;
+    }
+
+    static ALWAYS_INLINE UInt32 mixH1(UInt32 h1, UInt32 k1)
+    {
+        h1 ^= k1;
+        h1 = rotl32(h1, 13);
+        return h1 * 5 + 0xe6546b64;
+    }
+
+    static ALWAYS_INLINE UInt32 fmix(UInt32 h1, UInt32 len)
+    {
+        h1 ^= len;
+        h1 ^= h1 >> 16;
+        h1 *= 0x85ebca6b;
+        h1 ^= h1 >> 13;
+        h1 *= 0xc2b2ae35;
+        h1 ^= h1 >> 16;
+        return h1;
+    }
+
+    /// Same as apply() on the 4 or 8 bytes of value, i.e. Murmur3_x86_32.hashInt/hashLong of Spark.
+    static ALWAYS_INLINE UInt32 applyWord(UInt32 value, UInt32 seed) { return fmix(mixH1(seed, mixK1(value)), 4); }
+
+    static ALWAYS_INLINE UInt32 applyWord(UInt64 value, UInt32 seed)
+    {
+        UInt32 h1 = mixH1(seed, mixK1(static_cast<UInt32>(value)));
+        h1 = mixH1(h1, mixK1(static_cast<UInt32>(value >> 32)));
+        return fmix(h1, 8);
+    }
 };
 
 using SparkFunctionXxHash64 = SparkFunctionAnyHash<SparkImplXxHash64>;
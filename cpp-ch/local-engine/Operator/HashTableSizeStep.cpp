@@ -0,0 +1,84 @@
+#include "HashTableSizeStep.h"
+#include <QueryPipeline/QueryPipelineBuilder.h>
+#include <Common/HashTableSizeHints.h>
+
+namespace local_engine
+{
+HashTableSizeRecorder::~HashTableSizeRecorder()
+{
+    if (!abandoned && rows)
+        HashTableSizeHints::instance().update(key, rows, reserved);
+}
+
+static DB::ITransformingStep::Traits getTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = true,
+        },
+        {
+            .preserves_number_of_rows = true,
+        }};
+}
+
+HashTableSizeStep::HashTableSizeStep(const DB::DataStream & input_stream_, HashTableSizeRecorderPtr recorder_)
+    : DB::ITransformingStep(input_stream_, input_stream_.header, getTraits()), recorder(recorder_)
+{
+}
+
+void HashTableSizeStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    pipeline.addSimpleTransform([&](const DB::Block & header) { return std::make_shared<HashTableSizeTransform>(header, recorder); });
+}
+
+void HashTableSizeStep::describeActions(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    String prefix(settings.offset, settings.indent_char);
+    settings.out << prefix << "Size hint: ";
+    if (recorder->getHint())
+        settings.out << *recorder->getHint() << ", reserved: " << recorder->getReserved();
+    else
+        settings.out << "none";
+    settings.out << '\n';
+}
+
+void HashTableSizeStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void HashTableSizeStep::updateOutputStream()
+{
+    createOutputStream(input_streams.front(), input_streams.front().header, getDataStreamTraits());
+}
+
+HashTableSizeTransform::HashTableSizeTransform(const DB::Block & header_, HashTableSizeRecorderPtr recorder_)
+    : DB::ISimpleTransform(header_, header_, true), recorder(recorder_)
+{
+}
+
+DB::IProcessor::Status HashTableSizeTransform::prepare()
+{
+    /// Same as BuildRuntimeFilterTransform, must be checked before ISimpleTransform::prepare() closes the input.
+    if (output.isFinished() && !input.isFinished())
+        recorder->abandon();
+    return DB::ISimpleTransform::prepare();
+}
+
+void HashTableSizeTransform::transform(DB::Chunk & chunk)
+{
+    recorder->addRows(chunk.getNumRows());
+}
+
+void HashTableSizeTransform::collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const
+{
+    size_t rows = recorder->getRows();
+    extra_metrics["hash_table_size"] = rows;
+    extra_metrics["hash_table_size_hint"] = recorder->getHint().value_or(0);
+    extra_metrics["hash_table_rehashes"] = HashTableSizeHints::estimateRehashes(rows, recorder->getReserved());
+    extra_metrics["hash_table_rehashes_without_hint"] = HashTableSizeHints::estimateRehashes(rows, 0);
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <Parser/RelMetric.h>
+#include <Processors/ISimpleTransform.h>
+#include <Processors/QueryPlan/ITransformingStep.h>
+
+namespace local_engine
+{
+/// The size of a hash table built by a task, i.e. the groups of an aggregation or the rows of a join build side,
+/// recorded into the HashTableSizeHints of the executor when the task is done.
+class HashTableSizeRecorder
+{
+public:
+    /// hint_ is the size looked up for the task, reserved_ the rows the table is presized to.
+    HashTableSizeRecorder(UInt64 key_, std::optional<size_t> hint_, size_t reserved_) : key(key_), hint(hint_), reserved(reserved_) { }
+    ~HashTableSizeRecorder();
+
+    void addRows(size_t rows_) { rows += rows_; }
+    /// The input is not consumed to the end, e.g. below a limit, the size is not recorded.
+    void abandon() { abandoned = true; }
+
+    UInt64 getKey() const { return key; }
+    size_t getRows() const { return rows; }
+    std::optional<size_t> getHint() const { return hint; }
+    size_t getReserved() const { return reserved; }
+
+private:
+    UInt64 key;
+    std::optional<size_t> hint;
+    size_t reserved;
+    std::atomic<size_t> rows = 0;
+    std::atomic<bool> abandoned = false;
+};
+
+using HashTableSizeRecorderPtr = std::shared_ptr<HashTableSizeRecorder>;
+
+/// Placed after an aggregation, or on the build side of a shuffled hash join. Passes the blocks through and
+/// counts the rows into the recorder.
+class HashTableSizeStep : public DB::ITransformingStep
+{
+public:
+    HashTableSizeStep(const DB::DataStream & input_stream_, HashTableSizeRecorderPtr recorder_);
+    ~HashTableSizeStep() override = default;
+
+    String getName() const override { return "HashTableSizeStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describeActions(DB::IQueryPlanStep::FormatSettings & settings) const override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+private:
+    HashTableSizeRecorderPtr recorder;
+    void updateOutputStream() override;
+};
+
+class HashTableSizeTransform : public DB::ISimpleTransform, public IExtraMetricsProvider
+{
+public:
+    HashTableSizeTransform(const DB::Block & header_, HashTableSizeRecorderPtr recorder_);
+    ~HashTableSizeTransform() override = default;
+
+    String getName() const override { return "HashTableSizeTransform"; }
+    Status prepare() override;
+    void collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const override;
+
+protected:
+    void transform(DB::Chunk & chunk) override;
+
+private:
+    HashTableSizeRecorderPtr recorder;
+};
+}
@@ -0,0 +1,427 @@
+#include "JoinResidualFilterStep.h"
+#include <numeric>
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnsCommon.h>
+#include <Columns/ColumnsNumber.h>
+#include <Columns/FilterDescription.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <QueryPipeline/QueryPipelineBuilder.h>
+#include <Common/assert_cast.h>
+#include <magic_enum.hpp>
+
+namespace local_engine
+{
+static DB::ITransformingStep::Traits getAddRowIdTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = true,
+        },
+        {
+            .preserves_number_of_rows = true,
+        }};
+}
+
+static DB::ITransformingStep::Traits getResidualFilterTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = false,
+        },
+        {
+            .preserves_number_of_rows = false,
+        }};
+}
+
+/// Row id columns become nullable on the null-extended side of the join.
+static const DB::PaddedPODArray<UInt64> & getRowIds(const DB::IColumn & column, const DB::NullMap *& null_map)
+{
+    if (const auto * nullable = typeid_cast<const DB::ColumnNullable *>(&column))
+    {
+        null_map = &nullable->getNullMapData();
+        return assert_cast<const DB::ColumnUInt64 &>(nullable->getNestedColumn()).getData();
+    }
+    null_map = nullptr;
+    return assert_cast<const DB::ColumnUInt64 &>(column).getData();
+}
+
+AddRowIdStep::AddRowIdStep(const DB::DataStream & input_stream_, const String & row_id_column_)
+    : DB::ITransformingStep(input_stream_, buildOutputHeader(input_stream_.header, row_id_column_), getAddRowIdTraits())
+    , row_id_column(row_id_column_)
+{
+}
+
+DB::Block AddRowIdStep::buildOutputHeader(const DB::Block & input_header, const String & row_id_column)
+{
+    auto header = input_header.cloneEmpty();
+    header.insert(DB::ColumnWithTypeAndName(std::make_shared<DB::DataTypeUInt64>(), row_id_column));
+    return header;
+}
+
+void AddRowIdStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    pipeline.addSimpleTransform(
+        [&](const DB::Block & header)
+        { return std::make_shared<AddRowIdTransform>(header, getOutputStream().header, next_row_id); });
+}
+
+void AddRowIdStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void AddRowIdStep::updateOutputStream()
+{
+    createOutputStream(input_streams.front(), buildOutputHeader(input_streams.front().header, row_id_column), getDataStreamTraits());
+}
+
+AddRowIdTransform::AddRowIdTransform(
+    const DB::Block & input_header_, const DB::Block & output_header_, std::shared_ptr<std::atomic<UInt64>> next_row_id_)
+    : DB::ISimpleTransform(input_header_, output_header_, true), next_row_id(next_row_id_)
+{
+}
+
+void AddRowIdTransform::transform(DB::Chunk & chunk)
+{
+    size_t rows = chunk.getNumRows();
+    auto row_ids = DB::ColumnUInt64::create(rows);
+    auto & data = row_ids->getData();
+    std::iota(data.begin(), data.end(), next_row_id->fetch_add(rows));
+    chunk.addColumn(std::move(row_ids));
+}
+
+JoinResidualFilterStep::JoinResidualFilterStep(
+    const DB::DataStream & input_stream_,
+    DB::ActionsDAGPtr residual_dag_,
+    const String & filter_column_,
+    const String & probe_row_id_,
+    const String & build_row_id_,
+    size_t left_columns_,
+    ResidualJoinKind kind_)
+    : DB::ITransformingStep(
+        input_stream_, buildOutputHeader(input_stream_.header, probe_row_id_, build_row_id_), getResidualFilterTraits())
+    , residual_dag(residual_dag_)
+    , filter_column(filter_column_)
+    , probe_row_id(probe_row_id_)
+    , build_row_id(build_row_id_)
+    , left_columns(left_columns_)
+    , kind(kind_)
+{
+}
+
+DB::Block JoinResidualFilterStep::buildOutputHeader(const DB::Block & input_header, const String & probe_row_id, const String & build_row_id)
+{
+    auto header = input_header.cloneEmpty();
+    header.erase(probe_row_id);
+    if (!build_row_id.empty())
+        header.erase(build_row_id);
+    return header;
+}
+
+void JoinResidualFilterStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    auto residual_actions = std::make_shared<DB::ExpressionActions>(residual_dag);
+    std::shared_ptr<ResidualFullJoinState> full_join_state;
+    if (kind == ResidualJoinKind::Full)
+    {
+        full_join_state = std::make_shared<ResidualFullJoinState>();
+        const auto & output_header = getOutputStream().header;
+        for (size_t i = left_columns; i < output_header.columns(); ++i)
+            full_join_state->failed_build_columns.emplace_back(output_header.getByPosition(i).type->createColumn());
+    }
+    pipeline.addSimpleTransform(
+        [&](const DB::Block & header)
+        {
+            return std::make_shared<JoinResidualFilterTransform>(
+                header,
+                getOutputStream().header,
+                residual_actions,
+                filter_column,
+                probe_row_id,
+                build_row_id,
+                left_columns,
+                kind,
+                full_join_state);
+        });
+}
+
+void JoinResidualFilterStep::describeActions(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    String prefix(settings.offset, settings.indent_char);
+    settings.out << prefix << "Residual condition: " << filter_column << '\n';
+    settings.out << prefix << "Join kind: " << magic_enum::enum_name(kind) << '\n';
+}
+
+void JoinResidualFilterStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void JoinResidualFilterStep::updateOutputStream()
+{
+    createOutputStream(
+        input_streams.front(), buildOutputHeader(input_streams.front().header, probe_row_id, build_row_id), getDataStreamTraits());
+}
+
+JoinResidualFilterTransform::JoinResidualFilterTransform(
+    const DB::Block & input_header_,
+    const DB::Block & output_header_,
+    DB::ExpressionActionsPtr residual_actions_,
+    const String & filter_column_,
+    const String & probe_row_id_,
+    const String & build_row_id_,
+    size_t left_columns_,
+    ResidualJoinKind kind_,
+    std::shared_ptr<ResidualFullJoinState> full_join_state_)
+    : DB::IProcessor({input_header_}, {output_header_})
+    , input_header(input_header_)
+    , output_header(output_header_)
+    , residual_actions(residual_actions_)
+    , filter_column(filter_column_)
+    , probe_row_id(probe_row_id_)
+    , build_row_id(build_row_id_)
+    , left_columns(left_columns_)
+    , kind(kind_)
+    , full_join_state(full_join_state_)
+{
+    if (full_join_state)
+    {
+        std::lock_guard lock(full_join_state->mutex);
+        ++full_join_state->running_streams;
+    }
+}
+
+JoinResidualFilterTransform::Status JoinResidualFilterTransform::prepare()
+{
+    auto & output = outputs.front();
+    auto & input = inputs.front();
+
+    if (output.isFinished())
+    {
+        input.close();
+        if (!flushed && full_join_state)
+        {
+            /// Don't keep the other streams from emitting the unmatched build rows.
+            flushed = true;
+            std::lock_guard lock(full_join_state->mutex);
+            --full_join_state->running_streams;
+        }
+        return Status::Finished;
+    }
+
+    if (!output.canPush())
+    {
+        input.setNotNeeded();
+        return Status::PortFull;
+    }
+
+    if (output_chunk)
+    {
+        output.push(std::move(*output_chunk));
+        output_chunk.reset();
+        return Status::PortFull;
+    }
+
+    if (input_chunk)
+        return Status::Ready;
+
+    if (input.isFinished())
+    {
+        if (!flushed)
+            return Status::Ready;
+        output.finish();
+        return Status::Finished;
+    }
+
+    input.setNeeded();
+    if (!input.hasData())
+        return Status::NeedData;
+    input_chunk = input.pull(true);
+    return Status::Ready;
+}
+
+void JoinResidualFilterTransform::work()
+{
+    DB::Chunk chunk;
+    if (input_chunk)
+    {
+        chunk = process(std::move(*input_chunk));
+        input_chunk.reset();
+    }
+    else
+    {
+        chunk = flush();
+        flushed = true;
+    }
+    if (chunk.getNumRows())
+        output_chunk = std::move(chunk);
+}
+
+DB::Chunk JoinResidualFilterTransform::process(DB::Chunk chunk)
+{
+    size_t rows = chunk.getNumRows();
+    auto block = input_header.cloneWithColumns(chunk.detachColumns());
+    residual_actions->execute(block, rows);
+
+    DB::Columns columns;
+    columns.reserve(output_header.columns());
+    for (const auto & column : output_header)
+        columns.emplace_back(block.getByName(column.name).column->convertToFullColumnIfConst());
+
+    DB::FilterDescription filter_description(*block.getByName(filter_column).column);
+    const auto & passed = *filter_description.data;
+    const DB::NullMap * probe_null_map = nullptr;
+    auto probe_row_id_column = block.getByName(probe_row_id).column->convertToFullColumnIfConst();
+    const auto & probe_row_ids = getRowIds(*probe_row_id_column, probe_null_map);
+    const DB::NullMap * build_null_map = nullptr;
+    const DB::PaddedPODArray<UInt64> * build_row_ids = nullptr;
+    DB::ColumnPtr build_row_id_column;
+    if (!build_row_id.empty())
+    {
+        build_row_id_column = block.getByName(build_row_id).column->convertToFullColumnIfConst();
+        build_row_ids = &getRowIds(*build_row_id_column, build_null_map);
+    }
+
+    std::unique_lock<std::mutex> lock;
+    if (full_join_state)
+        lock = std::unique_lock(full_join_state->mutex);
+
+    DB::IColumn::Filter keep(rows, 0);
+    auto extra_rows = output_header.cloneEmptyColumns();
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (probe_null_map && (*probe_null_map)[i])
+        {
+            /// Build rows without any equi-key match, already null-extended by the full join.
+            keep[i] = 1;
+            continue;
+        }
+
+        UInt64 probe_row = probe_row_ids[i];
+        if (current_probe_row != probe_row)
+        {
+            finishProbeRow(extra_rows);
+            startProbeRow(probe_row, columns, i);
+        }
+
+        /// A probe row without any equi-key match is joined with a null build row.
+        bool has_build_row = !build_row_ids || !build_null_map || !(*build_null_map)[i];
+        bool pass = passed[i] && has_build_row;
+        switch (kind)
+        {
+            case ResidualJoinKind::Left:
+            case ResidualJoinKind::Full:
+                keep[i] = pass;
+                break;
+            case ResidualJoinKind::Semi:
+                keep[i] = pass && !current_probe_row_passed;
+                break;
+            case ResidualJoinKind::Anti:
+                break;
+        }
+        current_probe_row_passed |= pass;
+
+        if (full_join_state && has_build_row)
+        {
+            UInt64 build_row = (*build_row_ids)[i];
+            auto & state = *full_join_state;
+            auto & build_row_state = state.stateOf(build_row);
+            if (pass)
+                build_row_state |= ResidualFullJoinState::PASSED;
+            else if (!build_row_state)
+            {
+                build_row_state = ResidualFullJoinState::FAILED;
+                state.failed_build_row_ids.push_back(build_row);
+                for (size_t j = left_columns; j < columns.size(); ++j)
+                    state.failed_build_columns[j - left_columns]->insertFrom(*columns[j], i);
+            }
+        }
+    }
+
+    size_t result_rows = DB::countBytesInFilter(keep);
+    size_t extra_rows_num = extra_rows.empty() ? 0 : extra_rows.front()->size();
+    for (size_t j = 0; j < columns.size(); ++j)
+    {
+        if (result_rows < rows)
+            columns[j] = columns[j]->filter(keep, result_rows);
+        if (extra_rows_num)
+        {
+            auto column = DB::IColumn::mutate(std::move(columns[j]));
+            column->insertRangeFrom(*extra_rows[j], 0, extra_rows_num);
+            columns[j] = std::move(column);
+        }
+    }
+    return DB::Chunk(std::move(columns), result_rows + extra_rows_num);
+}
+
+DB::Chunk JoinResidualFilterTransform::flush()
+{
+    auto extra_rows = output_header.cloneEmptyColumns();
+    finishProbeRow(extra_rows);
+
+    if (full_join_state)
+    {
+        std::lock_guard lock(full_join_state->mutex);
+        auto & state = *full_join_state;
+        if (--state.running_streams == 0)
+        {
+            for (size_t index = 0; index < state.failed_build_row_ids.size(); ++index)
+            {
+                if (state.build_row_states[state.failed_build_row_ids[index]] & ResidualFullJoinState::PASSED)
+                    continue;
+                for (size_t j = 0; j < extra_rows.size(); ++j)
+                {
+                    if (j < left_columns)
+                        extra_rows[j]->insertDefault();
+                    else
+                        extra_rows[j]->insertFrom(*state.failed_build_columns[j - left_columns], index);
+                }
+            }
+            /// Released once the non-matched build rows are emitted, not at the end of the query.
+            state.build_row_states = {};
+            state.failed_build_row_ids = {};
+            for (auto & column : state.failed_build_columns)
+                column = column->cloneEmpty();
+        }
+    }
+
+    size_t rows = extra_rows.empty() ? 0 : extra_rows.front()->size();
+    return DB::Chunk(std::move(extra_rows), rows);
+}
+
+void JoinResidualFilterTransform::finishProbeRow(DB::MutableColumns & extra_rows)
+{
+    if (!current_probe_row)
+        return;
+    if (!current_probe_row_passed && kind != ResidualJoinKind::Semi)
+    {
+        for (size_t j = 0; j < extra_rows.size(); ++j)
+        {
+            if (j < left_columns)
+                extra_rows[j]->insertFrom(*current_first_pair[j], 0);
+            else
+                extra_rows[j]->insertDefault();
+        }
+    }
+    current_probe_row.reset();
+}
+
+void JoinResidualFilterTransform::startProbeRow(UInt64 probe_row, const DB::Columns & columns, size_t row)
+{
+    current_probe_row = probe_row;
+    current_probe_row_passed = false;
+    current_first_pair.clear();
+    for (size_t j = 0; j < left_columns; ++j)
+    {
+        auto column = columns[j]->cloneEmpty();
+        column->insertFrom(*columns[j], row);
+        current_first_pair.emplace_back(std::move(column));
+    }
+}
+}
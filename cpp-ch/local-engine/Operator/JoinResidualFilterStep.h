@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <Common/PODArray.h>
+#include <Interpreters/ExpressionActions.h>
+#include <Processors/IProcessor.h>
+#include <Processors/ISimpleTransform.h>
+#include <Processors/QueryPlan/ITransformingStep.h>
+
+namespace local_engine
+{
+/// Appends a column of unique UInt64 ids to every row. Used to tell which joined rows come from the
+/// same input row of a join.
+class AddRowIdStep : public DB::ITransformingStep
+{
+public:
+    AddRowIdStep(const DB::DataStream & input_stream_, const String & row_id_column_);
+    ~AddRowIdStep() override = default;
+
+    String getName() const override { return "AddRowIdStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+    static DB::Block buildOutputHeader(const DB::Block & input_header, const String & row_id_column);
+
+private:
+    String row_id_column;
+    /// Shared by all the streams, so the ids are unique in the whole plan.
+    std::shared_ptr<std::atomic<UInt64>> next_row_id = std::make_shared<std::atomic<UInt64>>(0);
+    void updateOutputStream() override;
+};
+
+class AddRowIdTransform : public DB::ISimpleTransform
+{
+public:
+    AddRowIdTransform(const DB::Block & input_header_, const DB::Block & output_header_, std::shared_ptr<std::atomic<UInt64>> next_row_id_);
+    ~AddRowIdTransform() override = default;
+
+    String getName() const override { return "AddRowIdTransform"; }
+
+protected:
+    void transform(DB::Chunk & chunk) override;
+
+private:
+    std::shared_ptr<std::atomic<UInt64>> next_row_id;
+};
+
+enum class ResidualJoinKind
+{
+    Left,
+    Full,
+    Semi,
+    Anti,
+};
+
+/// Build rows of a full join seen by all the streams, the build rows which never passed the residual
+/// condition are emitted by the last stream. The build row ids are dense, numbered from 0 by AddRowIdStep, so
+/// the state of a build row is a byte indexed by its id, bounded by the build side.
+struct ResidualFullJoinState
+{
+    static constexpr UInt8 PASSED = 1;
+    static constexpr UInt8 FAILED = 2;
+
+    std::mutex mutex;
+    size_t running_streams = 0;
+    DB::PaddedPODArray<UInt8> build_row_states;
+    /// The build rows which failed the condition when they were first seen, and their ids.
+    DB::MutableColumns failed_build_columns;
+    DB::PaddedPODArray<UInt64> failed_build_row_ids;
+
+    UInt8 & stateOf(UInt64 build_row)
+    {
+        if (build_row >= build_row_states.size())
+            build_row_states.resize_fill(build_row + 1, 0);
+        return build_row_states[build_row];
+    }
+};
+
+/// Evaluates the join conditions which reference both sides and can't be handled by the hash join of
+/// ch. The join itself runs as a left/full ALL join on the equi-keys only, this step sees all the
+/// matched pairs of a probe row next to each other, identified by the probe row id, and turns them into
+/// the result of the original join:
+/// - left/full: the pairs passing the condition, or one null-extended row if none passes,
+/// - semi: the first pair passing the condition,
+/// - anti: the probe row if no pair passes.
+/// For full joins the build rows are identified by the build row id as well, the build rows without
+/// any passing pair are emitted null-extended once all the streams are finished.
+/// The output is the input without the row ids.
+class JoinResidualFilterStep : public DB::ITransformingStep
+{
+public:
+    JoinResidualFilterStep(
+        const DB::DataStream & input_stream_,
+        DB::ActionsDAGPtr residual_dag_,
+        const String & filter_column_,
+        const String & probe_row_id_,
+        const String & build_row_id_,
+        size_t left_columns_,
+        ResidualJoinKind kind_);
+    ~JoinResidualFilterStep() override = default;
+
+    String getName() const override { return "JoinResidualFilterStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describeActions(DB::IQueryPlanStep::FormatSettings & settings) const override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+    static DB::Block buildOutputHeader(const DB::Block & input_header, const String & probe_row_id, const String & build_row_id);
+
+private:
+    DB::ActionsDAGPtr residual_dag;
+    String filter_column;
+    String probe_row_id;
+    String build_row_id;
+    size_t left_columns;
+    ResidualJoinKind kind;
+    void updateOutputStream() override;
+};
+
+class JoinResidualFilterTransform : public DB::IProcessor
+{
+public:
+    using Status = DB::IProcessor::Status;
+    JoinResidualFilterTransform(
+        const DB::Block & input_header_,
+        const DB::Block & output_header_,
+        DB::ExpressionActionsPtr residual_actions_,
+        const String & filter_column_,
+        const String & probe_row_id_,
+        const String & build_row_id_,
+        size_t left_columns_,
+        ResidualJoinKind kind_,
+        std::shared_ptr<ResidualFullJoinState> full_join_state_);
+    ~JoinResidualFilterTransform() override = default;
+
+    Status prepare() override;
+    void work() override;
+
+    String getName() const override { return "JoinResidualFilterTransform"; }
+
+private:
+    DB::Block input_header;
+    DB::Block output_header;
+    DB::ExpressionActionsPtr residual_actions;
+    String filter_column;
+    String probe_row_id;
+    String build_row_id;
+    size_t left_columns;
+    ResidualJoinKind kind;
+    std::shared_ptr<ResidualFullJoinState> full_join_state;
+
+    std::optional<DB::Chunk> input_chunk;
+    std::optional<DB::Chunk> output_chunk;
+    bool input_finished = false;
+    bool flushed = false;
+
+    /// The probe row whose pairs are being consumed, its pairs may span several chunks.
+    std::optional<UInt64> current_probe_row;
+    bool current_probe_row_passed = false;
+    /// The first pair of the current probe row, kept to emit the probe row for left/full/anti joins.
+    DB::MutableColumns current_first_pair;
+
+    DB::Chunk process(DB::Chunk chunk);
+    DB::Chunk flush();
+    void finishProbeRow(DB::MutableColumns & extra_rows);
+    void startProbeRow(UInt64 probe_row, const DB::Columns & columns, size_t row);
+};
+}
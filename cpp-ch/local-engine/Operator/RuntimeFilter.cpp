@@ -0,0 +1,391 @@
+#include "RuntimeFilter.h"
+#include <algorithm>
+#include <Columns/ColumnNullable.h>
+#include <DataTypes/DataTypeLowCardinality.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <base/sort.h>
+#include <fmt/format.h>
+#include <Common/Exception.h>
+#include <Common/FieldVisitorsAccurateComparison.h>
+#include <city.h>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+    extern const int LOGICAL_ERROR;
+}
+}
+
+namespace local_engine
+{
+using namespace DB;
+
+RuntimeFilterSettings RuntimeFilterSettings::loadFromConfig(const Poco::Util::AbstractConfiguration & config)
+{
+    RuntimeFilterSettings settings;
+    settings.enabled = config.getBool("runtime_filter.enabled", settings.enabled);
+    settings.max_in_set_size = config.getUInt64("runtime_filter.max_in_set_size", settings.max_in_set_size);
+    settings.max_bloom_filter_keys = config.getUInt64("runtime_filter.max_bloom_filter_keys", settings.max_bloom_filter_keys);
+    settings.bloom_filter_bits_per_key = config.getUInt64("runtime_filter.bloom_filter_bits_per_key", settings.bloom_filter_bits_per_key);
+    return settings;
+}
+
+static constexpr UInt32 BLOOM_FILTER_SALT[8]
+    = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+BlockedBloomFilter::BlockedBloomFilter(size_t expected_keys, size_t bits_per_key)
+{
+    num_blocks = std::max<UInt64>(1, (expected_keys * bits_per_key + 255) / 256);
+    words.assign(num_blocks * WORDS_PER_BLOCK, 0);
+}
+
+void BlockedBloomFilter::insert(UInt64 hash)
+{
+    UInt32 * block = words.data() + blockOffset(hash);
+    auto key = static_cast<UInt32>(hash);
+    for (size_t i = 0; i < WORDS_PER_BLOCK; ++i)
+        block[i] |= 1U << ((key * BLOOM_FILTER_SALT[i]) >> 27);
+}
+
+bool BlockedBloomFilter::mayContain(UInt64 hash) const
+{
+    const UInt32 * block = words.data() + blockOffset(hash);
+    auto key = static_cast<UInt32>(hash);
+    /// No early exit, so that the loop is vectorized.
+    UInt32 missed = 0;
+    for (size_t i = 0; i < WORDS_PER_BLOCK; ++i)
+        missed |= ~block[i] & (1U << ((key * BLOOM_FILTER_SALT[i]) >> 27));
+    return !missed;
+}
+
+static inline UInt64 hashKey(std::string_view key)
+{
+    return CityHash_v1_0_2::CityHash64(key.data(), key.size());
+}
+
+static std::pair<const IColumn *, const NullMap *> unwrapNullable(const IColumn & column)
+{
+    if (const auto * nullable = typeid_cast<const ColumnNullable *>(&column))
+        return {&nullable->getNestedColumn(), &nullable->getNullMapData()};
+    return {&column, nullptr};
+}
+
+RuntimeFilter::RuntimeFilter(const DataTypePtr & key_type_, const RuntimeFilterSettings & settings_)
+    : key_type(removeNullable(removeLowCardinality(key_type_))), settings(settings_)
+{
+    min_column = key_type->createColumn();
+    max_column = key_type->createColumn();
+}
+
+bool RuntimeFilter::isSupportedType(const DataTypePtr & type)
+{
+    WhichDataType which(removeNullable(removeLowCardinality(type)));
+    return which.isNativeInt() || which.isNativeUInt() || which.isDate() || which.isDate32() || which.isDateTime()
+        || which.isDateTime64() || which.isDecimal() || which.isStringOrFixedString();
+}
+
+void RuntimeFilter::insertKey(std::string_view key)
+{
+    if (!bloom_filter_overflow)
+        hashes.push_back(hashKey(key));
+
+    if (in_set_overflow || in_set.contains(key))
+        return;
+
+    if (in_set.size() >= settings.max_in_set_size)
+    {
+        in_set_overflow = true;
+        in_set.clear();
+        in_set_values.clear();
+        return;
+    }
+    const auto & stored = in_set_values.emplace_back(key);
+    in_set.emplace(stored);
+}
+
+void RuntimeFilter::shrinkHashes()
+{
+    ::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    if (hashes.size() > settings.max_bloom_filter_keys)
+    {
+        bloom_filter_overflow = true;
+        hashes = {};
+    }
+}
+
+void RuntimeFilter::updateMinMax(const IColumn & nested, const NullMap * null_map)
+{
+    std::optional<size_t> min_row;
+    std::optional<size_t> max_row;
+    for (size_t i = 0, rows = nested.size(); i < rows; ++i)
+    {
+        if (null_map && (*null_map)[i])
+            continue;
+        if (!min_row || nested.compareAt(i, *min_row, nested, 1) < 0)
+            min_row = i;
+        if (!max_row || nested.compareAt(i, *max_row, nested, 1) > 0)
+            max_row = i;
+    }
+    if (!min_row)
+        return;
+
+    if (!has_keys || nested.compareAt(*min_row, 0, *min_column, 1) < 0)
+    {
+        min_column = key_type->createColumn();
+        min_column->insertFrom(nested, *min_row);
+    }
+    if (!has_keys || nested.compareAt(*max_row, 0, *max_column, 1) > 0)
+    {
+        max_column = key_type->createColumn();
+        max_column->insertFrom(nested, *max_row);
+    }
+    has_keys = true;
+}
+
+void RuntimeFilter::insert(const IColumn & column)
+{
+    if (finalized)
+        throw Exception(ErrorCodes::LOGICAL_ERROR, "Can't insert keys into a finalized runtime filter");
+
+    auto full_column = column.convertToFullColumnIfConst()->convertToFullColumnIfLowCardinality();
+    auto [nested, null_map] = unwrapNullable(*full_column);
+    updateMinMax(*nested, null_map);
+
+    for (size_t i = 0, rows = nested->size(); i < rows; ++i)
+    {
+        if (null_map && (*null_map)[i])
+            continue;
+        insertKey(nested->getDataAt(i).toView());
+    }
+
+    if (!bloom_filter_overflow && hashes.size() > 2 * settings.max_bloom_filter_keys)
+        shrinkHashes();
+}
+
+void RuntimeFilter::merge(const RuntimeFilter & other)
+{
+    if (finalized || other.finalized)
+        throw Exception(ErrorCodes::LOGICAL_ERROR, "Can't merge finalized runtime filters");
+
+    if (other.has_keys)
+    {
+        if (!has_keys || other.min_column->compareAt(0, 0, *min_column, 1) < 0)
+            min_column = IColumn::mutate(other.min_column->getPtr());
+        if (!has_keys || other.max_column->compareAt(0, 0, *max_column, 1) > 0)
+            max_column = IColumn::mutate(other.max_column->getPtr());
+        has_keys = true;
+    }
+
+    if (other.in_set_overflow)
+    {
+        in_set_overflow = true;
+        in_set.clear();
+        in_set_values.clear();
+    }
+    else if (!in_set_overflow)
+    {
+        for (const auto & value : other.in_set_values)
+        {
+            if (in_set.contains(value))
+                continue;
+            if (in_set.size() >= settings.max_in_set_size)
+            {
+                in_set_overflow = true;
+                in_set.clear();
+                in_set_values.clear();
+                break;
+            }
+            in_set.emplace(in_set_values.emplace_back(value));
+        }
+    }
+
+    if (other.bloom_filter_overflow)
+    {
+        bloom_filter_overflow = true;
+        hashes = {};
+    }
+    else if (!bloom_filter_overflow)
+    {
+        hashes.insert(hashes.end(), other.hashes.begin(), other.hashes.end());
+        if (hashes.size() > 2 * settings.max_bloom_filter_keys)
+            shrinkHashes();
+    }
+}
+
+void RuntimeFilter::finalize()
+{
+    if (finalized)
+        return;
+    finalized = true;
+
+    if (!in_set_overflow || bloom_filter_overflow)
+    {
+        hashes = {};
+        return;
+    }
+
+    shrinkHashes();
+    if (bloom_filter_overflow)
+        return;
+
+    bloom_filter = std::make_unique<BlockedBloomFilter>(hashes.size(), settings.bloom_filter_bits_per_key);
+    for (auto hash : hashes)
+        bloom_filter->insert(hash);
+    hashes = {};
+}
+
+void RuntimeFilter::apply(const IColumn & column, IColumn::Filter & filter) const
+{
+    if (!finalized)
+        throw Exception(ErrorCodes::LOGICAL_ERROR, "Runtime filter is applied before it's finalized");
+
+    if (!has_keys)
+    {
+        /// The build side is empty or contains only nulls, nothing matches.
+        std::fill(filter.begin(), filter.end(), 0);
+        return;
+    }
+
+    auto full_column = column.convertToFullColumnIfConst()->convertToFullColumnIfLowCardinality();
+    auto [nested, null_map] = unwrapNullable(*full_column);
+    size_t rows = nested->size();
+
+    if (!in_set_overflow)
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            if (!filter[i])
+                continue;
+            filter[i] = !(null_map && (*null_map)[i]) && in_set.contains(nested->getDataAt(i).toView());
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (!filter[i])
+            continue;
+        if (null_map && (*null_map)[i])
+        {
+            filter[i] = 0;
+            continue;
+        }
+        if (nested->compareAt(i, 0, *min_column, 1) < 0 || nested->compareAt(i, 0, *max_column, 1) > 0)
+        {
+            filter[i] = 0;
+            continue;
+        }
+        if (bloom_filter)
+            filter[i] = bloom_filter->mayContain(hashKey(nested->getDataAt(i).toView()));
+    }
+}
+
+bool RuntimeFilter::mayIntersect(const Field & range_min, const Field & range_max) const
+{
+    if (!has_keys)
+        return false;
+    if (range_min.isNull() || range_max.isNull())
+        return true;
+
+    FieldVisitorAccurateLess less;
+    return !applyVisitor(less, range_max, getMin()) && !applyVisitor(less, getMax(), range_min);
+}
+
+Field RuntimeFilter::getMin() const
+{
+    return has_keys ? (*min_column)[0] : Field();
+}
+
+Field RuntimeFilter::getMax() const
+{
+    return has_keys ? (*max_column)[0] : Field();
+}
+
+String RuntimeFilter::dumpStructure() const
+{
+    if (!has_keys)
+        return "empty";
+    String res = fmt::format("min: {}, max: {}", toString(getMin()), toString(getMax()));
+    if (!in_set_overflow)
+        res += fmt::format(", in set: {} keys", in_set.size());
+    else if (bloom_filter)
+        res += fmt::format(", bloom filter: {} bytes", bloom_filter->allocatedBytes());
+    return res;
+}
+
+RuntimeFilterHolder::RuntimeFilterHolder(const Names & build_keys_, const DataTypes & key_types_, const RuntimeFilterSettings & settings_)
+    : build_keys(build_keys_), key_types(key_types_), settings(settings_)
+{
+    if (build_keys.size() != key_types.size())
+        throw Exception(ErrorCodes::LOGICAL_ERROR, "Runtime filter keys and types mismatch");
+    filters = createLocalFilters();
+}
+
+std::vector<RuntimeFilter> RuntimeFilterHolder::createLocalFilters() const
+{
+    std::vector<RuntimeFilter> res;
+    res.reserve(key_types.size());
+    for (const auto & type : key_types)
+        res.emplace_back(type, settings);
+    return res;
+}
+
+DB::Names RuntimeFilterHolder::matchProbeKeys(const DB::Names & join_build_keys, const DB::Names & join_probe_keys) const
+{
+    if (join_build_keys.size() != join_probe_keys.size() || build_keys.size() != join_build_keys.size())
+        return {};
+    DB::Names res;
+    res.reserve(build_keys.size());
+    for (const auto & build_key : build_keys)
+    {
+        auto it = std::find(join_build_keys.begin(), join_build_keys.end(), build_key);
+        if (it == join_build_keys.end())
+            return {};
+        res.emplace_back(join_probe_keys[it - join_build_keys.begin()]);
+    }
+    return res;
+}
+
+void RuntimeFilterHolder::registerBuilder()
+{
+    std::lock_guard lock(mutex);
+    ++pending_builders;
+}
+
+void RuntimeFilterHolder::finishBuilder(std::vector<RuntimeFilter> & local_filters)
+{
+    std::lock_guard lock(mutex);
+    if (!pending_builders)
+        throw Exception(ErrorCodes::LOGICAL_ERROR, "Runtime filter has no pending builder");
+
+    for (size_t i = 0; i < filters.size(); ++i)
+        filters[i].merge(local_filters[i]);
+    local_filters.clear();
+
+    if (--pending_builders == 0 && !abandoned)
+    {
+        for (auto & filter : filters)
+            filter.finalize();
+        ready.store(true, std::memory_order_release);
+    }
+}
+
+void RuntimeFilterHolder::abandonBuilder()
+{
+    std::lock_guard lock(mutex);
+    abandoned = true;
+    if (pending_builders)
+        --pending_builders;
+}
+
+void RuntimeFilterHolder::setReady(std::vector<RuntimeFilter> && filters_)
+{
+    std::lock_guard lock(mutex);
+    filters = std::move(filters_);
+    for (auto & filter : filters)
+        filter.finalize();
+    ready.store(true, std::memory_order_release);
+}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <Columns/IColumn.h>
+#include <Core/Field.h>
+#include <Core/Names.h>
+#include <DataTypes/IDataType.h>
+#include <Poco/Util/AbstractConfiguration.h>
+
+namespace local_engine
+{
+struct RuntimeFilterSettings
+{
+    bool enabled = true;
+    /// Build sides with at most this number of distinct keys are kept as an exact IN-list.
+    size_t max_in_set_size = 1024;
+    /// Build sides with more distinct keys than this only keep a min/max range.
+    size_t max_bloom_filter_keys = 8 * 1024 * 1024;
+    /// 10 bits per key gives a false positive rate around 1%.
+    size_t bloom_filter_bits_per_key = 10;
+
+    static RuntimeFilterSettings loadFromConfig(const Poco::Util::AbstractConfiguration & config);
+};
+
+/// Split block bloom filter, the same layout as the parquet bloom filter. Each key only touches one
+/// 256 bits block, so a probe costs a single cache line and the 8 words of a block can be checked
+/// with SIMD instructions.
+class BlockedBloomFilter
+{
+public:
+    BlockedBloomFilter(size_t expected_keys, size_t bits_per_key);
+
+    void insert(UInt64 hash);
+    bool mayContain(UInt64 hash) const;
+    size_t allocatedBytes() const { return words.size() * sizeof(UInt32); }
+
+private:
+    static constexpr size_t WORDS_PER_BLOCK = 8;
+    std::vector<UInt32> words;
+    UInt64 num_blocks;
+
+    size_t blockOffset(UInt64 hash) const { return ((hash >> 32) * num_blocks >> 32) * WORDS_PER_BLOCK; }
+};
+
+/// Runtime filter on one equi-join key, built from the keys of the hash join build side. Depending on
+/// the number of distinct build keys it's an exact IN-list, a bloom filter with a min/max range, or only
+/// a min/max range.
+/// Only used for joins which drop probe rows without a match, i.e. inner and left semi joins. Null keys
+/// never match.
+class RuntimeFilter
+{
+public:
+    RuntimeFilter(const DB::DataTypePtr & key_type_, const RuntimeFilterSettings & settings_);
+
+    /// Float keys are excluded, their bytes are not canonical (-0.0/0.0, NaN).
+    static bool isSupportedType(const DB::DataTypePtr & type);
+
+    void insert(const DB::IColumn & column);
+    void merge(const RuntimeFilter & other);
+    /// Called once all build keys are inserted. Decides which representation is used for probing.
+    void finalize();
+
+    /// Set filter[i] to 0 for the rows whose key can't match any build key.
+    void apply(const DB::IColumn & column, DB::IColumn::Filter & filter) const;
+    /// Whether there may be a build key in [range_min, range_max], used to prune row groups by statistics.
+    bool mayIntersect(const DB::Field & range_min, const DB::Field & range_max) const;
+
+    bool empty() const { return !has_keys; }
+    DB::Field getMin() const;
+    DB::Field getMax() const;
+    const DB::DataTypePtr & getKeyType() const { return key_type; }
+    String dumpStructure() const;
+
+private:
+    DB::DataTypePtr key_type;
+    RuntimeFilterSettings settings;
+    bool finalized = false;
+
+    bool has_keys = false;
+    /// Single row columns of the not nullable key type.
+    DB::MutableColumnPtr min_column;
+    DB::MutableColumnPtr max_column;
+
+    /// Raw bytes of the distinct keys, cleared once there are more than max_in_set_size keys.
+    std::deque<String> in_set_values;
+    std::unordered_set<std::string_view> in_set;
+    bool in_set_overflow = false;
+
+    /// Hashes of all the inserted keys, turned into the bloom filter in finalize().
+    std::vector<UInt64> hashes;
+    bool bloom_filter_overflow = false;
+    std::unique_ptr<BlockedBloomFilter> bloom_filter;
+
+    void updateMinMax(const DB::IColumn & nested, const DB::NullMap * null_map);
+    void insertKey(std::string_view key);
+    void shrinkHashes();
+};
+
+/// Runtime filters on all the equi-join keys of a join. It's shared by the build side, which fills it,
+/// and the probe side, which may only use it once isReady() returns true.
+class RuntimeFilterHolder
+{
+public:
+    struct Metrics
+    {
+        std::atomic<size_t> filtered_rows = 0;
+        std::atomic<size_t> skipped_files = 0;
+        std::atomic<size_t> skipped_row_groups = 0;
+        std::atomic<size_t> skipped_rows = 0;
+    };
+
+    RuntimeFilterHolder(const DB::Names & build_keys_, const DB::DataTypes & key_types_, const RuntimeFilterSettings & settings_);
+
+    /// Every build stream calls registerBuilder() when the pipeline is built and publishes its local
+    /// filters by finishBuilder() once it has consumed all of its input. The filters get ready when
+    /// the last builder finishes.
+    std::vector<RuntimeFilter> createLocalFilters() const;
+    void registerBuilder();
+    void finishBuilder(std::vector<RuntimeFilter> & local_filters);
+    /// A builder whose output was closed before its input was exhausted. The filters will never be ready.
+    void abandonBuilder();
+
+    /// Used by the broadcast join, whose build side is already complete.
+    void setReady(std::vector<RuntimeFilter> && filters_);
+
+    bool isReady() const { return ready.load(std::memory_order_acquire); }
+    size_t size() const { return build_keys.size(); }
+    const RuntimeFilter & getFilter(size_t i) const { return filters.at(i); }
+    const DB::Names & getBuildKeys() const { return build_keys; }
+    /// The probe key of every filter, matched to the build keys of the holder by name, as the build side may
+    /// order the keys of a join differently, e.g. a broadcast table. Empty if a build key is not a key of the join.
+    DB::Names matchProbeKeys(const DB::Names & join_build_keys, const DB::Names & join_probe_keys) const;
+    const DB::DataTypes & getKeyTypes() const { return key_types; }
+    Metrics & getMetrics() { return metrics; }
+
+private:
+    DB::Names build_keys;
+    DB::DataTypes key_types;
+    RuntimeFilterSettings settings;
+
+    std::mutex mutex;
+    size_t pending_builders = 0;
+    bool abandoned = false;
+    std::vector<RuntimeFilter> filters;
+    std::atomic<bool> ready = false;
+    Metrics metrics;
+};
+using RuntimeFilterHolderPtr = std::shared_ptr<RuntimeFilterHolder>;
+
+/// A runtime filter pushed down into a scan, applied on the scan column `column_name`.
+struct PushedRuntimeFilter
+{
+    String column_name;
+    RuntimeFilterHolderPtr holder;
+    size_t key_index;
+
+    bool isReady() const { return holder->isReady(); }
+    const RuntimeFilter & getFilter() const { return holder->getFilter(key_index); }
+};
+using PushedRuntimeFilters = std::vector<PushedRuntimeFilter>;
+}
@@ -0,0 +1,154 @@
+#include "RuntimeFilterStep.h"
+#include <Columns/ColumnsCommon.h>
+#include <QueryPipeline/QueryPipelineBuilder.h>
+
+namespace local_engine
+{
+static DB::ITransformingStep::Traits getBuildTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = true,
+        },
+        {
+            .preserves_number_of_rows = true,
+        }};
+}
+
+static DB::ITransformingStep::Traits getProbeTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = true,
+        },
+        {
+            .preserves_number_of_rows = false,
+        }};
+}
+
+BuildRuntimeFilterStep::BuildRuntimeFilterStep(const DB::DataStream & input_stream_, RuntimeFilterHolderPtr holder_)
+    : DB::ITransformingStep(input_stream_, input_stream_.header, getBuildTraits()), holder(holder_)
+{
+}
+
+void BuildRuntimeFilterStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    pipeline.addSimpleTransform([&](const DB::Block & header) { return std::make_shared<BuildRuntimeFilterTransform>(header, holder); });
+}
+
+void BuildRuntimeFilterStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void BuildRuntimeFilterStep::updateOutputStream()
+{
+    createOutputStream(input_streams.front(), input_streams.front().header, getDataStreamTraits());
+}
+
+BuildRuntimeFilterTransform::BuildRuntimeFilterTransform(const DB::Block & header_, RuntimeFilterHolderPtr holder_)
+    : DB::ISimpleTransform(header_, header_, true), holder(holder_)
+{
+    for (const auto & key : holder->getBuildKeys())
+        key_positions.emplace_back(header_.getPositionByName(key));
+    local_filters = holder->createLocalFilters();
+    holder->registerBuilder();
+}
+
+DB::IProcessor::Status BuildRuntimeFilterTransform::prepare()
+{
+    /// The output is finished when the downstream doesn't need more data, in that case the collected
+    /// keys are not complete. Must be checked before ISimpleTransform::prepare() closes the input.
+    bool incomplete = output.isFinished() && !input.isFinished();
+    auto status = DB::ISimpleTransform::prepare();
+    if (status == Status::Finished && !published)
+    {
+        published = true;
+        if (incomplete)
+            holder->abandonBuilder();
+        else
+            holder->finishBuilder(local_filters);
+    }
+    return status;
+}
+
+void BuildRuntimeFilterTransform::transform(DB::Chunk & chunk)
+{
+    const auto & columns = chunk.getColumns();
+    for (size_t i = 0; i < key_positions.size(); ++i)
+        local_filters[i].insert(*columns[key_positions[i]]);
+}
+
+RuntimeFilterStep::RuntimeFilterStep(const DB::DataStream & input_stream_, RuntimeFilterHolderPtr holder_, const DB::Names & probe_keys_)
+    : DB::ITransformingStep(input_stream_, input_stream_.header, getProbeTraits()), holder(holder_), probe_keys(probe_keys_)
+{
+}
+
+void RuntimeFilterStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    pipeline.addSimpleTransform([&](const DB::Block & header)
+                                { return std::make_shared<RuntimeFilterTransform>(header, holder, probe_keys); });
+}
+
+void RuntimeFilterStep::describeActions(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    String prefix(settings.offset, settings.indent_char);
+    for (size_t i = 0; i < probe_keys.size(); ++i)
+    {
+        settings.out << prefix << "Runtime filter: " << probe_keys[i] << " <- " << holder->getBuildKeys()[i];
+        if (holder->isReady())
+            settings.out << " (" << holder->getFilter(i).dumpStructure() << ")";
+        settings.out << '\n';
+    }
+}
+
+void RuntimeFilterStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void RuntimeFilterStep::updateOutputStream()
+{
+    createOutputStream(input_streams.front(), input_streams.front().header, getDataStreamTraits());
+}
+
+RuntimeFilterTransform::RuntimeFilterTransform(const DB::Block & header_, RuntimeFilterHolderPtr holder_, const DB::Names & probe_keys_)
+    : DB::ISimpleTransform(header_, header_, true), holder(holder_)
+{
+    for (const auto & key : probe_keys_)
+        key_positions.emplace_back(header_.getPositionByName(key));
+}
+
+void RuntimeFilterTransform::transform(DB::Chunk & chunk)
+{
+    if (!holder->isReady())
+        return;
+
+    size_t rows = chunk.getNumRows();
+    DB::IColumn::Filter filter(rows, 1);
+    auto columns = chunk.detachColumns();
+    for (size_t i = 0; i < key_positions.size(); ++i)
+        holder->getFilter(i).apply(*columns[key_positions[i]], filter);
+
+    size_t result_rows = DB::countBytesInFilter(filter);
+    if (result_rows < rows)
+    {
+        for (auto & column : columns)
+            column = column->filter(filter, result_rows);
+        filtered_rows += rows - result_rows;
+        holder->getMetrics().filtered_rows += rows - result_rows;
+    }
+    chunk.setColumns(std::move(columns), result_rows);
+}
+
+void RuntimeFilterTransform::collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const
+{
+    extra_metrics["runtime_filter_rows"] = filtered_rows;
+}
+}
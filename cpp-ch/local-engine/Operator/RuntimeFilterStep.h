@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Operator/RuntimeFilter.h>
+#include <Parser/RelMetric.h>
+#include <Processors/ISimpleTransform.h>
+#include <Processors/QueryPlan/ITransformingStep.h>
+
+namespace local_engine
+{
+/// Placed on the build side of a shuffled hash join. Passes the blocks through and collects the join
+/// keys into the runtime filters.
+class BuildRuntimeFilterStep : public DB::ITransformingStep
+{
+public:
+    BuildRuntimeFilterStep(const DB::DataStream & input_stream_, RuntimeFilterHolderPtr holder_);
+    ~BuildRuntimeFilterStep() override = default;
+
+    String getName() const override { return "BuildRuntimeFilterStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+private:
+    RuntimeFilterHolderPtr holder;
+    void updateOutputStream() override;
+};
+
+class BuildRuntimeFilterTransform : public DB::ISimpleTransform
+{
+public:
+    BuildRuntimeFilterTransform(const DB::Block & header_, RuntimeFilterHolderPtr holder_);
+    ~BuildRuntimeFilterTransform() override = default;
+
+    String getName() const override { return "BuildRuntimeFilterTransform"; }
+    Status prepare() override;
+
+protected:
+    void transform(DB::Chunk & chunk) override;
+
+private:
+    RuntimeFilterHolderPtr holder;
+    std::vector<size_t> key_positions;
+    std::vector<RuntimeFilter> local_filters;
+    bool published = false;
+};
+
+/// Placed on the probe side of a join. Drops the rows whose keys can't match any build key once the
+/// build side is finished, rows are passed through before that.
+class RuntimeFilterStep : public DB::ITransformingStep
+{
+public:
+    /// probe_keys_[i] is the probe column of the i-th runtime filter in holder_.
+    RuntimeFilterStep(const DB::DataStream & input_stream_, RuntimeFilterHolderPtr holder_, const DB::Names & probe_keys_);
+    ~RuntimeFilterStep() override = default;
+
+    String getName() const override { return "RuntimeFilterStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describeActions(DB::IQueryPlanStep::FormatSettings & settings) const override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+private:
+    RuntimeFilterHolderPtr holder;
+    DB::Names probe_keys;
+    void updateOutputStream() override;
+};
+
+class RuntimeFilterTransform : public DB::ISimpleTransform, public IExtraMetricsProvider
+{
+public:
+    RuntimeFilterTransform(const DB::Block & header_, RuntimeFilterHolderPtr holder_, const DB::Names & probe_keys_);
+    ~RuntimeFilterTransform() override = default;
+
+    String getName() const override { return "RuntimeFilterTransform"; }
+    void collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const override;
+
+protected:
+    void transform(DB::Chunk & chunk) override;
+
+private:
+    RuntimeFilterHolderPtr holder;
+    std::vector<size_t> key_positions;
+    size_t filtered_rows = 0;
+};
+}
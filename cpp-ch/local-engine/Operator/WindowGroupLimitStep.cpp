@@ -0,0 +1,297 @@
+#include "WindowGroupLimitStep.h"
+#include <algorithm>
+#include <Core/Defines.h>
+#include <IO/Operators.h>
+#include <QueryPipeline/QueryPipelineBuilder.h>
+#include <magic_enum.hpp>
+
+namespace local_engine
+{
+static DB::ITransformingStep::Traits getTraits()
+{
+    return DB::ITransformingStep::Traits{
+        {
+            .returns_single_stream = false,
+            .preserves_number_of_streams = true,
+            .preserves_sorting = false,
+        },
+        {
+            .preserves_number_of_rows = false,
+        }};
+}
+
+WindowGroupLimitStep::WindowGroupLimitStep(
+    const DB::DataStream & input_stream_,
+    const DB::Names & partition_by_,
+    const DB::SortDescription & order_by_,
+    WindowGroupLimitKind kind_,
+    size_t limit_,
+    size_t max_buffered_rows_)
+    : DB::ITransformingStep(input_stream_, input_stream_.header, getTraits())
+    , partition_by(partition_by_)
+    , order_by(order_by_)
+    , kind(kind_)
+    , limit(limit_)
+    , max_buffered_rows(max_buffered_rows_)
+{
+}
+
+void WindowGroupLimitStep::transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & /*settings*/)
+{
+    /// Every stream keeps its own candidates, their union still contains the candidates of the whole input.
+    pipeline.addSimpleTransform(
+        [&](const DB::Block & header)
+        { return std::make_shared<WindowGroupLimitTransform>(header, partition_by, order_by, kind, limit, max_buffered_rows); });
+}
+
+void WindowGroupLimitStep::describeActions(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    String prefix(settings.offset, settings.indent_char);
+    settings.out << prefix << "Partition by: " << fmt::format("{}", fmt::join(partition_by, ", ")) << '\n';
+    settings.out << prefix << "Order by: " << DB::dumpSortDescription(order_by) << '\n';
+    settings.out << prefix << "Limit: " << magic_enum::enum_name(kind) << " <= " << limit << '\n';
+}
+
+void WindowGroupLimitStep::describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const
+{
+    if (!processors.empty())
+        DB::IQueryPlanStep::describePipeline(processors, settings);
+}
+
+void WindowGroupLimitStep::updateOutputStream()
+{
+    createOutputStream(input_streams.front(), input_streams.front().header, getDataStreamTraits());
+}
+
+WindowGroupLimitTransform::WindowGroupLimitTransform(
+    const DB::Block & header_,
+    const DB::Names & partition_by_,
+    const DB::SortDescription & order_by_,
+    WindowGroupLimitKind kind_,
+    size_t limit_,
+    size_t max_buffered_rows_)
+    : DB::IProcessor({header_}, {header_})
+    , header(header_)
+    , order_by(order_by_)
+    , kind(kind_)
+    , limit(limit_)
+    , max_buffered_rows(max_buffered_rows_)
+{
+    for (const auto & name : partition_by_)
+        partition_positions.emplace_back(header.getPositionByName(name));
+    for (const auto & description : order_by)
+        order_positions.emplace_back(header.getPositionByName(description.column_name));
+}
+
+WindowGroupLimitTransform::Status WindowGroupLimitTransform::prepare()
+{
+    auto & output = outputs.front();
+    auto & input = inputs.front();
+
+    if (output.isFinished())
+    {
+        input.close();
+        return Status::Finished;
+    }
+
+    if (!output.canPush())
+    {
+        input.setNotNeeded();
+        return Status::PortFull;
+    }
+
+    if (!output_chunks.empty())
+    {
+        output.push(std::move(output_chunks.front()));
+        output_chunks.pop_front();
+        return Status::PortFull;
+    }
+
+    if (input_chunk)
+        return Status::Ready;
+
+    if (input.isFinished())
+    {
+        if (!input_finished)
+            return Status::Ready;
+        output.finish();
+        return Status::Finished;
+    }
+
+    input.setNeeded();
+    if (!input.hasData())
+        return Status::NeedData;
+    input_chunk = input.pull(true);
+    return Status::Ready;
+}
+
+void WindowGroupLimitTransform::work()
+{
+    if (input_chunk)
+    {
+        consume(std::move(*input_chunk));
+        input_chunk.reset();
+        if (candidate_rows > max_buffered_rows)
+            flush();
+        else if (buffered_rows > 2 * candidate_rows + DEFAULT_BLOCK_SIZE)
+            compact();
+    }
+    else
+    {
+        input_finished = true;
+        flush();
+    }
+}
+
+void WindowGroupLimitTransform::consume(DB::Chunk chunk)
+{
+    size_t rows = chunk.getNumRows();
+    if (!rows)
+        return;
+    auto chunk_index = static_cast<UInt32>(chunks.size());
+    chunks.emplace_back(chunk.detachColumns());
+    buffered_rows += rows;
+    const auto & columns = chunks.back();
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const char * begin = nullptr;
+        size_t key_size = 0;
+        for (auto position : partition_positions)
+            key_size += columns[position]->serializeValueIntoArena(i, *arena, begin).size;
+        StringRef key(begin, key_size);
+
+        auto it = groups.find(key);
+        if (it == groups.end())
+            it = groups.emplace(key, Group{}).first;
+        else if (key_size)
+            arena->rollback(key_size);
+        insertRow(it->second, RowRef{chunk_index, static_cast<UInt32>(i)});
+    }
+}
+
+void WindowGroupLimitTransform::insertRow(Group & group, RowRef row)
+{
+    /// No row ranks within a zero limit.
+    if (!limit)
+        return;
+
+    if (group.full)
+    {
+        int res = compareRows(row, group.rows.back());
+        /// Rows tied with the last candidate get the same rank, but a greater row number.
+        if (res > 0 || (res == 0 && kind == WindowGroupLimitKind::RowNumber))
+            return;
+    }
+
+    auto it = std::upper_bound(
+        group.rows.begin(), group.rows.end(), row, [this](RowRef lhs, RowRef rhs) { return compareRows(lhs, rhs) < 0; });
+    group.rows.insert(it, row);
+    ++candidate_rows;
+    pruneGroup(group);
+}
+
+void WindowGroupLimitTransform::pruneGroup(Group & group)
+{
+    auto & rows = group.rows;
+    size_t keep = rows.size();
+    switch (kind)
+    {
+        case WindowGroupLimitKind::RowNumber:
+            keep = std::min(rows.size(), limit);
+            group.full = rows.size() >= limit;
+            break;
+        case WindowGroupLimitKind::Rank:
+            if (rows.size() > limit)
+            {
+                /// The rows after the limit-th one are kept only if they are tied with it.
+                keep = limit;
+                while (keep < rows.size() && compareRows(rows[keep], rows[limit - 1]) == 0)
+                    ++keep;
+            }
+            group.full = rows.size() >= limit;
+            break;
+        case WindowGroupLimitKind::DenseRank: {
+            size_t distinct = rows.empty() ? 0 : 1;
+            for (keep = 1; keep < rows.size(); ++keep)
+            {
+                if (compareRows(rows[keep], rows[keep - 1]) != 0 && ++distinct > limit)
+                    break;
+            }
+            keep = std::min(keep, rows.size());
+            group.full = std::min(distinct, limit) == limit;
+            break;
+        }
+    }
+    candidate_rows -= rows.size() - keep;
+    rows.resize(keep);
+}
+
+int WindowGroupLimitTransform::compareRows(RowRef lhs, RowRef rhs) const
+{
+    for (size_t i = 0; i < order_positions.size(); ++i)
+    {
+        const auto & description = order_by[i];
+        const auto & lhs_column = *chunks[lhs.chunk][order_positions[i]];
+        const auto & rhs_column = *chunks[rhs.chunk][order_positions[i]];
+        int res = description.direction * lhs_column.compareAt(lhs.row, rhs.row, rhs_column, description.nulls_direction);
+        if (res)
+            return res;
+    }
+    return 0;
+}
+
+void WindowGroupLimitTransform::compact()
+{
+    auto columns = header.cloneEmptyColumns();
+    for (auto & column : columns)
+        column->reserve(candidate_rows);
+
+    UInt32 row = 0;
+    for (auto & [key, group] : groups)
+    {
+        for (auto & ref : group.rows)
+        {
+            const auto & source = chunks[ref.chunk];
+            for (size_t i = 0; i < columns.size(); ++i)
+                columns[i]->insertFrom(*source[i], ref.row);
+            ref = RowRef{0, row++};
+        }
+    }
+
+    chunks.clear();
+    chunks.emplace_back();
+    for (auto & column : columns)
+        chunks.back().emplace_back(std::move(column));
+    buffered_rows = candidate_rows;
+}
+
+void WindowGroupLimitTransform::flush()
+{
+    auto columns = header.cloneEmptyColumns();
+    size_t rows = 0;
+    for (auto & [key, group] : groups)
+    {
+        for (const auto & ref : group.rows)
+        {
+            const auto & source = chunks[ref.chunk];
+            for (size_t i = 0; i < columns.size(); ++i)
+                columns[i]->insertFrom(*source[i], ref.row);
+            if (++rows == DEFAULT_BLOCK_SIZE)
+            {
+                output_chunks.emplace_back(std::move(columns), rows);
+                columns = header.cloneEmptyColumns();
+                rows = 0;
+            }
+        }
+    }
+    if (rows)
+        output_chunks.emplace_back(std::move(columns), rows);
+
+    groups.clear();
+    chunks.clear();
+    arena = std::make_unique<DB::Arena>();
+    buffered_rows = 0;
+    candidate_rows = 0;
+}
+}
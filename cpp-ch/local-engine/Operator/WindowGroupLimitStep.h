@@ -0,0 +1,114 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <Common/Arena.h>
+#include <Core/SortDescription.h>
+#include <Processors/IProcessor.h>
+#include <Processors/QueryPlan/ITransformingStep.h>
+#include <base/StringRef.h>
+
+namespace local_engine
+{
+enum class WindowGroupLimitKind
+{
+    RowNumber,
+    Rank,
+    DenseRank,
+};
+
+/// Placed before the sorting of a window whose ranking function is filtered by `rank <= limit`. Keeps
+/// only the rows which may get a rank within the limit in their partition, so the sorting and the
+/// window only see about limit rows per partition.
+/// It's a pre-filter, the window and the filter after it are kept and produce the exact result. So once
+/// there are more than max_buffered_rows candidate rows (too many partitions), the candidates are
+/// emitted as they are and the operator starts over, instead of spilling.
+class WindowGroupLimitStep : public DB::ITransformingStep
+{
+public:
+    WindowGroupLimitStep(
+        const DB::DataStream & input_stream_,
+        const DB::Names & partition_by_,
+        const DB::SortDescription & order_by_,
+        WindowGroupLimitKind kind_,
+        size_t limit_,
+        size_t max_buffered_rows_);
+    ~WindowGroupLimitStep() override = default;
+
+    String getName() const override { return "WindowGroupLimitStep"; }
+
+    void transformPipeline(DB::QueryPipelineBuilder & pipeline, const DB::BuildQueryPipelineSettings & settings) override;
+    void describeActions(DB::IQueryPlanStep::FormatSettings & settings) const override;
+    void describePipeline(DB::IQueryPlanStep::FormatSettings & settings) const override;
+
+private:
+    DB::Names partition_by;
+    DB::SortDescription order_by;
+    WindowGroupLimitKind kind;
+    size_t limit;
+    size_t max_buffered_rows;
+    void updateOutputStream() override;
+};
+
+class WindowGroupLimitTransform : public DB::IProcessor
+{
+public:
+    using Status = DB::IProcessor::Status;
+    WindowGroupLimitTransform(
+        const DB::Block & header_,
+        const DB::Names & partition_by_,
+        const DB::SortDescription & order_by_,
+        WindowGroupLimitKind kind_,
+        size_t limit_,
+        size_t max_buffered_rows_);
+    ~WindowGroupLimitTransform() override = default;
+
+    Status prepare() override;
+    void work() override;
+
+    String getName() const override { return "WindowGroupLimitTransform"; }
+
+private:
+    struct RowRef
+    {
+        UInt32 chunk;
+        UInt32 row;
+    };
+
+    /// The candidate rows of a partition, sorted by the order by keys.
+    struct Group
+    {
+        std::vector<RowRef> rows;
+        /// No row ranked after the last one can be a candidate.
+        bool full = false;
+    };
+
+    DB::Block header;
+    std::vector<size_t> partition_positions;
+    std::vector<size_t> order_positions;
+    DB::SortDescription order_by;
+    WindowGroupLimitKind kind;
+    size_t limit;
+    size_t max_buffered_rows;
+
+    std::unique_ptr<DB::Arena> arena = std::make_unique<DB::Arena>();
+    std::unordered_map<StringRef, Group, StringRefHash> groups;
+    /// The input chunks referenced by the candidate rows.
+    std::vector<DB::Columns> chunks;
+    size_t buffered_rows = 0;
+    size_t candidate_rows = 0;
+
+    std::optional<DB::Chunk> input_chunk;
+    std::list<DB::Chunk> output_chunks;
+    bool input_finished = false;
+
+    void consume(DB::Chunk chunk);
+    void insertRow(Group & group, RowRef row);
+    /// Drops the rows ranked after limit and updates group.full.
+    void pruneGroup(Group & group);
+    int compareRows(RowRef lhs, RowRef rhs) const;
+    /// Moves the candidate rows into new columns, dropping the input chunks holding discarded rows.
+    void compact();
+    void flush();
+};
+}
@@ -6,11 +6,15 @@
 #include <DataTypes/DataTypeTuple.h>
 #include <Functions/FunctionFactory.h>
 #include <Functions/FunctionHelpers.h>
+#include <IO/ReadBufferFromString.h>
+#include <IO/ReadHelpers.h>
 #include <Parser/FunctionParser.h>
 #include <Parser/aggregate_function_parser/CommonAggregateFunctionParser.h>
 #include <Processors/QueryPlan/AggregatingStep.h>
 #include <Processors/QueryPlan/ExpressionStep.h>
 #include <Processors/QueryPlan/MergingAggregatedStep.h>
+#include <google/protobuf/wrappers.pb.h>
+#include <Common/HashTableSizeHints.h>
 #include <Common/StringUtils/StringUtils.h>
 
 #include <Operator/EmptyHashAggregate.h>
@@ -48,7 +52,11 @@ DB::QueryPlanPtr AggregateRelParser::parse(DB::QueryPlanPtr query_plan, const su
     LOG_TRACE(logger, "header after pre-projection is: {}", plan->getCurrentDataStream().header.dumpStructure());
     if (has_final_stage)
     {
-        addMergingAggregatedStep();
+        /// The typed partial results are added row by row, the merging of the states can't take them.
+        if (hasTypedIntermediateInput())
+            addAggregatingStep(true);
+        else
+            addMergingAggregatedStep();
         LOG_TRACE(logger, "header after merging is: {}", plan->getCurrentDataStream().header.dumpStructure());
         addPostProjection();
         LOG_TRACE(logger, "header after post-projection is: {}", plan->getCurrentDataStream().header.dumpStructure());
@@ -57,6 +65,8 @@ DB::QueryPlanPtr AggregateRelParser::parse(DB::QueryPlanPtr query_plan, const su
     {
         addAggregatingStep();
         LOG_TRACE(logger, "header after aggregating is: {}", plan->getCurrentDataStream().header.dumpStructure());
+        addIntermediateProjection();
+        LOG_TRACE(logger, "header after intermediate projection is: {}", plan->getCurrentDataStream().header.dumpStructure());
     }
     return std::move(plan);
 }
@@ -118,6 +128,58 @@ void AggregateRelParser::setup(DB::QueryPlanPtr query_plan, const substrait::Rel
     {
         throw DB::Exception(ErrorCodes::BAD_ARGUMENTS, "Unsupport multible groupings");
     }
+    parseGroupingKeysOrdering();
+}
+
+/// The plan carries the ordering of the grouping keys when the input is sorted by all of them, e.g. after
+/// a sort merge join or a sort. The aggregation can then emit each group once the keys change instead of
+/// keeping all the groups in a hash table, see AggregatingInOrderTransform.
+/// The ordering is "AggregateParameters:groupingKeysOrdering=<key index>:<sort direction>,...".
+void AggregateRelParser::parseGroupingKeysOrdering()
+{
+    if (grouping_keys.empty() || !aggregate_rel->has_advanced_extension() || !aggregate_rel->advanced_extension().has_optimization())
+        return;
+    if (!getContext()->getConfigRef().getBool("streaming_aggregation.enabled", true))
+        return;
+
+    google::protobuf::StringValue optimization;
+    optimization.ParseFromString(aggregate_rel->advanced_extension().optimization().value());
+    ReadBufferFromString in(optimization.value());
+    if (!checkString("AggregateParameters:", in))
+        return;
+    /// Same as the sort directions of SortRelParser.
+    static const std::map<int, std::pair<int, int>> direction_map = {{1, {1, -1}}, {2, {1, 1}}, {3, {-1, 1}}, {4, {-1, -1}}};
+    SortDescription description;
+    while (!in.eof())
+    {
+        String key;
+        readStringUntilEquals(key, in);
+        assertChar('=', in);
+        if (key != "groupingKeysOrdering")
+        {
+            String value;
+            readString(value, in);
+        }
+        else
+        {
+            do
+            {
+                size_t index;
+                int direction;
+                readIntText(index, in);
+                assertChar(':', in);
+                readIntText(direction, in);
+                auto it = direction_map.find(direction);
+                if (index >= grouping_keys.size() || it == direction_map.end())
+                    throw Exception(ErrorCodes::BAD_ARGUMENTS, "Invalid grouping keys ordering: {}", optimization.value());
+                description.emplace_back(grouping_keys[index], it->second.first, it->second.second);
+            } while (checkChar(',', in));
+        }
+        if (!in.eof())
+            assertChar('\n', in);
+    }
+    if (description.size() == grouping_keys.size())
+        group_by_sort_description = std::move(description);
 }
 
 /// Projections for function arguments.
@@ -164,6 +226,7 @@ void AggregateRelParser::buildAggregateDescriptions(AggregateDescriptions & desc
         AggregateDescription description;
         const auto & measure = agg_info.measure->measure();
         description.column_name = build_result_column_name(agg_info.function_name, agg_info.arg_column_names, measure.phase());
+        agg_info.result_column_name = description.column_name;
         description.argument_names = agg_info.arg_column_names;
         // May apply `PartialMerge` and `If` on the original function.
         auto [combinator_function_name, combinator_function_arg_types]
@@ -175,12 +238,25 @@ void AggregateRelParser::buildAggregateDescriptions(AggregateDescriptions & desc
     }
 }
 
+bool AggregateRelParser::hasTypedIntermediateInput() const
+{
+    for (const auto & agg_info : aggregates)
+    {
+        if (agg_info.arg_column_types.size() == 1 && !typeid_cast<const DataTypeAggregateFunction *>(agg_info.arg_column_types[0].get())
+            && !BaseAggregateFunctionParser::getTypedIntermediateMergeFunction(agg_info.function_name).empty())
+            return true;
+    }
+    return false;
+}
+
 void AggregateRelParser::addMergingAggregatedStep()
 {
     AggregateDescriptions aggregate_descriptions;
     buildAggregateDescriptions(aggregate_descriptions);
     auto settings = getContext()->getSettingsRef();
     Aggregator::Params params(grouping_keys, aggregate_descriptions, false, settings.max_threads, settings.max_block_size);
+    /// Merging the states doesn't presize its tables, the sizes are only recorded.
+    auto size_recorder = createHashTableSizeRecorder(0);
     auto merging_step = std::make_unique<DB::MergingAggregatedStep>(
         plan->getCurrentDataStream(),
         params,
@@ -195,13 +271,27 @@ void AggregateRelParser::addMergingAggregatedStep()
         settings.enable_memory_bound_merging_of_aggregation_results);
     steps.emplace_back(merging_step.get());
     plan->addStep(std::move(merging_step));
+    addHashTableSizeStep(size_recorder);
 }
 
-void AggregateRelParser::addAggregatingStep()
+void AggregateRelParser::addAggregatingStep(bool final)
 {
     AggregateDescriptions aggregate_descriptions;
     buildAggregateDescriptions(aggregate_descriptions);
     auto settings = getContext()->getSettingsRef();
+    /// No hash table is built when aggregating in order.
+    HashTableSizeRecorderPtr size_recorder;
+    if (group_by_sort_description.empty())
+        size_recorder = createHashTableSizeRecorder(settings.max_size_to_preallocate_for_aggregation);
+    /// The aggregator presizes its tables from the sizes it recorded for the same key, and starts with two level
+    /// tables if they were converted. Keyed by the plan fingerprint, the statistics are shared by the tasks of
+    /// the stage instead of the queries with the same AST.
+    auto stats_collecting_params = size_recorder
+        ? Aggregator::Params::StatsCollectingParams(
+            nullptr, false, settings.max_entries_for_hash_table_stats, settings.max_size_to_preallocate_for_aggregation)
+        : Aggregator::Params::StatsCollectingParams();
+    if (size_recorder)
+        stats_collecting_params.key = size_recorder->getKey();
     Aggregator::Params params(
         grouping_keys,
         aggregate_descriptions,
@@ -219,26 +309,80 @@ void AggregateRelParser::addAggregatingStep()
         3,
         settings.max_block_size,
         false,
-        false);
+        false,
+        stats_collecting_params);
 
     auto aggregating_step = std::make_unique<AggregatingStep>(
         plan->getCurrentDataStream(),
         params,
         GroupingSetsParamsList(),
-        false,
+        final,
         settings.max_block_size,
         settings.aggregation_in_order_max_block_bytes,
         1,
         1,
         false,
         false,
-        SortDescription(),
-        SortDescription(),
+        group_by_sort_description,
+        group_by_sort_description,
         false,
         false,
         false);
+    if (!group_by_sort_description.empty())
+        aggregating_step->setStepDescription("Aggregating in order");
     steps.emplace_back(aggregating_step.get());
     plan->addStep(std::move(aggregating_step));
+    addHashTableSizeStep(size_recorder);
+}
+
+HashTableSizeRecorderPtr AggregateRelParser::createHashTableSizeRecorder(size_t max_reserved)
+{
+    auto context = getContext();
+    if (!context->getConfigRef().getBool("hash_table_size_hints.enabled", true))
+        return nullptr;
+    auto & hints = HashTableSizeHints::instance();
+    hints.setMaxEntries(context->getSettingsRef().max_entries_for_hash_table_stats);
+    substrait::AggregateRel rel_without_input = *aggregate_rel;
+    rel_without_input.clear_input();
+    auto key = HashTableSizeHints::fingerprint(rel_without_input, plan->getCurrentDataStream().header);
+    auto hint = hints.get(key);
+    /// The aggregator doesn't presize its tables at all for hints above max_size_to_preallocate_for_aggregation.
+    return std::make_shared<HashTableSizeRecorder>(key, hint, hint && *hint <= max_reserved ? *hint : 0);
+}
+
+void AggregateRelParser::addHashTableSizeStep(HashTableSizeRecorderPtr recorder)
+{
+    if (!recorder)
+        return;
+    auto size_step = std::make_unique<HashTableSizeStep>(plan->getCurrentDataStream(), recorder);
+    size_step->setStepDescription("Hash table size");
+    /// Not in steps, the metrics updaters of the jvm expect the steps of the aggregation by position.
+    plan->addStep(std::move(size_step));
+}
+
+/// The functions with typed intermediate results send their partial results to the next stage instead of the
+/// states, see BaseAggregateFunctionParser::getTypedIntermediateMergeFunction. The column names are kept.
+void AggregateRelParser::addIntermediateProjection()
+{
+    auto input_header = plan->getCurrentDataStream().header;
+    ActionsDAGPtr project_actions_dag = std::make_shared<ActionsDAG>(input_header.getColumnsWithTypeAndName());
+    bool has_typed_result = false;
+    for (const auto & agg_info : aggregates)
+    {
+        if (BaseAggregateFunctionParser::getTypedIntermediateMergeFunction(agg_info.function_name).empty())
+            continue;
+        const auto * state_node = project_actions_dag->getInputs()[input_header.getPositionByName(agg_info.result_column_name)];
+        const auto * result_node = buildFunctionNode(project_actions_dag, "finalizeAggregation", {state_node});
+        project_actions_dag->addOrReplaceInOutputs(project_actions_dag->addAlias(*result_node, agg_info.result_column_name));
+        has_typed_result = true;
+    }
+    if (has_typed_result)
+    {
+        QueryPlanStepPtr finalize_step = std::make_unique<ExpressionStep>(plan->getCurrentDataStream(), project_actions_dag);
+        finalize_step->setStepDescription("Typed intermediate results");
+        /// Not in steps, the metrics updaters of the jvm expect the steps of the aggregation by position.
+        plan->addStep(std::move(finalize_step));
+    }
 }
 
 // Only be called in final stage.
@@ -1,4 +1,6 @@
 #pragma once
+#include <Core/SortDescription.h>
+#include <Operator/HashTableSizeStep.h>
 #include <Parser/FunctionParser.h>
 #include <Parser/RelParser.h>
 #include <Poco/Logger.h>
@@ -24,6 +26,7 @@ private:
         String function_name;
         // If no combinator be applied on it, same as function_name
         String combinator_function_name;
+        String result_column_name;
         // For avoiding repeated builds.
         FunctionParser::CommonFunctionInfo parser_func_info;
         // For avoiding repeated builds.
@@ -39,11 +42,19 @@ private:
     const substrait::AggregateRel * aggregate_rel = nullptr;
     std::vector<AggregateInfo> aggregates;
     Names grouping_keys;
+    /// Not empty if the input is sorted by all the grouping keys.
+    DB::SortDescription group_by_sort_description;
 
     void setup(DB::QueryPlanPtr query_plan, const substrait::Rel & rel);
+    void parseGroupingKeysOrdering();
     void addPreProjection();
+    bool hasTypedIntermediateInput() const;
     void addMergingAggregatedStep();
-    void addAggregatingStep();
+    void addAggregatingStep(bool final = false);
+    void addIntermediateProjection();
+    /// Null if the size hints are disabled. The reserved rows are the hint up to max_reserved.
+    HashTableSizeRecorderPtr createHashTableSizeRecorder(size_t max_reserved);
+    void addHashTableSizeStep(HashTableSizeRecorderPtr recorder);
     void addPostProjection();
 
     void buildAggregateDescriptions(AggregateDescriptions & descriptions);
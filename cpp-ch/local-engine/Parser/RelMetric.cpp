@@ -1,6 +1,7 @@
 #include <Processors/IProcessor.h>
 #include "RelMetric.h"
 #include <Processors/QueryPlan/AggregatingStep.h>
+#include <Processors/QueryPlan/ReadFromMergeTree.h>
 
 using namespace rapidjson;
 
@@ -14,6 +15,18 @@ RelMetric::RelMetric(String name_, const std::vector<RelMetricPtr> & inputs_, st
     auto rel = std::max_element(inputs.begin(), inputs.end(), [](RelMetricPtr a, RelMetricPtr b) {return a->id < b->id;});
     id = rel->get()->id + 1;
 }
+/// The granules of a merge tree read selected by the primary key and the skip indexes.
+static void collectMergeTreeReadMetrics(const DB::ReadFromMergeTree & read_step, std::map<String, UInt64> & extra_metrics)
+{
+    auto analysis = read_step.getAnalyzedResult();
+    if (!analysis || analysis->error())
+        return;
+    const auto & result = std::get<DB::ReadFromMergeTree::AnalysisResult>(analysis->result);
+    extra_metrics["total_marks"] = result.total_marks_pk;
+    extra_metrics["selected_marks"] = result.selected_marks;
+    extra_metrics["skipped_marks"] = result.total_marks_pk > result.selected_marks ? result.total_marks_pk - result.selected_marks : 0;
+}
+
 size_t RelMetric::getId() const
 {
     return id;
@@ -89,9 +102,35 @@ void RelMetric::serialize(Writer<StringBuffer> & writer, bool) const
                 writer.Uint64(processor->getProcessorDataStats().input_rows);
                 writer.Key("input_bytes");
                 writer.Uint64(processor->getProcessorDataStats().input_bytes);
+                if (const auto * provider = dynamic_cast<const IExtraMetricsProvider *>(processor.get()))
+                {
+                    std::map<String, UInt64> extra_metrics;
+                    provider->collectExtraMetrics(extra_metrics);
+                    writer.Key("extra_metrics");
+                    writer.StartObject();
+                    for (const auto & [key, value] : extra_metrics)
+                    {
+                        writer.Key(key.c_str());
+                        writer.Uint64(value);
+                    }
+                    writer.EndObject();
+                }
                 writer.EndObject();
             }
             writer.EndArray();
+            if (const auto * read_step = dynamic_cast<const DB::ReadFromMergeTree *>(step))
+            {
+                std::map<String, UInt64> extra_metrics;
+                collectMergeTreeReadMetrics(*read_step, extra_metrics);
+                writer.Key("extra_metrics");
+                writer.StartObject();
+                for (const auto & [key, value] : extra_metrics)
+                {
+                    writer.Key(key.c_str());
+                    writer.Uint64(value);
+                }
+                writer.EndObject();
+            }
             writer.EndObject();
         }
         writer.EndArray();
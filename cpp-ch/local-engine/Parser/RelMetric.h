@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <Processors/QueryPlan/IQueryPlanStep.h>
 #include <rapidjson/prettywriter.h>
 
@@ -18,6 +19,15 @@ struct RelMetricTimes
     size_t output_wait_elapsed_us;
 };
 
+/// Processors which collect counters besides the common processor statistics, e.g. the rows dropped
+/// by a runtime filter, implement this interface. The counters are serialized as "extra_metrics".
+class IExtraMetricsProvider
+{
+public:
+    virtual ~IExtraMetricsProvider() = default;
+    virtual void collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const = 0;
+};
+
 class RelMetric
 {
 public:
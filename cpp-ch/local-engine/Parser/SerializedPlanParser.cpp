@@ -17,6 +17,7 @@
 #include <DataTypes/DataTypeDateTime64.h>
 #include <DataTypes/DataTypeFactory.h>
 #include <DataTypes/DataTypeFixedString.h>
+#include <DataTypes/DataTypeLowCardinality.h>
 #include <DataTypes/DataTypeMap.h>
 #include <DataTypes/DataTypeNothing.h>
 #include <DataTypes/DataTypeNullable.h>
@@ -35,12 +36,16 @@
 #include <Interpreters/ActionsDAG.h>
 #include <Interpreters/ActionsVisitor.h>
 #include <Interpreters/CollectJoinOnKeysVisitor.h>
+#include <Interpreters/FullSortingMergeJoin.h>
 #include <Interpreters/Context.h>
 #include <Interpreters/HashJoin.h>
 #include <Interpreters/ProcessList.h>
 #include <Interpreters/QueryPriorities.h>
 #include <Operator/BlocksBufferPoolTransform.h>
+#include <Operator/HashTableSizeStep.h>
+#include <Operator/JoinResidualFilterStep.h>
 #include <Operator/PartitionColumnFillingTransform.h>
+#include <Operator/RuntimeFilterStep.h>
 #include <Parser/FunctionParser.h>
 #include <Parser/RelParser.h>
 #include <Parser/aggregate_function_parser/CommonAggregateFunctionParser.h>
@@ -58,6 +63,7 @@
 #include <Processors/QueryPlan/MergingAggregatedStep.h>
 #include <Processors/QueryPlan/Optimizations/QueryPlanOptimizationSettings.h>
 #include <Processors/QueryPlan/QueryPlan.h>
+#include <Processors/QueryPlan/ReadFromMergeTree.h>
 #include <Processors/QueryPlan/ReadFromPreparedSource.h>
 #include <Processors/QueryPlan/SortingStep.h>
 #include <Processors/Transforms/AggregatingTransform.h>
@@ -69,6 +75,7 @@
 #include <Storages/StorageMergeTreeFactory.h>
 #include <Storages/SubstraitSource/SubstraitFileSource.h>
 #include <base/Decimal.h>
+#include <base/scope_guard.h>
 #include <base/types.h>
 #include <google/protobuf/util/json_util.h>
 #include <google/protobuf/wrappers.pb.h>
@@ -78,6 +85,7 @@
 #include <Common/CHUtil.h>
 #include <Common/DebugUtils.h>
 #include <Common/Exception.h>
+#include <Common/HashTableSizeHints.h>
 #include <Common/JoinHelper.h>
 #include <Common/MergeTreeTool.h>
 #include <Common/StringUtils.h>
@@ -135,6 +143,8 @@ std::shared_ptr<DB::ActionsDAG> SerializedPlanParser::expressionsToActionsDAG(
     auto actions_dag = std::make_shared<ActionsDAG>(blockToNameAndTypeList(header));
     NamesWithAliases required_columns;
     std::set<String> distinct_columns;
+    beginExpressionReuse(actions_dag);
+    SCOPE_EXIT({ endExpressionReuse(); });
 
     for (const auto & expr : expressions)
     {
@@ -240,15 +250,145 @@ bool SerializedPlanParser::isReadRelFromJava(const substrait::ReadRel & rel)
     return rel.local_files().items().size() == 1 && rel.local_files().items().at(0).uri_file().starts_with("iterator");
 }
 
-QueryPlanStepPtr SerializedPlanParser::parseReadRealWithLocalFile(const substrait::ReadRel & rel)
+/// Reads the string columns of parquet files as LowCardinality, so the filter above the scan is evaluated once per
+/// dictionary value for the dictionary encoded columns. The partition columns are not read from the files.
+static Block toLowCardinalityStrings(const Block & header, const substrait::ReadRel::LocalFiles & local_files)
+{
+    std::set<String> partition_columns;
+    for (const auto & item : local_files.items())
+    {
+        if (!item.has_parquet())
+            return header;
+        for (const auto & part : StringUtils::parsePartitionTablePath(item.uri_file()))
+            partition_columns.insert(part.first);
+    }
+
+    ColumnsWithTypeAndName columns;
+    for (const auto & column : header)
+    {
+        if (!partition_columns.contains(column.name) && isString(removeNullable(column.type)))
+            columns.emplace_back(std::make_shared<DataTypeLowCardinality>(column.type), column.name);
+        else
+            columns.emplace_back(column);
+    }
+    return Block(std::move(columns));
+}
+
+static bool isDeterministicNode(const ActionsDAG::Node * node)
+{
+    if (node->type == ActionsDAG::ActionType::FUNCTION && !node->function_base->isDeterministic())
+        return false;
+    return std::all_of(node->children.begin(), node->children.end(), isDeterministicNode);
+}
+
+/// Whether expr only references the columns at positions, and at least one of them.
+static bool referencesOnlyColumns(const substrait::Expression & expr, const std::set<Int32> & positions, bool & has_reference)
+{
+    switch (expr.rex_type_case())
+    {
+        case substrait::Expression::RexTypeCase::kLiteral:
+            return true;
+        case substrait::Expression::RexTypeCase::kSelection:
+            if (!expr.selection().has_direct_reference() || !expr.selection().direct_reference().has_struct_field()
+                || expr.selection().direct_reference().struct_field().has_child())
+                return false;
+            has_reference = true;
+            return positions.contains(expr.selection().direct_reference().struct_field().field());
+        case substrait::Expression::RexTypeCase::kScalarFunction:
+            return std::all_of(
+                expr.scalar_function().arguments().begin(),
+                expr.scalar_function().arguments().end(),
+                [&](const auto & arg) { return referencesOnlyColumns(arg.value(), positions, has_reference); });
+        case substrait::Expression::RexTypeCase::kCast:
+            return referencesOnlyColumns(expr.cast().input(), positions, has_reference);
+        case substrait::Expression::RexTypeCase::kIfThen:
+            for (const auto & if_clause : expr.if_then().ifs())
+            {
+                if (!referencesOnlyColumns(if_clause.if_(), positions, has_reference)
+                    || !referencesOnlyColumns(if_clause.then(), positions, has_reference))
+                    return false;
+            }
+            return referencesOnlyColumns(expr.if_then().else_(), positions, has_reference);
+        case substrait::Expression::RexTypeCase::kSingularOrList:
+            return referencesOnlyColumns(expr.singular_or_list().value(), positions, has_reference)
+                && std::all_of(
+                       expr.singular_or_list().options().begin(),
+                       expr.singular_or_list().options().end(),
+                       [&](const auto & option) { return referencesOnlyColumns(option, positions, has_reference); });
+        default:
+            return false;
+    }
+}
+
+void SerializedPlanParser::collectPartitionConjuncts(
+    const substrait::Expression & condition, const std::set<Int32> & partition_positions, std::vector<const substrait::Expression *> & conjuncts)
+{
+    if (!condition.has_scalar_function())
+        return;
+    const auto & scalar_function = condition.scalar_function();
+    auto function_signature = function_mapping.at(std::to_string(scalar_function.function_reference()));
+    if (getFunctionName(function_signature, scalar_function) == "and")
+    {
+        for (const auto & arg : scalar_function.arguments())
+            collectPartitionConjuncts(arg.value(), partition_positions, conjuncts);
+        return;
+    }
+
+    bool has_reference = false;
+    if (referencesOnlyColumns(condition, partition_positions, has_reference) && has_reference)
+        conjuncts.emplace_back(&condition);
+}
+
+void SerializedPlanParser::addPartitionFilter(SubstraitFileSource & source, const Block & header, const substrait::Expression & condition)
+{
+    std::set<Int32> partition_positions;
+    for (const auto & key : source.getPartitionKeys())
+    {
+        /// The conjuncts on the partition columns whose values can't be parsed are left to the filter above.
+        if (header.has(key) && FileReaderWrapper::isSupportedPartitionType(header.getByName(key).type))
+            partition_positions.insert(static_cast<Int32>(header.getPositionByName(key)));
+    }
+    if (partition_positions.empty())
+        return;
+
+    std::vector<const substrait::Expression *> conjuncts;
+    collectPartitionConjuncts(condition, partition_positions, conjuncts);
+    if (conjuncts.empty())
+        return;
+
+    auto actions_dag = std::make_shared<ActionsDAG>(blockToNameAndTypeList(header));
+    Names filter_columns;
+    for (const auto * conjunct : conjuncts)
+    {
+        String filter_name;
+        parseFunction(header, *conjunct, filter_name, actions_dag, true);
+        filter_columns.emplace_back(filter_name);
+    }
+    actions_dag->removeUnusedActions(filter_columns);
+    /// The partition filter is evaluated once per partition, not per row.
+    for (const auto * output : actions_dag->getOutputs())
+    {
+        if (!isDeterministicNode(output))
+            return;
+    }
+    source.setPartitionFilter(std::make_shared<ExpressionActions>(actions_dag), filter_columns);
+}
+
+QueryPlanStepPtr SerializedPlanParser::parseReadRealWithLocalFile(
+    const substrait::ReadRel & rel, bool low_cardinality_strings, const substrait::Expression * filter)
 {
     assert(rel.has_local_files());
     assert(rel.has_base_schema());
     auto header = TypeParser::buildBlockFromNamedStruct(rel.base_schema());
+    if (low_cardinality_strings)
+        header = toLowCardinalityStrings(header, rel.local_files());
     auto source = std::make_shared<SubstraitFileSource>(context, header, rel.local_files());
+    if (filter)
+        addPartitionFilter(*source, header, *filter);
     auto source_pipe = Pipe(source);
     auto source_step = std::make_unique<ReadFromStorageStep>(std::move(source_pipe), "substrait local files", nullptr);
     source_step->setStepDescription("read local files");
+    file_sources[source_step.get()] = source;
     return source_step;
 }
 
@@ -267,6 +407,31 @@ QueryPlanStepPtr SerializedPlanParser::parseReadRealWithJavaIter(const substrait
     return source_step;
 }
 
+IQueryPlanStep * SerializedPlanParser::addMaterializeLowCardinalityStep(QueryPlan & plan)
+{
+    const auto & header = plan.getCurrentDataStream().header;
+    auto full_columns = header.getColumnsWithTypeAndName();
+    bool has_low_cardinality = false;
+    for (auto & column : full_columns)
+    {
+        if (column.type->lowCardinality())
+        {
+            column.type = recursiveRemoveLowCardinality(column.type);
+            column.column = nullptr;
+            has_low_cardinality = true;
+        }
+    }
+    if (!has_low_cardinality)
+        return nullptr;
+    auto materialize_actions_dag
+        = ActionsDAG::makeConvertingActions(header.getColumnsWithTypeAndName(), full_columns, ActionsDAG::MatchColumnsMode::Position);
+    auto expression_step = std::make_unique<ExpressionStep>(plan.getCurrentDataStream(), materialize_actions_dag);
+    expression_step->setStepDescription("Materialize LowCardinality");
+    auto * step_ptr = expression_step.get();
+    plan.addStep(std::move(expression_step));
+    return step_ptr;
+}
+
 IQueryPlanStep * SerializedPlanParser::addRemoveNullableStep(QueryPlan & plan, std::vector<String> columns)
 {
     if (columns.empty())
@@ -307,8 +472,20 @@ DB::QueryPlanPtr SerializedPlanParser::parseMergeTreeTable(const substrait::Read
         LOG_DEBUG(&Poco::Logger::get("SerializedPlanParser"), "Try to read ({}) instead of empty header", header.dumpNames());
     }
     auto names_and_types_list = header.getNamesAndTypesList();
+    auto storage_columns = names_and_types_list;
+    if (!merge_tree_table.order_by_key.empty() || !merge_tree_table.skip_indexes.empty())
+    {
+        /// The keys and indexes may refer to columns which are not read, they are taken from the parts.
+        auto all_parts_dir = MergeTreeUtil::getAllMergeTreeParts(std::filesystem::path("/") / merge_tree_table.relative_path);
+        if (!all_parts_dir.empty())
+        {
+            for (const auto & column : MergeTreeUtil::getSchemaFromMergeTreePart(all_parts_dir[0]))
+                if (!header.has(column.name))
+                    storage_columns.push_back(column);
+        }
+    }
     auto storage_factory = StorageMergeTreeFactory::instance();
-    auto metadata = buildMetaData(names_and_types_list, context);
+    auto metadata = buildMetaData(storage_columns, context, merge_tree_table);
     query_context.metadata = metadata;
     auto storage = storage_factory.getStorage(
         StorageID(merge_tree_table.database, merge_tree_table.table),
@@ -351,6 +528,23 @@ DB::QueryPlanPtr SerializedPlanParser::parseMergeTreeTable(const substrait::Read
     {
         throw Exception(ErrorCodes::NO_SUCH_DATA_PART, "part {} to {} not found.", min_block, max_block);
     }
+    /// Select the granules by the primary key and the skip indexes once, the result is kept by the read step
+    /// and reported in the metrics.
+    auto analysis_result = ReadFromMergeTree::selectRangesToRead(
+        selected_parts,
+        /* alter_conversions = */ {},
+        query_info->prewhere_info,
+        /* added_filter_nodes = */ {},
+        metadata,
+        metadata,
+        *query_info,
+        context,
+        1,
+        /* max_block_numbers_to_read = */ nullptr,
+        *query_context.custom_storage_merge_tree,
+        names_and_types_list.getNames(),
+        false,
+        &Poco::Logger::get("SerializedPlanParser"));
     auto read_step = query_context.custom_storage_merge_tree->reader.readFromParts(
         selected_parts,
         /* alter_conversions = */ {},
@@ -359,7 +553,9 @@ DB::QueryPlanPtr SerializedPlanParser::parseMergeTreeTable(const substrait::Read
         *query_info,
         context,
         4096 * 2,
-        1);
+        1,
+        /* max_block_numbers_to_read = */ nullptr,
+        analysis_result);
     QueryPlanPtr query = std::make_unique<QueryPlan>();
     steps.emplace_back(read_step.get());
     query->addStep(std::move(read_step));
@@ -536,22 +732,30 @@ QueryPlanPtr SerializedPlanParser::parseOp(const substrait::Rel & rel, std::list
             rel_stack.pop_back();
             std::string filter_name;
 
-            ActionsDAGPtr actions_dag = nullptr;
+            const auto & header = query_plan->getCurrentDataStream().header;
+            auto actions_dag = std::make_shared<ActionsDAG>(blockToNameAndTypeList(header));
+            beginExpressionReuse(actions_dag);
+            SCOPE_EXIT({ endExpressionReuse(); });
             if (filter.condition().has_scalar_function())
             {
-                actions_dag = parseFunction(
-                    query_plan->getCurrentDataStream().header, filter.condition(), filter_name, nullptr, true);
+                parseFunction(header, filter.condition(), filter_name, actions_dag, true);
             }
             else
             {
-                actions_dag = std::make_shared<ActionsDAG>(blockToNameAndTypeList(query_plan->getCurrentDataStream().header));
                 const auto * node = parseExpression(actions_dag, filter.condition());
                 filter_name = node->result_name;
             }
 
-            auto input = query_plan->getCurrentDataStream().header.getNames();
+            auto input = header.getNames();
             Names input_with_condition(input);
             input_with_condition.emplace_back(filter_name);
+            /// The project above can read the sub-expressions it shares with the filter instead of evaluating
+            /// them again.
+            if (!rel_stack.empty() && rel_stack.back()->has_project())
+            {
+                for (const auto & expr : rel_stack.back()->project().expressions())
+                    exposeFilterExpressions(*actions_dag, expr, header, filter_name, input_with_condition);
+            }
             actions_dag->removeUnusedActions(input_with_condition);
             NonNullableColumnsResolver non_nullable_columns_resolver(query_plan->getCurrentDataStream().header, *this, filter.condition());
             auto non_nullable_columns = non_nullable_columns_resolver.resolve();
@@ -559,6 +763,9 @@ QueryPlanPtr SerializedPlanParser::parseOp(const substrait::Rel & rel, std::list
             filter_step->setStepDescription("WHERE");
             steps.emplace_back(filter_step.get());
             query_plan->addStep(std::move(filter_step));
+            // LowCardinality strings of the scan are only kept for the filter, the other operators get full columns.
+            if (auto * materialize_step = addMaterializeLowCardinalityStep(*query_plan))
+                steps.emplace_back(materialize_step);
             // remove nullable
             auto * remove_null_step = addRemoveNullableStep(*query_plan, non_nullable_columns);
             if (remove_null_step)
@@ -613,7 +820,10 @@ QueryPlanPtr SerializedPlanParser::parseOp(const substrait::Rel & rel, std::list
                 }
                 else
                 {
-                    step = parseReadRealWithLocalFile(read);
+                    const substrait::Expression * filter
+                        = !rel_stack.empty() && rel_stack.back()->has_filter() ? &rel_stack.back()->filter().condition() : nullptr;
+                    bool low_cardinality_strings = filter && context->getConfigRef().getBool("low_cardinality_scan.enabled", false);
+                    step = parseReadRealWithLocalFile(read, low_cardinality_strings, filter);
                 }
                 steps.emplace_back(step.get());
                 query_plan->addStep(std::move(step));
@@ -1047,6 +1257,15 @@ const ActionsDAG::Node * SerializedPlanParser::parseFunctionWithDAG(
     if (!rel.has_scalar_function())
         throw Exception(ErrorCodes::BAD_ARGUMENTS, "the root of expression should be a scalar function:\n {}", rel.DebugString());
 
+    String reuse_key;
+    if (const auto * reused_node = findReusableExpression(actions_dag, rel, reuse_key))
+    {
+        if (keep_result)
+            actions_dag->addOrReplaceInOutputs(*reused_node);
+        result_name = reused_node->result_name;
+        return reused_node;
+    }
+
     const auto & scalar_function = rel.scalar_function();
     auto function_signature = function_mapping.at(std::to_string(scalar_function.function_reference()));
 
@@ -1063,6 +1282,7 @@ const ActionsDAG::Node * SerializedPlanParser::parseFunctionWithDAG(
             actions_dag->addOrReplaceInOutputs(*result_node);
 
         result_name = result_node->result_name;
+        addReusableExpression(reuse_key, result_node);
         return result_node;
     }
 
@@ -1155,6 +1375,7 @@ const ActionsDAG::Node * SerializedPlanParser::parseFunctionWithDAG(
         if (keep_result)
             actions_dag->addOrReplaceInOutputs(*result_node);
     }
+    addReusableExpression(reuse_key, result_node);
     return result_node;
 }
 
@@ -1358,8 +1579,7 @@ const DB::ActionsDAG::Node * SerializedPlanParser::parseFunctionArgument(
     {
         std::string arg_name;
         bool keep_arg = FUNCTION_NEED_KEEP_ARGUMENTS.contains(function_name);
-        parseFunctionWithDAG(arg.value(), arg_name, actions_dag, keep_arg);
-        res = &actions_dag->getNodes().back();
+        res = parseFunctionWithDAG(arg.value(), arg_name, actions_dag, keep_arg);
     }
     else
     {
@@ -1702,6 +1922,16 @@ const ActionsDAG::Node * SerializedPlanParser::parseExpression(ActionsDAGPtr act
         return &actions_dag->addColumn(ColumnWithTypeAndName(type->createColumnConst(1, field), type, getUniqueName(toString(field))));
     };
 
+    String reuse_key;
+    if (rel.has_cast() || rel.has_if_then() || rel.has_singular_or_list())
+    {
+        if (const auto * reused_node = findReusableExpression(actions_dag, rel, reuse_key))
+        {
+            actions_dag->addOrReplaceInOutputs(*reused_node);
+            return reused_node;
+        }
+    }
+
     switch (rel.rex_type_case())
     {
         case substrait::Expression::RexTypeCase::kLiteral: {
@@ -1742,6 +1972,7 @@ const ActionsDAG::Node * SerializedPlanParser::parseExpression(ActionsDAGPtr act
             }
 
             actions_dag->addOrReplaceInOutputs(*function_node);
+            addReusableExpression(reuse_key, function_node);
             return function_node;
         }
 
@@ -1767,6 +1998,7 @@ const ActionsDAG::Node * SerializedPlanParser::parseExpression(ActionsDAGPtr act
             auto result_name = "multiIf(" + args_name + ")";
             const auto * function_node = &actions_dag->addFunction(function_multi_if, args, result_name);
             actions_dag->addOrReplaceInOutputs(*function_node);
+            addReusableExpression(reuse_key, function_node);
             return function_node;
         }
 
@@ -1848,6 +2080,7 @@ const ActionsDAG::Node * SerializedPlanParser::parseExpression(ActionsDAGPtr act
                 auto cast = FunctionFactory::instance().get("if", context);
                 function_node = toFunctionNode(actions_dag, "if", cast_args);
             }
+            addReusableExpression(reuse_key, function_node);
             return function_node;
         }
 
@@ -1860,6 +2093,88 @@ const ActionsDAG::Node * SerializedPlanParser::parseExpression(ActionsDAGPtr act
     }
 }
 
+
+void SerializedPlanParser::beginExpressionReuse(const ActionsDAGPtr & actions_dag)
+{
+    reusable_dag = actions_dag.get();
+    reusable_nodes.clear();
+    for (const auto & [key, column_name] : filter_expressions)
+    {
+        if (const auto * node = actions_dag->tryFindInOutputs(column_name))
+            reusable_nodes.emplace(key, node);
+    }
+    filter_expressions.clear();
+}
+
+void SerializedPlanParser::endExpressionReuse()
+{
+    reusable_dag = nullptr;
+    reusable_nodes.clear();
+}
+
+const ActionsDAG::Node *
+SerializedPlanParser::findReusableExpression(const ActionsDAGPtr & actions_dag, const substrait::Expression & rel, String & key)
+{
+    if (!reusable_dag || actions_dag.get() != reusable_dag)
+        return nullptr;
+    key = rel.SerializeAsString();
+    auto it = reusable_nodes.find(key);
+    return it == reusable_nodes.end() ? nullptr : it->second;
+}
+
+void SerializedPlanParser::addReusableExpression(const String & key, const ActionsDAG::Node * node)
+{
+    /// Non-deterministic expressions like rand() must be evaluated once per occurrence.
+    if (!key.empty() && isDeterministicNode(node))
+        reusable_nodes.emplace(key, node);
+}
+
+void SerializedPlanParser::exposeFilterExpressions(
+    ActionsDAG & actions_dag, const substrait::Expression & expr, const Block & header, const String & filter_name, Names & outputs)
+{
+    if (!expr.has_scalar_function() && !expr.has_cast() && !expr.has_if_then() && !expr.has_singular_or_list())
+        return;
+
+    auto key = expr.SerializeAsString();
+    auto it = reusable_nodes.find(key);
+    if (it != reusable_nodes.end())
+    {
+        /// The filter column is removed by the filter step.
+        const auto * node = it->second;
+        if (node->type == ActionsDAG::ActionType::FUNCTION && node->result_name != filter_name && !header.has(node->result_name)
+            && filter_expressions.emplace(key, node->result_name).second)
+        {
+            actions_dag.addOrReplaceInOutputs(*node);
+            outputs.emplace_back(node->result_name);
+        }
+        return;
+    }
+
+    switch (expr.rex_type_case())
+    {
+        case substrait::Expression::RexTypeCase::kScalarFunction:
+            for (const auto & arg : expr.scalar_function().arguments())
+                exposeFilterExpressions(actions_dag, arg.value(), header, filter_name, outputs);
+            break;
+        case substrait::Expression::RexTypeCase::kCast:
+            exposeFilterExpressions(actions_dag, expr.cast().input(), header, filter_name, outputs);
+            break;
+        case substrait::Expression::RexTypeCase::kIfThen:
+            for (const auto & if_clause : expr.if_then().ifs())
+            {
+                exposeFilterExpressions(actions_dag, if_clause.if_(), header, filter_name, outputs);
+                exposeFilterExpressions(actions_dag, if_clause.then(), header, filter_name, outputs);
+            }
+            exposeFilterExpressions(actions_dag, expr.if_then().else_(), header, filter_name, outputs);
+            break;
+        case substrait::Expression::RexTypeCase::kSingularOrList:
+            exposeFilterExpressions(actions_dag, expr.singular_or_list().value(), header, filter_name, outputs);
+            break;
+        default:
+            break;
+    }
+}
+
 QueryPlanPtr SerializedPlanParser::parse(const std::string & plan)
 {
     auto plan_ptr = std::make_unique<substrait::Plan>();
@@ -2046,9 +2361,12 @@ DB::QueryPlanPtr SerializedPlanParser::parseJoin(substrait::JoinRel join, DB::Qu
     after_join_names.insert(after_join_names.end(), right_name.begin(), right_name.end());
 
     bool add_filter_step = false;
+    std::optional<ResidualJoinKind> residual_join_kind;
+    String probe_row_id;
+    String build_row_id;
     try
     {
-        parseJoinKeysAndCondition(table_join, join, left, right, table_join->columnsFromJoinedTable(), after_join_names, steps);
+        parseJoinKeysAndCondition(table_join, join, left, right, table_join->columnsFromJoinedTable(), after_join_names, steps, true);
     }
     // if ch not support the join type or join conditions, it will throw an exception like 'not support'.
     catch (Poco::Exception & e)
@@ -2059,12 +2377,35 @@ DB::QueryPlanPtr SerializedPlanParser::parseJoin(substrait::JoinRel join, DB::Qu
         {
             add_filter_step = true;
         }
+        // Other joins join on the equi-keys only and evaluate the post join filter on the matched pairs, see
+        // JoinResidualFilterStep. The broadcast build side of semi/anti joins keeps only one row per key.
+        else if (
+            e.code() == ErrorCodes::INVALID_JOIN_ON_EXPRESSION && join.has_post_join_filter()
+            && (!join_opt_info.is_broadcast || table_join->strictness() == DB::JoinStrictness::All))
+        {
+            if (table_join->kind() == DB::JoinKind::Full)
+                residual_join_kind = ResidualJoinKind::Full;
+            else if (table_join->strictness() == DB::JoinStrictness::Semi)
+                residual_join_kind = ResidualJoinKind::Semi;
+            else if (table_join->strictness() == DB::JoinStrictness::Anti)
+                residual_join_kind = ResidualJoinKind::Anti;
+            else
+                residual_join_kind = ResidualJoinKind::Left;
+            table_join->setStrictness(DB::JoinStrictness::All);
+            table_join->resetKeys();
+            parseJoinKeysAndCondition(table_join, join, left, right, table_join->columnsFromJoinedTable(), after_join_names, steps, false);
+            addResidualJoinRowIds(*table_join, *residual_join_kind, *left, *right, probe_row_id, build_row_id, steps);
+        }
         else
         {
             throw;
         }
     }
 
+    bool use_merge_join = !add_filter_step && !residual_join_kind && isSortMergeJoinApplicable(table_join, join_opt_info);
+    if (!add_filter_step && !residual_join_kind && !use_merge_join)
+        addRuntimeFilters(*table_join, join_opt_info, *left, *right, steps);
+
     if (join_opt_info.is_broadcast)
     {
         auto storage_join = BroadCastJoinBuilder::getJoin(join_opt_info.storage_join_key);
@@ -2078,8 +2419,27 @@ DB::QueryPlanPtr SerializedPlanParser::parseJoin(substrait::JoinRel join, DB::Qu
         /// hold right plan for profile
         extra_plan_holder.emplace_back(std::move(right));
     }
+    else if (use_merge_join)
+    {
+        query_plan = parseSortMergeJoin(table_join, join_opt_info, std::move(left), std::move(right), steps);
+    }
     else
     {
+        /// HashJoin can't reserve its maps, the sizes of the build side are only recorded.
+        if (context->getConfigRef().getBool("hash_table_size_hints.enabled", true))
+        {
+            auto & hints = HashTableSizeHints::instance();
+            hints.setMaxEntries(context->getSettingsRef().max_entries_for_hash_table_stats);
+            substrait::JoinRel join_without_inputs = join;
+            join_without_inputs.clear_left();
+            join_without_inputs.clear_right();
+            auto key = HashTableSizeHints::fingerprint(join_without_inputs, right->getCurrentDataStream().header);
+            auto recorder = std::make_shared<HashTableSizeRecorder>(key, hints.get(key), 0);
+            auto size_step = std::make_unique<HashTableSizeStep>(right->getCurrentDataStream(), recorder);
+            size_step->setStepDescription("Hash table size");
+            /// Not in steps, the metrics updaters of the jvm expect the steps of the join by position.
+            right->addStep(std::move(size_step));
+        }
         auto hash_join = std::make_shared<HashJoin>(table_join, right->getCurrentDataStream().header.cloneEmpty());
         QueryPlanStepPtr join_step
             = std::make_unique<DB::JoinStep>(left->getCurrentDataStream(), right->getCurrentDataStream(), hash_join, 8192, 1, false);
@@ -2094,6 +2454,25 @@ DB::QueryPlanPtr SerializedPlanParser::parseJoin(substrait::JoinRel join, DB::Qu
         query_plan->unitePlans(std::move(join_step), {std::move(plans)});
     }
 
+    if (residual_join_kind)
+    {
+        Names output_names = after_join_names;
+        output_names.emplace_back(probe_row_id);
+        if (!build_row_id.empty())
+            output_names.emplace_back(build_row_id);
+        reorderJoinOutput(*query_plan, output_names);
+
+        std::string filter_name;
+        auto actions_dag
+            = parseFunction(query_plan->getCurrentDataStream().header, join.post_join_filter(), filter_name, nullptr, true);
+        auto residual_step = std::make_unique<JoinResidualFilterStep>(
+            query_plan->getCurrentDataStream(), actions_dag, filter_name, probe_row_id, build_row_id, left_names.size(), *residual_join_kind);
+        residual_step->setStepDescription("Residual Join Filter");
+        steps.emplace_back(residual_step.get());
+        query_plan->addStep(std::move(residual_step));
+        return query_plan;
+    }
+
     reorderJoinOutput(*query_plan, after_join_names);
     if (add_filter_step)
     {
@@ -2108,6 +2487,252 @@ DB::QueryPlanPtr SerializedPlanParser::parseJoin(substrait::JoinRel join, DB::Qu
     return query_plan;
 }
 
+bool SerializedPlanParser::isSortMergeJoinApplicable(std::shared_ptr<TableJoin> table_join, const JoinOptimizationInfo & join_opt_info)
+{
+    const auto & config = context->getConfigRef();
+    if (join_opt_info.is_broadcast || !config.getBool("merge_join.enabled", true))
+        return false;
+    if (!join_opt_info.is_left_sorted && !join_opt_info.is_right_sorted)
+        return false;
+    /// The unsorted side is sorted with an external sort, which spills instead of holding the whole build side.
+    if (!(join_opt_info.is_left_sorted && join_opt_info.is_right_sorted) && !config.getBool("merge_join.sort_unsorted_side", true))
+        return false;
+    if (!FullSortingMergeJoin::isSupported(table_join))
+        return false;
+    const auto kind = table_join->kind();
+    const auto strictness = table_join->strictness();
+    if (kind == DB::JoinKind::Inner || kind == DB::JoinKind::Full)
+        return strictness == DB::JoinStrictness::All;
+    return kind == DB::JoinKind::Left
+        && (strictness == DB::JoinStrictness::All || strictness == DB::JoinStrictness::Semi || strictness == DB::JoinStrictness::Anti);
+}
+
+DB::QueryPlanPtr SerializedPlanParser::parseSortMergeJoin(
+    std::shared_ptr<TableJoin> table_join,
+    const JoinOptimizationInfo & join_opt_info,
+    DB::QueryPlanPtr left,
+    DB::QueryPlanPtr right,
+    std::vector<IQueryPlanStep *> & steps)
+{
+    /// The full sorting merge join has no semi/anti strictness. They run as a left any join, the probe rows
+    /// with/without a match are told by a marker column added to the build side.
+    String match_marker;
+    auto strictness = table_join->strictness();
+    if (strictness == DB::JoinStrictness::Semi || strictness == DB::JoinStrictness::Anti)
+    {
+        match_marker = getUniqueName("matched");
+        auto marker_type = std::make_shared<DataTypeUInt8>();
+        auto marker_dag = std::make_shared<ActionsDAG>(right->getCurrentDataStream().header.getColumnsWithTypeAndName());
+        const auto * marker_const
+            = &marker_dag->addColumn(ColumnWithTypeAndName(marker_type->createColumnConst(1, 1), marker_type, match_marker + "_const"));
+        const auto * marker_node = &marker_dag->addFunction(
+            DB::FunctionFactory::instance().get("materialize", context), {marker_const}, match_marker);
+        marker_dag->addOrReplaceInOutputs(*marker_node);
+        auto marker_step = std::make_unique<ExpressionStep>(right->getCurrentDataStream(), marker_dag);
+        marker_step->setStepDescription("Add Match Marker");
+        steps.emplace_back(marker_step.get());
+        right->addStep(std::move(marker_step));
+        table_join->addJoinedColumn(NameAndTypePair(match_marker, marker_type));
+        table_join->setStrictness(DB::JoinStrictness::Any);
+    }
+
+    const auto & clause = table_join->getOnlyClause();
+    sortJoinInput(*left, clause.key_names_left, join_opt_info.is_left_sorted, steps);
+    sortJoinInput(*right, clause.key_names_right, join_opt_info.is_right_sorted, steps);
+
+    auto merge_join = std::make_shared<FullSortingMergeJoin>(table_join, right->getCurrentDataStream().header.cloneEmpty());
+    QueryPlanStepPtr join_step
+        = std::make_unique<DB::JoinStep>(left->getCurrentDataStream(), right->getCurrentDataStream(), merge_join, 8192, 1, false);
+    join_step->setStepDescription("SORT MERGE JOIN");
+    steps.emplace_back(join_step.get());
+    std::vector<QueryPlanPtr> plans;
+    plans.emplace_back(std::move(left));
+    plans.emplace_back(std::move(right));
+    auto query_plan = std::make_unique<QueryPlan>();
+    query_plan->unitePlans(std::move(join_step), {std::move(plans)});
+
+    if (!match_marker.empty())
+    {
+        auto filter_dag = std::make_shared<ActionsDAG>(query_plan->getCurrentDataStream().header.getColumnsWithTypeAndName());
+        const auto * marker_node = &filter_dag->findInOutputs(match_marker);
+        const auto * zero = &filter_dag->addColumn(
+            ColumnWithTypeAndName(DataTypeUInt8().createColumnConst(1, 0), std::make_shared<DataTypeUInt8>(), getUniqueName("0")));
+        const auto * matched = toFunctionNode(filter_dag, "ifNull", {marker_node, zero});
+        if (strictness == DB::JoinStrictness::Anti)
+            matched = toFunctionNode(filter_dag, "not", {matched});
+        filter_dag->addOrReplaceInOutputs(*matched);
+        auto filter_step = std::make_unique<FilterStep>(query_plan->getCurrentDataStream(), filter_dag, matched->result_name, true);
+        filter_step->setStepDescription(strictness == DB::JoinStrictness::Semi ? "Semi Join Filter" : "Anti Join Filter");
+        steps.emplace_back(filter_step.get());
+        query_plan->addStep(std::move(filter_step));
+    }
+    return query_plan;
+}
+
+void SerializedPlanParser::sortJoinInput(DB::QueryPlan & plan, const DB::Names & keys, bool is_sorted, std::vector<IQueryPlanStep *> & steps)
+{
+    /// The merge join compares the keys with nulls last.
+    SortDescription sort_description;
+    for (const auto & key : keys)
+        sort_description.emplace_back(key, 1, 1);
+
+    QueryPlanStepPtr sorting_step;
+    if (is_sorted)
+    {
+        /// Every stream is sorted already, only merge them into a single sorted stream.
+        sorting_step = std::make_unique<SortingStep>(plan.getCurrentDataStream(), sort_description, 8192);
+        sorting_step->setStepDescription("Merge Sorted Join Input");
+    }
+    else
+    {
+        sorting_step = std::make_unique<SortingStep>(plan.getCurrentDataStream(), sort_description, 0, SortingStep::Settings(*context), false);
+        sorting_step->setStepDescription("Sort Join Input");
+    }
+    steps.emplace_back(sorting_step.get());
+    plan.addStep(std::move(sorting_step));
+}
+
+void SerializedPlanParser::addResidualJoinRowIds(
+    TableJoin & table_join,
+    ResidualJoinKind kind,
+    DB::QueryPlan & left,
+    DB::QueryPlan & right,
+    String & probe_row_id,
+    String & build_row_id,
+    std::vector<IQueryPlanStep *> & steps)
+{
+    probe_row_id = getUniqueName("probe_row_id");
+    auto probe_step = std::make_unique<AddRowIdStep>(left.getCurrentDataStream(), probe_row_id);
+    probe_step->setStepDescription("Add Probe Row Id");
+    steps.emplace_back(probe_step.get());
+    left.addStep(std::move(probe_step));
+
+    /// Left joins don't need to tell the build rows apart, a pair without a build row is the
+    /// null-extended probe row anyway.
+    if (kind == ResidualJoinKind::Left)
+        return;
+    build_row_id = getUniqueName("build_row_id");
+    auto build_step = std::make_unique<AddRowIdStep>(right.getCurrentDataStream(), build_row_id);
+    build_step->setStepDescription("Add Build Row Id");
+    steps.emplace_back(build_step.get());
+    right.addStep(std::move(build_step));
+    table_join.addJoinedColumn(NameAndTypePair(build_row_id, std::make_shared<DataTypeUInt64>()));
+}
+
+void SerializedPlanParser::addRuntimeFilters(
+    const TableJoin & table_join,
+    const JoinOptimizationInfo & join_opt_info,
+    DB::QueryPlan & left,
+    DB::QueryPlan & right,
+    std::vector<IQueryPlanStep *> & steps)
+{
+    /// Only the joins which drop the probe rows without a match can filter the probe side in advance.
+    bool drop_unmatched_probe_rows = (table_join.kind() == JoinKind::Inner && table_join.strictness() == JoinStrictness::All)
+        || (table_join.kind() == JoinKind::Left && table_join.strictness() == JoinStrictness::Semi);
+    if (!drop_unmatched_probe_rows || !table_join.oneDisjunct())
+        return;
+
+    auto settings = RuntimeFilterSettings::loadFromConfig(context->getConfigRef());
+    if (!settings.enabled)
+        return;
+
+    const auto & clause = table_join.getOnlyClause();
+    const auto & probe_header = left.getCurrentDataStream().header;
+    const auto & build_header = right.getCurrentDataStream().header;
+    if (clause.key_names_left.empty())
+        return;
+
+    RuntimeFilterHolderPtr holder;
+    if (join_opt_info.is_broadcast)
+    {
+        holder = BroadCastJoinBuilder::getJoin(join_opt_info.storage_join_key)->getRuntimeFilters();
+        if (!holder)
+            return;
+    }
+    else
+    {
+        DataTypes key_types;
+        for (const auto & key : clause.key_names_right)
+            key_types.emplace_back(build_header.getByName(key).type);
+        holder = std::make_shared<RuntimeFilterHolder>(clause.key_names_right, key_types, settings);
+    }
+
+    /// probe_keys[i] is the probe column of the i-th filter in the holder.
+    auto probe_keys = holder->matchProbeKeys(clause.key_names_right, clause.key_names_left);
+    if (probe_keys.empty())
+        return;
+
+    /// Runtime filters compare the raw bytes of the keys, so the probe keys must have the same types.
+    for (size_t i = 0; i < probe_keys.size(); ++i)
+    {
+        auto probe_type = removeNullable(removeLowCardinality(probe_header.getByName(probe_keys[i]).type));
+        const auto & build_type = holder->getKeyTypes()[i];
+        if (!RuntimeFilter::isSupportedType(build_type) || !probe_type->equals(*removeNullable(removeLowCardinality(build_type))))
+            return;
+    }
+
+    if (!join_opt_info.is_broadcast)
+    {
+        auto build_step = std::make_unique<BuildRuntimeFilterStep>(right.getCurrentDataStream(), holder);
+        build_step->setStepDescription("Build runtime filters");
+        steps.emplace_back(build_step.get());
+        right.addStep(std::move(build_step));
+    }
+
+    /// Push the filters down into the scan when the probe keys are passed through from it unchanged.
+    std::set<size_t> pushable_keys;
+    for (size_t i = 0; i < probe_keys.size(); ++i)
+        pushable_keys.emplace(i);
+    std::shared_ptr<SubstraitFileSource> file_source;
+    for (QueryPlan::Node * node = left.getRootNode(); node && !pushable_keys.empty();)
+    {
+        auto * step = node->step.get();
+        if (auto it = file_sources.find(step); it != file_sources.end())
+        {
+            file_source = it->second;
+            break;
+        }
+
+        ActionsDAGPtr actions_dag;
+        if (auto * expression_step = typeid_cast<ExpressionStep *>(step))
+            actions_dag = expression_step->getExpression();
+        else if (auto * filter_step = typeid_cast<FilterStep *>(step))
+            actions_dag = filter_step->getExpression();
+        else if (!typeid_cast<BlocksBufferPoolStep *>(step))
+            break;
+
+        if (actions_dag)
+        {
+            std::erase_if(
+                pushable_keys,
+                [&](size_t i)
+                {
+                    const auto * output = actions_dag->tryFindInOutputs(probe_keys[i]);
+                    return !output || output->type != ActionsDAG::ActionType::INPUT;
+                });
+        }
+
+        if (node->children.size() != 1)
+            break;
+        node = node->children.front();
+    }
+
+    if (file_source)
+    {
+        PushedRuntimeFilters pushed_filters;
+        for (auto i : pushable_keys)
+            pushed_filters.emplace_back(PushedRuntimeFilter{probe_keys[i], holder, i});
+        file_source->addRuntimeFilters(pushed_filters);
+        if (pushable_keys.size() == probe_keys.size())
+            return;
+    }
+
+    auto probe_step = std::make_unique<RuntimeFilterStep>(left.getCurrentDataStream(), holder, probe_keys);
+    probe_step->setStepDescription("Runtime filters");
+    steps.emplace_back(probe_step.get());
+    left.addStep(std::move(probe_step));
+}
+
 void SerializedPlanParser::parseJoinKeysAndCondition(
     std::shared_ptr<TableJoin> table_join,
     substrait::JoinRel & join,
@@ -2115,7 +2740,8 @@ void SerializedPlanParser::parseJoinKeysAndCondition(
     DB::QueryPlanPtr & right,
     const NamesAndTypesList & alias_right,
     Names & names,
-    std::vector<IQueryPlanStep *>& steps)
+    std::vector<IQueryPlanStep *>& steps,
+    bool with_post_join_filter)
 {
     ASTs args;
     ASTParser astParser(context, function_mapping);
@@ -2125,7 +2751,7 @@ void SerializedPlanParser::parseJoinKeysAndCondition(
         args.emplace_back(astParser.parseToAST(names, join.expression()));
     }
 
-    if (join.has_post_join_filter())
+    if (with_post_join_filter && join.has_post_join_filter())
     {
         args.emplace_back(astParser.parseToAST(names, join.post_join_filter()));
     }
@@ -19,6 +19,7 @@
 #include <base/types.h>
 #include <substrait/plan.pb.h>
 #include <Common/BlockIterator.h>
+#include <Common/JoinHelper.h>
 #include <DataTypes/Serializations/ISerialization.h>
 #include <base/types.h>
 #include <Core/SortDescription.h>
@@ -26,6 +27,8 @@
 
 namespace local_engine
 {
+class SubstraitFileSource;
+enum class ResidualJoinKind;
 
 static const std::map<std::string, std::string> SCALAR_FUNCTIONS
     = {{"is_not_null", "isNotNull"},
@@ -252,11 +255,20 @@ public:
     DB::QueryPlanPtr parseJson(const std::string & json_plan);
     DB::QueryPlanPtr parse(std::unique_ptr<substrait::Plan> plan);
 
-    DB::QueryPlanStepPtr parseReadRealWithLocalFile(const substrait::ReadRel & rel);
+    /// filter is the condition of the filter right above the read, if any.
+    DB::QueryPlanStepPtr parseReadRealWithLocalFile(
+        const substrait::ReadRel & rel, bool low_cardinality_strings = false, const substrait::Expression * filter = nullptr);
     DB::QueryPlanStepPtr parseReadRealWithJavaIter(const substrait::ReadRel & rel);
     // mergetree need create two steps in parse, can't return single step
     DB::QueryPlanPtr parseMergeTreeTable(const substrait::ReadRel & rel, std::vector<IQueryPlanStep *>& steps);
     PrewhereInfoPtr parsePreWhereInfo(const substrait::Expression & rel, Block & input);
+    /// Joins left and right by a full sorting merge join, the inputs not sorted by the join keys yet are sorted first.
+    DB::QueryPlanPtr parseSortMergeJoin(
+        std::shared_ptr<TableJoin> table_join,
+        const JoinOptimizationInfo & join_opt_info,
+        DB::QueryPlanPtr left,
+        DB::QueryPlanPtr right,
+        std::vector<IQueryPlanStep *> & steps);
 
     static bool isReadRelFromJava(const substrait::ReadRel & rel);
 
@@ -291,7 +303,25 @@ private:
         DB::QueryPlanPtr & right,
         const NamesAndTypesList & alias_right,
         Names & names,
-        std::vector<IQueryPlanStep *>& steps);
+        std::vector<IQueryPlanStep *>& steps,
+        bool with_post_join_filter);
+    bool isSortMergeJoinApplicable(std::shared_ptr<TableJoin> table_join, const JoinOptimizationInfo & join_opt_info);
+    void sortJoinInput(DB::QueryPlan & plan, const DB::Names & keys, bool is_sorted, std::vector<IQueryPlanStep *> & steps);
+    void addResidualJoinRowIds(
+        TableJoin & table_join,
+        ResidualJoinKind kind,
+        DB::QueryPlan & left,
+        DB::QueryPlan & right,
+        String & probe_row_id,
+        String & build_row_id,
+        std::vector<IQueryPlanStep *> & steps);
+
+    void addRuntimeFilters(
+        const TableJoin & table_join,
+        const JoinOptimizationInfo & join_opt_info,
+        DB::QueryPlan & left,
+        DB::QueryPlan & right,
+        std::vector<IQueryPlanStep *> & steps);
 
     static void reorderJoinOutput(DB::QueryPlan & plan, DB::Names cols);
     DB::ActionsDAGPtr parseFunction(
@@ -340,6 +370,22 @@ private:
         const std::string & function_name,
         const substrait::FunctionArgument & arg);
     const DB::ActionsDAG::Node * parseExpression(DB::ActionsDAGPtr actions_dag, const substrait::Expression & rel);
+    /// Starts reusing the nodes of identical deterministic sub-expressions parsed into actions_dag, and
+    /// picks up the sub-expressions computed by the filter right below.
+    void beginExpressionReuse(const DB::ActionsDAGPtr & actions_dag);
+    void endExpressionReuse();
+    const DB::ActionsDAG::Node * findReusableExpression(const DB::ActionsDAGPtr & actions_dag, const substrait::Expression & rel, String & key);
+    void addReusableExpression(const String & key, const DB::ActionsDAG::Node * node);
+    /// Collects the conjuncts of condition which only reference the partition columns.
+    void collectPartitionConjuncts(
+        const substrait::Expression & condition,
+        const std::set<Int32> & partition_positions,
+        std::vector<const substrait::Expression *> & conjuncts);
+    /// Gives the partition-only conjuncts of the filter above a file source to it, to skip whole files.
+    void addPartitionFilter(SubstraitFileSource & source, const DB::Block & header, const substrait::Expression & condition);
+    /// Keeps the sub-expressions of the filter that the project above evaluates again in the output of the filter.
+    void exposeFilterExpressions(
+        DB::ActionsDAG & actions_dag, const substrait::Expression & expr, const DB::Block & header, const String & filter_name, Names & outputs);
     const ActionsDAG::Node *
     toFunctionNode(ActionsDAGPtr actions_dag, const String & function, const DB::ActionsDAG::NodeRawConstPtrs & args);
     // remove nullable after isNotNull
@@ -350,6 +396,7 @@ private:
     void wrapNullable(std::vector<String> columns, ActionsDAGPtr actionsDag, std::map<std::string, std::string> & nullable_measure_names);
 
     IQueryPlanStep * addRemoveNullableStep(QueryPlan & plan, std::vector<String> columns);
+    IQueryPlanStep * addMaterializeLowCardinalityStep(QueryPlan & plan);
 
     static std::pair<DB::DataTypePtr, DB::Field> convertStructFieldType(const DB::DataTypePtr & type, const DB::Field & field);
 
@@ -361,6 +408,13 @@ private:
     std::vector<IQueryPlanStep *> temp_step_collection;
     std::vector<RelMetricPtr> metrics;
     ContextPtr contextPtr;
+    // file sources of the read steps, runtime filters from joins can be pushed down into them
+    std::unordered_map<const IQueryPlanStep *, std::shared_ptr<SubstraitFileSource>> file_sources;
+    // deterministic sub-expressions parsed into reusable_dag, keyed by the serialized substrait expression
+    const DB::ActionsDAG * reusable_dag = nullptr;
+    std::unordered_map<String, const DB::ActionsDAG::Node *> reusable_nodes;
+    // sub-expressions computed by the last filter, keyed like reusable_nodes, to the names of their columns
+    std::unordered_map<String, String> filter_expressions;
 };
 
 struct SparkBuffer
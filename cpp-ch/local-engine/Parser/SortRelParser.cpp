@@ -1,4 +1,5 @@
 #include "SortRelParser.h"
+#include <Operator/WindowGroupLimitStep.h>
 #include <Parser/RelParser.h>
 #include <Processors/QueryPlan/SortingStep.h>
 #include <Poco/Logger.h>
@@ -22,6 +23,7 @@ DB::QueryPlanPtr
 SortRelParser::parse(DB::QueryPlanPtr query_plan, const substrait::Rel & rel, std::list<const substrait::Rel *> & rel_stack_)
 {
     size_t limit = parseLimit(rel_stack_);
+    tryAddWindowGroupLimit(*query_plan, rel_stack_);
     const auto & sort_rel = rel.sort();
     auto sort_descr = parseSortDescription(sort_rel.sorts(), query_plan->getCurrentDataStream().header);
     auto sorting_step = std::make_unique<DB::SortingStep>(
@@ -82,6 +84,118 @@ size_t SortRelParser::parseLimit(std::list<const substrait::Rel *> & rel_stack_)
     return 0;
 }
 
+void SortRelParser::tryAddWindowGroupLimit(DB::QueryPlan & query_plan, std::list<const substrait::Rel *> & rel_stack_)
+{
+    /// Look for filter(window(sort)), where the filter limits a ranking function of the window.
+    if (rel_stack_.size() < 2 || !rel_stack_.back()->has_window() || !(*std::prev(rel_stack_.end(), 2))->has_filter())
+        return;
+    const auto & config = getContext()->getConfigRef();
+    if (!config.getBool("window_group_limit.enabled", true))
+        return;
+
+    const auto & window_rel = rel_stack_.back()->window();
+    const auto & filter_rel = (*std::prev(rel_stack_.end(), 2))->filter();
+    const auto & header = query_plan.getCurrentDataStream().header;
+
+    /// Other window functions would be computed on the reduced rows.
+    static const std::unordered_map<String, WindowGroupLimitKind> ranking_functions
+        = {{"row_number", WindowGroupLimitKind::RowNumber}, {"rank", WindowGroupLimitKind::Rank}, {"dense_rank", WindowGroupLimitKind::DenseRank}};
+    std::vector<WindowGroupLimitKind> kinds;
+    for (const auto & measure : window_rel.measures())
+    {
+        auto function_name = parseSignatureFunctionName(measure.measure().function_reference());
+        if (!function_name || !ranking_functions.contains(*function_name))
+            return;
+        kinds.emplace_back(ranking_functions.at(*function_name));
+    }
+
+    DB::Names partition_by;
+    for (const auto & expr : window_rel.partition_expressions())
+    {
+        if (!expr.has_selection())
+            return;
+        partition_by.emplace_back(header.getByPosition(expr.selection().direct_reference().struct_field().field()).name);
+    }
+
+    std::optional<std::pair<size_t, size_t>> rank_limit;
+    for (size_t i = 0; i < kinds.size() && !rank_limit; ++i)
+        rank_limit = parseRankLimit(filter_rel.condition(), static_cast<Int32>(header.columns() + i));
+    if (!rank_limit || rank_limit->first > config.getUInt64("window_group_limit.max_limit", 1000))
+        return;
+
+    auto step = std::make_unique<WindowGroupLimitStep>(
+        query_plan.getCurrentDataStream(),
+        partition_by,
+        parseSortDescription(window_rel.sorts(), header),
+        kinds[rank_limit->second - header.columns()],
+        rank_limit->first,
+        config.getUInt64("window_group_limit.max_buffered_rows", 1000000));
+    step->setStepDescription("Window group limit");
+    steps.emplace_back(step.get());
+    query_plan.addStep(std::move(step));
+}
+
+std::optional<std::pair<size_t, size_t>> SortRelParser::parseRankLimit(const substrait::Expression & condition, Int32 rank_field)
+{
+    if (!condition.has_scalar_function())
+        return {};
+    const auto & function = condition.scalar_function();
+    auto function_name = parseSignatureFunctionName(function.function_reference());
+    if (!function_name)
+        return {};
+
+    if (*function_name == "and")
+    {
+        for (const auto & arg : function.arguments())
+        {
+            if (auto rank_limit = parseRankLimit(arg.value(), rank_field))
+                return rank_limit;
+        }
+        return {};
+    }
+
+    if (function.arguments_size() != 2)
+        return {};
+    auto is_rank = [&](const substrait::Expression & expr)
+    { return expr.has_selection() && expr.selection().direct_reference().struct_field().field() == rank_field; };
+    auto get_value = [&](const substrait::Expression & expr) -> std::optional<Int64>
+    {
+        if (!expr.has_literal())
+            return {};
+        auto [type, field] = parseLiteral(expr.literal());
+        if (field.getType() == DB::Field::Types::Int64)
+            return field.get<Int64>();
+        if (field.getType() == DB::Field::Types::UInt64)
+            return static_cast<Int64>(field.get<UInt64>());
+        return {};
+    };
+
+    const auto & lhs = function.arguments(0).value();
+    const auto & rhs = function.arguments(1).value();
+    String op = *function_name;
+    std::optional<Int64> value;
+    if (is_rank(lhs))
+        value = get_value(rhs);
+    else if (is_rank(rhs))
+    {
+        value = get_value(lhs);
+        /// `limit >= rank` is `rank <= limit`.
+        static const std::unordered_map<String, String> flipped = {{"gte", "lte"}, {"gt", "lt"}, {"equal", "equal"}};
+        op = flipped.contains(op) ? flipped.at(op) : "";
+    }
+    if (!value)
+        return {};
+
+    Int64 limit = 0;
+    if (op == "lte" || op == "equal")
+        limit = *value;
+    else if (op == "lt")
+        limit = *value - 1;
+    if (limit <= 0)
+        return {};
+    return std::make_pair(static_cast<size_t>(limit), static_cast<size_t>(rank_field));
+}
+
 void registerSortRelParser(RelParserFactory & factory)
 {
     auto builder = [](SerializedPlanParser * plan_parser) { return std::make_shared<SortRelParser>(plan_parser); };
@@ -18,5 +18,9 @@ public:
 
 private:
     size_t parseLimit(std::list<const substrait::Rel *> & rel_stack_);
+    /// Adds a WindowGroupLimitStep before sorting the input of a window filtered by its rank.
+    void tryAddWindowGroupLimit(DB::QueryPlan & query_plan, std::list<const substrait::Rel *> & rel_stack_);
+    /// Returns the limit and the field of `rank <= limit` in the conjunctions of condition.
+    std::optional<std::pair<size_t, size_t>> parseRankLimit(const substrait::Expression & condition, Int32 rank_field);
 };
 }
@@ -19,6 +19,7 @@
 #include <Parser/TypeParser.h>
 #include <Parser/FunctionParser.h>
 #include <Parser/SerializedPlanParser.h>
+#include <Parser/aggregate_function_parser/CommonAggregateFunctionParser.h>
 #include <Poco/StringTokenizer.h>
 #include <Common/Exception.h>
 
@@ -229,9 +230,13 @@ DB::Block TypeParser::buildBlockFromNamedStruct(const substrait::NamedStruct & s
             SerializedPlanParser tmp_plan_parser(tmp_ctx);
             auto function_parser = FunctionParserFactory::instance().get(name_parts[3], &tmp_plan_parser);
             auto agg_function_name = function_parser->getCHFunctionName(args_types);
-            data_type = AggregateFunctionFactory::instance()
-                            .get(agg_function_name, args_types, function_parser->getDefaultFunctionParameters(), properties)
-                            ->getStateType();
+            auto agg_function = AggregateFunctionFactory::instance().get(
+                agg_function_name, args_types, function_parser->getDefaultFunctionParameters(), properties);
+            // The partial results of some functions are sent as typed columns instead of the states.
+            if (BaseAggregateFunctionParser::getTypedIntermediateMergeFunction(agg_function_name).empty())
+                data_type = agg_function->getStateType();
+            else
+                data_type = agg_function->getResultType();
         }
         internal_cols.push_back(ColumnWithTypeAndName(data_type, name));
     }
@@ -1,3 +1,4 @@
+#include <unordered_map>
 #include <AggregateFunctions/AggregateFunctionFactory.h>
 #include <DataTypes/DataTypeAggregateFunction.h>
 #include <DataTypes/DataTypeTuple.h>
@@ -95,6 +96,12 @@ std::pair<String, DB::DataTypes> BaseAggregateFunctionParser::tryApplyCHCombinat
         }
 
         const auto * agg_function_data = DB::checkAndGetDataType<DB::DataTypeAggregateFunction>(arg_column_types[0].get());
+        auto typed_merge_function = getTypedIntermediateMergeFunction(ch_func_name);
+        if (!agg_function_data && !typed_merge_function.empty())
+        {
+            // The partial results are typed columns, they are folded by a plain aggregate function.
+            return {typed_merge_function, arg_column_types};
+        }
         if (!agg_function_data)
         {
             // FIXME. This is should be fixed. It's the case that count(distinct(xxx)) with other aggregate functions.
@@ -137,6 +144,27 @@ std::pair<String, DB::DataTypes> BaseAggregateFunctionParser::tryApplyCHCombinat
     return {combinator_function_name, combinator_arg_column_types};
 }
 
+String BaseAggregateFunctionParser::getTypedIntermediateMergeFunction(const String & ch_func_name)
+{
+    /// The result of the merging function over the partial results must be the result of the original function.
+    static const std::unordered_map<String, String> merge_functions = {
+        {"sum", "sum"},
+        {"count", "sum"},
+        {"min", "min"},
+        {"max", "max"},
+        {"groupBitAnd", "groupBitAnd"},
+        {"groupBitOr", "groupBitOr"},
+        {"groupBitXor", "groupBitXor"},
+        {"groupArray", "groupArrayArray"},
+        {"groupUniqArray", "groupUniqArrayArray"},
+    };
+    /// Must be the same in all the stages, so it's read from the global config.
+    if (!SerializedPlanParser::global_context->getConfigRef().getBool("typed_aggregate_state.enabled", true))
+        return "";
+    auto it = merge_functions.find(ch_func_name);
+    return it == merge_functions.end() ? "" : it->second;
+}
+
 #define REGISTER_COMMON_AGGREGATE_FUNCTION_PARSER(cls_name, substait_name, ch_name) \
     class AggregateFunctionParser##cls_name : public BaseAggregateFunctionParser \
     { \
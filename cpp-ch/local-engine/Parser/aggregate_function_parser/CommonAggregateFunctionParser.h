@@ -31,6 +31,13 @@ public:
     virtual std::pair<String, DB::DataTypes>
     tryApplyCHCombinator(const CommonFunctionInfo & func_info, const String & ch_func_name, const DB::DataTypes & arg_column_types) const;
 
+    // Some functions send their partial results to the merging stages as typed columns instead of the aggregate
+    // function states, e.g. the partial sums of sum. Such columns are smaller and are folded row by row without
+    // deserializing any state.
+    // Returns the function folding the partial results of ch_func_name, or an empty string if the function keeps
+    // sending its aggregate function states.
+    static String getTypedIntermediateMergeFunction(const String & ch_func_name);
+
 protected:
     Poco::Logger * logger = &Poco::Logger::get("BaseAggregateFunctionParser");
 };
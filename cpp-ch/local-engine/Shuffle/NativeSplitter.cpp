@@ -3,10 +3,15 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <Compression/CompressedWriteBuffer.h>
+#include <Compression/CompressionFactory.h>
 #include <Core/Block.h>
+#include <Formats/NativeWriter.h>
+#include <IO/WriteBufferFromString.h>
 #include <Functions/FunctionFactory.h>
 #include <Parser/SerializedPlanParser.h>
 #include <base/types.h>
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/asio/detail/eventfd_select_interrupter.hpp>
 #include <jni/jni_common.h>
 #include <Poco/Logger.h>
@@ -67,7 +72,7 @@ void NativeSplitter::split(DB::Block & block)
 
     for (size_t i = 0; i < options.partition_nums; ++i)
     {
-        if (partition_buffer[i]->size() >= options.buffer_size)
+        if (isFull(*partition_buffer[i], options))
         {
             output_buffer.emplace(std::pair(i, std::make_unique<Block>(partition_buffer[i]->releaseColumns())));
         }
@@ -83,6 +88,8 @@ NativeSplitter::NativeSplitter(Options options_, jobject input_) : options(optio
     {
         partition_buffer.emplace_back(std::make_shared<ColumnsBuffer>(options.buffer_size));
     }
+    if (options.serialized && options.compressed)
+        codec = DB::CompressionCodecFactory::instance().get(boost::to_upper_copy(options.compress_method), {});
     CLEAN_JNIENV
 }
 
@@ -117,6 +124,8 @@ bool NativeSplitter::hasNext()
     if (!output_buffer.empty())
     {
         next_partition_id = output_buffer.top().first;
+        next_rows = output_buffer.top().second->rows();
+        next_serialized = false;
         setCurrentBlock(*output_buffer.top().second);
         produce();
     }
@@ -133,6 +142,37 @@ DB::Block * NativeSplitter::next()
     return &currentBlock();
 }
 
+std::string_view NativeSplitter::serializeNext()
+{
+    checkNextValid();
+    if (!next_serialized)
+    {
+        serialize(*output_buffer.top().second, codec, serialized_buffer);
+        next_serialized = true;
+    }
+    return serialized_buffer;
+}
+
+bool NativeSplitter::isFull(const ColumnsBuffer & buffer, const Options & options)
+{
+    return options.buffer_bytes ? buffer.bytes() >= options.buffer_bytes : buffer.size() >= options.buffer_size;
+}
+
+void NativeSplitter::serialize(const DB::Block & block, const DB::CompressionCodecPtr & codec, std::string & buffer)
+{
+    /// Every block is written with its own header, the serialized blocks can be concatenated.
+    DB::WriteBufferFromString out(buffer);
+    if (codec)
+    {
+        DB::CompressedWriteBuffer compressed_out(out, codec);
+        DB::NativeWriter(compressed_out, 0, block.cloneEmpty()).write(block);
+        compressed_out.finalize();
+    }
+    else
+        DB::NativeWriter(out, 0, block.cloneEmpty()).write(block);
+    out.finalize();
+}
+
 int32_t NativeSplitter::nextPartitionId()
 {
     return next_partition_id;
@@ -5,6 +5,7 @@
 #include <jni.h>
 #include <Core/ColumnWithTypeAndName.h>
 #include <Core/Defines.h>
+#include <Compression/ICompressionCodec.h>
 #include <Core/NamesAndTypes.h>
 #include <DataTypes/Serializations/ISerialization.h>
 #include <Interpreters/Context_fwd.h>
@@ -22,9 +23,16 @@ public:
     struct Options
     {
         size_t buffer_size = DEFAULT_BLOCK_SIZE;
+        /// If not 0, a partition is emitted once its rows take this many bytes instead of once it has
+        /// buffer_size rows, so narrow rows are not emitted in tiny blocks.
+        size_t buffer_bytes = 0;
         size_t partition_nums;
         std::string exprs_buffer;
         std::string schema_buffer;
+        /// The partition blocks are read by nextSerialized() in the format of ShuffleWriter.
+        bool serialized = false;
+        bool compressed = false;
+        std::string compress_method = "LZ4";
     };
 
     struct Holder
@@ -40,7 +48,16 @@ public:
     NativeSplitter(Options options, jobject input);
     bool hasNext();
     DB::Block * next();
+    /// Serializes the block made available by hasNext() into a buffer reused by the next calls, like
+    /// ShuffleWriter writes it, so the bytes can be written to the shuffle output as they are.
+    std::string_view serializeNext();
     int32_t nextPartitionId();
+    size_t nextRows() const { return next_rows; }
+
+    /// Whether the rows buffered for a partition are emitted, by bytes if options.buffer_bytes is set.
+    static bool isFull(const ColumnsBuffer & buffer, const Options & options);
+    /// Writes the block into buffer like ShuffleWriter does, compressed with codec if it's not null.
+    static void serialize(const DB::Block & block, const DB::CompressionCodecPtr & codec, std::string & buffer);
 
 
     virtual ~NativeSplitter();
@@ -61,6 +78,10 @@ private:
     std::vector<std::shared_ptr<ColumnsBuffer>> partition_buffer;
     std::stack<std::pair<int32_t, std::unique_ptr<DB::Block>>> output_buffer;
     int32_t next_partition_id = -1;
+    size_t next_rows = 0;
+    std::string serialized_buffer;
+    bool next_serialized = false;
+    DB::CompressionCodecPtr codec;
     jobject input;
 };
 
@@ -0,0 +1,127 @@
+#include "ParallelDecompressingReadBuffer.h"
+#include <city.h>
+#include <Compression/CompressionFactory.h>
+#include <Compression/ICompressionCodec.h>
+#include <base/scope_guard.h>
+#include <base/unaligned.h>
+#include <Common/CurrentThread.h>
+#include <Common/Exception.h>
+#include <Common/setThreadName.h>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+    extern const int CHECKSUM_DOESNT_MATCH;
+    extern const int CORRUPTED_DATA;
+}
+}
+
+namespace CurrentMetrics
+{
+extern const Metric LocalThread;
+extern const Metric LocalThreadActive;
+}
+
+namespace local_engine
+{
+using Checksum = CityHash_v1_0_2::uint128;
+
+ParallelDecompressingReadBuffer::ParallelDecompressingReadBuffer(DB::ReadBuffer & in_, ThreadPool & pool_, size_t max_frames_in_flight_)
+    : DB::ReadBuffer(nullptr, 0)
+    , in(in_)
+    , pool(pool_)
+    , max_frames_in_flight(std::max<size_t>(max_frames_in_flight_, 1))
+{
+}
+
+void ParallelDecompressingReadBuffer::initializeSharedPool(size_t threads)
+{
+    if (shared_pool || !threads)
+        return;
+    /// Unbounded queue, the frames in flight are bounded by every reader. Scheduling must not block a reader
+    /// on the frames of the others.
+    shared_pool = std::make_unique<ThreadPool>(CurrentMetrics::LocalThread, CurrentMetrics::LocalThreadActive, threads, threads, 0);
+}
+
+void ParallelDecompressingReadBuffer::shutdownSharedPool()
+{
+    if (!shared_pool)
+        return;
+    shared_pool->wait();
+    shared_pool.reset();
+}
+
+ParallelDecompressingReadBuffer::~ParallelDecompressingReadBuffer()
+{
+    for (auto & frame : frames)
+        if (frame->decompressing.valid())
+            frame->decompressing.wait();
+}
+
+bool ParallelDecompressingReadBuffer::nextImpl()
+{
+    readAhead();
+    if (frames.empty())
+        return false;
+    current_frame = std::move(frames.front());
+    frames.pop_front();
+    /// Read the next frame from in while the scheduled ones are being decompressed.
+    readAhead();
+    current_frame->decompressing.get();
+    working_buffer = Buffer(current_frame->decompressed.data(), current_frame->decompressed.data() + current_frame->decompressed_size);
+    return true;
+}
+
+void ParallelDecompressingReadBuffer::readAhead()
+{
+    const size_t header_size = DB::ICompressionCodec::getHeaderSize();
+    while (frames.size() < max_frames_in_flight && !in.eof())
+    {
+        auto frame = std::make_shared<Frame>();
+        frame->compressed.resize(sizeof(Checksum) + header_size);
+        in.readStrict(frame->compressed.data(), sizeof(Checksum) + header_size);
+        const char * header = frame->compressed.data() + sizeof(Checksum);
+        auto size_compressed = unalignedLoad<UInt32>(header + 1);
+        frame->decompressed_size = unalignedLoad<UInt32>(header + 5);
+        if (size_compressed < header_size)
+            throw DB::Exception(DB::ErrorCodes::CORRUPTED_DATA, "Too small size_compressed: {} in shuffle data", size_compressed);
+        frame->compressed.resize(sizeof(Checksum) + size_compressed);
+        in.readStrict(frame->compressed.data() + sizeof(Checksum) + header_size, size_compressed - header_size);
+
+        auto promise = std::make_shared<std::promise<void>>();
+        frame->decompressing = promise->get_future();
+        pool.scheduleOrThrowOnError(
+            [frame, promise, thread_group = DB::CurrentThread::getGroup()]()
+            {
+                if (thread_group)
+                    DB::CurrentThread::attachToGroupIfDetached(thread_group);
+                SCOPE_EXIT_SAFE(if (thread_group) DB::CurrentThread::detachFromGroupIfNotDetached(););
+                setThreadName("ShuffleDecomp");
+                try
+                {
+                    decompress(*frame);
+                    promise->set_value();
+                }
+                catch (...)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        frames.emplace_back(std::move(frame));
+    }
+}
+
+void ParallelDecompressingReadBuffer::decompress(Frame & frame)
+{
+    const char * compressed = frame.compressed.data() + sizeof(Checksum);
+    auto size_compressed = static_cast<UInt32>(frame.compressed.size() - sizeof(Checksum));
+    auto checksum = CityHash_v1_0_2::CityHash128(compressed, size_compressed);
+    if (memcmp(&checksum, frame.compressed.data(), sizeof(Checksum)) != 0)
+        throw DB::Exception(DB::ErrorCodes::CHECKSUM_DOESNT_MATCH, "Checksum doesn't match: corrupted shuffle data");
+
+    auto codec = DB::CompressionCodecFactory::instance().get(static_cast<UInt8>(compressed[0]));
+    frame.decompressed.resize(frame.decompressed_size + codec->getAdditionalSizeAtTheEndOfBuffer());
+    codec->decompress(compressed, size_compressed, frame.decompressed.data());
+}
+}
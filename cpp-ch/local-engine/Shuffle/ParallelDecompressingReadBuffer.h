@@ -0,0 +1,52 @@
+#pragma once
+#include <deque>
+#include <future>
+#include <IO/BufferWithOwnMemory.h>
+#include <IO/ReadBuffer.h>
+#include <Common/ThreadPool.h>
+
+namespace local_engine
+{
+/// Reads the output of a CompressedWriteBuffer, like CompressedReadBuffer, but reads whole compressed frames
+/// ahead and decompresses up to max_frames_in_flight of them concurrently on the given pool. The frames are
+/// returned in order, so it can be read by a NativeReader as usual.
+/// The buffers are allocated in the thread group of the reader, they are accounted by its memory tracker.
+class ParallelDecompressingReadBuffer : public DB::ReadBuffer
+{
+public:
+    ParallelDecompressingReadBuffer(DB::ReadBuffer & in_, ThreadPool & pool_, size_t max_frames_in_flight_);
+    ~ParallelDecompressingReadBuffer() override;
+
+    /// The pool shared by all the shuffle readers of the executor, so the threads don't multiply with the
+    /// number of partitions read. It lives with the backend, it's created by BackendInitializerUtil::init and
+    /// released by BackendFinalizerUtil::finalizeGlobally, and is nullptr out of that or with 0 threads.
+    static void initializeSharedPool(size_t threads);
+    static void shutdownSharedPool();
+    static ThreadPool * sharedPool() { return shared_pool.get(); }
+
+private:
+    struct Frame
+    {
+        /// The checksum, the codec header and the compressed data.
+        DB::Memory<> compressed;
+        DB::Memory<> decompressed;
+        UInt32 decompressed_size = 0;
+        std::future<void> decompressing;
+    };
+    using FramePtr = std::shared_ptr<Frame>;
+
+    inline static std::unique_ptr<ThreadPool> shared_pool;
+
+    DB::ReadBuffer & in;
+    ThreadPool & pool;
+    size_t max_frames_in_flight;
+    std::deque<FramePtr> frames;
+    /// The frame in the working buffer.
+    FramePtr current_frame;
+
+    bool nextImpl() override;
+    /// Reads frames from in and schedules their decompression, until there are max_frames_in_flight ones.
+    void readAhead();
+    static void decompress(Frame & frame);
+};
+}
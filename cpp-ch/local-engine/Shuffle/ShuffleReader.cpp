@@ -1,4 +1,5 @@
 #include "ShuffleReader.h"
+#include <Shuffle/ParallelDecompressingReadBuffer.h>
 #include <jni/jni_common.h>
 #include <Common/DebugUtils.h>
 #include <Common/JNIUtils.h>
@@ -8,11 +9,16 @@ using namespace DB;
 
 namespace local_engine
 {
-local_engine::ShuffleReader::ShuffleReader(std::unique_ptr<ReadBuffer> in_, bool compressed) : in(std::move(in_))
+local_engine::ShuffleReader::ShuffleReader(std::unique_ptr<ReadBuffer> in_, bool compressed, ThreadPool * decompression_pool)
+    : in(std::move(in_))
 {
     if (compressed)
     {
-        compressed_in = std::make_unique<CompressedReadBuffer>(*in);
+        /// Two frames per thread, so the threads don't wait for the frames to be read from in.
+        if (decompression_pool)
+            compressed_in = std::make_unique<ParallelDecompressingReadBuffer>(*in, *decompression_pool, decompression_pool->getMaxThreads() * 2);
+        else
+            compressed_in = std::make_unique<CompressedReadBuffer>(*in);
         input_stream = std::make_unique<NativeReader>(*compressed_in, 0);
     }
     else
@@ -4,6 +4,7 @@
 #include <Formats/NativeReader.h>
 #include <IO/ReadBuffer.h>
 #include <Common/BlockIterator.h>
+#include <Common/ThreadPool.h>
 
 
 namespace local_engine
@@ -12,7 +13,9 @@ class ReadBufferFromJavaInputStream;
 class ShuffleReader : BlockIterator
 {
 public:
-    explicit ShuffleReader(std::unique_ptr<DB::ReadBuffer> in_, bool compressed);
+    /// With a decompression_pool the compressed frames are decompressed ahead on it, otherwise on the reading
+    /// thread.
+    explicit ShuffleReader(std::unique_ptr<DB::ReadBuffer> in_, bool compressed, ThreadPool * decompression_pool = nullptr);
     DB::Block * read();
     ~ShuffleReader();
     static jclass input_stream_class;
@@ -20,7 +23,7 @@ public:
     std::unique_ptr<DB::ReadBuffer> in;
 
 private:
-    std::unique_ptr<DB::CompressedReadBuffer> compressed_in;
+    std::unique_ptr<DB::ReadBuffer> compressed_in;
     std::unique_ptr<DB::NativeReader> input_stream;
     DB::Block header;
 };
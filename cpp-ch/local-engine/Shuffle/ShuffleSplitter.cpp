@@ -9,10 +9,12 @@
 #include <Functions/FunctionFactory.h>
 #include <IO/BrotliWriteBuffer.h>
 #include <IO/ReadBufferFromFile.h>
+#include <IO/ReadHelpers.h>
 #include <IO/WriteHelpers.h>
 #include <Parser/SerializedPlanParser.h>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <Poco/StringTokenizer.h>
+#include <base/scope_guard.h>
 #include <Common/DebugUtils.h>
 
 namespace local_engine
@@ -25,12 +27,68 @@ void ShuffleSplitter::split(DB::Block & block)
     }
     Stopwatch watch;
     watch.start();
-    computeAndCountPartitionId(block);
-    splitBlockByPartition(block);
+    splitting = true;
+    try
+    {
+        computeAndCountPartitionId(block);
+        splitBlockByPartition(block);
+    }
+    catch (...)
+    {
+        splitting = false;
+        throw;
+    }
+    splitting = false;
+    if (pending_spill_bytes)
+        releaseMemory(std::exchange(pending_spill_bytes, 0));
     split_result.total_write_time += watch.elapsedNanoseconds();
 }
+
+size_t ShuffleSplitter::releaseMemory(size_t bytes)
+{
+    if (stopped)
+        return 0;
+    if (splitting)
+    {
+        pending_spill_bytes += bytes;
+        return 0;
+    }
+    splitting = true;
+    SCOPE_EXIT({ splitting = false; });
+    return spillLargestPartitions(bytes);
+}
+
+size_t ShuffleSplitter::spillLargestPartitions(size_t bytes)
+{
+    std::vector<std::pair<size_t, size_t>> partition_bytes;
+    for (size_t i = 0; i < options.partition_nums; ++i)
+        if (partition_buffer[i].size())
+            partition_bytes.emplace_back(partition_buffer[i].allocatedBytes(), i);
+    std::sort(partition_bytes.begin(), partition_bytes.end(), std::greater<>());
+
+    size_t released = 0;
+    for (const auto & [partition_size, partition_id] : partition_bytes)
+    {
+        if (released >= bytes)
+            break;
+        spillPartition(partition_id);
+        released += partition_size;
+    }
+    return released;
+}
+
+void ShuffleSplitter::unregisterSpillCallback()
+{
+    if (spill_callbacks)
+    {
+        spill_callbacks->remove(spill_callback_id);
+        spill_callbacks.reset();
+    }
+}
+
 SplitResult ShuffleSplitter::stop()
 {
+    unregisterSpillCallback();
     // spill all buffers
     Stopwatch watch;
     watch.start();
@@ -104,6 +162,7 @@ void ShuffleSplitter::init()
     partition_cached_write_buffers.reserve(options.partition_nums);
     split_result.partition_length.reserve(options.partition_nums);
     split_result.raw_partition_length.reserve(options.partition_nums);
+    partition_blocks.resize(options.partition_nums);
     for (size_t i = 0; i < options.partition_nums; ++i)
     {
         partition_buffer.emplace_back(ColumnsBuffer());
@@ -129,17 +188,32 @@ void ShuffleSplitter::spillPartition(size_t partition_id)
     if (result.rows() > 0)
     {
         partition_outputs[partition_id]->write(result);
+        if (!options.block_index_file.empty())
+            recordBlock(partition_id, result.rows());
     }
     split_result.total_spill_time += watch.elapsedNanoseconds();
     split_result.total_bytes_spilled += result.bytes();
 }
 
+void ShuffleSplitter::recordBlock(size_t partition_id, size_t rows)
+{
+    /// End the compressed frame, so that the block can be decompressed without the ones before it.
+    partition_write_buffers[partition_id]->next();
+    auto & file_buffer
+        = partition_cached_write_buffers[partition_id] ? partition_cached_write_buffers[partition_id] : partition_write_buffers[partition_id];
+    file_buffer->next();
+    auto & blocks = partition_blocks[partition_id];
+    size_t offset = blocks.empty() ? 0 : blocks.back().offset + blocks.back().length;
+    blocks.push_back({.offset = offset, .length = file_buffer->count() - offset, .rows = rows});
+}
+
 void ShuffleSplitter::mergePartitionFiles()
 {
     DB::WriteBufferFromFile data_write_buffer = DB::WriteBufferFromFile(options.data_file);
     std::string buffer;
     size_t buffer_size = options.io_buffer_size;
     buffer.reserve(buffer_size);
+    size_t partition_start = 0;
     for (size_t i = 0; i < options.partition_nums; ++i)
     {
         auto file = getPartitionTempFile(i);
@@ -153,13 +227,21 @@ void ShuffleSplitter::mergePartitionFiles()
         }
         reader.close();
         std::filesystem::remove(file);
+        for (auto & block : partition_blocks[i])
+            block.offset += partition_start;
+        partition_start += split_result.partition_length[i];
     }
     data_write_buffer.close();
+    if (!options.block_index_file.empty())
+        writeBlockIndexFile();
 }
 
 ShuffleSplitter::ShuffleSplitter(SplitOptions && options_) : options(options_)
 {
     init();
+    spill_callbacks = currentSpillCallbackRegistry();
+    if (spill_callbacks)
+        spill_callback_id = spill_callbacks->add([this](size_t bytes) { return releaseMemory(bytes); });
 }
 
 ShuffleSplitter::Ptr ShuffleSplitter::create(const std::string & short_name, SplitOptions options_)
@@ -232,6 +314,49 @@ void ShuffleSplitter::writeIndexFile()
     }
 }
 
+void ShuffleSplitter::writeBlockIndexFile()
+{
+    auto writer = std::make_unique<DB::WriteBufferFromFile>(options.block_index_file, options.io_buffer_size, O_CREAT | O_WRONLY | O_TRUNC);
+    for (size_t i = 0; i < partition_blocks.size(); ++i)
+    {
+        for (const auto & block : partition_blocks[i])
+        {
+            DB::writeIntText(i, *writer);
+            DB::writeChar(' ', *writer);
+            DB::writeIntText(block.offset, *writer);
+            DB::writeChar(' ', *writer);
+            DB::writeIntText(block.length, *writer);
+            DB::writeChar(' ', *writer);
+            DB::writeIntText(block.rows, *writer);
+            DB::writeChar('\n', *writer);
+        }
+    }
+    writer->finalize();
+}
+
+std::vector<std::vector<ShuffleBlock>> ShuffleSplitter::readBlockIndexFile(const std::string & file)
+{
+    std::vector<std::vector<ShuffleBlock>> blocks;
+    DB::ReadBufferFromFile reader(file);
+    while (!reader.eof())
+    {
+        size_t partition_id;
+        ShuffleBlock block;
+        DB::readIntText(partition_id, reader);
+        DB::assertChar(' ', reader);
+        DB::readIntText(block.offset, reader);
+        DB::assertChar(' ', reader);
+        DB::readIntText(block.length, reader);
+        DB::assertChar(' ', reader);
+        DB::readIntText(block.rows, reader);
+        DB::assertChar('\n', reader);
+        if (partition_id >= blocks.size())
+            blocks.resize(partition_id + 1);
+        blocks[partition_id].push_back(block);
+    }
+    return blocks;
+}
+
 void ColumnsBuffer::add(DB::Block & block, int start, int end)
 {
     if (header.columns() == 0)
@@ -293,6 +418,22 @@ size_t ColumnsBuffer::size() const
     return accumulated_columns.at(0)->size();
 }
 
+size_t ColumnsBuffer::allocatedBytes() const
+{
+    size_t bytes = 0;
+    for (const auto & column : accumulated_columns)
+        bytes += column->allocatedBytes();
+    return bytes;
+}
+
+size_t ColumnsBuffer::bytes() const
+{
+    size_t bytes = 0;
+    for (const auto & column : accumulated_columns)
+        bytes += column->byteSize();
+    return bytes;
+}
+
 DB::Block ColumnsBuffer::releaseColumns()
 {
     DB::Columns res(std::make_move_iterator(accumulated_columns.begin()), std::make_move_iterator(accumulated_columns.end()));
@@ -5,6 +5,7 @@
 #include <Functions/IFunction.h>
 #include <IO/WriteBufferFromFile.h>
 #include <Shuffle/SelectorBuilder.h>
+#include <Common/QueryContext.h>
 #include <Common/PODArray.h>
 #include <Common/PODArray_fwd.h>
 
@@ -26,6 +27,17 @@ struct SplitOptions
     // std::vector<std::string> exprs;
     std::string compress_method = "zstd";
     int compress_level;
+    /// If not empty, the blocks of every partition in the data file are written to it, one line per block:
+    /// "<partition id> <offset> <length> <rows>", so that a skewed partition can be read by several reducers.
+    std::string block_index_file;
+};
+
+/// A spilled block of a partition, a compressed frame that can be read on its own.
+struct ShuffleBlock
+{
+    size_t offset;
+    size_t length;
+    size_t rows;
 };
 
 class ColumnsBuffer
@@ -35,6 +47,8 @@ public:
     void add(DB::Block & columns, int start, int end);
     void appendSelective(size_t column_idx, const DB::Block & source, const DB::IColumn::Selector & selector, size_t from, size_t length);
     size_t size() const;
+    size_t allocatedBytes() const;
+    size_t bytes() const;
     DB::Block releaseColumns();
     DB::Block getHeader();
 
@@ -68,9 +82,15 @@ public:
             stop();
     }
     void split(DB::Block & block);
+    /// Spills the partitions buffering the most memory until about the bytes are released, returns the
+    /// bytes released. Called by the spill callback registered in the task.
+    size_t releaseMemory(size_t bytes);
     virtual void computeAndCountPartitionId(DB::Block &) { }
     std::vector<int64_t> getPartitionLength() const { return split_result.partition_length; }
     void writeIndexFile();
+    void writeBlockIndexFile();
+    /// The blocks of every partition written by writeBlockIndexFile(), for the partitions up to the last one with a block.
+    static std::vector<std::vector<ShuffleBlock>> readBlockIndexFile(const std::string & file);
     SplitResult stop();
 
 private:
@@ -80,6 +100,15 @@ private:
     std::string getPartitionTempFile(size_t partition_id);
     void mergePartitionFiles();
     std::unique_ptr<DB::WriteBuffer> getPartitionWriteBuffer(size_t partition_id);
+    void recordBlock(size_t partition_id, size_t rows);
+    size_t spillLargestPartitions(size_t bytes);
+    void unregisterSpillCallback();
+
+    SpillCallbackRegistryPtr spill_callbacks;
+    UInt64 spill_callback_id = 0;
+    /// A spill requested while splitting or spilling, e.g. by their own allocations, is done after them.
+    bool splitting = false;
+    size_t pending_spill_bytes = 0;
 
 protected:
     bool stopped = false;
@@ -92,6 +121,8 @@ protected:
     DB::Block output_header;
     SplitOptions options;
     SplitResult split_result;
+    /// Blocks of every partition, offsets are in the partition temp file until merged into the data file.
+    std::vector<std::vector<ShuffleBlock>> partition_blocks;
 };
 
 class RoundRobinSplitter : public ShuffleSplitter
@@ -1,14 +1,127 @@
 #include "CustomMergeTreeSink.h"
+#include <Common/CurrentThread.h>
+#include <Common/scope_guard_safe.h>
+#include <Common/setThreadName.h>
 
-void local_engine::CustomMergeTreeSink::consume(Chunk chunk)
+namespace local_engine
+{
+CustomMergeTreeSink::CustomMergeTreeSink(
+    CustomStorageMergeTree & storage_, const StorageMetadataPtr metadata_snapshot_, ContextPtr context_)
+    : ISink(metadata_snapshot_->getSampleBlock())
+    , storage(storage_)
+    , metadata_snapshot(metadata_snapshot_)
+    , context(context_)
+    , squashing(context_->getSettingsRef().min_insert_block_size_rows, context_->getSettingsRef().min_insert_block_size_bytes)
+    , merge_after_insert(context_->getConfigRef().getBool("mergetree.merge_after_insert", true))
+    /// One block is encoded while the next one is squashed, more would only hold memory.
+    , pending_blocks(1)
+{
+    /// The parts are written for the query of the sink, its memory and profile events included.
+    write_thread = std::make_unique<ThreadFromGlobalPool>(
+        [this, thread_group = CurrentThread::getGroup()]
+        {
+            if (thread_group)
+                CurrentThread::attachToGroupIfDetached(thread_group);
+            SCOPE_EXIT_SAFE(if (thread_group) CurrentThread::detachFromGroupIfNotDetached(););
+            setThreadName("MergeTreeWrite");
+            writeParts();
+        });
+}
+
+CustomMergeTreeSink::~CustomMergeTreeSink()
+{
+    /// Cancelled, the pending blocks are dropped.
+    pending_blocks.clearAndFinish();
+    if (write_thread && write_thread->joinable())
+        write_thread->join();
+}
+
+void CustomMergeTreeSink::consume(Chunk chunk)
 {
     auto block = metadata_snapshot->getSampleBlock().cloneWithColumns(chunk.detachColumns());
-    DB::BlockWithPartition block_with_partition(Block(block), DB::Row{});
-    auto part = storage.writer.writeTempPart(block_with_partition, metadata_snapshot, context);
-    MergeTreeData::Transaction transaction(storage, NO_TRANSACTION_RAW);
+    if (auto squashed = squashing.add(std::move(block)))
+        write(std::move(squashed));
+}
+
+void CustomMergeTreeSink::onFinish()
+{
+    if (auto squashed = squashing.add(Block{}))
+        write(std::move(squashed));
+    finishWriting();
+    if (merge_after_insert)
+        mergeWrittenParts();
+}
+
+void CustomMergeTreeSink::write(Block block)
+{
+    /// Fails only when the writing thread has given up.
+    if (!pending_blocks.push(std::move(block)))
+        finishWriting();
+}
+
+void CustomMergeTreeSink::writeParts()
+{
+    try
+    {
+        Block block;
+        while (pending_blocks.pop(block))
+        {
+            /// writeTempPart sorts the block by the sorting key and builds the primary and skip indexes.
+            DB::BlockWithPartition block_with_partition(std::move(block), DB::Row{});
+            auto part = storage.writer.writeTempPart(block_with_partition, metadata_snapshot, context);
+            MergeTreeData::Transaction transaction(storage, NO_TRANSACTION_RAW);
+            {
+                auto lock = storage.lockParts();
+                storage.renameTempPartAndAdd(part.part, transaction, lock);
+                transaction.commit(&lock);
+            }
+            written_parts.emplace_back(part.part);
+        }
+    }
+    catch (...)
     {
-        auto lock = storage.lockParts();
-        storage.renameTempPartAndAdd(part.part, transaction, lock);
-        transaction.commit(&lock);
+        write_exception = std::current_exception();
+        pending_blocks.clearAndFinish();
     }
 }
+
+void CustomMergeTreeSink::finishWriting()
+{
+    pending_blocks.finish();
+    if (write_thread->joinable())
+        write_thread->join();
+    if (write_exception)
+        std::rethrow_exception(write_exception);
+}
+
+MergeTreeData::DataPartsVector CustomMergeTreeSink::mergeWrittenParts()
+{
+    std::unordered_set<String> written_names;
+    for (const auto & part : written_parts)
+        written_names.insert(part->name);
+
+    /// Only the runs of written parts without any other part in between can be merged, a merged part covers
+    /// all the blocks from its first part to its last one.
+    MergeTreeData::DataPartsVector result;
+    MergeTreeData::DataPartsVector run;
+    auto merge_run = [&]()
+    {
+        if (run.size() > 1)
+            result.emplace_back(storage.mergeParts(run, context));
+        else if (!run.empty())
+            result.emplace_back(run.front());
+        run.clear();
+    };
+    for (const auto & part : storage.getDataPartsVectorForInternalUsage())
+    {
+        if (written_names.contains(part->name))
+            run.emplace_back(part);
+        else
+            merge_run();
+    }
+    merge_run();
+    written_parts = result;
+    return result;
+}
+
+}
@@ -1,27 +1,51 @@
 #pragma once
 
+#include <Interpreters/SquashingTransform.h>
 #include <Processors/ISink.h>
 #include <Storages/MergeTree/MergeTreeDataWriter.h>
 #include <Storages/StorageInMemoryMetadata.h>
+#include <Common/ConcurrentBoundedQueue.h>
+#include <Common/ThreadPool.h>
 #include "CustomStorageMergeTree.h"
 
 namespace local_engine
 {
+/// Squashes the chunks up to min_insert_block_size_rows/bytes of the context and writes a part for every
+/// squashed block, instead of a tiny part per chunk. The parts are sorted by the sorting key of the table
+/// (if any) and encoded on a background thread, so the upstream keeps running meanwhile. Once finished, the
+/// written parts are merged unless mergetree.merge_after_insert is false.
 class CustomMergeTreeSink : public ISink
 {
 public:
-    CustomMergeTreeSink(CustomStorageMergeTree & storage_, const StorageMetadataPtr metadata_snapshot_, ContextPtr context_)
-        : ISink(metadata_snapshot_->getSampleBlock()), storage(storage_), metadata_snapshot(metadata_snapshot_), context(context_)
-    {
-    }
+    CustomMergeTreeSink(CustomStorageMergeTree & storage_, const StorageMetadataPtr metadata_snapshot_, ContextPtr context_);
+    ~CustomMergeTreeSink() override;
 
     String getName() const override { return "CustomMergeTreeSink"; }
     void consume(Chunk chunk) override;
+    void onFinish() override;
+
+    /// The parts committed by this sink, complete once it's finished.
+    const MergeTreeData::DataPartsVector & getWrittenParts() const { return written_parts; }
+    /// Merges the parts committed by this sink, which are adjacent in the table, into bigger ones. Called when
+    /// the sink is finished. Returns the parts covering the written data afterwards.
+    MergeTreeData::DataPartsVector mergeWrittenParts();
 
 private:
     CustomStorageMergeTree & storage;
     StorageMetadataPtr metadata_snapshot;
     ContextPtr context;
+    SquashingTransform squashing;
+    bool merge_after_insert;
+
+    /// The squashed blocks waiting to be written by write_thread.
+    ConcurrentBoundedQueue<Block> pending_blocks;
+    std::unique_ptr<ThreadFromGlobalPool> write_thread;
+    std::exception_ptr write_exception;
+    MergeTreeData::DataPartsVector written_parts;
+
+    void write(Block block);
+    void writeParts();
+    void finishWriting();
 };
 
 }
@@ -1,4 +1,5 @@
 #include "CustomStorageMergeTree.h"
+#include <Storages/MergeTree/MergeList.h>
 
 namespace local_engine
 {
@@ -23,9 +24,42 @@ CustomStorageMergeTree::CustomStorageMergeTree(
         attach)
     , writer(*this)
     , reader(*this)
+    , merger_mutator(*this)
 {
     initializeDirectoriesAndFormatVersion(relative_data_path_, attach, date_column_name);
 }
+
+MergeTreeData::DataPartPtr CustomStorageMergeTree::mergeParts(const DataPartsVector & parts, ContextPtr context)
+{
+    auto future_part = std::make_shared<FutureMergedMutatedPart>();
+    future_part->assign(parts);
+    auto merge_entry = getContext()->getMergeList().insert(getStorageID(), future_part, context);
+    auto reservation = reserveSpace(MergeTreeDataMergerMutator::estimateNeededDiskSpace(parts));
+    auto table_lock = lockForShare(RWLockImpl::NO_QUERY, context->getSettingsRef().lock_acquire_timeout);
+
+    auto task = merger_mutator.mergePartsToTemporaryPart(
+        future_part,
+        getInMemoryMetadataPtr(),
+        merge_entry.get(),
+        /* projection_merge_list_element = */ {},
+        table_lock,
+        time(nullptr),
+        context,
+        reservation,
+        /* deduplicate = */ false,
+        /* deduplicate_by_columns = */ {},
+        /* cleanup = */ false,
+        merging_params,
+        NO_TRANSACTION_PTR);
+    while (task->execute())
+        ;
+    auto new_part = task->getFuture().get();
+
+    MergeTreeData::Transaction transaction(*this, NO_TRANSACTION_RAW);
+    merger_mutator.renameMergedTemporaryPart(new_part, parts, NO_TRANSACTION_PTR, transaction);
+    transaction.commit();
+    return new_part;
+}
 void CustomStorageMergeTree::dropPartNoWaitNoThrow(const String & /*part_name*/)
 {
     throw std::runtime_error("not implement");
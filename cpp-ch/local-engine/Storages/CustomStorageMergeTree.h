@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Storages/MergeTree/MergeTreeData.h>
+#include <Storages/MergeTree/MergeTreeDataMergerMutator.h>
 #include <Storages/MergeTree/MergeTreeDataSelectExecutor.h>
 #include <Storages/MergeTree/MergeTreeDataWriter.h>
 #include <Storages/MutationCommands.h>
@@ -30,8 +31,12 @@ public:
     std::vector<MergeTreeMutationStatus> getMutationsStatus() const override;
     bool scheduleDataProcessingJob(BackgroundJobsAssignee & executor) override;
 
+    /// Merges the given adjacent parts into one and replaces them with it in the working set.
+    DataPartPtr mergeParts(const DataPartsVector & parts, ContextPtr context);
+
     MergeTreeDataWriter writer;
     MergeTreeDataSelectExecutor reader;
+    MergeTreeDataMergerMutator merger_mutator;
 
 private:
     SimpleIncrement increment;
@@ -0,0 +1,199 @@
+#include "BucketedFileWriter.h"
+#include <algorithm>
+#include <Columns/ColumnsNumber.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Functions/FunctionFactory.h>
+#include <Interpreters/TemporaryDataOnDisk.h>
+#include <Processors/QueryPlan/SortingStep.h>
+#include <Processors/Transforms/MergeSortingTransform.h>
+#include <Processors/Transforms/PartialSortingTransform.h>
+#include <QueryPipeline/Chain.h>
+#include <Storages/SinkToStorage.h>
+#include <Poco/URI.h>
+#include <Common/assert_cast.h>
+
+namespace CurrentMetrics
+{
+extern const Metric TemporaryFilesForSort;
+}
+
+namespace local_engine
+{
+/// Receives the rows sorted by bucket id, writes every bucket to its own file as it ends.
+class BucketFilesSink : public DB::SinkToStorage
+{
+public:
+    BucketFilesSink(
+        const DB::Block & header_,
+        DB::ContextPtr context_,
+        const String & directory_,
+        const String & file_prefix_,
+        const String & file_suffix_,
+        std::shared_ptr<std::vector<String>> written_files_)
+        : DB::SinkToStorage(header_)
+        , context(context_)
+        , directory(directory_)
+        , file_prefix(file_prefix_)
+        , file_suffix(file_suffix_)
+        , written_files(written_files_)
+        , bucket_id_position(header_.getPositionByName(BucketedFileWriter::BUCKET_ID_COLUMN))
+    {
+        write_buffer_builder = WriteBufferBuilderFactory::instance().createBuilder(Poco::URI(directory).getScheme(), context);
+        for (size_t i = 0; i < header_.columns(); ++i)
+            if (i != bucket_id_position)
+                file_header.insert(header_.getByPosition(i).cloneEmpty());
+    }
+
+    String getName() const override { return "BucketFilesSink"; }
+
+protected:
+    void consume(DB::Chunk chunk) override
+    {
+        size_t rows = chunk.getNumRows();
+        auto columns = chunk.detachColumns();
+        const auto & bucket_ids = assert_cast<const DB::ColumnInt32 &>(*columns[bucket_id_position]).getData();
+        size_t begin = 0;
+        while (begin < rows)
+        {
+            size_t end = std::upper_bound(bucket_ids.begin() + begin, bucket_ids.begin() + rows, bucket_ids[begin]) - bucket_ids.begin();
+            write(bucket_ids[begin], columns, begin, end - begin);
+            begin = end;
+        }
+    }
+
+    void onFinish() override { closeFile(); }
+
+private:
+    DB::ContextPtr context;
+    String directory;
+    String file_prefix;
+    String file_suffix;
+    std::shared_ptr<std::vector<String>> written_files;
+    size_t bucket_id_position;
+    DB::Block file_header;
+    WriteBufferBuilderPtr write_buffer_builder;
+
+    Int32 current_bucket_id = -1;
+    std::unique_ptr<FileWriterWrapper> file_writer;
+
+    void write(Int32 bucket_id, const DB::Columns & columns, size_t offset, size_t length)
+    {
+        if (!file_writer || bucket_id != current_bucket_id)
+        {
+            closeFile();
+            auto file_uri = directory + "/" + file_prefix + BucketedFileWriter::bucketIdToString(bucket_id) + file_suffix;
+            file_writer = std::make_unique<NormalFileWriter>(OutputFormatFileUtil::createFile(context, write_buffer_builder, file_uri), context);
+            current_bucket_id = bucket_id;
+            written_files->emplace_back(file_uri);
+        }
+
+        auto block = file_header.cloneEmpty();
+        for (size_t i = 0, j = 0; i < columns.size(); ++i)
+            if (i != bucket_id_position)
+                block.getByPosition(j++).column = columns[i]->cut(offset, length);
+        file_writer->consume(block);
+    }
+
+    void closeFile()
+    {
+        if (!file_writer)
+            return;
+        file_writer->close();
+        file_writer.reset();
+    }
+};
+
+BucketedFileWriter::BucketedFileWriter(
+    DB::ContextPtr context_,
+    const String & directory_,
+    const String & file_prefix_,
+    const String & file_suffix_,
+    const DB::Names & bucket_columns_,
+    Int32 num_buckets_,
+    const DB::Names & sort_columns_)
+    : context(context_)
+    , directory(directory_)
+    , file_prefix(file_prefix_)
+    , file_suffix(file_suffix_)
+    , bucket_columns(bucket_columns_)
+    , num_buckets(num_buckets_)
+    , sort_columns(sort_columns_)
+{
+    while (directory.ends_with('/'))
+        directory.pop_back();
+}
+
+DB::ColumnPtr BucketedFileWriter::computeBucketIds(const DB::Block & block)
+{
+    DB::ColumnsWithTypeAndName arguments;
+    for (const auto & name : bucket_columns)
+        arguments.emplace_back(block.getByName(name));
+    if (!hash_function)
+        hash_function = DB::FunctionFactory::instance().get("sparkMurmurHash3_32", context)->build(arguments);
+
+    size_t rows = block.rows();
+    auto hashes = hash_function->execute(arguments, hash_function->getResultType(), rows)->convertToFullColumnIfConst();
+    const auto & hash_data = assert_cast<const DB::ColumnUInt32 &>(*hashes).getData();
+    auto bucket_ids = DB::ColumnInt32::create(rows);
+    auto & bucket_id_data = bucket_ids->getData();
+    for (size_t i = 0; i < rows; ++i)
+        bucket_id_data[i] = bucketIdFromHash(static_cast<Int32>(hash_data[i]), num_buckets);
+    return bucket_ids;
+}
+
+String BucketedFileWriter::bucketIdToString(Int32 bucket_id)
+{
+    return fmt::format("_{:05d}", bucket_id);
+}
+
+void BucketedFileWriter::initPipeline(const DB::Block & header)
+{
+    /// Nulls first, as the ascending sort of spark.
+    DB::SortDescription sort_description;
+    sort_description.emplace_back(BUCKET_ID_COLUMN, 1, -1);
+    for (const auto & name : sort_columns)
+        sort_description.emplace_back(name, 1, -1);
+
+    DB::SortingStep::Settings settings(*context);
+    auto tmp_data = context->getTempDataOnDisk();
+    size_t max_bytes_before_external_sort
+        = tmp_data ? context->getConfigRef().getUInt64("bucketed_write.max_bytes_before_external_sort", 256 * 1024 * 1024) : 0;
+
+    DB::Chain chain;
+    chain.addSink(std::make_shared<DB::PartialSortingTransform>(header, sort_description));
+    chain.addSink(std::make_shared<DB::MergeSortingTransform>(
+        header,
+        sort_description,
+        settings.max_block_size,
+        /*max_block_bytes=*/0,
+        /*limit=*/0,
+        false,
+        settings.max_bytes_before_remerge,
+        settings.remerge_lowered_memory_bytes_ratio,
+        max_bytes_before_external_sort,
+        tmp_data ? std::make_shared<DB::TemporaryDataOnDisk>(tmp_data, CurrentMetrics::TemporaryFilesForSort) : nullptr,
+        settings.min_free_disk_space));
+    chain.addSink(std::make_shared<BucketFilesSink>(header, context, directory, file_prefix, file_suffix, written_files));
+
+    pipeline = std::make_unique<DB::QueryPipeline>(std::move(chain));
+    writer = std::make_unique<DB::PushingPipelineExecutor>(*pipeline);
+}
+
+void BucketedFileWriter::consume(DB::Block & block)
+{
+    if (!block.rows())
+        return;
+    /// The block of the caller is left as it is, the copy shares its columns.
+    DB::Block bucketed_block = block;
+    bucketed_block.insert({computeBucketIds(block), std::make_shared<DB::DataTypeInt32>(), BUCKET_ID_COLUMN});
+    if (!writer) [[unlikely]]
+        initPipeline(bucketed_block.cloneEmpty());
+    writer->push(std::move(bucketed_block));
+}
+
+void BucketedFileWriter::close()
+{
+    if (writer)
+        writer->finish();
+}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Core/Block.h>
+#include <Core/SortDescription.h>
+#include <Functions/IFunction.h>
+#include <Interpreters/Context.h>
+#include <Processors/Executors/PushingPipelineExecutor.h>
+#include <QueryPipeline/QueryPipeline.h>
+#include <Storages/Output/FileWriterWrappers.h>
+
+namespace local_engine
+{
+/// Writes the rows of a bucketed table the way spark does, without sending them to the jvm:
+/// - the bucket of a row is pmod(murmur3hash(bucket columns), num_buckets), as HashPartitioning,
+/// - the rows of a bucket go to <directory>/<file_prefix>_<bucket id, 5 digits><file_suffix>,
+///   e.g. part-00000-<job id>_00003.c000.snappy.parquet,
+/// - the rows of a file are sorted by the sort columns of the table.
+/// The rows are sorted by bucket id and sort columns with the external sort of ch, which spills beyond
+/// max_bytes_before_external_sort, so only the file of the current bucket is open at a time.
+class BucketedFileWriter : public FileWriterWrapper
+{
+public:
+    BucketedFileWriter(
+        DB::ContextPtr context_,
+        const String & directory_,
+        const String & file_prefix_,
+        const String & file_suffix_,
+        const DB::Names & bucket_columns_,
+        Int32 num_buckets_,
+        const DB::Names & sort_columns_);
+    ~BucketedFileWriter() override = default;
+
+    void consume(DB::Block & block) override;
+    void close() override;
+
+    /// The uris of the written files, one per non empty bucket, in the order of bucket ids.
+    const std::vector<String> & getWrittenFiles() const { return *written_files; }
+
+    /// Same as the bucket ids computed by spark for the rows of block.
+    DB::ColumnPtr computeBucketIds(const DB::Block & block);
+
+    static Int32 bucketIdFromHash(Int32 hash, Int32 num_buckets) { return (hash % num_buckets + num_buckets) % num_buckets; }
+    static String bucketIdToString(Int32 bucket_id);
+
+    static constexpr auto BUCKET_ID_COLUMN = "__bucket_id";
+
+private:
+    DB::ContextPtr context;
+    String directory;
+    String file_prefix;
+    String file_suffix;
+    DB::Names bucket_columns;
+    Int32 num_buckets;
+    DB::Names sort_columns;
+
+    DB::ExecutableFunctionPtr hash_function;
+    std::shared_ptr<std::vector<String>> written_files = std::make_shared<std::vector<String>>();
+    std::unique_ptr<DB::QueryPipeline> pipeline;
+    std::unique_ptr<DB::PushingPipelineExecutor> writer;
+
+    void initPipeline(const DB::Block & header);
+};
+}
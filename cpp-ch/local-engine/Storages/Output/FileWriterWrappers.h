@@ -26,6 +26,9 @@ public:
     virtual void close() = 0;
 
 protected:
+    /// For the writers of several files.
+    FileWriterWrapper() = default;
+
     OutputFormatFilePtr file;
 };
 
@@ -34,15 +34,36 @@ void StorageJoinFromReadBuffer::restore()
     ContextPtr ctx = nullptr;
     NativeReader block_stream(*in, 0);
 
+    DataTypes key_types;
+    for (const auto & key : key_names)
+        key_types.emplace_back(sample_block.getByName(key).type);
+    bool build_runtime_filters
+        = std::all_of(key_types.begin(), key_types.end(), [](const auto & type) { return RuntimeFilter::isSupportedType(type); });
+    RuntimeFilterSettings runtime_filter_settings;
+    if (auto global_context = Context::getGlobalContextInstance())
+        runtime_filter_settings = RuntimeFilterSettings::loadFromConfig(global_context->getConfigRef());
+    build_runtime_filters = build_runtime_filters && runtime_filter_settings.enabled;
+
+    std::vector<RuntimeFilter> filters;
+    if (build_runtime_filters)
+    {
+        runtime_filters = std::make_shared<RuntimeFilterHolder>(key_names, key_types, runtime_filter_settings);
+        filters = runtime_filters->createLocalFilters();
+    }
+
     ProfileInfo info;
     {
         while (Block block = block_stream.read())
         {
             auto final_block = sample_block.cloneWithColumns(block.mutateColumns());
             info.update(final_block);
+            for (size_t i = 0; i < filters.size(); ++i)
+                filters[i].insert(*final_block.getByName(key_names[i]).column);
             join->addBlockToJoin(final_block, true);
         }
     }
+    if (runtime_filters)
+        runtime_filters->setReady(std::move(filters));
     in.reset();
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <Interpreters/JoinUtils.h>
+#include <Operator/RuntimeFilter.h>
 #include <Storages/StorageInMemoryMetadata.h>
 
 namespace DB
@@ -41,6 +42,9 @@ public:
         return block;
     }
 
+    /// Runtime filters on the join keys, in the order of key_names. Null if no key supports runtime filters.
+    RuntimeFilterHolderPtr getRuntimeFilters() const { return runtime_filters; }
+
 protected:
     void restore();
 
@@ -56,6 +60,7 @@ private:
 
     std::shared_ptr<DB::TableJoin> table_join;
     DB::HashJoinPtr join;
+    RuntimeFilterHolderPtr runtime_filters;
 
     std::unique_ptr<DB::ReadBuffer> in;
 };
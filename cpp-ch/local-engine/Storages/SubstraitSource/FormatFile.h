@@ -7,6 +7,7 @@
 #include <Core/Block.h>
 #include <IO/ReadBuffer.h>
 #include <Interpreters/Context.h>
+#include <Operator/RuntimeFilter.h>
 #include <Processors/Formats/IInputFormat.h>
 #include <Storages/SubstraitSource/ReadBufferBuilder.h>
 #include <substrait/plan.pb.h>
@@ -38,6 +39,10 @@ public:
     /// try to get rows from file metadata
     virtual std::optional<size_t> getTotalRows() { return {}; }
 
+    /// Whether the input format reads struct columns into tuples by itself. Otherwise the struct columns are
+    /// flattened into their fields for the input format and folded back after every chunk.
+    virtual bool supportNestedColumns() const { return false; }
+
     /// get partition keys from file path
     inline const std::vector<String> & getFilePartitionKeys() const { return partition_keys; }
 
@@ -48,12 +53,16 @@ public:
     virtual size_t getStartOffset() const { return file_info.start(); }
     virtual size_t getLength() const { return file_info.length(); }
 
+    /// Runtime filters pushed down from a join. The file may use them to skip data, e.g. parquet row groups.
+    void setRuntimeFilters(const PushedRuntimeFilters & runtime_filters_) { runtime_filters = runtime_filters_; }
+
 protected:
     DB::ContextPtr context;
     substrait::ReadRel::LocalFiles::FileOrFiles file_info;
     ReadBufferBuilderPtr read_buffer_builder;
     std::vector<String> partition_keys;
     std::map<String, String> partition_values;
+    PushedRuntimeFilters runtime_filters;
 };
 using FormatFilePtr = std::shared_ptr<FormatFile>;
 using FormatFiles = std::vector<FormatFilePtr>;
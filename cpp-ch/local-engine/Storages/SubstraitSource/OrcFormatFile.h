@@ -94,6 +94,7 @@ public:
     std::optional<size_t> getTotalRows() override;
 
     bool supportSplit() override { return true; }
+    bool supportNestedColumns() const override { return USE_LOCAL_FORMATS; }
 
 private:
     std::mutex mutex;
@@ -6,7 +6,9 @@
 #include <string>
 #include <utility>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <parquet/arrow/reader.h>
+#include <parquet/statistics.h>
 #include <Common/Config.h>
 #include <Formats/FormatFactory.h>
 #include <Formats/FormatSettings.h>
@@ -44,7 +46,7 @@ FormatFile::InputFormatPtr ParquetFormatFile::createInputFormat(const DB::Block
     {
         // reuse the read_buffer to avoid opening the file twice.
         // especially，the cost of opening a hdfs file is large.
-        required_row_groups = collectRequiredRowGroups(seekable_in, total_row_groups);
+        required_row_groups = collectRequiredRowGroups(seekable_in, total_row_groups, true);
         seekable_in->seek(0, SEEK_SET);
     }
     else
@@ -117,7 +119,64 @@ std::vector<RowGroupInfomation> ParquetFormatFile::collectRequiredRowGroups(int
     return collectRequiredRowGroups(in.get(), total_row_groups);
 }
 
-std::vector<RowGroupInfomation> ParquetFormatFile::collectRequiredRowGroups(DB::ReadBuffer * read_buffer, int & total_row_groups)
+/// Min/max of a column chunk, only for the physical types whose statistics can be compared with the
+/// runtime filter keys directly.
+static std::optional<std::pair<DB::Field, DB::Field>> getColumnChunkRange(const parquet::ColumnChunkMetaData & column_chunk)
+{
+    auto stats = column_chunk.statistics();
+    if (!stats || !stats->HasMinMax())
+        return {};
+
+    const auto & logical_type = column_chunk.descr()->logical_type();
+    /// Unsigned integers are stored as signed ones, their statistics are ordered differently.
+    bool is_unsigned = logical_type && logical_type->is_int()
+        && !std::static_pointer_cast<const parquet::IntLogicalType>(logical_type)->is_signed();
+    switch (stats->physical_type())
+    {
+        case parquet::Type::INT32: {
+            if (is_unsigned || (logical_type && !(logical_type->is_none() || logical_type->is_int() || logical_type->is_date())))
+                return {};
+            auto typed_stats = std::static_pointer_cast<parquet::Int32Statistics>(stats);
+            return std::make_pair(DB::Field(static_cast<Int64>(typed_stats->min())), DB::Field(static_cast<Int64>(typed_stats->max())));
+        }
+        case parquet::Type::INT64: {
+            if (is_unsigned || (logical_type && !(logical_type->is_none() || logical_type->is_int())))
+                return {};
+            auto typed_stats = std::static_pointer_cast<parquet::Int64Statistics>(stats);
+            return std::make_pair(DB::Field(static_cast<Int64>(typed_stats->min())), DB::Field(static_cast<Int64>(typed_stats->max())));
+        }
+        case parquet::Type::BYTE_ARRAY: {
+            if (logical_type && !(logical_type->is_none() || logical_type->is_string()))
+                return {};
+            auto typed_stats = std::static_pointer_cast<parquet::ByteArrayStatistics>(stats);
+            return std::make_pair(
+                DB::Field(parquet::ByteArrayToString(typed_stats->min())), DB::Field(parquet::ByteArrayToString(typed_stats->max())));
+        }
+        default:
+            return {};
+    }
+}
+
+/// Only keys whose Field representation matches the parquet statistics are used for pruning.
+static bool canPruneByStatistics(const DB::DataTypePtr & key_type)
+{
+    DB::WhichDataType which(key_type);
+    return which.isNativeInt() || which.isNativeUInt() || which.isDate() || which.isDate32() || which.isString();
+}
+
+static int findColumnIndex(const parquet::SchemaDescriptor & schema, const String & column_name)
+{
+    for (int i = 0; i < schema.num_columns(); ++i)
+    {
+        /// Only top level primitive columns, the same as the case insensitive matching of the input format.
+        if (schema.Column(i)->path()->ToDotVector().size() == 1 && boost::iequals(schema.Column(i)->name(), column_name))
+            return i;
+    }
+    return -1;
+}
+
+std::vector<RowGroupInfomation>
+ParquetFormatFile::collectRequiredRowGroups(DB::ReadBuffer * read_buffer, int & total_row_groups, bool apply_runtime_filters)
 {
     DB::FormatSettings format_settings{
         .seekable_read = true,
@@ -154,7 +213,43 @@ std::vector<RowGroupInfomation> ParquetFormatFile::collectRequiredRowGroups(DB::
             row_group_metadatas.emplace_back(std::move(info));
         }
     }
-    return row_group_metadatas;
+
+    if (!apply_runtime_filters || runtime_filters.empty())
+        return row_group_metadatas;
+
+    std::vector<std::pair<const PushedRuntimeFilter *, int>> usable_filters;
+    for (const auto & runtime_filter : runtime_filters)
+    {
+        if (!runtime_filter.isReady() || !canPruneByStatistics(runtime_filter.getFilter().getKeyType()))
+            continue;
+        int column_index = findColumnIndex(*file_meta->schema(), runtime_filter.column_name);
+        if (column_index >= 0)
+            usable_filters.emplace_back(&runtime_filter, column_index);
+    }
+    if (usable_filters.empty())
+        return row_group_metadatas;
+
+    std::vector<RowGroupInfomation> pruned_row_groups;
+    for (auto & info : row_group_metadatas)
+    {
+        auto row_group_meta = file_meta->RowGroup(info.index);
+        bool may_match = true;
+        for (const auto & [runtime_filter, column_index] : usable_filters)
+        {
+            auto range = getColumnChunkRange(*row_group_meta->ColumnChunk(column_index));
+            if (range && !runtime_filter->getFilter().mayIntersect(range->first, range->second))
+            {
+                auto & metrics = runtime_filter->holder->getMetrics();
+                metrics.skipped_row_groups += 1;
+                metrics.skipped_rows += info.num_rows;
+                may_match = false;
+                break;
+            }
+        }
+        if (may_match)
+            pruned_row_groups.emplace_back(std::move(info));
+    }
+    return pruned_row_groups;
 }
 }
 #endif
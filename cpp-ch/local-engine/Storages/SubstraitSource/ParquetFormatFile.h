@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include <Common/Config.h>
 
 #if USE_PARQUET
 // clang-format off
@@ -27,13 +28,15 @@ public:
     FormatFile::InputFormatPtr createInputFormat(const DB::Block & header) override;
     std::optional<size_t> getTotalRows() override;
     bool supportSplit() override { return true; }
+    bool supportNestedColumns() const override { return USE_LOCAL_FORMATS; }
 
 private:
     std::mutex mutex;
     std::optional<size_t> total_rows;
 
     std::vector<RowGroupInfomation> collectRequiredRowGroups(int & total_row_groups);
-    std::vector<RowGroupInfomation> collectRequiredRowGroups(DB::ReadBuffer * read_buffer, int & total_row_groups);
+    std::vector<RowGroupInfomation>
+    collectRequiredRowGroups(DB::ReadBuffer * read_buffer, int & total_row_groups, bool apply_runtime_filters = false);
 };
 
 }
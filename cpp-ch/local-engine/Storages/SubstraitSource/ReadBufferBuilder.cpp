@@ -1,4 +1,5 @@
 #include <memory>
+#include <mutex>
 #include <Disks/IO/AsynchronousBoundedReadBuffer.h>
 #include <Disks/IO/ReadBufferFromAzureBlobStorage.h>
 #include <Disks/IO/ReadBufferFromRemoteFSGather.h>
@@ -248,7 +249,11 @@ public:
         Poco::URI file_uri(file_info.uri_file());
         // file uri looks like: s3a://my-dev-bucket/tpch100/part/0001.parquet
         std::string bucket = file_uri.getHost();
-        const auto client = getClient(bucket);
+        std::shared_ptr<DB::S3::Client> client;
+        {
+            std::lock_guard lock(clients_mutex);
+            client = getClient(bucket);
+        }
         std::string key = file_uri.getPath().substr(1);
         size_t object_size = DB::S3::getObjectSize(*client, bucket, key, "");
 
@@ -286,6 +291,8 @@ public:
 private:
     // TODO: currently every SubstraitFileSource will create its own ReadBufferBuilder,
     // so the cached clients are not actually shared among different tasks
+    /// The files of a source may be opened concurrently when they are prefetched.
+    std::mutex clients_mutex;
     std::map<std::string, std::shared_ptr<DB::S3::Client>> per_bucket_clients;
     std::shared_ptr<DB::S3::Client> shared_client;
     DB::ReadSettings new_settings;
@@ -14,7 +14,7 @@ public:
     explicit ReadBufferBuilder(DB::ContextPtr context_) : context(context_) { }
     virtual ~ReadBufferBuilder() = default;
 
-    /// build a new read buffer
+    /// build a new read buffer, may be called concurrently
     virtual std::unique_ptr<DB::ReadBuffer>
     build(const substrait::ReadRel::LocalFiles::FileOrFiles & file_info, bool set_read_util_position = false) = 0;
 
@@ -1,12 +1,16 @@
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <unordered_set>
 
 #include <substrait/plan.pb.h>
 #include <magic_enum.hpp>
 #include <Poco/URI.h>
 
+#include <Columns/ColumnConst.h>
 #include <Columns/ColumnNullable.h>
 #include <Columns/ColumnTuple.h>
+#include <Columns/ColumnsCommon.h>
 #include <Columns/ColumnsNumber.h>
 #include <DataTypes/DataTypeNullable.h>
 #include <DataTypes/DataTypeTuple.h>
@@ -17,9 +21,12 @@
 #include <QueryPipeline/Pipe.h>
 #include <Storages/SubstraitSource/FormatFile.h>
 #include <Storages/SubstraitSource/SubstraitFileSource.h>
+#include <base/scope_guard.h>
 #include <Common/CHUtil.h>
+#include <Common/CurrentThread.h>
 #include <Common/Exception.h>
 #include <Common/StringUtils.h>
+#include <Common/setThreadName.h>
 #include <Common/typeid_cast.h>
 
 namespace DB
@@ -30,6 +37,12 @@ namespace ErrorCodes
     extern const int LOGICAL_ERROR;
 }
 }
+
+namespace CurrentMetrics
+{
+extern const Metric LocalThread;
+extern const Metric LocalThreadActive;
+}
 namespace local_engine
 {
 // When run query "select count(*) from t", there is no any column to be read.
@@ -53,10 +66,9 @@ SubstraitFileSource::SubstraitFileSource(
      * struct type and cause some exceptions. To solve this, we flatten all struct columns into
      * independent field columns recursively, and fold the field columns back into struct columns
      * at the end.
+     * The formats which read the struct columns into tuples by fields names (parquet and orc) take
+     * the struct columns as they are, only the wanted fields are read and nothing is folded.
      */
-    flatten_output_header = BlockUtil::flattenBlock(output_header, BlockUtil::FLAT_STRUCT, true);
-
-    to_read_header = flatten_output_header;
     if (file_infos.items_size())
     {
         Poco::URI file_uri(file_infos.items().Get(0).uri_file());
@@ -65,7 +77,18 @@ SubstraitFileSource::SubstraitFileSource(
         {
             files.emplace_back(FormatFileUtil::createFile(context, read_buffer_builder, item));
         }
+        flatten_struct_columns
+            = !std::all_of(files.begin(), files.end(), [](const FormatFilePtr & file) { return file->supportNestedColumns(); });
+    }
+
+    if (flatten_struct_columns)
+        flatten_output_header = BlockUtil::flattenBlock(output_header, BlockUtil::FLAT_STRUCT, true);
+    else
+        flatten_output_header = output_header;
 
+    to_read_header = flatten_output_header;
+    if (!files.empty())
+    {
         auto partition_keys = files[0]->getFilePartitionKeys();
         /// file partition keys are read from the file path
         for (const auto & key : partition_keys)
@@ -75,9 +98,29 @@ SubstraitFileSource::SubstraitFileSource(
                 to_read_header.erase(key);
             }
         }
+
+        if (files.size() > 1)
+        {
+            const auto & config = context->getConfigRef();
+            prefetch_files = config.getUInt64("file_prefetch.files", 2);
+            max_prefetched_bytes = config.getUInt64("file_prefetch.max_bytes", 0);
+            if (prefetch_files)
+                prefetch_pool = std::make_unique<ThreadPool>(
+                    CurrentMetrics::LocalThread, CurrentMetrics::LocalThreadActive, std::min(prefetch_files, files.size() - 1));
+        }
     }
 }
 
+SubstraitFileSource::~SubstraitFileSource()
+{
+    /// The prefetching jobs reference this source.
+    cancelled = true;
+    if (prefetch_pool)
+        prefetch_pool->wait();
+    /// The reader of a prefetched file references prefetched_bytes.
+    file_reader.reset();
+}
+
 DB::Chunk SubstraitFileSource::generate()
 {
     while (true)
@@ -93,9 +136,18 @@ DB::Chunk SubstraitFileSource::generate()
         {
             if (output_header.columns())
             {
-                auto block = foldFlattenColumns(chunk.detachColumns(), output_header);
-                auto columns = block.getColumns();
-                return DB::Chunk(columns, block.rows());
+                DB::Chunk result;
+                if (flatten_struct_columns)
+                {
+                    auto block = foldFlattenColumns(chunk.detachColumns(), output_header);
+                    result = DB::Chunk(block.getColumns(), block.rows());
+                }
+                else
+                    result = std::move(chunk);
+                applyRuntimeFilters(result);
+                if (!result.getNumRows())
+                    continue;
+                return result;
             }
             else
             {
@@ -120,36 +172,283 @@ bool SubstraitFileSource::tryPrepareReader()
     auto current_file = files[current_file_index];
     current_file_index += 1;
 
-    if (!current_file->supportSplit() && current_file->getStartOffset())
+    /// The front of prefetched_files is the current file, if it has been prefetched.
+    PrefetchedFilePtr prefetched;
+    if (!prefetched_files.empty())
     {
-        /// For the files do not support split strategy, the task with not 0 offset will generate empty data
+        prefetched = std::move(prefetched_files.front());
+        prefetched_files.pop_front();
+    }
+    prefetchNextFiles();
+
+    if (isPrunedByPartitionFilter(current_file_index - 1) || canSkipFileByRuntimeFilters(current_file))
+    {
+        if (prefetched)
+        {
+            prefetched->prefetching.wait();
+            prefetched_bytes -= prefetched->bytes;
+        }
         file_reader = std::make_unique<EmptyFileReader>(current_file);
         return true;
     }
 
+    if (prefetched)
+    {
+        /// Rethrows the exception of the prefetching, if any.
+        prefetched->prefetching.get();
+        file_reader = std::make_unique<PrefetchedFileReader>(current_file, prefetched, prefetched_bytes);
+        return true;
+    }
+
+    file_reader = createReader(current_file);
+    return true;
+}
+
+std::unique_ptr<FileReaderWrapper> SubstraitFileSource::createReader(const FormatFilePtr & file) const
+{
+    if (!file->supportSplit() && file->getStartOffset())
+    {
+        /// For the files do not support split strategy, the task with not 0 offset will generate empty data
+        return std::make_unique<EmptyFileReader>(file);
+    }
+
     if (!to_read_header.columns())
     {
-        auto total_rows = current_file->getTotalRows();
+        auto total_rows = file->getTotalRows();
         if (total_rows)
+            return std::make_unique<ConstColumnsFileReader>(file, context, flatten_output_header, *total_rows);
+
+        /// For text/json format file, we can't get total rows from file metadata.
+        /// So we add a dummy column to indicate the number of rows.
+        auto dummy_header = BlockUtil::buildRowCountHeader();
+        auto flatten_output_header_contains_dummy = flatten_output_header;
+        flatten_output_header_contains_dummy.insertUnique(dummy_header.getByPosition(0));
+        return std::make_unique<NormalFileReader>(file, context, dummy_header, flatten_output_header_contains_dummy);
+    }
+
+    return std::make_unique<NormalFileReader>(file, context, to_read_header, flatten_output_header);
+}
+
+void SubstraitFileSource::prefetchNextFiles()
+{
+    if (!prefetch_pool || cancelled)
+        return;
+
+    auto thread_group = DB::CurrentThread::getGroup();
+    while (prefetched_files.size() < prefetch_files && current_file_index + prefetched_files.size() < files.size())
+    {
+        size_t file_index = current_file_index + prefetched_files.size();
+        auto file = files[file_index];
+        auto prefetched = std::make_shared<PrefetchedFile>();
+        auto promise = std::make_shared<std::promise<void>>();
+        prefetched->prefetching = promise->get_future();
+        if (isPrunedByPartitionFilter(file_index))
         {
-            file_reader = std::make_unique<ConstColumnsFileReader>(current_file, context, flatten_output_header, *total_rows);
+            /// Skipped without being opened.
+            promise->set_value();
+            prefetched_files.emplace_back(std::move(prefetched));
+            continue;
         }
-        else
+        prefetch_pool->scheduleOrThrowOnError(
+            [this, file, prefetched, promise, thread_group]()
+            {
+                if (thread_group)
+                    DB::CurrentThread::attachToGroupIfDetached(thread_group);
+                SCOPE_EXIT_SAFE(if (thread_group) DB::CurrentThread::detachFromGroupIfNotDetached(););
+                setThreadName("FilePrefetch");
+                try
+                {
+                    prefetch(file, *prefetched);
+                    promise->set_value();
+                }
+                catch (...)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        prefetched_files.emplace_back(std::move(prefetched));
+    }
+}
+
+void SubstraitFileSource::prefetch(const FormatFilePtr & file, PrefetchedFile & prefetched)
+{
+    if (cancelled)
+        return;
+    prefetched.reader = createReader(file);
+
+    /// The first chunk is always read, it's where opening the file and the first read happen.
+    do
+    {
+        DB::Chunk chunk;
+        if (!prefetched.reader->pull(chunk))
         {
-            /// For text/json format file, we can't get total rows from file metadata.
-            /// So we add a dummy column to indicate the number of rows.
-            auto dummy_header = BlockUtil::buildRowCountHeader();
-            auto flatten_output_header_contains_dummy = flatten_output_header;
-            flatten_output_header_contains_dummy.insertUnique(dummy_header.getByPosition(0));
-            file_reader = std::make_unique<NormalFileReader>(current_file, context, dummy_header, flatten_output_header_contains_dummy);
+            prefetched.finished = true;
+            break;
         }
+        size_t bytes = chunk.bytes();
+        prefetched.bytes += bytes;
+        prefetched_bytes += bytes;
+        prefetched.chunks.emplace_back(std::move(chunk));
+    } while (!cancelled && prefetched_bytes < max_prefetched_bytes);
+}
+
+void SubstraitFileSource::addRuntimeFilters(const PushedRuntimeFilters & runtime_filters_)
+{
+    for (const auto & runtime_filter : runtime_filters_)
+    {
+        if (output_header.has(runtime_filter.column_name))
+            runtime_filters.emplace_back(runtime_filter);
     }
-    else
+    for (auto & file : files)
+        file->setRuntimeFilters(runtime_filters);
+}
+
+std::vector<String> SubstraitFileSource::getPartitionKeys() const
+{
+    if (files.empty())
+        return {};
+    return files[0]->getFilePartitionKeys();
+}
+
+void SubstraitFileSource::setPartitionFilter(const DB::ExpressionActionsPtr & actions, const DB::Names & filter_columns)
+{
+    const auto required_columns = actions->getRequiredColumnsWithTypes();
+    pruned_files.clear();
+    partition_filter_skipped_files = 0;
+    for (const auto & column : required_columns)
     {
-        file_reader = std::make_unique<NormalFileReader>(current_file, context, to_read_header, flatten_output_header);
+        if (!FileReaderWrapper::isSupportedPartitionType(column.type))
+            return;
     }
 
-    return true;
+    pruned_files.assign(files.size(), 0);
+    /// Usually many files share the same partition.
+    std::map<std::map<String, String>, bool> pruned_partitions;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const auto & partition_values = files[i]->getFilePartitionValues();
+        auto [it, inserted] = pruned_partitions.try_emplace(partition_values, false);
+        if (inserted)
+        {
+            try
+            {
+                DB::Block block;
+                for (const auto & column : required_columns)
+                {
+                    auto value = partition_values.find(column.name);
+                    if (value == partition_values.end())
+                        throw DB::Exception(
+                            DB::ErrorCodes::LOGICAL_ERROR, "Not found column({}) from file({}) partition keys.", column.name, files[i]->getURIPath());
+                    block.insert({FileReaderWrapper::createColumn(value->second, column.type, 1), column.type, column.name});
+                }
+                size_t rows = 1;
+                actions->execute(block, rows);
+                for (const auto & name : filter_columns)
+                {
+                    const auto & column = block.getByName(name).column;
+                    if (column->isNullAt(0) || !column->getBool(0))
+                    {
+                        it->second = true;
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                /// All the files are read, the filter above evaluates them on every row and reports the error if any.
+                DB::tryLogCurrentException("SubstraitFileSource", "Partition filter is not applied");
+                pruned_files.clear();
+                partition_filter_skipped_files = 0;
+                return;
+            }
+        }
+        pruned_files[i] = it->second;
+        partition_filter_skipped_files += it->second;
+    }
+}
+
+bool SubstraitFileSource::canSkipFileByRuntimeFilters(const FormatFilePtr & file) const
+{
+    const auto & partition_values = file->getFilePartitionValues();
+    for (const auto & runtime_filter : runtime_filters)
+    {
+        if (!runtime_filter.isReady())
+            continue;
+        auto it = partition_values.find(runtime_filter.column_name);
+        if (it == partition_values.end())
+            continue;
+
+        /// All the rows of this file have the same value on a partition column, test it only once.
+        auto column = FileReaderWrapper::createColumn(it->second, output_header.getByName(runtime_filter.column_name).type, 1);
+        DB::IColumn::Filter filter(1, 1);
+        runtime_filter.getFilter().apply(*column, filter);
+        if (!filter[0])
+        {
+            runtime_filter.holder->getMetrics().skipped_files += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SubstraitFileSource::applyRuntimeFilters(DB::Chunk & chunk)
+{
+    size_t rows = chunk.getNumRows();
+    DB::IColumn::Filter filter;
+    auto columns = chunk.detachColumns();
+    for (const auto & runtime_filter : runtime_filters)
+    {
+        if (!runtime_filter.isReady())
+            continue;
+        if (filter.empty())
+            filter.resize_fill(rows, 1);
+        const auto & column = columns[output_header.getPositionByName(runtime_filter.column_name)];
+        if (const auto * const_column = typeid_cast<const DB::ColumnConst *>(column.get()))
+        {
+            /// A partition column, test its value only once.
+            DB::IColumn::Filter const_filter(1, 1);
+            runtime_filter.getFilter().apply(*const_column->getDataColumn().convertToFullColumnIfLowCardinality(), const_filter);
+            if (!const_filter[0])
+                std::fill(filter.begin(), filter.end(), 0);
+            continue;
+        }
+        runtime_filter.getFilter().apply(*column->convertToFullColumnIfLowCardinality(), filter);
+    }
+
+    size_t result_rows = filter.empty() ? rows : DB::countBytesInFilter(filter);
+    if (result_rows < rows)
+    {
+        for (auto & column : columns)
+            column = column->filter(filter, result_rows);
+        runtime_filter_rows += rows - result_rows;
+    }
+    chunk.setColumns(std::move(columns), result_rows);
+}
+
+void SubstraitFileSource::collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const
+{
+    if (!pruned_files.empty())
+        extra_metrics["partition_filter_skipped_files"] = partition_filter_skipped_files;
+    if (runtime_filters.empty())
+        return;
+
+    size_t skipped_files = 0;
+    size_t skipped_row_groups = 0;
+    size_t skipped_rows = 0;
+    std::unordered_set<const RuntimeFilterHolder *> holders;
+    for (const auto & runtime_filter : runtime_filters)
+    {
+        if (!holders.emplace(runtime_filter.holder.get()).second)
+            continue;
+        const auto & metrics = runtime_filter.holder->getMetrics();
+        skipped_files += metrics.skipped_files;
+        skipped_row_groups += metrics.skipped_row_groups;
+        skipped_rows += metrics.skipped_rows;
+    }
+    extra_metrics["runtime_filter_rows"] = runtime_filter_rows;
+    extra_metrics["runtime_filter_skipped_files"] = skipped_files;
+    extra_metrics["runtime_filter_skipped_row_groups"] = skipped_row_groups;
+    extra_metrics["runtime_filter_skipped_rows"] = skipped_rows;
 }
 
 DB::Block SubstraitFileSource::foldFlattenColumns(const DB::Columns & cols, const DB::Block & header)
@@ -215,12 +514,8 @@ SubstraitFileSource::foldFlattenColumn(DB::DataTypePtr col_type, const std::stri
 
 DB::ColumnPtr FileReaderWrapper::createConstColumn(DB::DataTypePtr data_type, const DB::Field & field, size_t rows)
 {
-    auto nested_type = DB::removeNullable(data_type);
-    auto column = nested_type->createColumnConst(rows, field);
-
-    if (data_type->isNullable())
-        column = DB::ColumnNullable::create(column, DB::ColumnUInt8::create(rows, 0));
-    return column;
+    /// Nullable too, a ColumnNullable would materialize the value and the null map for every row.
+    return data_type->createColumnConst(rows, field);
 }
 
 DB::ColumnPtr FileReaderWrapper::createColumn(const String & value, DB::DataTypePtr type, size_t rows)
@@ -231,9 +526,7 @@ DB::ColumnPtr FileReaderWrapper::createColumn(const String & value, DB::DataType
         {
             throw DB::Exception(DB::ErrorCodes::LOGICAL_ERROR, "Partition column is null value,but column data type is not nullable.");
         }
-        auto nested_type = static_cast<const DB::DataTypeNullable &>(*type).getNestedType();
-        auto column = nested_type->createColumnConstWithDefaultValue(rows);
-        return DB::ColumnNullable::create(column, DB::ColumnUInt8::create(rows, 1));
+        return type->createColumnConst(rows, DB::Null{});
     }
     else
     {
@@ -258,10 +551,11 @@ DB::ColumnPtr FileReaderWrapper::createColumn(const String & value, DB::DataType
         return DB::Field(value); \
     }
 
-DB::Field FileReaderWrapper::buildFieldFromString(const String & str_value, DB::DataTypePtr type)
+using FieldBuilder = std::function<DB::Field(DB::ReadBuffer &, const String &)>;
+
+static const std::map<int, FieldBuilder> & getFieldBuilders()
 {
-    using FieldBuilder = std::function<DB::Field(DB::ReadBuffer &, const String &)>;
-    static std::map<int, FieldBuilder> field_builders
+    static const std::map<int, FieldBuilder> field_builders
         = {{magic_enum::enum_integer(DB::TypeIndex::Int8), BUILD_INT_FIELD(Int8)},
            {magic_enum::enum_integer(DB::TypeIndex::Int16), BUILD_INT_FIELD(Int16)},
            {magic_enum::enum_integer(DB::TypeIndex::Int32), BUILD_INT_FIELD(Int32)},
@@ -283,7 +577,17 @@ DB::Field FileReaderWrapper::buildFieldFromString(const String & str_value, DB::
                 readDateText(value, in);
                 return DB::Field(value.toUnderType());
             }}};
+    return field_builders;
+}
 
+bool FileReaderWrapper::isSupportedPartitionType(const DB::DataTypePtr & type)
+{
+    return getFieldBuilders().contains(magic_enum::enum_integer(DB::removeNullable(type)->getTypeId()));
+}
+
+DB::Field FileReaderWrapper::buildFieldFromString(const String & str_value, DB::DataTypePtr type)
+{
+    const auto & field_builders = getFieldBuilders();
     auto nested_type = DB::removeNullable(type);
     DB::ReadBufferFromString read_buffer(str_value);
     auto it = field_builders.find(magic_enum::enum_integer(nested_type->getTypeId()));
@@ -299,6 +603,17 @@ ConstColumnsFileReader::ConstColumnsFileReader(FormatFilePtr file_, DB::ContextP
     if (!rows)
         throw DB::Exception(DB::ErrorCodes::LOGICAL_ERROR, "Cannot get total rows number from file : {}", file->getURIPath());
     remained_rows = *rows;
+
+    const auto & partition_values = file->getFilePartitionValues();
+    for (const auto & column : header)
+    {
+        auto it = partition_values.find(column.name);
+        if (it == partition_values.end()) [[unlikely]]
+        {
+            throw DB::Exception(DB::ErrorCodes::LOGICAL_ERROR, "Unknow partition column : {}", column.name);
+        }
+        partition_columns.emplace_back(createColumn(it->second, column.type, 1));
+    }
 }
 
 bool ConstColumnsFileReader::pull(DB::Chunk & chunk)
@@ -318,23 +633,11 @@ bool ConstColumnsFileReader::pull(DB::Chunk & chunk)
         remained_rows -= block_size;
     }
     DB::Columns res_columns;
-    size_t columns_num = header.columns();
-    if (columns_num)
+    if (!partition_columns.empty())
     {
-        res_columns.reserve(columns_num);
-        const auto & partition_values = file->getFilePartitionValues();
-        for (size_t pos = 0; pos < columns_num; ++pos)
-        {
-            auto col_with_name_and_type = header.getByPosition(pos);
-            auto type = col_with_name_and_type.type;
-            const auto & name = col_with_name_and_type.name;
-            auto it = partition_values.find(name);
-            if (it == partition_values.end()) [[unlikely]]
-            {
-                throw DB::Exception(DB::ErrorCodes::LOGICAL_ERROR, "Unknow partition column : {}", name);
-            }
-            res_columns.emplace_back(createColumn(it->second, type, to_read_rows));
-        }
+        res_columns.reserve(partition_columns.size());
+        for (const auto & column : partition_columns)
+            res_columns.emplace_back(column->cloneResized(to_read_rows));
     }
     else
     {
@@ -346,6 +649,34 @@ bool ConstColumnsFileReader::pull(DB::Chunk & chunk)
     return true;
 }
 
+PrefetchedFileReader::PrefetchedFileReader(
+    FormatFilePtr file_, PrefetchedFilePtr prefetched_, std::atomic<size_t> & prefetched_bytes_)
+    : FileReaderWrapper(file_), prefetched(prefetched_), prefetched_bytes(prefetched_bytes_)
+{
+}
+
+PrefetchedFileReader::~PrefetchedFileReader()
+{
+    prefetched_bytes -= prefetched->bytes;
+}
+
+bool PrefetchedFileReader::pull(DB::Chunk & chunk)
+{
+    if (!prefetched->chunks.empty())
+    {
+        chunk = std::move(prefetched->chunks.front());
+        prefetched->chunks.pop_front();
+        size_t bytes = chunk.bytes();
+        prefetched->bytes -= bytes;
+        prefetched_bytes -= bytes;
+        return true;
+    }
+    /// The prefetching was cancelled before the file was opened.
+    if (prefetched->finished || !prefetched->reader)
+        return false;
+    return prefetched->reader->pull(chunk);
+}
+
 NormalFileReader::NormalFileReader(
     FormatFilePtr file_, DB::ContextPtr context_, const DB::Block & to_read_header_, const DB::Block & output_header_)
     : FileReaderWrapper(file_), context(context_), to_read_header(to_read_header_), output_header(output_header_)
@@ -354,6 +685,25 @@ NormalFileReader::NormalFileReader(
     DB::Pipe pipe(input_format->input);
     pipeline = std::make_unique<DB::QueryPipeline>(std::move(pipe));
     reader = std::make_unique<DB::PullingPipelineExecutor>(*pipeline);
+
+    const auto & partition_values = file->getFilePartitionValues();
+    for (const auto & column : output_header)
+    {
+        if (to_read_header.has(column.name))
+        {
+            read_positions.emplace_back(to_read_header.getPositionByName(column.name));
+            partition_columns.emplace_back();
+            continue;
+        }
+        auto it = partition_values.find(column.name);
+        if (it == partition_values.end())
+        {
+            throw DB::Exception(
+                DB::ErrorCodes::LOGICAL_ERROR, "Not found column({}) from file({}) partition keys.", column.name, file->getURIPath());
+        }
+        read_positions.emplace_back();
+        partition_columns.emplace_back(createColumn(it->second, column.type, 1));
+    }
 }
 
 
@@ -369,27 +719,14 @@ bool NormalFileReader::pull(DB::Chunk & chunk)
         return false;
 
     auto read_columns = tmp_chunk.detachColumns();
-    auto columns_with_name_and_type = output_header.getColumnsWithTypeAndName();
-    auto partition_values = file->getFilePartitionValues();
-
     DB::Columns res_columns;
-    for (auto & column : columns_with_name_and_type)
+    res_columns.reserve(read_positions.size());
+    for (size_t i = 0; i < read_positions.size(); ++i)
     {
-        if (to_read_header.has(column.name))
-        {
-            auto pos = to_read_header.getPositionByName(column.name);
-            res_columns.push_back(read_columns[pos]);
-        }
+        if (read_positions[i])
+            res_columns.push_back(read_columns[*read_positions[i]]);
         else
-        {
-            auto it = partition_values.find(column.name);
-            if (it == partition_values.end())
-            {
-                throw DB::Exception(
-                    DB::ErrorCodes::LOGICAL_ERROR, "Not found column({}) from file({}) partition keys.", column.name, file->getURIPath());
-            }
-            res_columns.push_back(createColumn(it->second, column.type, rows));
-        }
+            res_columns.push_back(partition_columns[i]->cloneResized(rows));
     }
 
     chunk = DB::Chunk(std::move(res_columns), rows);
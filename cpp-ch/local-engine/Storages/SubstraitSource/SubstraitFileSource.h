@@ -1,10 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <list>
+#include <optional>
 #include <Columns/IColumn.h>
 #include <Core/Block.h>
 #include <Core/ColumnsWithTypeAndName.h>
 #include <Core/Field.h>
 #include <Interpreters/Context.h>
+#include <Interpreters/ExpressionActions.h>
+#include <Operator/RuntimeFilter.h>
+#include <Parser/RelMetric.h>
 #include <Processors/Chunk.h>
 #include <Processors/Executors/PullingPipelineExecutor.h>
 #include <Processors/ISource.h>
@@ -12,6 +20,7 @@
 #include <Storages/SubstraitSource/FormatFile.h>
 #include <Storages/SubstraitSource/ReadBufferBuilder.h>
 #include <base/types.h>
+#include <Common/ThreadPool.h>
 
 namespace local_engine
 {
@@ -22,11 +31,15 @@ public:
     virtual ~FileReaderWrapper() = default;
     virtual bool pull(DB::Chunk & chunk) = 0;
 
+    /// Build a column from a partition value in the file path, it's a ColumnConst
+    static DB::ColumnPtr createColumn(const String & value, DB::DataTypePtr type, size_t rows);
+    /// Whether createColumn can build a column of the type, nullable or not.
+    static bool isSupportedPartitionType(const DB::DataTypePtr & type);
+
 protected:
     FormatFilePtr file;
 
     static DB::ColumnPtr createConstColumn(DB::DataTypePtr type, const DB::Field & field, size_t rows);
-    static DB::ColumnPtr createColumn(const String & value, DB::DataTypePtr type, size_t rows);
     static DB::Field buildFieldFromString(const String & value, DB::DataTypePtr type);
 };
 
@@ -41,6 +54,10 @@ private:
     DB::ContextPtr context;
     DB::Block to_read_header;
     DB::Block output_header;
+    /// For every column of output_header, its position in to_read_header, or none for a partition column.
+    std::vector<std::optional<size_t>> read_positions;
+    /// The partition columns of output_header with one row, resized for every chunk.
+    DB::Columns partition_columns;
 
     FormatFile::InputFormatPtr input_format;
     std::unique_ptr<DB::QueryPipeline> pipeline;
@@ -68,23 +85,66 @@ private:
     DB::Block header;
     size_t remained_rows;
     size_t block_size;
+    /// The columns of header with one row, resized for every chunk.
+    DB::Columns partition_columns;
 };
 
-class SubstraitFileSource : public DB::ISource
+/// A file opened and read ahead in the background by SubstraitFileSource.
+struct PrefetchedFile
+{
+    std::unique_ptr<FileReaderWrapper> reader;
+    /// The chunks read ahead, the reader continues after them.
+    std::list<DB::Chunk> chunks;
+    size_t bytes = 0;
+    bool finished = false;
+    std::future<void> prefetching;
+};
+using PrefetchedFilePtr = std::shared_ptr<PrefetchedFile>;
+
+/// Returns the chunks of a prefetched file, then continues to read it.
+class PrefetchedFileReader : public FileReaderWrapper
+{
+public:
+    PrefetchedFileReader(FormatFilePtr file_, PrefetchedFilePtr prefetched_, std::atomic<size_t> & prefetched_bytes_);
+    ~PrefetchedFileReader() override;
+    bool pull(DB::Chunk & chunk) override;
+
+private:
+    PrefetchedFilePtr prefetched;
+    std::atomic<size_t> & prefetched_bytes;
+};
+
+class SubstraitFileSource : public DB::ISource, public IExtraMetricsProvider
 {
 public:
     SubstraitFileSource(DB::ContextPtr context_, const DB::Block & header_, const substrait::ReadRel::LocalFiles & file_infos);
-    ~SubstraitFileSource() override = default;
+    ~SubstraitFileSource() override;
 
     String getName() const override { return "SubstraitFileSource"; }
 
+    /// Runtime filters from a join on top of this scan. They are used to skip files by partition values,
+    /// to skip parquet row groups by statistics and to filter the rows read, once the join's build side
+    /// is finished.
+    void addRuntimeFilters(const PushedRuntimeFilters & runtime_filters_);
+    /// The partition keys found in the file paths.
+    std::vector<String> getPartitionKeys() const;
+    /// Conjuncts of the filter above this source which only reference partition columns. They are evaluated once
+    /// per distinct partition on its values, the files failing any of them are skipped without being opened.
+    /// Nothing is pruned if a partition column has a type the partition values can't be parsed into.
+    void setPartitionFilter(const DB::ExpressionActionsPtr & actions, const DB::Names & filter_columns);
+    void collectExtraMetrics(std::map<String, UInt64> & extra_metrics) const override;
+
 protected:
     DB::Chunk generate() override;
+    void onCancel() override { cancelled = true; }
 
 private:
     DB::ContextPtr context;
     DB::Block output_header; /// Sample header before flatten, may contains partitions keys
     DB::Block flatten_output_header; // Sample header after flatten, include partition keys
+    /// False if all the files read struct columns into tuples directly, then nothing is flattened and
+    /// flatten_output_header is the same as output_header.
+    bool flatten_struct_columns = true;
     DB::Block to_read_header; // Sample header after flatten, not include partition keys
     FormatFiles files;
 
@@ -92,7 +152,32 @@ private:
     std::unique_ptr<FileReaderWrapper> file_reader;
     ReadBufferBuilderPtr read_buffer_builder;
 
+    /// The next prefetch_files files are opened and their first chunks are read in the background, while the
+    /// current one is read. Besides the first chunks, they are read ahead until the chunks read ahead by all
+    /// of them take max_prefetched_bytes. The files are still returned one after another, in their order.
+    size_t prefetch_files = 0;
+    size_t max_prefetched_bytes = 0;
+    /// The prefetched files after the current one, in order.
+    std::deque<PrefetchedFilePtr> prefetched_files;
+    std::atomic<size_t> prefetched_bytes = 0;
+    std::atomic<bool> cancelled = false;
+    std::unique_ptr<ThreadPool> prefetch_pool;
+
+    PushedRuntimeFilters runtime_filters;
+    size_t runtime_filter_rows = 0;
+
+    /// Whether each file is pruned by the partition filter, empty without a partition filter.
+    std::vector<UInt8> pruned_files;
+    size_t partition_filter_skipped_files = 0;
+
     bool tryPrepareReader();
+    std::unique_ptr<FileReaderWrapper> createReader(const FormatFilePtr & file) const;
+    /// Schedules the prefetching of the files after the current one, up to prefetch_files of them.
+    void prefetchNextFiles();
+    void prefetch(const FormatFilePtr & file, PrefetchedFile & prefetched);
+    bool canSkipFileByRuntimeFilters(const FormatFilePtr & file) const;
+    bool isPrunedByPartitionFilter(size_t file_index) const { return !pruned_files.empty() && pruned_files[file_index]; }
+    void applyRuntimeFilters(DB::Chunk & chunk);
 
     // E.g we have flatten columns correspond to header {a:int, b.x.i: int, b.x.j: string, b.y: string}
     // but we want to fold all the flatten struct columns into one struct column,
@@ -38,6 +38,7 @@
 #include <Common/quoteString.h>
 
 #include <arrow/column_reader.h>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <Poco/Logger.h>
 #include <Common/logger_useful.h>
@@ -343,11 +344,96 @@ static ColumnWithTypeAndName readColumnFromArrowColumn(
     const std::shared_ptr<arrow::Field> & arrow_field,
     std::shared_ptr<arrow::ChunkedArray> & arrow_column,
     const std::string & format_name,
-    std::unordered_map<String, std::shared_ptr<ColumnWithTypeAndName>> & dictionary_values,
+    std::unordered_map<String, ArrowDictionary> & dictionary_values,
+    bool read_ints_as_dates);
+
+/// Unlike a ColumnUnique, an Arrow dictionary has no default value at position 0 (and no null at position 1 if it's
+/// nullable) and may not contain unique values, so the Arrow indexes are mapped to the positions of the values in
+/// the ColumnUnique. The dictionary is only converted again when it changes.
+static ColumnWithTypeAndName readColumnWithDictionaryData(
+    const std::shared_ptr<arrow::Field> & arrow_field,
+    std::shared_ptr<arrow::ChunkedArray> & arrow_column,
+    const std::string & format_name,
+    ArrowDictionary & dictionary,
+    bool read_ints_as_dates)
+{
+    auto * arrow_dict_type = assert_cast<arrow::DictionaryType *>(arrow_field->type().get());
+    auto arrow_dict_field = arrow::field("dict", arrow_dict_type->value_type(), false);
+    std::unordered_map<String, ArrowDictionary> nested_dictionaries;
+
+    auto indexes_column = ColumnUInt32::create();
+    auto & indexes = indexes_column->getData();
+    indexes.reserve(arrow_column->length());
+    for (size_t chunk_i = 0, num_chunks = static_cast<size_t>(arrow_column->num_chunks()); chunk_i < num_chunks; ++chunk_i)
+    {
+        arrow::DictionaryArray & dict_chunk = dynamic_cast<arrow::DictionaryArray &>(*(arrow_column->chunk(chunk_i)));
+        const auto & arrow_dictionary = dict_chunk.dictionary();
+        if (!dictionary.dictionary
+            || (dictionary.arrow_dictionary != arrow_dictionary && !dictionary.arrow_dictionary->Equals(*arrow_dictionary)))
+        {
+            auto arrow_dict_column = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{arrow_dictionary});
+            auto values = readColumnFromArrowColumn(arrow_dict_field, arrow_dict_column, format_name, nested_dictionaries, read_ints_as_dates);
+            /// The rows of the previous chunks reference the current dictionary, so it's extended instead of replaced.
+            MutableColumnPtr unique;
+            if (chunk_i == 0 || !dictionary.dictionary)
+            {
+                dictionary.type = arrow_field->nullable() ? makeNullable(values.type) : values.type;
+                unique = DataTypeLowCardinality::createColumnUnique(*dictionary.type);
+            }
+            else
+                unique = IColumn::mutate(std::move(dictionary.dictionary));
+            auto positions = assert_cast<IColumnUnique &>(*unique).uniqueInsertRangeFrom(*values.column, 0, values.column->size());
+            dictionary.positions.resize(positions->size());
+            for (size_t i = 0; i < positions->size(); ++i)
+                dictionary.positions[i] = static_cast<UInt32>(positions->getUInt(i));
+            dictionary.dictionary = std::move(unique);
+            dictionary.arrow_dictionary = arrow_dictionary;
+        }
+
+        auto arrow_indexes_column = std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{dict_chunk.indices()});
+        auto chunk_indexes = readColumnWithIndexesData(arrow_indexes_column);
+        const auto & positions = dictionary.positions;
+        UInt32 null_index = 0;
+        if (arrow_field->nullable())
+            null_index = static_cast<UInt32>(assert_cast<const IColumnUnique &>(*dictionary.dictionary).getNullValueIndex());
+        const auto * int32_indexes = typeid_cast<const ColumnInt32 *>(chunk_indexes.get());
+        for (int64_t i = 0, length = dict_chunk.length(); i < length; ++i)
+        {
+            if (dict_chunk.IsNull(i))
+                indexes.push_back(null_index);
+            else if (int32_indexes)
+                indexes.push_back(positions[int32_indexes->getData()[i]]);
+            else
+                indexes.push_back(positions[chunk_indexes->getUInt(i)]);
+        }
+    }
+
+    if (!dictionary.dictionary)
+    {
+        /// No chunk, only the type of the values is needed.
+        auto arrow_dict_column = std::make_shared<arrow::ChunkedArray>(
+            arrow::ArrayVector{arrow::MakeEmptyArray(arrow_dict_type->value_type()).ValueOrDie()});
+        auto values = readColumnFromArrowColumn(arrow_dict_field, arrow_dict_column, format_name, nested_dictionaries, read_ints_as_dates);
+        dictionary.type = arrow_field->nullable() ? makeNullable(values.type) : values.type;
+        dictionary.dictionary = DataTypeLowCardinality::createColumnUnique(*dictionary.type);
+    }
+    auto lc_column = ColumnLowCardinality::create(dictionary.dictionary, std::move(indexes_column));
+    auto lc_type = std::make_shared<DataTypeLowCardinality>(dictionary.type);
+    return {std::move(lc_column), std::move(lc_type), arrow_field->name()};
+}
+
+static ColumnWithTypeAndName readColumnFromArrowColumn(
+    const std::shared_ptr<arrow::Field> & arrow_field,
+    std::shared_ptr<arrow::ChunkedArray> & arrow_column,
+    const std::string & format_name,
+    std::unordered_map<String, ArrowDictionary> & dictionary_values,
     bool read_ints_as_dates)
 {
     const auto is_nullable = arrow_field->nullable();
     const auto column_name = arrow_field->name();
+    /// LowCardinality can't be inside Nullable, the nulls are kept in the dictionary.
+    if (arrow_column->type()->id() == arrow::Type::DICTIONARY)
+        return readColumnWithDictionaryData(arrow_field, arrow_column, format_name, dictionary_values[column_name], read_ints_as_dates);
     if (is_nullable)
     {
         auto nested_column
@@ -452,46 +538,6 @@ static ColumnWithTypeAndName readColumnFromArrowColumn(
             auto tuple_type = std::make_shared<DataTypeTuple>(std::move(tuple_types), std::move(tuple_names));
             return {std::move(tuple_column), std::move(tuple_type), column_name};
         }
-        case arrow::Type::DICTIONARY: {
-            auto & dict_values = dictionary_values[column_name];
-            /// Load dictionary values only once and reuse it.
-            if (!dict_values)
-            {
-                arrow::ArrayVector dict_array;
-                for (size_t chunk_i = 0, num_chunks = static_cast<size_t>(arrow_column->num_chunks()); chunk_i < num_chunks; ++chunk_i)
-                {
-                    arrow::DictionaryArray & dict_chunk = dynamic_cast<arrow::DictionaryArray &>(*(arrow_column->chunk(chunk_i)));
-                    dict_array.emplace_back(dict_chunk.dictionary());
-                }
-
-                auto * arrow_dict_type = assert_cast<arrow::DictionaryType *>(arrow_field->type().get());
-                auto arrow_dict_field = arrow::field("dict", arrow_dict_type->value_type());
-                auto arrow_dict_column = std::make_shared<arrow::ChunkedArray>(dict_array);
-                auto dict_column
-                    = readColumnFromArrowColumn(arrow_dict_field, arrow_dict_column, format_name, dictionary_values, read_ints_as_dates);
-
-                /// We should convert read column to ColumnUnique.
-                auto tmp_lc_column = DataTypeLowCardinality(dict_column.type).createColumn();
-                auto tmp_dict_column = IColumn::mutate(assert_cast<ColumnLowCardinality *>(tmp_lc_column.get())->getDictionaryPtr());
-                static_cast<IColumnUnique *>(tmp_dict_column.get())
-                    ->uniqueInsertRangeFrom(*dict_column.column, 0, dict_column.column->size());
-                dict_column.column = std::move(tmp_dict_column);
-                dict_values = std::make_shared<ColumnWithTypeAndName>(std::move(dict_column));
-            }
-
-            arrow::ArrayVector indexes_array;
-            for (size_t chunk_i = 0, num_chunks = static_cast<size_t>(arrow_column->num_chunks()); chunk_i < num_chunks; ++chunk_i)
-            {
-                arrow::DictionaryArray & dict_chunk = dynamic_cast<arrow::DictionaryArray &>(*(arrow_column->chunk(chunk_i)));
-                indexes_array.emplace_back(dict_chunk.indices());
-            }
-
-            auto arrow_indexes_column = std::make_shared<arrow::ChunkedArray>(indexes_array);
-            auto indexes_column = readColumnWithIndexesData(arrow_indexes_column);
-            auto lc_column = ColumnLowCardinality::create(dict_values->column, indexes_column);
-            auto lc_type = std::make_shared<DataTypeLowCardinality>(dict_values->type);
-            return {std::move(lc_column), std::move(lc_type), column_name};
-        }
 #        define DISPATCH(ARROW_NUMERIC_TYPE, CPP_NUMERIC_TYPE) \
             case ARROW_NUMERIC_TYPE: \
                 return readColumnWithNumericData<CPP_NUMERIC_TYPE>(arrow_column, column_name);
@@ -510,6 +556,65 @@ static ColumnWithTypeAndName readColumnFromArrowColumn(
 }
 
 
+/// Reads a struct column right into the named tuple wanted by the header, the fields are matched by name. The
+/// fields of the struct not in the tuple are skipped, the ones of the tuple not in the struct are filled with
+/// default values. Nested structs are read the same way, so the leaves are not flattened and folded back.
+static ColumnWithTypeAndName readStructColumnAsTuple(
+    const DataTypePtr & type,
+    const std::shared_ptr<arrow::Field> & arrow_field,
+    std::shared_ptr<arrow::ChunkedArray> & arrow_column,
+    const std::string & format_name,
+    std::unordered_map<String, ArrowDictionary> & dictionary_values,
+    bool allow_missing_columns)
+{
+    const auto column_name = arrow_field->name();
+    const auto * tuple_type = typeid_cast<const DataTypeTuple *>(removeNullable(type).get());
+    if (!tuple_type || !tuple_type->haveExplicitNames() || arrow_column->type()->id() != arrow::Type::STRUCT)
+    {
+        auto column = readColumnFromArrowColumn(arrow_field, arrow_column, format_name, dictionary_values, true);
+        column.column = castColumn(column, type);
+        column.type = type;
+        return column;
+    }
+
+    const auto & arrow_struct_type = assert_cast<const arrow::StructType &>(*arrow_column->type());
+    const auto & element_names = tuple_type->getElementNames();
+    const auto & element_types = tuple_type->getElements();
+    size_t rows = arrow_column->length();
+    Columns elements;
+    elements.reserve(element_names.size());
+    for (size_t i = 0; i < element_names.size(); ++i)
+    {
+        int field_index = 0;
+        while (field_index < arrow_struct_type.num_fields()
+               && !boost::iequals(arrow_struct_type.field(field_index)->name(), element_names[i]))
+            ++field_index;
+        if (field_index == arrow_struct_type.num_fields())
+        {
+            if (!allow_missing_columns)
+                throw Exception{
+                    ErrorCodes::THERE_IS_NO_COLUMN, "Field '{}' of column '{}' is not presented in input data.", element_names[i], column_name};
+            elements.emplace_back(element_types[i]->createColumnConstWithDefaultValue(rows)->convertToFullColumnIfConst());
+            continue;
+        }
+
+        const auto & nested_arrow_field = arrow_struct_type.field(field_index);
+        arrow::ArrayVector nested_arrow_chunks;
+        nested_arrow_chunks.reserve(arrow_column->num_chunks());
+        for (const auto & chunk : arrow_column->chunks())
+            nested_arrow_chunks.emplace_back(dynamic_cast<arrow::StructArray &>(*chunk).field(field_index));
+        auto nested_arrow_column = std::make_shared<arrow::ChunkedArray>(std::move(nested_arrow_chunks), nested_arrow_field->type());
+        auto element = readStructColumnAsTuple(
+            element_types[i], nested_arrow_field, nested_arrow_column, format_name, dictionary_values, allow_missing_columns);
+        elements.emplace_back(std::move(element.column));
+    }
+
+    ColumnPtr column = ColumnTuple::create(std::move(elements));
+    if (type->isNullable())
+        column = ColumnNullable::create(column, readByteMapFromArrowColumn(arrow_column));
+    return {std::move(column), type, column_name};
+}
+
 // Creating CH header by arrow schema. Will be useful in task about inserting
 // data from file without knowing table structure.
 
@@ -536,7 +641,7 @@ Block OptimizedArrowColumnToCHColumn::arrowSchemaToCHHeader(const arrow::Schema
 
         arrow::ArrayVector array_vector = {arrow_array};
         auto arrow_column = std::make_shared<arrow::ChunkedArray>(array_vector);
-        std::unordered_map<std::string, std::shared_ptr<ColumnWithTypeAndName>> dict_values;
+        std::unordered_map<std::string, ArrowDictionary> dict_values;
         ColumnWithTypeAndName sample_column = readColumnFromArrowColumn(field, arrow_column, format_name, dict_values, false);
         // std::cerr << "field:" << field->ToString() << ", datatype:" << sample_column.type->getName() << std::endl;
 
@@ -634,6 +739,13 @@ void OptimizedArrowColumnToCHColumn::arrowColumnsToCHChunk(
         {
             auto arrow_column = name_to_column_ptr[search_column_name];
             const auto & arrow_field = schema->field(schema->GetFieldIndex(search_column_name));
+            if (isTuple(removeNullable(header_column.type)) && arrow_column->type()->id() == arrow::Type::STRUCT)
+            {
+                column = readStructColumnAsTuple(
+                    header_column.type, arrow_field, arrow_column, format_name, dictionary_values, allow_missing_columns);
+                columns_list.push_back(std::move(column.column));
+                continue;
+            }
             column = readColumnFromArrowColumn(arrow_field, arrow_column, format_name, dictionary_values, true);
         }
         try
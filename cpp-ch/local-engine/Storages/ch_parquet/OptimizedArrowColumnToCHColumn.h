@@ -12,6 +12,7 @@
 #include <Core/ColumnWithTypeAndName.h>
 #include <DataTypes/IDataType.h>
 #include <arrow/table.h>
+#include <Common/PODArray.h>
 
 // clang-format on
 
@@ -20,6 +21,18 @@ namespace DB
 class Block;
 class Chunk;
 
+/// The ClickHouse dictionary of a column read from Arrow dictionary arrays. Kept while the Arrow dictionary doesn't
+/// change, e.g. within a Parquet row group.
+struct ArrowDictionary
+{
+    std::shared_ptr<arrow::Array> arrow_dictionary;
+    DataTypePtr type;
+    /// ColumnUnique holding the values of arrow_dictionary.
+    ColumnPtr dictionary;
+    /// Position in dictionary of every value of arrow_dictionary.
+    PaddedPODArray<UInt32> positions;
+};
+
 class OptimizedArrowColumnToCHColumn
 {
 public:
@@ -50,7 +63,7 @@ private:
     /// Map {column name : dictionary column}.
     /// To avoid converting dictionary from Arrow Dictionary
     /// to LowCardinality every chunk we save it and reuse.
-    std::unordered_map<std::string, std::shared_ptr<ColumnWithTypeAndName>> dictionary_values;
+    std::unordered_map<std::string, ArrowDictionary> dictionary_values;
 };
 
 }
@@ -1,13 +1,17 @@
 #include "OptimizedParquetBlockInputFormat.h"
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #if USE_PARQUET && USE_LOCAL_FORMATS
 // clang-format off
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypeTuple.h>
 #include <DataTypes/NestedUtils.h>
 #include <Formats/FormatFactory.h>
 #include <Processors/Formats/Impl/ArrowBufferedStreams.h>
 #include <Storages/ch_parquet/OptimizedArrowColumnToCHColumn.h>
 #include <Storages/ch_parquet/arrow/reader.h>
+#include <parquet/metadata.h>
 // clang-format on
 namespace DB
 {
@@ -103,17 +107,95 @@ static size_t countIndicesForType(std::shared_ptr<arrow::DataType> type)
     return 1;
 }
 
+/// Adds the leaves of a column to read. Of a struct wanted as a named tuple, only the leaves of the wanted fields
+/// are read, recursively.
+static void addColumnIndices(const std::shared_ptr<arrow::DataType> & type, const DataTypePtr & wanted_type, int & index, std::vector<int> & indices)
+{
+    int indexes_count = static_cast<int>(countIndicesForType(type));
+    const auto * tuple_type = wanted_type ? typeid_cast<const DataTypeTuple *>(removeNullable(wanted_type).get()) : nullptr;
+    if (type->id() == arrow::Type::STRUCT && tuple_type && tuple_type->haveExplicitNames())
+    {
+        const auto & element_names = tuple_type->getElementNames();
+        size_t selected = indices.size();
+        int field_index = index;
+        for (const auto & field : static_cast<arrow::StructType *>(type.get())->fields())
+        {
+            auto it = std::find_if(
+                element_names.begin(), element_names.end(), [&](const String & name) { return boost::iequals(name, field->name()); });
+            if (it != element_names.end())
+                addColumnIndices(field->type(), tuple_type->getElement(it - element_names.begin()), field_index, indices);
+            else
+                field_index += static_cast<int>(countIndicesForType(field->type()));
+        }
+        /// None of the fields is wanted, the first leaf is still read for the rows and the nulls of the struct.
+        if (indices.size() == selected)
+            indices.push_back(index);
+        index += indexes_count;
+        return;
+    }
+
+    for (int j = 0; j != indexes_count; ++j)
+        indices.push_back(index + j);
+    index += indexes_count;
+}
+
+/// Dictionaries up to this size are read as they are into LowCardinality columns.
+static constexpr Int64 MAX_LOW_CARDINALITY_DICTIONARY_BYTES = 256 * 1024;
+
+/// Whether every column chunk of the column is dictionary encoded, with a small dictionary. The strings of such
+/// columns are not decoded, the dictionary and the indexes are read instead.
+static bool hasSmallDictionaries(const parquet::FileMetaData & metadata, int column_index)
+{
+    for (int i = 0; i < metadata.num_row_groups(); ++i)
+    {
+        auto column_chunk = metadata.RowGroup(i)->ColumnChunk(column_index);
+        /// Without the encoding stats the pages falling back to the plain encoding can't be told.
+        if (!column_chunk->has_dictionary_page() || column_chunk->encoding_stats().empty())
+            return false;
+        /// The dictionary page is right before the data pages.
+        if (column_chunk->data_page_offset() - column_chunk->dictionary_page_offset() > MAX_LOW_CARDINALITY_DICTIONARY_BYTES)
+            return false;
+        for (const auto & stats : column_chunk->encoding_stats())
+        {
+            bool is_data_page = stats.page_type == parquet::PageType::DATA_PAGE || stats.page_type == parquet::PageType::DATA_PAGE_V2;
+            if (is_data_page && stats.encoding != parquet::Encoding::PLAIN_DICTIONARY
+                && stats.encoding != parquet::Encoding::RLE_DICTIONARY)
+                return false;
+        }
+    }
+    return true;
+}
+
 static void getFileReaderAndSchema(
     ReadBuffer & in,
     std::unique_ptr<ch_parquet::arrow::FileReader> & file_reader,
     std::shared_ptr<arrow::Schema> & schema,
     const FormatSettings & format_settings,
-    std::atomic<int> & is_stopped)
+    std::atomic<int> & is_stopped,
+    const Block & header = {})
 {
     auto arrow_file = asArrowFile(in, format_settings, is_stopped, "Parquet", PARQUET_MAGIC_BYTES);
     if (is_stopped)
         return;
-    THROW_ARROW_NOT_OK(ch_parquet::arrow::OpenFile(std::move(arrow_file), arrow::default_memory_pool(), &file_reader));
+    ch_parquet::arrow::FileReaderBuilder builder;
+    THROW_ARROW_NOT_OK(builder.Open(std::move(arrow_file)));
+
+    /// The top level string columns wanted as LowCardinality are read as Arrow dictionaries when it's cheap.
+    auto properties = parquet::default_arrow_reader_properties();
+    const auto & metadata = *builder.raw_reader()->metadata();
+    for (int i = 0; i < metadata.num_columns(); ++i)
+    {
+        const auto * column = metadata.schema()->Column(i);
+        if (column->physical_type() != parquet::Type::BYTE_ARRAY || column->path()->ToDotVector().size() != 1)
+            continue;
+        auto name = column->name();
+        if (format_settings.use_lowercase_column_name)
+            boost::to_lower(name);
+        const auto * header_column = header.findByName(name);
+        if (header_column && header_column->type->lowCardinality() && hasSmallDictionaries(metadata, i))
+            properties.set_read_dictionary(i, true);
+    }
+    THROW_ARROW_NOT_OK(builder.memory_pool(arrow::default_memory_pool())->properties(properties)->Build(&file_reader));
     THROW_ARROW_NOT_OK(file_reader->GetSchema(&schema));
 
     if (format_settings.use_lowercase_column_name)
@@ -134,7 +216,7 @@ static void getFileReaderAndSchema(
 void OptimizedParquetBlockInputFormat::prepareReader()
 {
     std::shared_ptr<arrow::Schema> schema;
-    getFileReaderAndSchema(*in, file_reader, schema, format_settings, is_stopped);
+    getFileReaderAndSchema(*in, file_reader, schema, format_settings, is_stopped, getPort().getHeader());
     if (is_stopped)
         return;
 
@@ -155,17 +237,16 @@ void OptimizedParquetBlockInputFormat::prepareReader()
         /// STRUCT type require the number of indexes equal to the number of
         /// nested elements, so we should recursively
         /// count the number of indices we need for this type.
-        int indexes_count = countIndicesForType(schema->field(i)->type());
         const auto & name = schema->field(i)->name();
-        if (getPort().getHeader().has(name) || nested_table_names.contains(name))
+        const auto * header_column = getPort().getHeader().findByName(name);
+        if (header_column || nested_table_names.contains(name))
         {
-            for (int j = 0; j != indexes_count; ++j)
-            {
-                column_indices.push_back(index + j);
-                column_names.push_back(name);
-            }
+            addColumnIndices(schema->field(i)->type(), header_column ? header_column->type : nullptr, index, column_indices);
+            /// The table read has one column per field of the schema.
+            column_names.push_back(name);
         }
-        index += indexes_count;
+        else
+            index += countIndicesForType(schema->field(i)->type());
     }
 }
 
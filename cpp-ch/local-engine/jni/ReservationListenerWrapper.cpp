@@ -15,6 +15,8 @@ ReservationListenerWrapper::ReservationListenerWrapper(jobject listener_) : list
 
 ReservationListenerWrapper::~ReservationListenerWrapper()
 {
+    if (!listener)
+        return;
     GET_JNIENV(env)
     env->DeleteGlobalRef(listener);
     CLEAN_JNIENV
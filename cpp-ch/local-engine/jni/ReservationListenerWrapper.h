@@ -14,13 +14,17 @@ public:
     static jmethodID reservation_listener_unreserve;
 
     explicit ReservationListenerWrapper(jobject listener);
-    ~ReservationListenerWrapper();
-    void reserve(int64_t size);
-    void reserveOrThrow(int64_t size);
-    void free(int64_t size);
+    virtual ~ReservationListenerWrapper();
+    virtual void reserve(int64_t size);
+    virtual void reserveOrThrow(int64_t size);
+    virtual void free(int64_t size);
+
+protected:
+    /// Not bound to a java listener, for tests.
+    ReservationListenerWrapper() = default;
 
 private:
-    jobject listener;
+    jobject listener = nullptr;
 };
 using ReservationListenerWrapperPtr = std::shared_ptr<ReservationListenerWrapper>;
 }
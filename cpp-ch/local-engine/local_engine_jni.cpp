@@ -12,6 +12,7 @@
 #include <Parser/SparkRowToCHColumn.h>
 #include <Shuffle/NativeSplitter.h>
 #include <Shuffle/NativeWriterInMemory.h>
+#include <Shuffle/ParallelDecompressingReadBuffer.h>
 #include <Shuffle/ShuffleReader.h>
 #include <Shuffle/ShuffleSplitter.h>
 #include <Shuffle/ShuffleWriter.h>
@@ -531,7 +532,8 @@ JNIEXPORT jlong Java_io_glutenproject_vectorized_CHStreamReader_createNativeShuf
     LOCAL_ENGINE_JNI_METHOD_START
     auto * input = env->NewGlobalRef(input_stream);
     auto read_buffer = std::make_unique<local_engine::ReadBufferFromJavaInputStream>(input, customize_buffer_size);
-    auto * shuffle_reader = new local_engine::ShuffleReader(std::move(read_buffer), compressed);
+    auto * shuffle_reader = new local_engine::ShuffleReader(
+        std::move(read_buffer), compressed, local_engine::ParallelDecompressingReadBuffer::sharedPool());
     return reinterpret_cast<jlong>(shuffle_reader);
     LOCAL_ENGINE_JNI_METHOD_END(env, -1)
 }
@@ -613,7 +615,8 @@ JNIEXPORT jlong Java_io_glutenproject_vectorized_CHShuffleSplitterJniWrapper_nat
     jstring codec,
     jstring data_file,
     jstring local_dirs,
-    jint num_sub_dirs)
+    jint num_sub_dirs,
+    jstring block_index_file)
 {
     LOCAL_ENGINE_JNI_METHOD_START
     std::string hash_exprs;
@@ -654,6 +657,8 @@ JNIEXPORT jlong Java_io_glutenproject_vectorized_CHShuffleSplitterJniWrapper_nat
         .hash_exprs = hash_exprs,
         .out_exprs = out_exprs,
         .compress_method = jstring2string(env, codec)};
+    if (block_index_file)
+        options.block_index_file = jstring2string(env, block_index_file);
     local_engine::SplitterHolder * splitter
         = new local_engine::SplitterHolder{.splitter = local_engine::ShuffleSplitter::create(jstring2string(env, short_name), options)};
     return reinterpret_cast<jlong>(splitter);
@@ -841,7 +846,7 @@ JNIEXPORT void Java_org_apache_spark_sql_execution_datasources_CHDatasourceJniWr
 {
     LOCAL_ENGINE_JNI_METHOD_START
 
-    auto * writer = reinterpret_cast<local_engine::NormalFileWriter *>(instanceId);
+    auto * writer = reinterpret_cast<local_engine::FileWriterWrapper *>(instanceId);
     auto * block = reinterpret_cast<DB::Block *>(block_address);
     writer->consume(*block);
     LOCAL_ENGINE_JNI_METHOD_END(env, )
@@ -850,7 +855,7 @@ JNIEXPORT void Java_org_apache_spark_sql_execution_datasources_CHDatasourceJniWr
 JNIEXPORT void Java_org_apache_spark_sql_execution_datasources_CHDatasourceJniWrapper_close(JNIEnv * env, jobject, jlong instanceId)
 {
     LOCAL_ENGINE_JNI_METHOD_START
-    auto * writer = reinterpret_cast<local_engine::NormalFileWriter *>(instanceId);
+    auto * writer = reinterpret_cast<local_engine::FileWriterWrapper *>(instanceId);
     writer->close();
     delete writer;
     LOCAL_ENGINE_JNI_METHOD_END(env, )
@@ -903,12 +908,28 @@ Java_io_glutenproject_vectorized_StorageJoinBuilder_nativeCleanBuildHashTable(JN
 
 // BlockSplitIterator
 JNIEXPORT jlong Java_io_glutenproject_vectorized_BlockSplitIterator_nativeCreate(
-    JNIEnv * env, jobject, jobject in, jstring name, jstring expr, jstring schema, jint partition_num, jint buffer_size)
+    JNIEnv * env,
+    jobject,
+    jobject in,
+    jstring name,
+    jstring expr,
+    jstring schema,
+    jint partition_num,
+    jint buffer_size,
+    jlong buffer_bytes,
+    jboolean serialized,
+    jboolean compressed,
+    jstring codec)
 {
     LOCAL_ENGINE_JNI_METHOD_START
     local_engine::NativeSplitter::Options options;
     options.partition_nums = partition_num;
     options.buffer_size = buffer_size;
+    options.buffer_bytes = buffer_bytes;
+    options.serialized = serialized;
+    options.compressed = compressed;
+    if (codec)
+        options.compress_method = jstring2string(env, codec);
     auto expr_str = jstring2string(env, expr);
     std::string schema_str;
     if (schema)
@@ -947,6 +968,29 @@ JNIEXPORT jlong Java_io_glutenproject_vectorized_BlockSplitIterator_nativeNext(J
     LOCAL_ENGINE_JNI_METHOD_END(env, false)
 }
 
+JNIEXPORT jint
+Java_io_glutenproject_vectorized_BlockSplitIterator_nativeNextSerialized(JNIEnv * env, jobject, jlong instance, jbyteArray buffer)
+{
+    LOCAL_ENGINE_JNI_METHOD_START
+    local_engine::NativeSplitter::Holder * splitter = reinterpret_cast<local_engine::NativeSplitter::Holder *>(instance);
+    auto data = splitter->splitter->serializeNext();
+    /// The block stays available, so it can be read again into a large enough buffer.
+    if (data.size() > static_cast<size_t>(env->GetArrayLength(buffer)))
+        return -static_cast<jint>(data.size());
+    env->SetByteArrayRegion(buffer, 0, static_cast<jsize>(data.size()), reinterpret_cast<const jbyte *>(data.data()));
+    splitter->splitter->next();
+    return static_cast<jint>(data.size());
+    LOCAL_ENGINE_JNI_METHOD_END(env, 0)
+}
+
+JNIEXPORT jint Java_io_glutenproject_vectorized_BlockSplitIterator_nativeNextRows(JNIEnv * env, jobject, jlong instance)
+{
+    LOCAL_ENGINE_JNI_METHOD_START
+    local_engine::NativeSplitter::Holder * splitter = reinterpret_cast<local_engine::NativeSplitter::Holder *>(instance);
+    return static_cast<jint>(splitter->splitter->nextRows());
+    LOCAL_ENGINE_JNI_METHOD_END(env, -1)
+}
+
 JNIEXPORT jint Java_io_glutenproject_vectorized_BlockSplitIterator_nativeNextPartitionId(JNIEnv * env, jobject, jlong instance)
 {
     LOCAL_ENGINE_JNI_METHOD_START
@@ -1062,6 +1106,13 @@ JNIEXPORT jlong Java_io_glutenproject_memory_alloc_CHNativeMemoryAllocator_bytes
     LOCAL_ENGINE_JNI_METHOD_END(env, -1)
 }
 
+JNIEXPORT jlong Java_io_glutenproject_memory_alloc_CHNativeMemoryAllocator_spill(JNIEnv * env, jclass, jlong allocator_id, jlong size)
+{
+    LOCAL_ENGINE_JNI_METHOD_START
+    return local_engine::spillAllocator(allocator_id, size);
+    LOCAL_ENGINE_JNI_METHOD_END(env, -1)
+}
+
 #ifdef __cplusplus
 }
 
@@ -1,21 +1,29 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <AggregateFunctions/AggregateFunctionFactory.h>
 #include <Builder/SerializedPlanBuilder.h>
+#include <Columns/ColumnsNumber.h>
 #include <Functions/FunctionFactory.h>
 #include <Interpreters/Context.h>
+#include <Interpreters/ExpressionActions.h>
+#include <Interpreters/FullSortingMergeJoin.h>
 #include <Interpreters/HashJoin.h>
 #include <Interpreters/TableJoin.h>
 #include <Interpreters/TreeRewriter.h>
+#include <Operator/WindowGroupLimitStep.h>
 #include <Parser/CHColumnToSparkRow.h>
 #include <Parser/SerializedPlanParser.h>
 #include <Parser/SparkRowToCHColumn.h>
 #include <Parsers/ASTIdentifier.h>
 #include <Processors/Executors/PullingPipelineExecutor.h>
 #include <Processors/Formats/IOutputFormat.h>
+#include <Processors/QueryPlan/AggregatingStep.h>
 #include <Processors/QueryPlan/ExpressionStep.h>
 #include <Processors/QueryPlan/JoinStep.h>
 #include <Processors/QueryPlan/Optimizations/QueryPlanOptimizationSettings.h>
+#include <Processors/QueryPlan/ReadFromPreparedSource.h>
+#include <Processors/QueryPlan/SortingStep.h>
 #include <QueryPipeline/QueryPipelineBuilder.h>
 #include <Shuffle/ShuffleReader.h>
 #include <Shuffle/ShuffleSplitter.h>
@@ -33,6 +41,7 @@
 #include <Common/Logger.h>
 #include <Common/MergeTreeTool.h>
 #include <Common/PODArray_fwd.h>
+#include <Common/QueryContext.h>
 #include <Common/Stopwatch.h>
 #include <Common/logger_useful.h>
 #include "testConfig.h"
@@ -42,6 +51,12 @@
 #endif
 
 
+namespace CurrentMetrics
+{
+extern const Metric LocalThread;
+extern const Metric LocalThreadActive;
+}
+
 using namespace local_engine;
 using namespace dbms;
 
@@ -372,13 +387,19 @@ DB::ContextMutablePtr global_context;
     }
 }
 
+/// Reads the shuffle data written by BM_ShuffleSplitter, the local file stands in for the java input stream.
+/// The arg is the number of decompression threads, 0 decompresses on the reading thread.
 [[maybe_unused]] static void BM_ShuffleReader(benchmark::State & state)
 {
+    auto threads = static_cast<size_t>(state.range(0));
+    std::unique_ptr<ThreadPool> pool;
+    if (threads)
+        pool = std::make_unique<ThreadPool>(CurrentMetrics::LocalThread, CurrentMetrics::LocalThreadActive, threads, threads, 0);
     for (auto _ : state)
     {
         auto read_buffer = std::make_unique<ReadBufferFromFile>("/tmp/test_shuffle/ZSTD/data.dat");
         //        read_buffer->seek(357841655, SEEK_SET);
-        auto shuffle_reader = local_engine::ShuffleReader(std::move(read_buffer), true);
+        auto shuffle_reader = local_engine::ShuffleReader(std::move(read_buffer), true, pool.get());
         Block * block;
         int sum = 0;
         do
@@ -1371,7 +1392,7 @@ QueryPlanPtr readFromMergeTree(MergeTreeWithSnapshot storage)
     return query_plan;
 }
 
-QueryPlanPtr joinPlan(QueryPlanPtr left, QueryPlanPtr right, String left_key, String right_key, size_t block_size = 8192)
+QueryPlanPtr joinPlan(QueryPlanPtr left, QueryPlanPtr right, String left_key, String right_key, size_t block_size = 8192, bool merge_join = false)
 {
     auto join = std::make_shared<TableJoin>(global_context->getSettings(), global_context->getGlobalTemporaryVolume());
     auto left_columns = left->getCurrentDataStream().header.getColumnsWithTypeAndName();
@@ -1407,10 +1428,23 @@ QueryPlanPtr joinPlan(QueryPlanPtr left, QueryPlanPtr right, String left_key, St
         converting_step->setStepDescription("Convert joined columns");
         left->addStep(std::move(converting_step));
     }
-    auto hash_join = std::make_shared<HashJoin>(join, right->getCurrentDataStream().header);
+    JoinPtr join_algorithm;
+    if (merge_join)
+    {
+        /// The inputs are sorted by the keys already, only merge the streams.
+        for (auto [plan, key] : {std::make_pair(left.get(), left_key), std::make_pair(right.get(), right_key)})
+        {
+            SortDescription sort_description;
+            sort_description.emplace_back(key, 1, 1);
+            plan->addStep(std::make_unique<SortingStep>(plan->getCurrentDataStream(), sort_description, block_size));
+        }
+        join_algorithm = std::make_shared<FullSortingMergeJoin>(join, right->getCurrentDataStream().header);
+    }
+    else
+        join_algorithm = std::make_shared<HashJoin>(join, right->getCurrentDataStream().header);
 
     QueryPlanStepPtr join_step
-        = std::make_unique<JoinStep>(left->getCurrentDataStream(), right->getCurrentDataStream(), hash_join, block_size, 1, false);
+        = std::make_unique<JoinStep>(left->getCurrentDataStream(), right->getCurrentDataStream(), join_algorithm, block_size, 1, false);
 
     std::vector<QueryPlanPtr> plans;
     plans.emplace_back(std::move(left));
@@ -1476,7 +1510,303 @@ QueryPlanPtr joinPlan(QueryPlanPtr left, QueryPlanPtr right, String left_key, St
     }
 }
 
+QueryPlanPtr readFromParquet(const std::string & file_path, const Block & header)
+{
+    substrait::ReadRel::LocalFiles files;
+    substrait::ReadRel::LocalFiles::FileOrFiles * file = files.add_items();
+    file->set_uri_file(file_path);
+    substrait::ReadRel::LocalFiles::FileOrFiles::ParquetReadOptions parquet_format;
+    file->mutable_parquet()->CopyFrom(parquet_format);
+    auto query_plan = std::make_unique<QueryPlan>();
+    query_plan->addStep(std::make_unique<ReadFromPreparedSource>(
+        Pipe(std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, header, files))));
+    return query_plan;
+}
+
+/// Join lineitem with orders on the order key, both files are sorted by it. Arg 0 runs a hash join,
+/// arg 1 a sort merge join.
+[[maybe_unused]] static void BM_SortedParquetJoin(benchmark::State & state)
+{
+    const std::string data_path = "file:///home/hongbin/code/gluten/jvm/src/test/resources/tpch-data/";
+    Block lineitem_header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "l_orderkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "l_extendedprice")};
+    Block orders_header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "o_orderkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "o_totalprice")};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto left = readFromParquet(data_path + "lineitem/part-00000-d08071cb-0dfa-42dc-9198-83cb334ccda3-c000.snappy.parquet", lineitem_header);
+        auto right = readFromParquet(data_path + "orders/part-00000-55be73d5-c753-4e79-a9e7-27e0c0baaf52-c000.snappy.parquet", orders_header);
+        auto query_plan = joinPlan(std::move(left), std::move(right), "l_orderkey", "o_orderkey", 8192, state.range(0));
+        QueryPlanOptimizationSettings optimization_settings{.optimize_plan = false};
+        BuildQueryPipelineSettings pipeline_settings;
+        auto pipeline_builder = query_plan->buildQueryPipeline(optimization_settings, pipeline_settings);
+        state.ResumeTiming();
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*pipeline_builder));
+        auto executor = PullingPipelineExecutor(pipeline);
+        Block result = executor.getHeader();
+        size_t total_rows = 0;
+        while (executor.pull(result))
+            total_rows += result.rows();
+        benchmark::DoNotOptimize(total_rows);
+    }
+}
+
+/// Top 10 rows by price of every part in lineitem, the parts are almost unique so the window sees
+/// about as many partitions as rows. Arg 0 sorts the whole input, arg 1 adds the window group limit
+/// before sorting.
+[[maybe_unused]] static void BM_WindowGroupLimit(benchmark::State & state)
+{
+    const std::string data_path = "file:///home/hongbin/code/gluten/jvm/src/test/resources/tpch-data/";
+    Block header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "l_partkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "l_extendedprice")};
+    SortDescription order_by{SortColumnDescription("l_extendedprice", -1, 1)};
+    SortDescription sort_by{SortColumnDescription("l_partkey", 1, 1), SortColumnDescription("l_extendedprice", -1, 1)};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto query_plan = readFromParquet(data_path + "lineitem/part-00000-d08071cb-0dfa-42dc-9198-83cb334ccda3-c000.snappy.parquet", header);
+        if (state.range(0))
+            query_plan->addStep(std::make_unique<local_engine::WindowGroupLimitStep>(
+                query_plan->getCurrentDataStream(), Names{"l_partkey"}, order_by, local_engine::WindowGroupLimitKind::RowNumber, 10, 1000000));
+        query_plan->addStep(std::make_unique<SortingStep>(
+            query_plan->getCurrentDataStream(), sort_by, 0, SortingStep::Settings(*SerializedPlanParser::global_context), false));
+        QueryPlanOptimizationSettings optimization_settings{.optimize_plan = false};
+        BuildQueryPipelineSettings pipeline_settings;
+        auto pipeline_builder = query_plan->buildQueryPipeline(optimization_settings, pipeline_settings);
+        state.ResumeTiming();
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*pipeline_builder));
+        auto executor = PullingPipelineExecutor(pipeline);
+        Block result = executor.getHeader();
+        size_t total_rows = 0;
+        while (executor.pull(result))
+            total_rows += result.rows();
+        benchmark::DoNotOptimize(total_rows);
+    }
+}
+
+/// Projects sqrt(a * b) + a as many times as the arg. The repeated projections share one node of the
+/// actions, so the time should stay flat as the arg grows.
+[[maybe_unused]] static void BM_RepeatedExpression(benchmark::State & state)
+{
+    substrait::Plan plan;
+    std::vector<std::string> function_names{"multiply:fp64_fp64", "sqrt:fp64", "add:fp64_fp64"};
+    for (size_t i = 0; i < function_names.size(); ++i)
+    {
+        auto * function = plan.add_extensions()->mutable_extension_function();
+        function->set_function_anchor(static_cast<UInt32>(i));
+        function->set_name(function_names[i]);
+    }
+    auto field_reference = [](Int32 field)
+    {
+        substrait::Expression expr;
+        expr.mutable_selection()->mutable_direct_reference()->mutable_struct_field()->set_field(field);
+        return expr;
+    };
+    auto scalar_function_expr = [](UInt32 anchor, const std::vector<substrait::Expression> & args)
+    {
+        substrait::Expression expr;
+        auto * scalar_function = expr.mutable_scalar_function();
+        scalar_function->set_function_reference(anchor);
+        scalar_function->mutable_output_type()->mutable_fp64()->set_nullability(substrait::Type_Nullability_NULLABILITY_REQUIRED);
+        for (const auto & arg : args)
+            *scalar_function->add_arguments()->mutable_value() = arg;
+        return expr;
+    };
+    auto expr = scalar_function_expr(
+        2, {scalar_function_expr(1, {scalar_function_expr(0, {field_reference(0), field_reference(1)})}), field_reference(0)});
+    std::vector<substrait::Expression> expressions(state.range(0), expr);
+
+    const size_t rows = 10000000;
+    auto double_type = std::make_shared<DataTypeFloat64>();
+    auto a = ColumnFloat64::create(rows);
+    auto b = ColumnFloat64::create(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        a->getData()[i] = static_cast<Float64>(i);
+        b->getData()[i] = static_cast<Float64>(rows - i);
+    }
+    Block block{ColumnWithTypeAndName(std::move(a), double_type, "a"), ColumnWithTypeAndName(std::move(b), double_type, "b")};
+
+    SerializedPlanParser parser(SerializedPlanParser::global_context);
+    parser.parseExtensions(plan.extensions());
+    auto actions = std::make_shared<ExpressionActions>(parser.expressionsToActionsDAG(expressions, block.cloneEmpty(), block.cloneEmpty()));
+    for (auto _ : state)
+    {
+        Block result = block;
+        actions->execute(result);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+/// Partial sum of the prices by order key in lineitem, which is sorted by it, so there are about as many
+/// groups as a quarter of the rows. Arg 0 aggregates in a hash table, arg 1 in order of the keys.
+[[maybe_unused]] static void BM_SortedAggregation(benchmark::State & state)
+{
+    const std::string data_path = "file:///home/hongbin/code/gluten/jvm/src/test/resources/tpch-data/";
+    Block header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "l_orderkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "l_extendedprice")};
+    const auto & settings = SerializedPlanParser::global_context->getSettingsRef();
+
+    AggregateFunctionProperties properties;
+    AggregateDescription description;
+    description.column_name = "sum(l_extendedprice)";
+    description.argument_names = {"l_extendedprice"};
+    description.function = AggregateFunctionFactory::instance().get("sum", {std::make_shared<DataTypeFloat64>()}, {}, properties);
+    SortDescription group_by_sort_description;
+    if (state.range(0))
+        group_by_sort_description.emplace_back("l_orderkey", 1, 1);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto query_plan = readFromParquet(data_path + "lineitem/part-00000-d08071cb-0dfa-42dc-9198-83cb334ccda3-c000.snappy.parquet", header);
+        Aggregator::Params params(
+            {"l_orderkey"},
+            {description},
+            false,
+            settings.max_rows_to_group_by,
+            settings.group_by_overflow_mode,
+            settings.group_by_two_level_threshold,
+            settings.group_by_two_level_threshold_bytes,
+            settings.max_bytes_before_external_group_by,
+            settings.empty_result_for_aggregation_by_empty_set,
+            SerializedPlanParser::global_context->getTempDataOnDisk(),
+            settings.max_threads,
+            settings.min_free_disk_space_for_temporary_data,
+            true,
+            3,
+            settings.max_block_size,
+            false,
+            false);
+        query_plan->addStep(std::make_unique<AggregatingStep>(
+            query_plan->getCurrentDataStream(),
+            params,
+            GroupingSetsParamsList(),
+            false,
+            settings.max_block_size,
+            settings.aggregation_in_order_max_block_bytes,
+            1,
+            1,
+            false,
+            false,
+            group_by_sort_description,
+            group_by_sort_description,
+            false,
+            false,
+            false));
+        QueryPlanOptimizationSettings optimization_settings{.optimize_plan = false};
+        BuildQueryPipelineSettings pipeline_settings;
+        auto pipeline_builder = query_plan->buildQueryPipeline(optimization_settings, pipeline_settings);
+        state.ResumeTiming();
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*pipeline_builder));
+        auto executor = PullingPipelineExecutor(pipeline);
+        Block result = executor.getHeader();
+        size_t total_rows = 0;
+        while (executor.pull(result))
+            total_rows += result.rows();
+        benchmark::DoNotOptimize(total_rows);
+    }
+}
+
+/// Insert lineitem into a merge tree on the local disk. Arg 0 writes a part per chunk, arg 1 squashes the
+/// chunks into parts of min_insert_block_size_rows/bytes, arg 2 also merges the written parts afterwards.
+[[maybe_unused]] static void BM_MergeTreeInsert(benchmark::State & state)
+{
+    const std::string data_path = "file:///home/hongbin/code/gluten/jvm/src/test/resources/tpch-data/";
+    Block header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "l_orderkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "l_partkey"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "l_quantity"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "l_extendedprice"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeString>(), "l_shipmode"),
+        ColumnWithTypeAndName(std::make_shared<DataTypeString>(), "l_comment")};
+    auto context = Context::createCopy(SerializedPlanParser::global_context);
+    if (state.range(0) == 0)
+        context->setSetting("min_insert_block_size_rows", Field(1));
+    SerializedPlanParser::config->setBool("mergetree.merge_after_insert", state.range(0) == 2);
+    SCOPE_EXIT({ SerializedPlanParser::config->remove("mergetree.merge_after_insert"); });
+
+    size_t parts = 0;
+    size_t total_rows = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto metadata = local_engine::buildMetaData(header.getNamesAndTypesList(), context);
+        local_engine::CustomStorageMergeTree merge_tree(
+            DB::StorageID("default", "benchmark_merge_tree_insert"),
+            "tmp/benchmark_merge_tree_insert/",
+            *metadata,
+            false,
+            SerializedPlanParser::global_context,
+            "",
+            DB::MergeTreeData::MergingParams(),
+            local_engine::buildMergeTreeSettings());
+        auto query_plan = readFromParquet(data_path + "lineitem/part-00000-d08071cb-0dfa-42dc-9198-83cb334ccda3-c000.snappy.parquet", header);
+        QueryPlanOptimizationSettings optimization_settings{.optimize_plan = false};
+        auto pipeline_builder = query_plan->buildQueryPipeline(optimization_settings, BuildQueryPipelineSettings());
+        pipeline_builder->setSinks(
+            [&](const Block &, Pipe::StreamType type) -> ProcessorPtr
+            {
+                if (type != Pipe::StreamType::Main)
+                    return nullptr;
+                return std::make_shared<local_engine::CustomMergeTreeSink>(merge_tree, metadata, context);
+            });
+        state.ResumeTiming();
+
+        auto executor = pipeline_builder->execute();
+        executor->execute(1);
+
+        state.PauseTiming();
+        parts = merge_tree.getDataPartsVectorForInternalUsage().size();
+        total_rows = 0;
+        for (const auto & part : merge_tree.getDataPartsVectorForInternalUsage())
+            total_rows += part->rows_count;
+        merge_tree.dropAllData();
+        state.ResumeTiming();
+    }
+    state.counters["parts"] = parts;
+    state.counters["rows"] = benchmark::Counter(total_rows * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+namespace
+{
+class NoopReservationListener : public ReservationListenerWrapper
+{
+public:
+    NoopReservationListener() = default;
+    void reserve(int64_t) override { }
+    void reserveOrThrow(int64_t) override { }
+    void free(int64_t) override { }
+};
+}
+
+/// The native setup and teardown of a task without any work: its query context, thread group, memory
+/// tracking and settings.
+[[maybe_unused]] static void BM_TaskSetup(benchmark::State & state)
+{
+    auto listener = std::make_shared<NoopReservationListener>();
+    for (auto _ : state)
+    {
+        auto allocator_id = initializeQuery(listener);
+        BackendInitializerUtil::updateConfig(getAllocator(allocator_id)->query_context, nullptr);
+        releaseAllocator(allocator_id);
+    }
+}
+
 BENCHMARK(BM_ParquetRead)->Unit(benchmark::kMillisecond)->Iterations(10);
+// BENCHMARK(BM_SortedParquetJoin)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Iterations(10);
+// BENCHMARK(BM_WindowGroupLimit)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Iterations(10);
+// BENCHMARK(BM_RepeatedExpression)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->Iterations(10);
+// BENCHMARK(BM_SortedAggregation)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Iterations(10);
+// BENCHMARK(BM_MergeTreeInsert)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->Iterations(5);
+// BENCHMARK(BM_TaskSetup)->Unit(benchmark::kMicrosecond)->Iterations(10000);
 
 // BENCHMARK(BM_TestDecompress)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Unit(benchmark::kMillisecond)->Iterations(50)->Repetitions(6)->ComputeStatistics("80%", quantile);
 // BENCHMARK(BM_JoinTest)->Unit(benchmark::k
@@ -1487,7 +1817,7 @@ BENCHMARK(BM_ParquetRead)->Unit(benchmark::kMillisecond)->Iterations(10);
 
 //BENCHMARK(BM_ShuffleSplitter)->Args({2, 0})->Args({2, 1})->Args({2, 2})->Unit(benchmark::kMillisecond)->Iterations(1);
 //BENCHMARK(BM_HashShuffleSplitter)->Args({2, 0})->Args({2, 1})->Args({2, 2})->Unit(benchmark::kMillisecond)->Iterations(1);
-//BENCHMARK(BM_ShuffleReader)->Unit(benchmark::kMillisecond)->Iterations(10);
+//BENCHMARK(BM_ShuffleReader)->Arg(0)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond)->Iterations(10);
 //BENCHMARK(BM_SimpleAggregate)->Arg(150)->Unit(benchmark::kMillisecond)->Iterations(40);
 //BENCHMARK(BM_SIMDFilter)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->Iterations(40);
 //BENCHMARK(BM_NormalFilter)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->Iterations(40);
@@ -1,11 +1,19 @@
+#include <filesystem>
+#include <Columns/ColumnsNumber.h>
 #include <Core/Block.h>
 #include <DataTypes/DataTypeDate32.h>
+#include <DataTypes/DataTypeFactory.h>
+#include <DataTypes/DataTypeLowCardinality.h>
+#include <DataTypes/DataTypeNullable.h>
 #include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <IO/ReadBufferFromFile.h>
+#include <IO/WriteBufferFromFile.h>
 #include <Parser/SerializedPlanParser.h>
 #include <Processors/Executors/PullingPipelineExecutor.h>
 #include <Processors/Formats/Impl/ArrowColumnToCHColumn.h>
 #include <Processors/Formats/Impl/ParquetBlockInputFormat.h>
+#include <Processors/Formats/Impl/ParquetBlockOutputFormat.h>
 #include <QueryPipeline/QueryPipeline.h>
 #include <QueryPipeline/QueryPipelineBuilder.h>
 #include <Storages/SubstraitSource/SubstraitFileSource.h>
@@ -95,6 +103,39 @@ static void BM_OptimizedParquetReadString(benchmark::State & state)
     }
 }
 
+static void BM_OptimizedParquetReadLowCardinalityString(benchmark::State & state)
+{
+    using namespace DB;
+    using namespace local_engine;
+    auto type = std::make_shared<DataTypeLowCardinality>(std::make_shared<DataTypeString>());
+    Block header{
+        ColumnWithTypeAndName(type->createColumn(), type, "l_returnflag"),
+        ColumnWithTypeAndName(type->createColumn(), type, "l_linestatus"),
+        ColumnWithTypeAndName(type->createColumn(), type, "l_shipmode")};
+    std::string file = "file:///data1/liyang/cppproject/gluten/jvm/src/test/resources/tpch-data/lineitem/"
+                       "part-00000-d08071cb-0dfa-42dc-9198-83cb334ccda3-c000.snappy.parquet";
+    Block res;
+
+    for (auto _ : state)
+    {
+        substrait::ReadRel::LocalFiles files;
+        substrait::ReadRel::LocalFiles::FileOrFiles * file_item = files.add_items();
+        file_item->set_uri_file(file);
+        substrait::ReadRel::LocalFiles::FileOrFiles::ParquetReadOptions parquet_format;
+        file_item->mutable_parquet()->CopyFrom(parquet_format);
+
+        auto builder = std::make_unique<QueryPipelineBuilder>();
+        builder->init(
+            Pipe(std::make_shared<local_engine::SubstraitFileSource>(local_engine::SerializedPlanParser::global_context, header, files)));
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*builder));
+        auto reader = PullingPipelineExecutor(pipeline);
+        while (reader.pull(res))
+        {
+            // debug::headBlock(res);
+        }
+    }
+}
+
 static void BM_OptimizedParquetReadDate32(benchmark::State & state)
 {
     using namespace DB;
@@ -127,7 +168,134 @@ static void BM_OptimizedParquetReadDate32(benchmark::State & state)
     }
 }
 
+static void writeParquet(const String & path, const DB::Block & block)
+{
+    using namespace DB;
+    WriteBufferFromFile out(path);
+    ParquetBlockOutputFormat format(out, block.cloneEmpty(), FormatSettings{});
+    format.write(block);
+    format.finalize();
+    out.finalize();
+}
+
+/// Writes a file with a struct column nested three levels deep, if it doesn't exist.
+static String writeNestedStructParquet()
+{
+    using namespace DB;
+    String path = "/tmp/benchmark_nested_struct.parquet";
+    if (std::filesystem::exists(path))
+        return path;
+
+    auto type = DataTypeFactory::instance().get(
+        "Tuple(a Int64, b String, c Tuple(d Int64, e Float64, f Tuple(g Int64, h String, i Float64), j String), k Float64)");
+    auto column = type->createColumn();
+    for (size_t i = 0; i < 1000000; ++i)
+    {
+        auto n = static_cast<Int64>(i);
+        Tuple f{n * 3, "nested_" + std::to_string(i), Float64(n) / 7};
+        Tuple c{n * 2, Float64(n) / 3, std::move(f), std::to_string(i)};
+        column->insert(Tuple{n, "row_" + std::to_string(i), std::move(c), Float64(n) / 11});
+    }
+    writeParquet(path, Block{ColumnWithTypeAndName(std::move(column), type, "s")});
+    return path;
+}
+
+static void BM_OptimizedParquetReadNestedStruct(benchmark::State & state)
+{
+    using namespace DB;
+    using namespace local_engine;
+    /// 0: the whole struct, 1: a few leaves spread over the nesting levels.
+    auto type = DataTypeFactory::instance().get(
+        state.range(0) ? "Tuple(a Int64, c Tuple(f Tuple(h String), j String))"
+                       : "Tuple(a Int64, b String, c Tuple(d Int64, e Float64, f Tuple(g Int64, h String, i Float64), j String), k Float64)");
+    Block header{ColumnWithTypeAndName(type->createColumn(), type, "s")};
+    std::string file = "file://" + writeNestedStructParquet();
+    Block res;
+
+    for (auto _ : state)
+    {
+        substrait::ReadRel::LocalFiles files;
+        substrait::ReadRel::LocalFiles::FileOrFiles * file_item = files.add_items();
+        file_item->set_uri_file(file);
+        substrait::ReadRel::LocalFiles::FileOrFiles::ParquetReadOptions parquet_format;
+        file_item->mutable_parquet()->CopyFrom(parquet_format);
+
+        auto builder = std::make_unique<QueryPipelineBuilder>();
+        builder->init(
+            Pipe(std::make_shared<local_engine::SubstraitFileSource>(local_engine::SerializedPlanParser::global_context, header, files)));
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*builder));
+        auto reader = PullingPipelineExecutor(pipeline);
+        while (reader.pull(res))
+        {
+            // debug::headBlock(res);
+        }
+    }
+}
+
+/// Writes a hive partitioned table with 20 * 20 partitions of one file each, if it doesn't exist.
+static std::vector<String> writePartitionedParquet()
+{
+    using namespace DB;
+    String root = "/tmp/benchmark_partitioned";
+    std::vector<String> files;
+    for (size_t p1 = 0; p1 < 20; ++p1)
+    {
+        for (size_t p2 = 0; p2 < 20; ++p2)
+        {
+            auto dir = fmt::format("{}/p1={}/p2=value_{}", root, p1, p2);
+            auto path = dir + "/part-00000.parquet";
+            files.emplace_back("file://" + path);
+            if (std::filesystem::exists(path))
+                continue;
+
+            std::filesystem::create_directories(dir);
+            auto column = ColumnInt64::create();
+            for (size_t i = 0; i < 65536; ++i)
+                column->insertValue(static_cast<Int64>(i));
+            writeParquet(path, Block{ColumnWithTypeAndName(std::move(column), std::make_shared<DataTypeInt64>(), "v")});
+        }
+    }
+    return files;
+}
+
+static void BM_OptimizedParquetReadManyPartitions(benchmark::State & state)
+{
+    using namespace DB;
+    using namespace local_engine;
+    Block header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "v"),
+        ColumnWithTypeAndName(makeNullable(std::make_shared<DataTypeInt64>()), "p1"),
+        ColumnWithTypeAndName(makeNullable(std::make_shared<DataTypeString>()), "p2")};
+    auto paths = writePartitionedParquet();
+    Block res;
+
+    for (auto _ : state)
+    {
+        substrait::ReadRel::LocalFiles files;
+        for (const auto & path : paths)
+        {
+            substrait::ReadRel::LocalFiles::FileOrFiles * file_item = files.add_items();
+            file_item->set_uri_file(path);
+            substrait::ReadRel::LocalFiles::FileOrFiles::ParquetReadOptions parquet_format;
+            file_item->mutable_parquet()->CopyFrom(parquet_format);
+        }
+
+        auto builder = std::make_unique<QueryPipelineBuilder>();
+        builder->init(
+            Pipe(std::make_shared<local_engine::SubstraitFileSource>(local_engine::SerializedPlanParser::global_context, header, files)));
+        auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*builder));
+        auto reader = PullingPipelineExecutor(pipeline);
+        while (reader.pull(res))
+        {
+            // debug::headBlock(res);
+        }
+    }
+}
+
 BENCHMARK(BM_ParquetReadString)->Unit(benchmark::kMillisecond)->Iterations(10);
 BENCHMARK(BM_ParquetReadDate32)->Unit(benchmark::kMillisecond)->Iterations(10);
 BENCHMARK(BM_OptimizedParquetReadString)->Unit(benchmark::kMillisecond)->Iterations(10);
+BENCHMARK(BM_OptimizedParquetReadLowCardinalityString)->Unit(benchmark::kMillisecond)->Iterations(10);
 BENCHMARK(BM_OptimizedParquetReadDate32)->Unit(benchmark::kMillisecond)->Iterations(200);
+BENCHMARK(BM_OptimizedParquetReadNestedStruct)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Iterations(10);
+BENCHMARK(BM_OptimizedParquetReadManyPartitions)->Unit(benchmark::kMillisecond)->Iterations(10);
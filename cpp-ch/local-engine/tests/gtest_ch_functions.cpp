@@ -1,9 +1,19 @@
+#include <AggregateFunctions/AggregateFunctionFactory.h>
+#include <Columns/ColumnDecimal.h>
+#include <Columns/ColumnNullable.h>
 #include <Columns/ColumnSet.h>
+#include <Columns/ColumnsNumber.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesDecimal.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <DataTypes/DataTypeSet.h>
 #include <Functions/FunctionFactory.h>
 #include <Interpreters/Set.h>
 #include <Parser/SerializedPlanParser.h>
+#include <Parser/aggregate_function_parser/CommonAggregateFunctionParser.h>
 #include <gtest/gtest.h>
+#include <Common/Arena.h>
 #include <Common/DebugUtils.h>
 
 TEST(TestFuntion, Hash)
@@ -166,3 +176,126 @@ TEST(TestFunction, NotIn2)
     debug::headColumn(result2);
     ASSERT_EQ(result2->getUInt(3), 1);
 }
+
+TEST(TestFunction, SparkHash)
+{
+    using namespace DB;
+    auto & factory = FunctionFactory::instance();
+    auto murmur3 = factory.get("sparkMurmurHash3_32", local_engine::SerializedPlanParser::global_context);
+    auto xxhash64 = factory.get("sparkXxHash64", local_engine::SerializedPlanParser::global_context);
+    auto execute = [](const FunctionOverloadResolverPtr & function, const ColumnsWithTypeAndName & arguments)
+    {
+        auto executable = function->build(arguments);
+        return executable->execute(arguments, executable->getResultType(), arguments.front().column->size());
+    };
+
+    /// Expected values are the results of hash() and xxhash64() in spark.
+    auto check = [&](const ColumnWithTypeAndName & argument, const std::vector<Int32> & expected_murmur3, const std::vector<Int64> & expected_xxhash64)
+    {
+        auto murmur3_result = execute(murmur3, {argument});
+        auto xxhash64_result = execute(xxhash64, {argument});
+        for (size_t i = 0; i < expected_murmur3.size(); ++i)
+        {
+            ASSERT_EQ(static_cast<Int32>(murmur3_result->getUInt(i)), expected_murmur3[i]) << argument.type->getName() << " row " << i;
+            ASSERT_EQ(static_cast<Int64>(xxhash64_result->getUInt(i)), expected_xxhash64[i]) << argument.type->getName() << " row " << i;
+        }
+    };
+    auto number_column = []<typename T>(const std::vector<T> & values)
+    {
+        auto column = ColumnVector<T>::create();
+        column->getData().assign(values.begin(), values.end());
+        return ColumnWithTypeAndName(std::move(column), std::make_shared<DataTypeNumber<T>>(), "x");
+    };
+
+    check(
+        number_column(std::vector<Int32>{0, 1, -1, 2147483647}),
+        {933211791, -559580957, -1604776387, 133916647},
+        {3614696996920510707, -6698625589789238999, 2017008487422258757, 1508894993788531228});
+    check(
+        number_column(std::vector<Int64>{0, 1, -1, 1LL << 40}),
+        {-1670924195, -1712319331, -939490007, -1596767687},
+        {-5252525462095825812, -7001672635703045582, 3858142552250413010, 1821704621099523357});
+    check(number_column(std::vector<Int8>{-1, 127}), {-1604776387, 1135925485}, {2017008487422258757, 8632298611707923906});
+    check(
+        number_column(std::vector<Float32>{0.0f, -0.0f, 1.5f}),
+        {933211791, 933211791, -221251528},
+        {3614696996920510707, 3614696996920510707, 6163473420726370430});
+    check(number_column(std::vector<Float64>{-0.0, 1.5}), {-1670924195, 1290763749}, {-5252525462095825812, 7738255526519901366});
+
+    auto decimal_column = ColumnDecimal<Decimal64>::create(0, 2);
+    decimal_column->getData().push_back(Decimal64(12345));
+    decimal_column->getData().push_back(Decimal64(-1));
+    check(
+        ColumnWithTypeAndName(std::move(decimal_column), std::make_shared<DataTypeDecimal64>(10, 2), "x"),
+        {1416086240, -939490007},
+        {8791244235932249694, 3858142552250413010});
+
+    /// The tail bytes of strings are signed in spark.
+    auto string_column = ColumnString::create();
+    for (const auto * value : {"", "a", "abcd", "hello world", "中文"})
+        string_column->insertData(value, strlen(value));
+    check(
+        ColumnWithTypeAndName(std::move(string_column), std::make_shared<DataTypeString>(), "x"),
+        {142593372, 1485273170, -396302900, -1528836094, -1261019299},
+        {-7444071767201028348, -8582455328737087284, -6810745876291105281, 7620854247404556961, -7082105647848352025});
+
+    /// hash(1, 'a') hashes 'a' with the hash of 1 as the seed.
+    auto int_column = ColumnInt32::create();
+    int_column->insertValue(1);
+    auto a_column = ColumnString::create();
+    a_column->insertData("a", 1);
+    ColumnsWithTypeAndName arguments{
+        ColumnWithTypeAndName(std::move(int_column), std::make_shared<DataTypeInt32>(), "x"),
+        ColumnWithTypeAndName(std::move(a_column), std::make_shared<DataTypeString>(), "y")};
+    ASSERT_EQ(static_cast<Int32>(execute(murmur3, arguments)->getUInt(0)), -936062819);
+    ASSERT_EQ(static_cast<Int64>(execute(xxhash64, arguments)->getUInt(0)), 8205864924878002737);
+}
+
+namespace
+{
+/// The result of an aggregate function over the rows [begin, end) of a column.
+DB::ColumnPtr aggregateRange(const DB::AggregateFunctionPtr & function, const DB::IColumn & column, size_t begin, size_t end)
+{
+    DB::Arena arena;
+    auto * place = arena.alignedAlloc(function->sizeOfData(), function->alignOfData());
+    function->create(place);
+    const DB::IColumn * columns[] = {&column};
+    for (size_t i = begin; i < end; ++i)
+        function->add(place, columns, i, &arena);
+    auto result = function->getResultType()->createColumn();
+    function->insertResultInto(place, *result, &arena);
+    function->destroy(place);
+    return result;
+}
+}
+
+TEST(TestFuntion, TypedIntermediateMerge)
+{
+    using namespace DB;
+    auto type = std::make_shared<DataTypeInt64>();
+    auto column = type->createColumn();
+    for (Int64 i = 1; i <= 10; ++i)
+        column->insert(i * 3);
+
+    /// Folding the typed partial results of two partitions gives the result over all the rows.
+    for (const String name : {"sum", "count", "min", "max", "groupBitAnd", "groupBitOr", "groupBitXor", "groupArray"})
+    {
+        auto merge_name = local_engine::BaseAggregateFunctionParser::getTypedIntermediateMergeFunction(name);
+        ASSERT_FALSE(merge_name.empty()) << name;
+        AggregateFunctionProperties properties;
+        auto function = AggregateFunctionFactory::instance().get(name, {type}, {}, properties);
+        auto partials = function->getResultType()->createColumn();
+        partials->insertFrom(*aggregateRange(function, *column, 0, 4), 0);
+        partials->insertFrom(*aggregateRange(function, *column, 4, 10), 0);
+
+        auto merge_function = AggregateFunctionFactory::instance().get(merge_name, {function->getResultType()}, {}, properties);
+        ASSERT_TRUE(merge_function->getResultType()->equals(*function->getResultType())) << name;
+        auto merged = aggregateRange(merge_function, *partials, 0, partials->size());
+        auto expected = aggregateRange(function, *column, 0, column->size());
+        EXPECT_EQ((*merged)[0], (*expected)[0]) << name;
+    }
+
+    /// The other functions keep sending their states.
+    EXPECT_TRUE(local_engine::BaseAggregateFunctionParser::getTypedIntermediateMergeFunction("avg").empty());
+    EXPECT_TRUE(local_engine::BaseAggregateFunctionParser::getTypedIntermediateMergeFunction("stddevSamp").empty());
+}
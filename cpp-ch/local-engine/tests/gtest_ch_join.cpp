@@ -1,7 +1,13 @@
+#include <Columns/ColumnsCommon.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <Functions/FunctionFactory.h>
+#include <Operator/RuntimeFilter.h>
 #include <Parser/SerializedPlanParser.h>
 #include <Parsers/ASTIdentifier.h>
 #include <Processors/Executors/PipelineExecutor.h>
+#include <Processors/Executors/PullingPipelineExecutor.h>
 #include <Processors/QueryPlan/ExpressionStep.h>
 #include <Processors/QueryPlan/JoinStep.h>
 #include <Processors/QueryPlan/Optimizations/QueryPlanOptimizationSettings.h>
@@ -18,6 +24,7 @@
 #include <Interpreters/HashJoin.h>
 #include <Interpreters/TableJoin.h>
 #include <substrait/plan.pb.h>
+#include <magic_enum.hpp>
 
 
 using namespace DB;
@@ -226,3 +233,198 @@ TEST(TestJoin, StorageJoinFromReadBufferTest)
     executor.pull(res);
     debug::headBlock(res);
 }
+
+TEST(TestJoin, RuntimeFilter)
+{
+    auto int_type = std::make_shared<DataTypeInt64>();
+    auto nullable_int_type = makeNullable(int_type);
+
+    auto build_column = nullable_int_type->createColumn();
+    for (Int64 i = 0; i < 100; ++i)
+        build_column->insert(i * 10);
+    build_column->insert(Field());
+
+    auto probe_column = nullable_int_type->createColumn();
+    probe_column->insert(-10);
+    probe_column->insert(0);
+    probe_column->insert(15);
+    probe_column->insert(990);
+    probe_column->insert(1000);
+    probe_column->insert(Field());
+
+    /// Exact IN-list
+    RuntimeFilterSettings settings;
+    RuntimeFilter in_set_filter(nullable_int_type, settings);
+    in_set_filter.insert(*build_column);
+    in_set_filter.finalize();
+    IColumn::Filter filter(probe_column->size(), 1);
+    in_set_filter.apply(*probe_column, filter);
+    EXPECT_EQ(filter, IColumn::Filter({0, 1, 0, 1, 0, 0}));
+
+    /// Bloom filter with min/max, merged from two builders. There may be false positives inside the range.
+    settings.max_in_set_size = 10;
+    RuntimeFilter bloom_filter(nullable_int_type, settings);
+    RuntimeFilter other_bloom_filter(nullable_int_type, settings);
+    bloom_filter.insert(*build_column->cut(0, 50));
+    other_bloom_filter.insert(*build_column->cut(50, 51));
+    bloom_filter.merge(other_bloom_filter);
+    bloom_filter.finalize();
+    filter.assign(probe_column->size(), static_cast<UInt8>(1));
+    bloom_filter.apply(*probe_column, filter);
+    EXPECT_EQ(filter[0], 0);
+    EXPECT_EQ(filter[1], 1);
+    EXPECT_EQ(filter[3], 1);
+    EXPECT_EQ(filter[4], 0);
+    EXPECT_EQ(filter[5], 0);
+
+    EXPECT_TRUE(bloom_filter.mayIntersect(Field(Int64(-5)), Field(Int64(5))));
+    EXPECT_FALSE(bloom_filter.mayIntersect(Field(Int64(991)), Field(Int64(2000))));
+    EXPECT_FALSE(bloom_filter.mayIntersect(Field(Int64(-100)), Field(Int64(-1))));
+
+    /// Empty build side, nothing matches.
+    RuntimeFilter empty_filter(nullable_int_type, settings);
+    empty_filter.finalize();
+    filter.assign(probe_column->size(), static_cast<UInt8>(1));
+    empty_filter.apply(*probe_column, filter);
+    EXPECT_EQ(countBytesInFilter(filter), 0);
+    EXPECT_FALSE(empty_filter.mayIntersect(Field(Int64(0)), Field(Int64(1000))));
+}
+
+TEST(TestJoin, RuntimeFilterReorderedKeys)
+{
+    auto int_type = std::make_shared<DataTypeInt64>();
+    auto string_type = std::make_shared<DataTypeString>();
+    /// A broadcast table built with the keys in another order than the join.
+    RuntimeFilterHolder holder({"b_str", "b_int"}, {string_type, int_type}, RuntimeFilterSettings{});
+
+    auto probe_keys = holder.matchProbeKeys({"b_int", "b_str"}, {"p_int", "p_str"});
+    EXPECT_EQ(probe_keys, Names({"p_str", "p_int"}));
+
+    probe_keys = holder.matchProbeKeys({"b_str", "b_int"}, {"p_str", "p_int"});
+    EXPECT_EQ(probe_keys, Names({"p_str", "p_int"}));
+
+    /// The filters don't apply when a build key of the table isn't a key of the join.
+    EXPECT_TRUE(holder.matchProbeKeys({"b_int", "other"}, {"p_int", "p_str"}).empty());
+    EXPECT_TRUE(holder.matchProbeKeys({"b_int"}, {"p_int"}).empty());
+}
+
+namespace
+{
+using JoinInputRows = std::vector<std::pair<std::optional<Int64>, Int64>>;
+
+Block makeJoinInput(const String & key_name, const String & value_name, const JoinInputRows & rows)
+{
+    auto key_type = makeNullable(std::make_shared<DataTypeInt64>());
+    auto value_type = std::make_shared<DataTypeInt64>();
+    auto key_column = key_type->createColumn();
+    auto value_column = value_type->createColumn();
+    for (const auto & [key, value] : rows)
+    {
+        key_column->insert(key ? Field(*key) : Field());
+        value_column->insert(value);
+    }
+    return Block(
+        {ColumnWithTypeAndName(std::move(key_column), key_type, key_name),
+         ColumnWithTypeAndName(std::move(value_column), value_type, value_name)});
+}
+
+QueryPlanPtr makeSourcePlan(const Block & block)
+{
+    auto plan = std::make_unique<QueryPlan>();
+    plan->addStep(std::make_unique<ReadFromPreparedSource>(Pipe(std::make_shared<SourceFromSingleChunk>(block))));
+    return plan;
+}
+
+std::shared_ptr<TableJoin> makeTableJoin(JoinKind kind, JoinStrictness strictness, const Block & right)
+{
+    auto global_context = SerializedPlanParser::global_context;
+    auto table_join = std::make_shared<TableJoin>(global_context->getSettings(), global_context->getGlobalTemporaryVolume());
+    table_join->setKind(kind);
+    table_join->setStrictness(strictness);
+    table_join->setColumnsFromJoinedTable(right.getNamesAndTypesList());
+    table_join->addDisjunct();
+    ASTPtr left_key = std::make_shared<ASTIdentifier>("l_key");
+    ASTPtr right_key = std::make_shared<ASTIdentifier>("r_key");
+    table_join->addOnKeys(left_key, right_key);
+    for (const auto & column : table_join->columnsFromJoinedTable())
+        table_join->addJoinedColumn(column);
+    return table_join;
+}
+
+/// The rows of the columns, sorted, as the joins don't keep the same order.
+std::vector<String> collectRows(QueryPlan & plan, const Names & columns)
+{
+    auto builder = plan.buildQueryPipeline(QueryPlanOptimizationSettings(), BuildQueryPipelineSettings());
+    auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*builder));
+    PullingPipelineExecutor executor(pipeline);
+    std::vector<String> rows;
+    Block block;
+    while (executor.pull(block))
+    {
+        for (size_t row = 0; row < block.rows(); ++row)
+        {
+            String line;
+            for (const auto & name : columns)
+                line += toString((*block.getByName(name).column->convertToFullColumnIfConst())[row]) + ",";
+            rows.emplace_back(std::move(line));
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+}
+
+TEST(TestJoin, SortMergeJoinMatchesHashJoin)
+{
+    auto global_context = SerializedPlanParser::global_context;
+    global_context->setSetting("join_use_nulls", true);
+    /// Duplicate keys on both sides, null keys and keys without a match on both sides.
+    auto left = makeJoinInput("l_key", "l_value", {{3, 0}, {1, 1}, {std::nullopt, 2}, {2, 3}, {2, 4}, {5, 5}, {std::nullopt, 6}, {7, 7}});
+    auto right = makeJoinInput("r_key", "r_value", {{2, 0}, {std::nullopt, 1}, {1, 2}, {2, 3}, {4, 4}, {3, 5}, {3, 6}, {std::nullopt, 7}});
+    /// The same left rows sorted by the key with nulls last, merged instead of sorted by the merge join.
+    auto sorted_left
+        = makeJoinInput("l_key", "l_value", {{1, 1}, {2, 3}, {2, 4}, {3, 0}, {5, 5}, {7, 7}, {std::nullopt, 2}, {std::nullopt, 6}});
+
+    const std::vector<std::pair<JoinKind, JoinStrictness>> joins
+        = {{JoinKind::Inner, JoinStrictness::All},
+           {JoinKind::Left, JoinStrictness::All},
+           {JoinKind::Full, JoinStrictness::All},
+           {JoinKind::Left, JoinStrictness::Semi},
+           {JoinKind::Left, JoinStrictness::Anti}};
+    for (const auto & [kind, strictness] : joins)
+    {
+        /// Semi/anti joins only output the left columns.
+        Names columns{"l_key", "l_value"};
+        if (strictness == JoinStrictness::All)
+            columns.insert(columns.end(), {"r_key", "r_value"});
+
+        auto left_plan = makeSourcePlan(left);
+        auto right_plan = makeSourcePlan(right);
+        auto hash_join = std::make_shared<HashJoin>(makeTableJoin(kind, strictness, right), right.cloneEmpty());
+        QueryPlanStepPtr join_step = std::make_unique<JoinStep>(
+            left_plan->getCurrentDataStream(), right_plan->getCurrentDataStream(), hash_join, 8192, 1, false);
+        std::vector<QueryPlanPtr> plans;
+        plans.emplace_back(std::move(left_plan));
+        plans.emplace_back(std::move(right_plan));
+        QueryPlan hash_plan;
+        hash_plan.unitePlans(std::move(join_step), {std::move(plans)});
+        auto expected = collectRows(hash_plan, columns);
+        EXPECT_FALSE(expected.empty());
+
+        for (bool left_sorted : {false, true})
+        {
+            SerializedPlanParser parser(global_context);
+            JoinOptimizationInfo join_opt_info;
+            join_opt_info.is_left_sorted = left_sorted;
+            std::vector<IQueryPlanStep *> steps;
+            auto merge_plan = parser.parseSortMergeJoin(
+                makeTableJoin(kind, strictness, right),
+                join_opt_info,
+                makeSourcePlan(left_sorted ? sorted_left : left),
+                makeSourcePlan(right),
+                steps);
+            EXPECT_EQ(collectRows(*merge_plan, columns), expected)
+                << magic_enum::enum_name(kind) << " " << magic_enum::enum_name(strictness) << " left sorted: " << left_sorted;
+        }
+    }
+}
@@ -1,13 +1,31 @@
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <Columns/ColumnConst.h>
+#include <Columns/ColumnsNumber.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypesDecimal.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <Functions/FunctionFactory.h>
 #include <Parser/SerializedPlanParser.h>
 #include <Parsers/ASTFunction.h>
 #include <Processors/Executors/PipelineExecutor.h>
+#include <Processors/Executors/PullingPipelineExecutor.h>
+#include <Processors/QueryPlan/BuildQueryPipelineSettings.h>
+#include <Processors/QueryPlan/Optimizations/QueryPlanOptimizationSettings.h>
+#include <Processors/QueryPlan/ReadFromMergeTree.h>
+#include <Processors/Sources/SourceFromSingleChunk.h>
 #include <QueryPipeline/QueryPipelineBuilder.h>
 #include <Storages/CustomMergeTreeSink.h>
+#include <Storages/CustomStorageMergeTree.h>
+#include <Storages/Output/BucketedFileWriter.h>
 #include <Storages/SubstraitSource/SubstraitFileSource.h>
+#include <google/protobuf/wrappers.pb.h>
 #include <gtest/gtest.h>
 #include <substrait/plan.pb.h>
+#include <base/scope_guard.h>
 #include <Common/DebugUtils.h>
+#include <Common/assert_cast.h>
 #include <Common/MergeTreeTool.h>
 
 using namespace DB;
@@ -269,3 +287,459 @@ TEST(TestWrite, MergeTreeWriteTest)
     auto executor = query_pipeline_builder.execute();
     executor->execute(1);
 }
+
+TEST(TestWrite, MergeWrittenParts)
+{
+    auto context = Context::createCopy(SerializedPlanParser::global_context);
+    /// A part per chunk.
+    context->setSetting("min_insert_block_size_rows", Field(1));
+    auto metadata = buildMetaData(NamesAndTypesList{{"id", std::make_shared<DataTypeInt64>()}}, context);
+    SCOPE_EXIT({ SerializedPlanParser::config->remove("mergetree.merge_after_insert"); });
+
+    for (bool merge : {false, true})
+    {
+        SerializedPlanParser::config->setBool("mergetree.merge_after_insert", merge);
+        CustomStorageMergeTree storage(
+            StorageID("default", "test_merge_written_parts"),
+            "tmp/test_merge_written_parts/",
+            *metadata,
+            false,
+            context,
+            "",
+            MergeTreeData::MergingParams(),
+            buildMergeTreeSettings());
+        SCOPE_EXIT({ storage.dropAllData(); });
+
+        Pipes pipes;
+        for (Int64 i = 0; i < 4; ++i)
+        {
+            auto column = ColumnInt64::create();
+            for (Int64 j = 0; j < 10; ++j)
+                column->insertValue(i * 10 + j);
+            pipes.emplace_back(std::make_shared<SourceFromSingleChunk>(metadata->getSampleBlock(), Chunk(Columns{std::move(column)}, 10)));
+        }
+        auto pipe = Pipe::unitePipes(std::move(pipes));
+        pipe.resize(1);
+        std::shared_ptr<CustomMergeTreeSink> sink;
+        QueryPipelineBuilder pipeline_builder;
+        pipeline_builder.init(std::move(pipe));
+        pipeline_builder.setSinks(
+            [&](const Block &, Pipe::StreamType type) -> ProcessorPtr
+            {
+                if (type != Pipe::StreamType::Main)
+                    return nullptr;
+                sink = std::make_shared<CustomMergeTreeSink>(storage, metadata, context);
+                return sink;
+            });
+        pipeline_builder.execute()->execute(1);
+
+        /// The four parts written by the sink are merged into one once it's finished.
+        auto parts = storage.getDataPartsVectorForInternalUsage();
+        size_t rows = 0;
+        for (const auto & part : parts)
+            rows += part->rows_count;
+        EXPECT_EQ(rows, 40);
+        EXPECT_EQ(parts.size(), merge ? 1 : 4);
+        ASSERT_TRUE(sink);
+        EXPECT_EQ(sink->getWrittenParts().size(), parts.size());
+    }
+}
+
+TEST(TestSubstraitFileSource, PartitionColumns)
+{
+    auto type = makeNullable(std::make_shared<DataTypeInt32>());
+    auto column = FileReaderWrapper::createColumn("7", type, 100);
+    ASSERT_TRUE(isColumnConst(*column));
+    EXPECT_EQ(column->size(), 100);
+    EXPECT_EQ((*column)[99], Field(Int32(7)));
+
+    auto null_column = FileReaderWrapper::createColumn("__HIVE_DEFAULT_PARTITION__", type, 10);
+    ASSERT_TRUE(isColumnConst(*null_column));
+    EXPECT_TRUE(null_column->isNullAt(9));
+}
+
+TEST(TestSubstraitFileSource, PartitionFilter)
+{
+    /// The files don't exist, they must be skipped without being opened.
+    auto type = makeNullable(std::make_shared<DataTypeInt32>());
+    Block header{ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "v"), ColumnWithTypeAndName(type, "p")};
+    substrait::ReadRel::LocalFiles files;
+    for (const auto * path : {"file:///tmp/not_exists/p=1/part-0.parquet", "file:///tmp/not_exists/p=2/part-0.parquet"})
+    {
+        auto * file = files.add_items();
+        file->set_uri_file(path);
+        file->mutable_parquet();
+    }
+    auto source = std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, header, files);
+    EXPECT_EQ(source->getPartitionKeys(), (std::vector<String>{"p"}));
+
+    auto dag = std::make_shared<ActionsDAG>(NamesAndTypesList{{"p", type}});
+    auto literal_type = std::make_shared<DataTypeInt32>();
+    const auto & literal = dag->addColumn(ColumnWithTypeAndName(literal_type->createColumnConst(1, Int32(3)), literal_type, "3"));
+    const auto & equals = dag->addFunction(
+        FunctionFactory::instance().get("equals", SerializedPlanParser::global_context), {dag->getInputs().front(), &literal}, "p_equals_3");
+    dag->addOrReplaceInOutputs(equals);
+    source->setPartitionFilter(std::make_shared<ExpressionActions>(dag), {"p_equals_3"});
+
+    QueryPipeline pipeline(Pipe(std::move(source)));
+    PullingPipelineExecutor executor(pipeline);
+    Block result;
+    size_t rows = 0;
+    while (executor.pull(result))
+        rows += result.rows();
+    EXPECT_EQ(rows, 0);
+}
+
+TEST(TestSubstraitFileSource, PartitionFilterNotApplied)
+{
+    auto make_source = [](const DataTypePtr & type, const std::vector<String> & paths)
+    {
+        Block header{ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "v"), ColumnWithTypeAndName(type, "p")};
+        substrait::ReadRel::LocalFiles files;
+        for (const auto & path : paths)
+        {
+            auto * file = files.add_items();
+            file->set_uri_file(path);
+            file->mutable_parquet();
+        }
+        auto source = std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, header, files);
+        auto dag = std::make_shared<ActionsDAG>(NamesAndTypesList{{"p", type}});
+        const auto & is_not_null = dag->addFunction(
+            FunctionFactory::instance().get("isNotNull", SerializedPlanParser::global_context), {dag->getInputs().front()}, "p_is_not_null");
+        dag->addOrReplaceInOutputs(is_not_null);
+        source->setPartitionFilter(std::make_shared<ExpressionActions>(dag), {"p_is_not_null"});
+        std::map<String, UInt64> metrics;
+        source->collectExtraMetrics(metrics);
+        return metrics;
+    };
+
+    auto int_type = std::make_shared<DataTypeInt32>();
+    EXPECT_EQ(make_source(makeNullable(int_type), {"file:///tmp/not_exists/p=__HIVE_DEFAULT_PARTITION__/part-0.parquet"})
+                  .at("partition_filter_skipped_files"),
+              1);
+    /// The partition values can't be parsed into a decimal, nothing is pruned.
+    EXPECT_FALSE(make_source(createDecimal<DataTypeDecimal>(10, 2), {"file:///tmp/not_exists/p=1.5/part-0.parquet"})
+                     .contains("partition_filter_skipped_files"));
+    /// A null value of a column which isn't nullable fails the evaluation, nothing is pruned.
+    auto metrics = make_source(
+        int_type, {"file:///tmp/not_exists/p=1/part-0.parquet", "file:///tmp/not_exists/p=__HIVE_DEFAULT_PARTITION__/part-0.parquet"});
+    EXPECT_FALSE(metrics.contains("partition_filter_skipped_files"));
+}
+
+namespace
+{
+/// JSON files of an Int64 column v, each with the values after the ones of the file before it.
+substrait::ReadRel::LocalFiles writeJsonFiles(const String & dir, const std::vector<size_t> & rows_per_file, size_t max_block_size)
+{
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    substrait::ReadRel::LocalFiles files;
+    Int64 value = 0;
+    for (size_t i = 0; i < rows_per_file.size(); ++i)
+    {
+        String path = dir + "/part-" + std::to_string(i) + ".json";
+        std::ofstream out(path);
+        for (size_t row = 0; row < rows_per_file[i]; ++row)
+            out << "{\"v\":" << value++ << "}\n";
+        auto * file = files.add_items();
+        file->set_uri_file("file://" + path);
+        file->mutable_json()->set_max_block_size(max_block_size);
+    }
+    return files;
+}
+
+Block jsonFilesHeader()
+{
+    return Block{ColumnWithTypeAndName(std::make_shared<DataTypeInt64>(), "v")};
+}
+
+std::vector<Int64> readJsonFiles(const substrait::ReadRel::LocalFiles & files)
+{
+    QueryPipeline pipeline(Pipe(std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, jsonFilesHeader(), files)));
+    PullingPipelineExecutor executor(pipeline);
+    std::vector<Int64> values;
+    Block result;
+    while (executor.pull(result))
+    {
+        const auto & column = assert_cast<const ColumnInt64 &>(*result.getByName("v").column);
+        values.insert(values.end(), column.getData().begin(), column.getData().end());
+    }
+    return values;
+}
+}
+
+TEST(TestSubstraitFileSource, PrefetchKeepsFilesOrder)
+{
+    auto files = writeJsonFiles("/tmp/test_file_prefetch_order", {100, 0, 35, 1, 200, 64}, 7);
+    std::vector<Int64> expected(400);
+    std::iota(expected.begin(), expected.end(), 0);
+    SCOPE_EXIT({
+        SerializedPlanParser::config->remove("file_prefetch.files");
+        SerializedPlanParser::config->remove("file_prefetch.max_bytes");
+    });
+    /// Without prefetching, prefetching the first chunks only, and reading whole files ahead.
+    for (size_t prefetch_files : std::initializer_list<size_t>{0, 1, 2, 8})
+    {
+        for (size_t max_bytes : std::initializer_list<size_t>{0, 1024 * 1024})
+        {
+            SerializedPlanParser::config->setUInt64("file_prefetch.files", prefetch_files);
+            SerializedPlanParser::config->setUInt64("file_prefetch.max_bytes", max_bytes);
+            EXPECT_EQ(readJsonFiles(files), expected) << prefetch_files << " files prefetched, max bytes " << max_bytes;
+        }
+    }
+}
+
+TEST(TestSubstraitFileSource, PrefetchPropagatesErrors)
+{
+    auto files = writeJsonFiles("/tmp/test_file_prefetch_error", {50, 50}, 10);
+    /// The third file doesn't exist, it fails while being prefetched during the read of the first ones.
+    auto * missing = files.add_items();
+    missing->set_uri_file("file:///tmp/test_file_prefetch_error/missing.json");
+    missing->mutable_json()->set_max_block_size(10);
+    SCOPE_EXIT({ SerializedPlanParser::config->remove("file_prefetch.files"); });
+    SerializedPlanParser::config->setUInt64("file_prefetch.files", 2);
+
+    QueryPipeline pipeline(Pipe(std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, jsonFilesHeader(), files)));
+    PullingPipelineExecutor executor(pipeline);
+    size_t rows = 0;
+    Block result;
+    /// The files before it are returned, the error is thrown when the reading reaches it.
+    EXPECT_THROW(
+        {
+            while (executor.pull(result))
+                rows += result.rows();
+        },
+        Exception);
+    EXPECT_EQ(rows, 100);
+}
+
+TEST(TestSubstraitFileSource, DestroyedWhilePrefetching)
+{
+    auto files = writeJsonFiles("/tmp/test_file_prefetch_destroy", std::vector<size_t>(8, 20000), 100);
+    SCOPE_EXIT({
+        SerializedPlanParser::config->remove("file_prefetch.files");
+        SerializedPlanParser::config->remove("file_prefetch.max_bytes");
+    });
+    SerializedPlanParser::config->setUInt64("file_prefetch.files", 4);
+    /// The prefetching reads whole files, it's still running when the source is destroyed.
+    SerializedPlanParser::config->setUInt64("file_prefetch.max_bytes", 1024 * 1024 * 1024);
+    for (size_t i = 0; i < 5; ++i)
+    {
+        QueryPipeline pipeline(Pipe(std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, jsonFilesHeader(), files)));
+        PullingPipelineExecutor executor(pipeline);
+        Block result;
+        ASSERT_TRUE(executor.pull(result));
+        EXPECT_EQ(assert_cast<const ColumnInt64 &>(*result.getByName("v").column).getElement(0), 0);
+    }
+}
+
+TEST(TestMergeTreeTable, KeysAndSkipIndexes)
+{
+    local_engine::MergeTreeTable table{
+        .database = "default",
+        .table = "lineitem",
+        .relative_path = "tmp/lineitem",
+        .min_block = 1,
+        .max_block = 10,
+        .order_by_key = "l_shipdate, l_orderkey",
+        .primary_key = "l_shipdate",
+        .skip_indexes = "idx_quantity l_quantity TYPE minmax GRANULARITY 1"};
+    auto parsed = local_engine::parseMergeTreeTableString(table.toString());
+    EXPECT_EQ(parsed.order_by_key, table.order_by_key);
+    EXPECT_EQ(parsed.primary_key, table.primary_key);
+    EXPECT_EQ(parsed.skip_indexes, table.skip_indexes);
+
+    /// The descriptors without keys are still accepted.
+    local_engine::MergeTreeTable plain_table{
+        .database = "default", .table = "lineitem", .relative_path = "tmp/lineitem", .min_block = 1, .max_block = 10};
+    EXPECT_TRUE(local_engine::parseMergeTreeTableString(plain_table.toString()).order_by_key.empty());
+
+    auto names_and_types_list = NamesAndTypesList::parse("columns format version: 1\n"
+                                                         "3 columns:\n"
+                                                         "`l_orderkey` Int64\n"
+                                                         "`l_quantity` Float64\n"
+                                                         "`l_shipdate` Date\n");
+    auto metadata = local_engine::buildMetaData(names_and_types_list, SerializedPlanParser::global_context, parsed);
+    EXPECT_EQ(metadata->getSortingKeyColumns(), (Names{"l_shipdate", "l_orderkey"}));
+    EXPECT_EQ(metadata->getPrimaryKeyColumns(), (Names{"l_shipdate"}));
+    ASSERT_EQ(metadata->getSecondaryIndices().size(), 1);
+    EXPECT_EQ(metadata->getSecondaryIndices()[0].name, "idx_quantity");
+    EXPECT_EQ(metadata->getSecondaryIndices()[0].type, "minmax");
+}
+
+TEST(TestBucketedFileWriter, SparkBucketIds)
+{
+    /// hash(k) in spark is 933211791, -559580957, -1604776387 and 133916647, pmod(hash(k), 8) as below.
+    BucketedFileWriter writer(SerializedPlanParser::global_context, "file:///tmp/test_bucket_ids", "part-00000", ".parquet", {"k"}, 8, {});
+    auto column = ColumnInt32::create();
+    column->getData().assign(std::vector<Int32>{0, 1, -1, 2147483647});
+    Block block{ColumnWithTypeAndName(std::move(column), std::make_shared<DataTypeInt32>(), "k")};
+    auto bucket_ids = writer.computeBucketIds(block);
+    EXPECT_EQ(assert_cast<const ColumnInt32 &>(*bucket_ids).getData(), (PaddedPODArray<Int32>{7, 3, 5, 7}));
+    EXPECT_EQ(BucketedFileWriter::bucketIdToString(3), "_00003");
+}
+
+TEST(TestBucketedFileWriter, WriteSortedBuckets)
+{
+    String directory = "/tmp/test_bucketed_write";
+    std::filesystem::remove_all(directory);
+    BucketedFileWriter writer(
+        SerializedPlanParser::global_context, "file://" + directory, "part-00000-test", ".c000.parquet", {"k"}, 8, {"v"});
+
+    auto keys = ColumnInt32::create();
+    auto values = ColumnInt64::create();
+    for (Int64 i = 0; i < 1000; ++i)
+    {
+        keys->insertValue(std::vector<Int32>{0, 1, -1, 2147483647}[i % 4]);
+        values->insertValue(1000 - i);
+    }
+    Block block{
+        ColumnWithTypeAndName(std::move(keys), std::make_shared<DataTypeInt32>(), "k"),
+        ColumnWithTypeAndName(std::move(values), std::make_shared<DataTypeInt64>(), "v")};
+    auto header = block.cloneEmpty();
+    writer.consume(block);
+    /// The block of the caller is not changed.
+    ASSERT_TRUE(blocksHaveEqualStructure(block, header));
+    ASSERT_EQ(block.rows(), 1000);
+    writer.close();
+
+    std::vector<String> expected_files;
+    for (const auto * bucket : {"00003", "00005", "00007"})
+        expected_files.emplace_back(fmt::format("file://{}/part-00000-test_{}.c000.parquet", directory, bucket));
+    ASSERT_EQ(writer.getWrittenFiles(), expected_files);
+
+    /// Bucket 7 holds the rows of 0 and 2147483647, sorted by v.
+    substrait::ReadRel::LocalFiles files;
+    auto * file = files.add_items();
+    file->set_uri_file(expected_files.back());
+    file->mutable_parquet();
+    QueryPipeline pipeline(Pipe(std::make_shared<SubstraitFileSource>(SerializedPlanParser::global_context, header, files)));
+    PullingPipelineExecutor executor(pipeline);
+    Block result;
+    std::vector<Int64> read_values;
+    while (executor.pull(result))
+        for (size_t i = 0; i < result.rows(); ++i)
+            read_values.emplace_back(result.getByName("v").column->getInt(i));
+    EXPECT_EQ(read_values.size(), 500);
+    EXPECT_TRUE(std::is_sorted(read_values.begin(), read_values.end()));
+}
+
+namespace
+{
+/// Reads the table with the filter "column = value", returns the read step of the plan and the rows read.
+std::pair<const ReadFromMergeTree *, Block>
+readMergeTreeWithFilter(const MergeTreeTable & table, SerializedPlanParser & parser, QueryPlanPtr & query_plan, Int32 column, Int64 value)
+{
+    auto plan = std::make_unique<substrait::Plan>();
+    auto * function = plan->add_extensions()->mutable_extension_function();
+    function->set_function_anchor(0);
+    function->set_name("equal:i64_i64");
+
+    auto * read = plan->add_relations()->mutable_root()->mutable_input()->mutable_read();
+    google::protobuf::StringValue table_string;
+    table_string.set_value(table.toString());
+    read->mutable_extension_table()->mutable_detail()->PackFrom(table_string);
+    for (const auto * name : {"id", "value"})
+    {
+        read->mutable_base_schema()->add_names(name);
+        read->mutable_base_schema()->mutable_struct_()->add_types()->mutable_i64()->set_nullability(
+            substrait::Type_Nullability_NULLABILITY_REQUIRED);
+    }
+    auto * equal = read->mutable_filter()->mutable_scalar_function();
+    equal->set_function_reference(0);
+    equal->mutable_output_type()->mutable_bool_()->set_nullability(substrait::Type_Nullability_NULLABILITY_REQUIRED);
+    equal->add_arguments()->mutable_value()->mutable_selection()->mutable_direct_reference()->mutable_struct_field()->set_field(column);
+    equal->add_arguments()->mutable_value()->mutable_literal()->set_i64(value);
+
+    query_plan = parser.parse(std::move(plan));
+    const ReadFromMergeTree * read_step = nullptr;
+    for (auto * node = query_plan->getRootNode(); node && !read_step; node = node->children.empty() ? nullptr : node->children.front())
+        read_step = typeid_cast<const ReadFromMergeTree *>(node->step.get());
+
+    auto pipeline_builder = query_plan->buildQueryPipeline(QueryPlanOptimizationSettings(), BuildQueryPipelineSettings());
+    auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*pipeline_builder));
+    PullingPipelineExecutor executor(pipeline);
+    Block result;
+    Block block;
+    while (executor.pull(block))
+    {
+        if (!result)
+            result = block.cloneEmpty();
+        auto columns = result.mutateColumns();
+        for (size_t i = 0; i < columns.size(); ++i)
+            columns[i]->insertRangeFrom(*block.getByPosition(i).column, 0, block.rows());
+        result.setColumns(std::move(columns));
+    }
+    return {read_step, result};
+}
+}
+
+TEST(TestMergeTreeTable, PruneGranulesByPrimaryKey)
+{
+    auto context = SerializedPlanParser::global_context;
+    MergeTreeTable table{
+        .database = "default",
+        .table = "test_prune_granules",
+        .relative_path = "tmp/test_prune_granules/",
+        .min_block = 0,
+        .max_block = 1 << 30,
+        .order_by_key = "id",
+        .primary_key = "id"};
+
+    auto metadata = buildMetaData(NamesAndTypesList{{"id", std::make_shared<DataTypeInt64>()}, {"value", std::make_shared<DataTypeInt64>()}}, context, table);
+    auto settings = buildMergeTreeSettings();
+    settings->set("index_granularity", Field(100));
+    CustomStorageMergeTree writer(
+        StorageID(table.database, table.table), table.relative_path, *metadata, false, context, "", MergeTreeData::MergingParams(), std::move(settings));
+
+    /// 1000 rows in granules of 100 rows, written in reverse order, the sink sorts them by the key.
+    auto id_column = ColumnInt64::create();
+    auto value_column = ColumnInt64::create();
+    for (Int64 i = 999; i >= 0; --i)
+    {
+        id_column->insertValue(i);
+        value_column->insertValue(i * 2);
+    }
+    Chunk chunk(Columns{std::move(id_column), std::move(value_column)}, 1000);
+    QueryPipelineBuilder pipeline_builder;
+    pipeline_builder.init(Pipe(std::make_shared<SourceFromSingleChunk>(metadata->getSampleBlock(), std::move(chunk))));
+    pipeline_builder.setSinks(
+        [&](const Block &, Pipe::StreamType type) -> ProcessorPtr
+        {
+            if (type != Pipe::StreamType::Main)
+                return nullptr;
+            return std::make_shared<CustomMergeTreeSink>(writer, metadata, context);
+        });
+    pipeline_builder.execute()->execute(1);
+    SCOPE_EXIT({ writer.dropAllData(); });
+
+    {
+        /// The primary key selects the granule of id 555 only.
+        SerializedPlanParser parser(context);
+        QueryPlanPtr query_plan;
+        auto [read_step, result] = readMergeTreeWithFilter(table, parser, query_plan, 0, 555);
+        ASSERT_TRUE(read_step);
+        auto analysis = read_step->getAnalyzedResult();
+        ASSERT_TRUE(analysis && !analysis->error());
+        const auto & ranges = std::get<ReadFromMergeTree::AnalysisResult>(analysis->result);
+        EXPECT_EQ(ranges.total_marks_pk, 10);
+        EXPECT_EQ(ranges.selected_marks, 1);
+        ASSERT_EQ(result.rows(), 1);
+        EXPECT_EQ(result.getByName("id").column->getInt(0), 555);
+        EXPECT_EQ(result.getByName("value").column->getInt(0), 1110);
+    }
+
+    {
+        /// value is not a key column, all the granules are read.
+        SerializedPlanParser parser(context);
+        QueryPlanPtr query_plan;
+        auto [read_step, result] = readMergeTreeWithFilter(table, parser, query_plan, 1, 1110);
+        ASSERT_TRUE(read_step);
+        auto analysis = read_step->getAnalyzedResult();
+        ASSERT_TRUE(analysis && !analysis->error());
+        const auto & ranges = std::get<ReadFromMergeTree::AnalysisResult>(analysis->result);
+        EXPECT_EQ(ranges.selected_marks, ranges.total_marks_pk);
+        ASSERT_EQ(result.rows(), 1);
+        EXPECT_EQ(result.getByName("id").column->getInt(0), 555);
+    }
+}
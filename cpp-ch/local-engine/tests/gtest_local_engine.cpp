@@ -1,20 +1,39 @@
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <Builder/SerializedPlanBuilder.h>
+#include <Columns/ColumnString.h>
 #include <Columns/ColumnVector.h>
+#include <Compression/CompressedReadBuffer.h>
+#include <Compression/CompressedWriteBuffer.h>
+#include <Compression/CompressionFactory.h>
+#include <DataTypes/DataTypeAggregateFunction.h>
+#include <DataTypes/DataTypeString.h>
 #include <DataTypes/DataTypesNumber.h>
 #include <Disks/DiskLocal.h>
+#include <Formats/NativeReader.h>
+#include <Formats/NativeWriter.h>
+#include <IO/ReadBufferFromFile.h>
+#include <IO/ReadBufferFromString.h>
+#include <IO/WriteBufferFromString.h>
 #include <Interpreters/Context.h>
 #include <Interpreters/TableJoin.h>
 #include <Interpreters/TreeRewriter.h>
+#include <Parser/AggregateRelParser.h>
 #include <Parser/CHColumnToSparkRow.h>
 #include <Parser/SerializedPlanParser.h>
 #include <Parser/SparkRowToCHColumn.h>
 #include <Parsers/ASTFunction.h>
 #include <Processors/Executors/PipelineExecutor.h>
+#include <Processors/Executors/PullingPipelineExecutor.h>
 #include <Processors/Formats/Impl/CSVRowOutputFormat.h>
+#include <Processors/QueryPlan/AggregatingStep.h>
 #include <Processors/QueryPlan/Optimizations/QueryPlanOptimizationSettings.h>
+#include <Processors/QueryPlan/ReadFromPreparedSource.h>
+#include <Processors/Sources/SourceFromSingleChunk.h>
 #include <QueryPipeline/QueryPipelineBuilder.h>
+#include <Shuffle/NativeSplitter.h>
+#include <Shuffle/ParallelDecompressingReadBuffer.h>
 #include <Storages/CustomMergeTreeSink.h>
 #include <Storages/CustomStorageMergeTree.h>
 #include <Storages/MergeTree/MergeTreeData.h>
@@ -22,11 +41,13 @@
 #include <Storages/SelectQueryInfo.h>
 #include <Storages/SubstraitSource/SubstraitFileSource.h>
 #include <gtest/gtest.h>
+#include <google/protobuf/wrappers.pb.h>
 #include <substrait/plan.pb.h>
 #include <Poco/Util/MapConfiguration.h>
 #include <Common/DebugUtils.h>
 #include <Common/Logger.h>
 #include <Common/CHUtil.h>
+#include <Common/assert_cast.h>
 #include "testConfig.h"
 
 using namespace local_engine;
@@ -330,6 +351,60 @@ TEST(TestSubstrait, TestGenerate)
     output.close();
 }
 
+TEST(TestSubstrait, ReuseCommonSubexpressions)
+{
+    substrait::Plan plan;
+    auto add_function = [&](UInt32 anchor, const std::string & name)
+    {
+        auto * function = plan.add_extensions()->mutable_extension_function();
+        function->set_function_anchor(anchor);
+        function->set_name(name);
+    };
+    add_function(0, "multiply:fp64_fp64");
+    add_function(1, "add:fp64_fp64");
+    add_function(2, "rand:i32");
+
+    auto field_reference = [](Int32 field)
+    {
+        substrait::Expression expr;
+        expr.mutable_selection()->mutable_direct_reference()->mutable_struct_field()->set_field(field);
+        return expr;
+    };
+    auto scalar_function_expr = [](UInt32 anchor, const std::vector<substrait::Expression> & args)
+    {
+        substrait::Expression expr;
+        auto * scalar_function = expr.mutable_scalar_function();
+        scalar_function->set_function_reference(anchor);
+        scalar_function->mutable_output_type()->mutable_fp64()->set_nullability(substrait::Type_Nullability_NULLABILITY_REQUIRED);
+        for (const auto & arg : args)
+            *scalar_function->add_arguments()->mutable_value() = arg;
+        return expr;
+    };
+    substrait::Expression seed;
+    seed.mutable_literal()->set_i32(1);
+
+    /// a * b, a * b + a, rand(1), rand(1)
+    auto multiply = scalar_function_expr(0, {field_reference(0), field_reference(1)});
+    std::vector<substrait::Expression> expressions{
+        multiply, scalar_function_expr(1, {multiply, field_reference(0)}), scalar_function_expr(2, {seed}), scalar_function_expr(2, {seed})};
+
+    Block header{
+        ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "a"), ColumnWithTypeAndName(std::make_shared<DataTypeFloat64>(), "b")};
+    local_engine::SerializedPlanParser parser(local_engine::SerializedPlanParser::global_context);
+    parser.parseExtensions(plan.extensions());
+    auto actions_dag = parser.expressionsToActionsDAG(expressions, header, header);
+
+    std::map<std::string, size_t> functions;
+    for (const auto & node : actions_dag->getNodes())
+        if (node.type == ActionsDAG::ActionType::FUNCTION)
+            ++functions[node.function_base->getName()];
+    ASSERT_EQ(actions_dag->getOutputs().size(), 4) << actions_dag->dumpDAG();
+    /// a * b is evaluated once, the non-deterministic rand(1) twice.
+    ASSERT_EQ(functions["multiply"], 1) << actions_dag->dumpDAG();
+    ASSERT_EQ(functions["plus"], 1) << actions_dag->dumpDAG();
+    ASSERT_EQ(functions["randCanonical"], 2) << actions_dag->dumpDAG();
+}
+
 TEST(ReadBufferFromFile, seekBackwards)
 {
     static constexpr size_t N = 256;
@@ -359,6 +434,352 @@ TEST(ReadBufferFromFile, seekBackwards)
     ASSERT_EQ(x, 8);
 }
 
+TEST(TestNativeSplitter, AccumulateByBytes)
+{
+    auto column = DB::ColumnUInt64::create();
+    for (UInt64 i = 0; i < 1000; ++i)
+        column->insertValue(i);
+    DB::Block block({DB::ColumnWithTypeAndName(std::move(column), std::make_shared<DB::DataTypeUInt64>(), "a")});
+
+    NativeSplitter::Options by_rows;
+    by_rows.buffer_size = 500;
+    NativeSplitter::Options by_bytes = by_rows;
+    by_bytes.buffer_bytes = 8 * 800;
+
+    ColumnsBuffer buffer(by_rows.buffer_size);
+    buffer.add(block, 0, 499);
+    ASSERT_FALSE(NativeSplitter::isFull(buffer, by_rows));
+    buffer.add(block, 499, 500);
+    ASSERT_TRUE(NativeSplitter::isFull(buffer, by_rows));
+    /// With buffer_bytes the rows don't matter, 500 rows of UInt64 take less than 800 * 8 bytes.
+    ASSERT_FALSE(NativeSplitter::isFull(buffer, by_bytes));
+    buffer.add(block, 500, 800);
+    ASSERT_TRUE(NativeSplitter::isFull(buffer, by_bytes));
+    ASSERT_EQ(buffer.releaseColumns().rows(), 800);
+}
+
+TEST(TestNativeSplitter, SerializedBlocksCanBeConcatenated)
+{
+    auto make_block = [](UInt64 from, UInt64 rows)
+    {
+        auto column = DB::ColumnUInt64::create();
+        for (UInt64 i = from; i < from + rows; ++i)
+            column->insertValue(i);
+        return DB::Block({DB::ColumnWithTypeAndName(std::move(column), std::make_shared<DB::DataTypeUInt64>(), "a")});
+    };
+
+    for (const auto & codec : {DB::CompressionCodecPtr{}, DB::CompressionCodecFactory::instance().get("LZ4", {})})
+    {
+        /// Written like the shuffle output of the serialized splitter, one block after the other.
+        std::string output;
+        std::string serialized;
+        NativeSplitter::serialize(make_block(0, 10), codec, serialized);
+        output += serialized;
+        NativeSplitter::serialize(make_block(10, 20), codec, serialized);
+        output += serialized;
+
+        DB::ReadBufferFromString in(output);
+        std::unique_ptr<DB::ReadBuffer> compressed_in;
+        if (codec)
+            compressed_in = std::make_unique<DB::CompressedReadBuffer>(in);
+        DB::NativeReader reader(codec ? *compressed_in : in, 0);
+        UInt64 expected = 0;
+        for (size_t rows : {10, 20})
+        {
+            auto block = reader.read();
+            ASSERT_EQ(block.rows(), rows);
+            const auto & column = assert_cast<const DB::ColumnUInt64 &>(*block.getByName("a").column);
+            for (size_t i = 0; i < rows; ++i)
+                ASSERT_EQ(column.getElement(i), expected++);
+        }
+        ASSERT_FALSE(reader.read());
+    }
+}
+
+TEST(TestShuffleReader, ParallelDecompressionMatchesSequential)
+{
+    auto make_block = [](UInt64 from, UInt64 rows)
+    {
+        auto number = DB::ColumnUInt64::create();
+        auto text = DB::ColumnString::create();
+        for (UInt64 i = from; i < from + rows; ++i)
+        {
+            number->insertValue(i);
+            text->insert(std::string(i % 37, static_cast<char>('a' + i % 26)));
+        }
+        return DB::Block(
+            {DB::ColumnWithTypeAndName(std::move(number), std::make_shared<DB::DataTypeUInt64>(), "a"),
+             DB::ColumnWithTypeAndName(std::move(text), std::make_shared<DB::DataTypeString>(), "b")});
+    };
+    auto read_all = [](DB::ReadBuffer & in)
+    {
+        std::vector<String> rows;
+        DB::NativeReader reader(in, 0);
+        while (auto block = reader.read())
+        {
+            for (size_t row = 0; row < block.rows(); ++row)
+                rows.emplace_back(toString((*block.getByPosition(0).column)[row]) + "," + toString((*block.getByPosition(1).column)[row]));
+        }
+        return rows;
+    };
+
+    auto * pool = ParallelDecompressingReadBuffer::sharedPool();
+    ASSERT_NE(pool, nullptr);
+    for (const auto * codec_name : {"LZ4", "ZSTD", "NONE"})
+    {
+        /// A small buffer, so a block spans several compressed frames and a frame may hold the end of a block and
+        /// the start of the next one.
+        std::string output;
+        DB::WriteBufferFromString out(output);
+        DB::CompressedWriteBuffer compressed_out(out, DB::CompressionCodecFactory::instance().get(codec_name, {}), 4096);
+        DB::NativeWriter writer(compressed_out, 0, make_block(0, 0).cloneEmpty());
+        UInt64 from = 0;
+        for (UInt64 rows : std::initializer_list<UInt64>{1, 1000, 0, 5000, 37})
+        {
+            writer.write(make_block(from, rows));
+            from += rows;
+        }
+        compressed_out.finalize();
+        out.finalize();
+
+        DB::ReadBufferFromString sequential_in(output);
+        DB::CompressedReadBuffer sequential(sequential_in);
+        auto expected = read_all(sequential);
+        ASSERT_EQ(expected.size(), from);
+        for (size_t frames_in_flight : std::initializer_list<size_t>{1, 3, 16})
+        {
+            DB::ReadBufferFromString parallel_in(output);
+            ParallelDecompressingReadBuffer parallel(parallel_in, *pool, frames_in_flight);
+            ASSERT_EQ(read_all(parallel), expected) << codec_name << " with " << frames_in_flight << " frames in flight";
+        }
+
+        /// A corrupted frame fails the read like with CompressedReadBuffer.
+        output[output.size() / 2] = static_cast<char>(output[output.size() / 2] ^ 0x5a);
+        DB::ReadBufferFromString corrupted_in(output);
+        ParallelDecompressingReadBuffer corrupted(corrupted_in, *pool, 3);
+        ASSERT_ANY_THROW(read_all(corrupted));
+    }
+}
+
+TEST(TestShuffleSplitter, BlockIndex)
+{
+    String root = "/tmp/test_shuffle_block_index";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    SplitOptions options{
+        .split_size = 100,
+        .data_file = root + "/data.dat",
+        .local_dirs_list = {root},
+        .num_sub_dirs = 1,
+        .shuffle_id = 0,
+        .map_id = 0,
+        .partition_nums = 2,
+        .compress_method = "LZ4",
+        .block_index_file = root + "/data.blocks"};
+    auto splitter = ShuffleSplitter::create("rr", options);
+    UInt64 total_rows = 0;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto column = DB::ColumnUInt64::create();
+        for (size_t j = 0; j < 250; ++j)
+            column->insertValue(total_rows++);
+        DB::Block block({DB::ColumnWithTypeAndName(std::move(column), std::make_shared<DB::DataTypeUInt64>(), "a")});
+        splitter->split(block);
+    }
+    auto result = splitter->stop();
+
+    auto blocks = ShuffleSplitter::readBlockIndexFile(options.block_index_file);
+    ASSERT_EQ(blocks.size(), 2);
+    DB::ReadBufferFromFile data(options.data_file);
+    size_t partition_start = 0;
+    size_t read_rows = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        /// Every partition is split into blocks once it has more than split_size rows, the blocks follow each other.
+        ASSERT_GT(blocks[i].size(), 1);
+        size_t offset = partition_start;
+        for (const auto & block : blocks[i])
+        {
+            ASSERT_EQ(block.offset, offset);
+            offset += block.length;
+
+            /// A block is read without the ones before it.
+            String bytes(block.length, '\0');
+            data.seek(block.offset, SEEK_SET);
+            data.readStrict(bytes.data(), block.length);
+            DB::ReadBufferFromString in(bytes);
+            DB::CompressedReadBuffer compressed_in(in);
+            DB::NativeReader reader(compressed_in, 0);
+            auto read = reader.read();
+            ASSERT_EQ(read.rows(), block.rows);
+            ASSERT_FALSE(reader.read());
+            read_rows += read.rows();
+        }
+        partition_start += result.partition_length[i];
+        ASSERT_EQ(offset, partition_start);
+    }
+    ASSERT_EQ(read_rows, total_rows);
+}
+
+namespace
+{
+/// (k1, k2, v) rows.
+Block makeAggregateInput(const std::vector<std::array<Int64, 3>> & rows)
+{
+    auto int_type = std::make_shared<DataTypeInt64>();
+    Block header{ColumnWithTypeAndName(int_type, "k1"), ColumnWithTypeAndName(int_type, "k2"), ColumnWithTypeAndName(int_type, "v")};
+    auto columns = header.cloneEmptyColumns();
+    for (const auto & row : rows)
+        for (size_t i = 0; i < row.size(); ++i)
+            columns[i]->insert(row[i]);
+    return header.cloneWithColumns(std::move(columns));
+}
+
+/// One stream per block.
+QueryPlanPtr makeAggregateSource(const std::vector<Block> & streams)
+{
+    Pipes pipes;
+    for (const auto & block : streams)
+        pipes.emplace_back(std::make_shared<SourceFromSingleChunk>(block));
+    auto plan = std::make_unique<QueryPlan>();
+    plan->addStep(std::make_unique<ReadFromPreparedSource>(Pipe::unitePipes(std::move(pipes))));
+    return plan;
+}
+
+/// sum(<sum_field>) grouped by the key fields, the ordering is the one sent by the jvm for sorted inputs.
+substrait::Rel makeSumRel(const std::vector<Int32> & key_fields, Int32 sum_field, substrait::AggregationPhase phase, const String & ordering = "")
+{
+    auto field_reference = [](substrait::Expression & expr, Int32 field)
+    { expr.mutable_selection()->mutable_direct_reference()->mutable_struct_field()->set_field(field); };
+
+    substrait::Rel rel;
+    auto * aggregate = rel.mutable_aggregate();
+    auto * grouping = aggregate->add_groupings();
+    for (auto field : key_fields)
+        field_reference(*grouping->add_grouping_expressions(), field);
+    auto * measure = aggregate->add_measures()->mutable_measure();
+    measure->set_function_reference(0);
+    measure->set_phase(phase);
+    field_reference(*measure->add_arguments()->mutable_value(), sum_field);
+    measure->mutable_output_type()->mutable_i64()->set_nullability(substrait::Type_Nullability_NULLABILITY_NULLABLE);
+    if (!ordering.empty())
+    {
+        google::protobuf::StringValue optimization;
+        optimization.set_value("AggregateParameters:groupingKeysOrdering=" + ordering + "\n");
+        aggregate->mutable_advanced_extension()->mutable_optimization()->PackFrom(optimization);
+    }
+    return rel;
+}
+
+QueryPlanPtr parseAggregateRel(QueryPlanPtr plan, const substrait::Rel & rel)
+{
+    substrait::Plan substrait_plan;
+    auto * function = substrait_plan.add_extensions()->mutable_extension_function();
+    function->set_function_anchor(0);
+    function->set_name("sum:i64");
+    SerializedPlanParser parser(SerializedPlanParser::global_context);
+    parser.parseExtensions(substrait_plan.extensions());
+    AggregateRelParser rel_parser(&parser);
+    std::list<const substrait::Rel *> rel_stack;
+    return rel_parser.parse(std::move(plan), rel, rel_stack);
+}
+
+/// sum(v) group by k1, k2 through a partial and a final aggregation.
+QueryPlanPtr parseSumByKeys(QueryPlanPtr plan, const String & partial_ordering = "")
+{
+    plan = parseAggregateRel(
+        std::move(plan), makeSumRel({0, 1}, 2, substrait::AggregationPhase::AGGREGATION_PHASE_INITIAL_TO_INTERMEDIATE, partial_ordering));
+    return parseAggregateRel(std::move(plan), makeSumRel({0, 1}, 2, substrait::AggregationPhase::AGGREGATION_PHASE_INTERMEDIATE_TO_RESULT));
+}
+
+bool aggregatesInOrder(const QueryPlan & plan)
+{
+    for (auto * node = plan.getRootNode(); node; node = node->children.empty() ? nullptr : node->children.front())
+        if (dynamic_cast<const AggregatingStep *>(node->step.get()))
+            return node->step->getStepDescription() == "Aggregating in order";
+    return false;
+}
+
+/// The rows of the result, sorted, as the aggregations don't keep the same order.
+std::vector<String> collectSortedRows(QueryPlan & plan)
+{
+    auto builder = plan.buildQueryPipeline(QueryPlanOptimizationSettings(), BuildQueryPipelineSettings());
+    auto pipeline = QueryPipelineBuilder::getPipeline(std::move(*builder));
+    PullingPipelineExecutor executor(pipeline);
+    std::vector<String> rows;
+    Block block;
+    while (executor.pull(block))
+    {
+        for (size_t row = 0; row < block.rows(); ++row)
+        {
+            String line;
+            for (const auto & column : block)
+                line += toString((*column.column->convertToFullColumnIfConst())[row]) + ",";
+            rows.emplace_back(std::move(line));
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+/// Two streams sorted by (k1, k2), the groups (1, 1), (1, 2) and (2, 1) are in both.
+std::vector<Block> sortedAggregateInput()
+{
+    return {
+        makeAggregateInput({{1, 1, 1}, {1, 1, 2}, {1, 2, 3}, {2, 1, 4}, {2, 3, 5}, {4, 1, 6}}),
+        makeAggregateInput({{1, 1, 10}, {1, 2, 20}, {2, 1, 30}, {2, 1, 40}, {3, 3, 50}})};
+}
+}
+
+TEST(TestAggregate, GroupingKeysOrdering)
+{
+    auto initial = substrait::AggregationPhase::AGGREGATION_PHASE_INITIAL_TO_INTERMEDIATE;
+    auto source = [] { return makeAggregateSource(sortedAggregateInput()); };
+
+    /// The keys may be sorted in any order and direction.
+    EXPECT_TRUE(aggregatesInOrder(*parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "0:1,1:2"))));
+    EXPECT_TRUE(aggregatesInOrder(*parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "1:3,0:4"))));
+    /// Sorted by a part of the keys only, or without ordering.
+    EXPECT_FALSE(aggregatesInOrder(*parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "0:1"))));
+    EXPECT_FALSE(aggregatesInOrder(*parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial))));
+    EXPECT_THROW(parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "2:1,0:1")), DB::Exception);
+    EXPECT_THROW(parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "0:5,1:1")), DB::Exception);
+
+    SerializedPlanParser::config->setBool("streaming_aggregation.enabled", false);
+    SCOPE_EXIT({ SerializedPlanParser::config->remove("streaming_aggregation.enabled"); });
+    EXPECT_FALSE(aggregatesInOrder(*parseAggregateRel(source(), makeSumRel({0, 1}, 2, initial, "0:1,1:1"))));
+}
+
+TEST(TestAggregate, InOrderMatchesHashed)
+{
+    auto hashed_plan = parseSumByKeys(makeAggregateSource(sortedAggregateInput()));
+    auto in_order_plan = parseSumByKeys(makeAggregateSource(sortedAggregateInput()), "0:1,1:1");
+    auto expected = collectSortedRows(*hashed_plan);
+    EXPECT_EQ(expected, std::vector<String>({"1,1,13,", "1,2,23,", "2,1,74,", "2,3,5,", "3,3,50,", "4,1,6,"}));
+    EXPECT_EQ(collectSortedRows(*in_order_plan), expected);
+}
+
+TEST(TestAggregate, TypedIntermediateResults)
+{
+    SCOPE_EXIT({ SerializedPlanParser::config->remove("typed_aggregate_state.enabled"); });
+    std::vector<std::vector<String>> results;
+    for (bool typed : {true, false})
+    {
+        SerializedPlanParser::config->setBool("typed_aggregate_state.enabled", typed);
+        auto plan = parseAggregateRel(
+            makeAggregateSource(sortedAggregateInput()),
+            makeSumRel({0, 1}, 2, substrait::AggregationPhase::AGGREGATION_PHASE_INITIAL_TO_INTERMEDIATE));
+        /// The partial sums are sent as numbers or as aggregate states.
+        const auto & partial_type = plan->getCurrentDataStream().header.getByPosition(2).type;
+        EXPECT_EQ(typeid_cast<const DataTypeAggregateFunction *>(partial_type.get()) == nullptr, typed) << partial_type->getName();
+        plan = parseAggregateRel(
+            std::move(plan), makeSumRel({0, 1}, 2, substrait::AggregationPhase::AGGREGATION_PHASE_INTERMEDIATE_TO_RESULT));
+        results.emplace_back(collectSortedRows(*plan));
+    }
+    EXPECT_FALSE(results[0].empty());
+    EXPECT_EQ(results[0], results[1]);
+}
+
 int main(int argc, char ** argv)
 {
     BackendInitializerUtil::init(nullptr);
@@ -8,6 +8,7 @@
 #include <DataTypes/DataTypeDateTime.h>
 #include <DataTypes/DataTypeDateTime64.h>
 #include <DataTypes/DataTypeFactory.h>
+#include <DataTypes/DataTypeLowCardinality.h>
 #include <DataTypes/DataTypeMap.h>
 #include <DataTypes/DataTypeNullable.h>
 #include <DataTypes/DataTypeString.h>
@@ -22,10 +23,14 @@
 #include <Storages/ch_parquet/OptimizedArrowColumnToCHColumn.h>
 #include <Storages/ch_parquet/OptimizedParquetBlockInputFormat.h>
 #include <Storages/ch_parquet/arrow/reader.h>
+#include <arrow/builder.h>
+#include <arrow/io/file.h>
 #include <gtest/gtest.h>
 #include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
 #include <Common/DebugUtils.h>
 #include <Common/Config.h>
+#include <Common/filesystemHelpers.h>
 
 using namespace DB;
 
@@ -278,6 +283,101 @@ TEST(ParquetRead, ReadDataNotNull)
 #endif
 }
 
+#if USE_LOCAL_FORMATS
+/// Writes the values as the nullable string column "s", dictionary encoded by default.
+static void writeStringParquet(const String & path, const std::vector<std::optional<String>> & values, int64_t row_group_size)
+{
+    arrow::StringBuilder builder;
+    for (const auto & value : values)
+        ASSERT_TRUE((value ? builder.Append(*value) : builder.AppendNull()).ok());
+    std::shared_ptr<arrow::Array> array;
+    ASSERT_TRUE(builder.Finish(&array).ok());
+    auto table = arrow::Table::Make(arrow::schema({arrow::field("s", arrow::utf8(), true)}), {array});
+    auto file = arrow::io::FileOutputStream::Open(path).ValueOrDie();
+    ASSERT_TRUE(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), file, row_group_size).ok());
+    ASSERT_TRUE(file->Close().ok());
+}
+
+static ColumnPtr readStringParquet(const String & path, const DataTypePtr & type)
+{
+    auto in = std::make_shared<ReadBufferFromFile>(path);
+    FormatSettings settings;
+    Block header{ColumnWithTypeAndName(type, "s")};
+    auto format = std::make_shared<OptimizedParquetBlockInputFormat>(*in, header, settings);
+    auto pipeline = QueryPipeline(std::move(format));
+    PullingPipelineExecutor reader(pipeline);
+
+    auto result = type->createColumn();
+    Block block;
+    while (reader.pull(block))
+    {
+        EXPECT_TRUE(block.getByPosition(0).type->equals(*type));
+        result->insertRangeFrom(*block.getByPosition(0).column, 0, block.rows());
+    }
+    return result;
+}
+
+TEST(ParquetRead, ReadLowCardinalityStrings)
+{
+    auto string_type = makeNullable(std::make_shared<DataTypeString>());
+    auto low_cardinality_type = std::make_shared<DataTypeLowCardinality>(string_type);
+
+    /// Row groups of 4 rows, each with its own dictionary except the third one which repeats the first one, and a
+    /// null in every row group.
+    std::vector<std::optional<String>> small_dictionaries;
+    for (int group : {0, 1, 0, 2})
+        for (int i = 0; i < 4; ++i)
+            small_dictionaries.emplace_back(
+                i == 2 ? std::nullopt : std::optional<String>(fmt::format("group{}_{}", group, i % 2)));
+
+    /// The dictionary page of the distinct long values is above the size read as a dictionary, the strings are
+    /// decoded and cast instead.
+    std::vector<std::optional<String>> large_dictionary;
+    for (int i = 0; i < 400; ++i)
+        large_dictionary.emplace_back(i % 50 == 0 ? std::nullopt : std::optional<String>(fmt::format("{}{}", String(1000, static_cast<char>('a' + i % 26)), i)));
+
+    for (const auto & [values, row_group_size] :
+         {std::make_pair(small_dictionaries, int64_t{4}), std::make_pair(large_dictionary, int64_t{1000})})
+    {
+        auto tmp_file = createTemporaryFile("/tmp/");
+        writeStringParquet(tmp_file->path(), values, row_group_size);
+
+        auto low_cardinality = readStringParquet(tmp_file->path(), low_cardinality_type);
+        auto plain = readStringParquet(tmp_file->path(), string_type);
+        ASSERT_EQ(low_cardinality->size(), values.size());
+        ASSERT_EQ(plain->size(), values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            Field expected = values[i] ? Field(*values[i]) : Field();
+            EXPECT_EQ((*plain)[i], expected) << i;
+            EXPECT_EQ((*low_cardinality)[i], expected) << i;
+        }
+    }
+}
+
+TEST(ParquetRead, ReadNestedFields)
+{
+    /// Only some fields of the structs are wanted, in another order, they are read right into the tuples.
+    const String path = "./utils/extern-local-engine/tests/data/alltypes/alltypes_notnull.parquet";
+    auto & factory = DataTypeFactory::instance();
+    Block header{
+        ColumnWithTypeAndName(factory.get("Nullable(Tuple(b Nullable(Int64)))"), "f_struct"),
+        ColumnWithTypeAndName(factory.get("Nullable(Tuple(c Nullable(Tuple(y Nullable(Int64))), a Nullable(String)))"), "f_struct_struct")};
+
+    auto in = std::make_shared<ReadBufferFromFile>(path);
+    FormatSettings settings;
+    auto format = std::make_shared<OptimizedParquetBlockInputFormat>(*in, header, settings);
+    auto pipeline = QueryPipeline(std::move(format));
+    auto reader = std::make_unique<PullingPipelineExecutor>(pipeline);
+
+    Block block;
+    EXPECT_TRUE(reader->pull(block));
+    EXPECT_TRUE(block.rows() == 1);
+    EXPECT_TRUE(block.getByName("f_struct").type->equals(*header.getByName("f_struct").type));
+    EXPECT_TRUE((*block.getByName("f_struct").column)[0] == Field(Tuple{Int64(5)}));
+    EXPECT_TRUE((*block.getByName("f_struct_struct").column)[0] == Field(Tuple{Tuple{Int64(6)}, "hello"}));
+}
+#endif
 
 TEST(ParquetRead, ReadDataNull)
 {
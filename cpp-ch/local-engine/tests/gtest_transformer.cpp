@@ -1,7 +1,15 @@
+#include <map>
 #include <Core/Field.h>
 #include <DataTypes/DataTypeFactory.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <Operator/PartitionColumnFillingTransform.h>
+#include <Operator/WindowGroupLimitStep.h>
+#include <Processors/Executors/PullingPipelineExecutor.h>
+#include <Processors/Sources/SourceFromSingleChunk.h>
+#include <QueryPipeline/Pipe.h>
+#include <QueryPipeline/QueryPipeline.h>
 #include <gtest/gtest.h>
+#include <magic_enum.hpp>
 
 using namespace DB;
 
@@ -111,3 +119,91 @@ TEST(TestPartitionColumnFillingTransform, TestString)
     WhichDataType which(chunk.getColumns().at(1)->getDataType());
     ASSERT_TRUE(which.isString());
 }
+
+namespace
+{
+using local_engine::WindowGroupLimitKind;
+/// (partition, order by value) rows.
+using WindowRows = std::vector<std::pair<Int64, Int64>>;
+
+WindowRows runWindowGroupLimit(const std::vector<WindowRows> & chunks, WindowGroupLimitKind kind, size_t limit)
+{
+    auto int_type = std::make_shared<DataTypeInt64>();
+    Block header({ColumnWithTypeAndName(int_type, "p"), ColumnWithTypeAndName(int_type, "o")});
+    Pipes pipes;
+    for (const auto & rows : chunks)
+    {
+        auto columns = header.cloneEmptyColumns();
+        for (const auto & [partition, order] : rows)
+        {
+            columns[0]->insert(partition);
+            columns[1]->insert(order);
+        }
+        pipes.emplace_back(std::make_shared<SourceFromSingleChunk>(header.cloneWithColumns(std::move(columns))));
+    }
+    /// A single stream, so the rows of a partition come in several chunks.
+    auto pipe = Pipe::unitePipes(std::move(pipes));
+    pipe.resize(1);
+    SortDescription order_by{SortColumnDescription("o", 1, 1)};
+    pipe.addSimpleTransform(
+        [&](const Block & input_header)
+        { return std::make_shared<local_engine::WindowGroupLimitTransform>(input_header, Names{"p"}, order_by, kind, limit, 1000000); });
+
+    QueryPipeline pipeline(std::move(pipe));
+    PullingPipelineExecutor executor(pipeline);
+    WindowRows result;
+    Block block;
+    while (executor.pull(block))
+    {
+        for (size_t i = 0; i < block.rows(); ++i)
+            result.emplace_back(block.getByPosition(0).column->getInt(i), block.getByPosition(1).column->getInt(i));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/// The rows ranked within limit in their partition, computed from the ranks.
+WindowRows rankedWithinLimit(const std::vector<WindowRows> & chunks, WindowGroupLimitKind kind, size_t limit)
+{
+    std::map<Int64, std::vector<Int64>> partitions;
+    for (const auto & rows : chunks)
+        for (const auto & [partition, order] : rows)
+            partitions[partition].emplace_back(order);
+
+    WindowRows result;
+    for (auto & [partition, orders] : partitions)
+    {
+        std::sort(orders.begin(), orders.end());
+        size_t dense_rank = 0;
+        for (size_t i = 0; i < orders.size(); ++i)
+        {
+            if (i == 0 || orders[i] != orders[i - 1])
+                ++dense_rank;
+            size_t rank = static_cast<size_t>(std::lower_bound(orders.begin(), orders.end(), orders[i]) - orders.begin()) + 1;
+            size_t value = kind == WindowGroupLimitKind::RowNumber ? i + 1 : (kind == WindowGroupLimitKind::Rank ? rank : dense_rank);
+            if (value <= limit)
+                result.emplace_back(partition, orders[i]);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+}
+
+TEST(TestWindowGroupLimitTransform, RanksWithTies)
+{
+    /// Every partition spans the three chunks, partition 1 and 2 have ties at and around the limits.
+    const std::vector<WindowRows> chunks
+        = {{{1, 5}, {2, 1}, {1, 3}, {3, 2}},
+           {{1, 3}, {2, 1}, {1, 1}, {3, 2}, {2, 4}},
+           {{1, 2}, {2, 1}, {1, 3}, {2, 0}, {3, 9}}};
+    for (auto kind : {WindowGroupLimitKind::RowNumber, WindowGroupLimitKind::Rank, WindowGroupLimitKind::DenseRank})
+    {
+        for (size_t limit : std::initializer_list<size_t>{0, 1, 2, 3})
+        {
+            auto expected = rankedWithinLimit(chunks, kind, limit);
+            EXPECT_EQ(expected.empty(), limit == 0);
+            EXPECT_EQ(runWindowGroupLimit(chunks, kind, limit), expected) << magic_enum::enum_name(kind) << " <= " << limit;
+        }
+    }
+}
@@ -1,4 +1,8 @@
+#include <thread>
 #include <gtest/gtest.h>
+#include <Common/HashTableSizeHints.h>
+#include <Common/PODArray.h>
+#include <Common/QueryContext.h>
 #include <Common/StringUtils.h>
 
 using namespace local_engine;
@@ -13,3 +17,103 @@ TEST(TestStringUtils, TestExtractPartitionValues)
     ASSERT_EQ("col2", values[1].first);
     ASSERT_EQ("test", values[1].second);
 }
+
+namespace
+{
+/// Grants up to limit bytes, asks the task to spill the rest like spark does under memory pressure.
+class ConstrainedReservationListener : public ReservationListenerWrapper
+{
+public:
+    explicit ConstrainedReservationListener(int64_t limit_) : limit(limit_) { }
+    void reserve(int64_t size) override
+    {
+        reserved += size;
+        if (reserved > limit)
+            reserved -= currentSpillCallbackRegistry()->spill(reserved - limit);
+    }
+    void reserveOrThrow(int64_t size) override { reserve(size); }
+    void free(int64_t size) override { reserved -= size; }
+
+private:
+    int64_t limit;
+    int64_t reserved = 0;
+};
+}
+
+TEST(TestQueryContext, SpillCallbacks)
+{
+    std::thread(
+        []
+        {
+            ASSERT_EQ(nullptr, currentSpillCallbackRegistry());
+            auto allocator_id = initializeQuery(std::make_shared<ConstrainedReservationListener>(std::numeric_limits<int64_t>::max()));
+            auto registry = currentSpillCallbackRegistry();
+            ASSERT_NE(nullptr, registry);
+
+            std::vector<size_t> requested;
+            auto first = registry->add([&](size_t bytes) { requested.push_back(bytes); return 60; });
+            registry->add([&](size_t bytes) { requested.push_back(bytes); return bytes; });
+            ASSERT_EQ(100, spillAllocator(allocator_id, 100));
+            ASSERT_EQ((std::vector<size_t>{100, 40}), requested);
+
+            registry->remove(first);
+            requested.clear();
+            ASSERT_EQ(30, spillAllocator(allocator_id, 30));
+            ASSERT_EQ((std::vector<size_t>{30}), requested);
+            releaseAllocator(allocator_id);
+        })
+        .join();
+}
+
+TEST(TestQueryContext, SpillOnReservation)
+{
+    std::thread(
+        []
+        {
+            auto allocator_id = initializeQuery(std::make_shared<ConstrainedReservationListener>(16 << 20));
+            size_t spilled = 0;
+            auto registry = currentSpillCallbackRegistry();
+            auto id = registry->add([&](size_t bytes) { spilled += bytes; return bytes; });
+            {
+                DB::PODArray<char> memory;
+                memory.resize(64 << 20);
+            }
+            ASSERT_GT(spilled, 0);
+            registry->remove(id);
+            releaseAllocator(allocator_id);
+        })
+        .join();
+}
+
+TEST(TestHashTableSizeHints, EstimateRehashes)
+{
+    /// 128 rows fit in the initial 256 cells, 129 need 1024.
+    ASSERT_EQ(0, HashTableSizeHints::estimateRehashes(128, 0));
+    ASSERT_EQ(1, HashTableSizeHints::estimateRehashes(129, 0));
+    ASSERT_EQ(8, HashTableSizeHints::estimateRehashes(1 << 23, 0));
+    ASSERT_EQ(0, HashTableSizeHints::estimateRehashes(1 << 23, 1 << 23));
+    ASSERT_EQ(1, HashTableSizeHints::estimateRehashes(1 << 23, 1 << 21));
+}
+
+TEST(TestHashTableSizeHints, EvictLeastRecentlyUsed)
+{
+    auto & hints = HashTableSizeHints::instance();
+    hints.setMaxEntries(2);
+    auto before = hints.getStats();
+    hints.update(1, 100, 0);
+    hints.update(2, 200, 0);
+    ASSERT_EQ(100, hints.get(1).value_or(0));
+    hints.update(3, 300, 0);
+    ASSERT_FALSE(hints.get(2));
+    ASSERT_EQ(100, hints.get(1).value_or(0));
+    ASSERT_EQ(300, hints.get(3).value_or(0));
+    hints.update(3, 1000, 300);
+    ASSERT_EQ(1000, hints.get(3).value_or(0));
+
+    auto after = hints.getStats();
+    ASSERT_EQ(4, after.hits - before.hits);
+    ASSERT_EQ(1, after.misses - before.misses);
+    ASSERT_EQ(1, after.evictions - before.evictions);
+    ASSERT_LT(after.rehashes - before.rehashes, after.rehashes_without_hints - before.rehashes_without_hints);
+    hints.setMaxEntries(10000);
+}
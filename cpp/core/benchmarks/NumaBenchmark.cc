@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <sched.h>
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "memory/Numa.h"
+#include "memory/NumaAllocator.h"
+
+namespace gluten {
+
+namespace {
+const int32_t kNumPartitions = 64;
+const int32_t kPasses = 4;
+int64_t bufferSize = 2 << 20;
+
+void pinToNode(int32_t node) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (auto cpu : NumaTopology::instance().cpusOfNode(node)) {
+    CPU_SET(cpu, &cpus);
+  }
+  sched_setaffinity(0, sizeof(cpus), &cpus);
+}
+} // namespace
+
+// The split loop of the shuffle writer on partition buffers allocated by the task thread on the last node, but first
+// touched by a thread on node 0, e.g. a buffer zeroed by another thread. The buffers of StdMemoryAllocator end up on
+// node 0, the ones of NumaMemoryAllocator on the node of the task thread.
+static void BM_SplitToPartitionBuffers(benchmark::State& state) {
+  auto& topology = NumaTopology::instance();
+  auto localNode = topology.numNodes() - 1;
+  pinToNode(localNode);
+
+  std::shared_ptr<MemoryAllocator> allocator = std::make_shared<StdMemoryAllocator>();
+  if (state.range(0)) {
+    allocator = std::make_shared<NumaMemoryAllocator>(allocator, 0);
+  }
+
+  int64_t localPages = 0;
+  int64_t pages = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t*> buffers(kNumPartitions);
+    for (auto& buffer : buffers) {
+      allocator->allocateAligned(4096, bufferSize, reinterpret_cast<void**>(&buffer));
+    }
+    std::thread toucher([&]() {
+      pinToNode(0);
+      for (auto* buffer : buffers) {
+        memset(buffer, 0, bufferSize);
+      }
+    });
+    toucher.join();
+    for (auto* buffer : buffers) {
+      for (int64_t offset = 0; offset < bufferSize; offset += 4096) {
+        localPages += topology.nodeOfAddress(reinterpret_cast<uint8_t*>(buffer) + offset) == localNode;
+        ++pages;
+      }
+    }
+    state.ResumeTiming();
+
+    const int64_t slots = bufferSize / sizeof(uint64_t);
+    for (int32_t pass = 0; pass < kPasses; ++pass) {
+      for (int64_t row = 0; row < slots * kNumPartitions; ++row) {
+        auto partition = (row * 0x9E3779B97F4A7C15ULL >> 32) % kNumPartitions;
+        buffers[partition][(row / kNumPartitions) % slots] += row;
+      }
+    }
+    benchmark::DoNotOptimize(buffers[0][0]);
+
+    state.PauseTiming();
+    for (auto* buffer : buffers) {
+      allocator->free(buffer, bufferSize);
+    }
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(state.iterations() * kPasses * kNumPartitions * bufferSize);
+  if (!topology.simulated()) {
+    state.counters["local_pages"] = pages ? static_cast<double>(localPages) / pages : 0;
+  }
+}
+
+BENCHMARK(BM_SplitToPartitionBuffers)->ArgName("numa_aware")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace gluten
+
+int main(int argc, char** argv) {
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--simulated-nodes") == 0) {
+      // Simulated nodes run the same code on a single node machine, but the pages are all local.
+      gluten::NumaTopology::instance().simulate(atoi(argv[i + 1]));
+    } else if (strcmp(argv[i], "--buffer-size") == 0) {
+      gluten::bufferSize = atol(argv[i + 1]);
+    }
+  }
+  std::cout << "numa nodes = " << gluten::NumaTopology::instance().numNodes()
+            << (gluten::NumaTopology::instance().simulated() ? " (simulated)" : "") << std::endl;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
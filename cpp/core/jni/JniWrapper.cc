@@ -25,6 +25,7 @@
 #include "jni/ConcurrentMap.h"
 #include "jni/JniCommon.h"
 #include "jni/JniErrors.h"
+#include "memory/NumaAllocator.h"
 
 #include "operators/writer/Datasource.h"
 
@@ -291,7 +292,7 @@ jint JNI_OnLoad(JavaVM* vm, void* reserved) {
   metricsBuilderClass = createGlobalClassReferenceOrError(env, "Lio/glutenproject/metrics/Metrics;");
 
   metricsBuilderConstructor =
-      getMethodIdOrError(env, metricsBuilderClass, "<init>", "([J[J[J[J[J[J[J[J[J[JJ[J[J[J[J[J[J[J[J[J[J[J[J[J[J[J)V");
+      getMethodIdOrError(env, metricsBuilderClass, "<init>", "([J[J[J[J[J[J[J[J[J[JJ[J[J[J[J[J[J[J[J[J[J[J[J[J[J[J[J)V");
 
   serializedColumnarBatchIteratorClass =
       createGlobalClassReferenceOrError(env, "Lio/glutenproject/vectorized/ColumnarBatchInIterator;");
@@ -462,6 +463,7 @@ JNIEXPORT jobject JNICALL Java_io_glutenproject_vectorized_ColumnarBatchOutItera
   auto spilledRows = env->NewLongArray(numMetrics);
   auto spilledPartitions = env->NewLongArray(numMetrics);
   auto spilledFiles = env->NewLongArray(numMetrics);
+  auto spillLevels = env->NewLongArray(numMetrics);
   auto numDynamicFiltersProduced = env->NewLongArray(numMetrics);
   auto numDynamicFiltersAccepted = env->NewLongArray(numMetrics);
   auto numReplacedWithDynamicFilterRows = env->NewLongArray(numMetrics);
@@ -489,6 +491,7 @@ JNIEXPORT jobject JNICALL Java_io_glutenproject_vectorized_ColumnarBatchOutItera
     env->SetLongArrayRegion(spilledRows, 0, numMetrics, metrics->spilledRows);
     env->SetLongArrayRegion(spilledPartitions, 0, numMetrics, metrics->spilledPartitions);
     env->SetLongArrayRegion(spilledFiles, 0, numMetrics, metrics->spilledFiles);
+    env->SetLongArrayRegion(spillLevels, 0, numMetrics, metrics->spillLevels);
     env->SetLongArrayRegion(numDynamicFiltersProduced, 0, numMetrics, metrics->numDynamicFiltersProduced);
     env->SetLongArrayRegion(numDynamicFiltersAccepted, 0, numMetrics, metrics->numDynamicFiltersAccepted);
     env->SetLongArrayRegion(numReplacedWithDynamicFilterRows, 0, numMetrics, metrics->numReplacedWithDynamicFilterRows);
@@ -520,6 +523,7 @@ JNIEXPORT jobject JNICALL Java_io_glutenproject_vectorized_ColumnarBatchOutItera
       spilledRows,
       spilledPartitions,
       spilledFiles,
+      spillLevels,
       numDynamicFiltersProduced,
       numDynamicFiltersAccepted,
       numReplacedWithDynamicFilterRows,
@@ -778,7 +782,8 @@ JNIEXPORT jlong JNICALL Java_io_glutenproject_vectorized_ShuffleWriterJniWrapper
     jlong taskAttemptId,
     jint pushBufferMaxSize,
     jobject partitionPusher,
-    jstring partitionWriterTypeJstr) {
+    jstring partitionWriterTypeJstr,
+    jstring blockIndexFileJstr) {
   JNI_METHOD_START
   if (partitioningNameJstr == nullptr) {
     throw gluten::GlutenException(std::string("Short partitioning name can't be null"));
@@ -804,6 +809,7 @@ JNIEXPORT jlong JNICALL Java_io_glutenproject_vectorized_ShuffleWriterJniWrapper
     throw gluten::GlutenException("Allocator does not exist or has been closed");
   }
   shuffleWriterOptions.memory_pool = asArrowMemoryPool((*allocator).get());
+  shuffleWriterOptions.numa_aware = (*allocator)->numaAware();
   shuffleWriterOptions.ipc_memory_pool = shuffleWriterOptions.memory_pool;
 
   jclass cls = env->FindClass("java/lang/Thread");
@@ -846,6 +852,10 @@ JNIEXPORT jlong JNICALL Java_io_glutenproject_vectorized_ShuffleWriterJniWrapper
     shuffleWriterOptions.data_file = std::string(dataFileC);
     env->ReleaseStringUTFChars(dataFileJstr, dataFileC);
 
+    if (blockIndexFileJstr != NULL) {
+      shuffleWriterOptions.block_index_file = jStringToCString(env, blockIndexFileJstr);
+    }
+
     auto localDirs = env->GetStringUTFChars(localDirsJstr, JNI_FALSE);
     setenv("NATIVESQL_SPARK_LOCAL_DIRS", localDirs, 1);
     env->ReleaseStringUTFChars(localDirsJstr, localDirs);
@@ -1114,6 +1124,8 @@ JNIEXPORT jlong JNICALL Java_io_glutenproject_memory_alloc_NativeMemoryAllocator
   std::shared_ptr<MemoryAllocator>* allocator = new std::shared_ptr<MemoryAllocator>;
   if (typeName == "DEFAULT") {
     *allocator = defaultMemoryAllocator();
+  } else if (typeName == "NUMA_AWARE") {
+    *allocator = std::make_shared<NumaMemoryAllocator>(defaultMemoryAllocator());
   } else {
     throw GlutenException("Unexpected allocator type name: " + typeName);
   }
@@ -44,6 +44,11 @@ class MemoryAllocator {
   virtual bool unreserveBytes(int64_t size) = 0;
 
   virtual int64_t getBytes() const = 0;
+
+  // Whether the large allocations are placed on the NUMA node of the allocating thread.
+  virtual bool numaAware() const {
+    return false;
+  }
 };
 
 class AllocationListener {
@@ -81,6 +86,10 @@ class ListenableMemoryAllocator final : public MemoryAllocator {
 
   int64_t getBytes() const override;
 
+  bool numaAware() const override {
+    return delegated_->numaAware();
+  }
+
  private:
   MemoryAllocator* delegated_;
   std::shared_ptr<AllocationListener> listener_;
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Numa.h"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+
+namespace gluten {
+
+namespace {
+constexpr const char* kNodePath = "/sys/devices/system/node/";
+
+// Parses a cpu list like "0-3,8-11".
+std::vector<int32_t> parseCpuList(const std::string& list) {
+  std::vector<int32_t> cpus;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    auto end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    auto range = list.substr(pos, end - pos);
+    auto dash = range.find('-');
+    if (!range.empty() && range[0] != '\n') {
+      int32_t first = std::stoi(range.substr(0, dash));
+      int32_t last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    pos = end + 1;
+  }
+  return cpus;
+}
+} // namespace
+
+NumaTopology& NumaTopology::instance() {
+  static NumaTopology topology;
+  return topology;
+}
+
+NumaTopology::NumaTopology() {
+  cpuToNode_.assign(sysconf(_SC_NPROCESSORS_CONF), 0);
+  auto* dir = opendir(kNodePath);
+  if (dir == nullptr) {
+    return;
+  }
+  int32_t maxNode = 0;
+  while (auto* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(name[4])) {
+      continue;
+    }
+    auto node = std::stoi(name.substr(4));
+    std::ifstream cpuList(std::string(kNodePath) + name + "/cpulist");
+    std::string list;
+    std::getline(cpuList, list);
+    for (auto cpu : parseCpuList(list)) {
+      if (cpu < cpuToNode_.size()) {
+        cpuToNode_[cpu] = node;
+      }
+    }
+    maxNode = std::max(maxNode, node);
+  }
+  closedir(dir);
+  numNodes_ = maxNode + 1;
+}
+
+int32_t NumaTopology::currentNode() const {
+  if (numNodes_ == 1) {
+    return 0;
+  }
+  return nodeOfCpu(sched_getcpu());
+}
+
+int32_t NumaTopology::nodeOfCpu(int32_t cpu) const {
+  return cpu >= 0 && cpu < cpuToNode_.size() ? cpuToNode_[cpu] : 0;
+}
+
+std::vector<int32_t> NumaTopology::cpusOfNode(int32_t node) const {
+  std::vector<int32_t> cpus;
+  for (int32_t cpu = 0; cpu < cpuToNode_.size(); ++cpu) {
+    if (cpuToNode_[cpu] == node) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+bool NumaTopology::bindToNode(void* addr, int64_t size, int32_t node) const {
+  if (simulated_ || numNodes_ == 1 || node >= sizeof(unsigned long) * 8) {
+    return false;
+  }
+  // Preferred rather than bound, so the allocation falls back to the other nodes instead of failing when the node
+  // is out of memory.
+  unsigned long nodeMask = 1UL << node;
+  return syscall(SYS_mbind, addr, size, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0) == 0;
+}
+
+int32_t NumaTopology::nodeOfAddress(void* addr) const {
+  if (simulated_ || numNodes_ == 1) {
+    return 0;
+  }
+  void* pages[] = {addr};
+  int status[] = {-1};
+  if (syscall(SYS_move_pages, 0, 1, pages, nullptr, status, 0) != 0 || status[0] < 0) {
+    return -1;
+  }
+  return status[0];
+}
+
+void NumaTopology::simulate(int32_t numNodes) {
+  simulated_ = true;
+  numNodes_ = numNodes;
+  for (int32_t cpu = 0; cpu < cpuToNode_.size(); ++cpu) {
+    cpuToNode_[cpu] = cpu % numNodes;
+  }
+}
+
+} // namespace gluten
@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace gluten {
+
+// The NUMA nodes of the machine and the cpus of every node, read from /sys/devices/system/node. The memory policies
+// are set with the mbind syscall, so libnuma is not needed.
+class NumaTopology {
+ public:
+  static NumaTopology& instance();
+
+  int32_t numNodes() const {
+    return numNodes_;
+  }
+
+  // The node of the cpu the calling thread runs on, 0 if unknown.
+  int32_t currentNode() const;
+
+  int32_t nodeOfCpu(int32_t cpu) const;
+
+  std::vector<int32_t> cpusOfNode(int32_t node) const;
+
+  // Makes the pages of [addr, addr + size) be allocated on node when they are touched first, whichever thread
+  // touches them. addr must be page aligned. Does nothing and returns false with simulated nodes.
+  bool bindToNode(void* addr, int64_t size, int32_t node) const;
+
+  // The node the page of addr is allocated on, -1 if it's not allocated yet.
+  int32_t nodeOfAddress(void* addr) const;
+
+  // Splits the cpus into numNodes nodes round robin, to test and benchmark the NUMA aware code on a machine with
+  // a single node. The memory policies are not set on simulated nodes. Not thread safe, call it before anything
+  // else uses the topology.
+  void simulate(int32_t numNodes);
+
+  bool simulated() const {
+    return simulated_;
+  }
+
+ private:
+  NumaTopology();
+
+  int32_t numNodes_{1};
+  bool simulated_{false};
+  std::vector<int32_t> cpuToNode_;
+};
+
+} // namespace gluten
@@ -0,0 +1,222 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NumaAllocator.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "Numa.h"
+#include "utils/exception.h"
+#include "utils/macros.h"
+
+namespace gluten {
+
+namespace {
+int64_t pageSize() {
+  static const int64_t kPageSize = sysconf(_SC_PAGESIZE);
+  return kPageSize;
+}
+} // namespace
+
+NumaMemoryAllocator::NumaMemoryAllocator(std::shared_ptr<MemoryAllocator> delegated, int64_t maxCachedBytesPerNode)
+    : delegated_(std::move(delegated)), maxCachedBytesPerNode_(maxCachedBytesPerNode) {
+  auto numNodes = NumaTopology::instance().numNodes();
+  cached_.resize(numNodes);
+  cachedBytes_.assign(numNodes, 0);
+}
+
+NumaMemoryAllocator::~NumaMemoryAllocator() {
+  for (auto& chunks : cached_) {
+    for (auto& [size, chunk] : chunks) {
+      munmap(chunk.addr, chunk.mappedSize);
+    }
+  }
+}
+
+void* NumaMemoryAllocator::allocateLarge(int64_t size, uint64_t alignment, bool zeroFilled) {
+  auto& topology = NumaTopology::instance();
+  auto node = std::min(topology.currentNode(), static_cast<int32_t>(cached_.size()) - 1);
+  int64_t mappedSize = ROUND_TO_LINE(size, pageSize());
+
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto range = cached_[node].equal_range(mappedSize);
+    for (auto it = range.first; it != range.second; ++it) {
+      auto chunk = it->second;
+      if (reinterpret_cast<uintptr_t>(chunk.addr) % alignment != 0) {
+        continue;
+      }
+      cached_[node].erase(it);
+      cachedBytes_[node] -= mappedSize;
+      chunks_[chunk.addr] = {node, chunk};
+      if (zeroFilled) {
+        memset(chunk.addr, 0, size);
+      }
+      return chunk.addr;
+    }
+  }
+
+  // mmap only aligns to pages, map more for a larger alignment and unmap the rest.
+  int64_t padding = alignment > pageSize() ? alignment : 0;
+  auto* mapped = static_cast<uint8_t*>(
+      mmap(nullptr, mappedSize + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (mapped == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* addr = mapped;
+  if (padding > 0) {
+    addr = reinterpret_cast<uint8_t*>(ROUND_TO_LINE(reinterpret_cast<uintptr_t>(mapped), alignment));
+    if (addr > mapped) {
+      munmap(mapped, addr - mapped);
+    }
+    if (mapped + padding > addr) {
+      munmap(addr + mappedSize, mapped + padding - addr);
+    }
+  }
+  // No page is touched yet, they will all be allocated on the node of this thread.
+  topology.bindToNode(addr, mappedSize, node);
+
+  std::lock_guard<std::mutex> l(mutex_);
+  chunks_[addr] = {node, {addr, mappedSize}};
+  return addr;
+}
+
+void NumaMemoryAllocator::freeLarge(void* p) {
+  Chunk chunk;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto it = chunks_.find(p);
+    GLUTEN_CHECK(it != chunks_.end(), "Freeing a chunk not allocated by NumaMemoryAllocator");
+    auto node = it->second.first;
+    chunk = it->second.second;
+    chunks_.erase(it);
+    // Back to the cache of its home node, whichever thread frees it.
+    if (cachedBytes_[node] + chunk.mappedSize <= maxCachedBytesPerNode_) {
+      cached_[node].emplace(chunk.mappedSize, chunk);
+      cachedBytes_[node] += chunk.mappedSize;
+      return;
+    }
+  }
+  munmap(chunk.addr, chunk.mappedSize);
+}
+
+bool NumaMemoryAllocator::allocate(int64_t size, void** out) {
+  if (!isLarge(size)) {
+    *out = nullptr;
+    delegated_->allocate(size, out);
+  } else {
+    *out = allocateLarge(size, pageSize(), false);
+  }
+  if (*out == nullptr) {
+    return false;
+  }
+  bytes_ += size;
+  return true;
+}
+
+bool NumaMemoryAllocator::allocateZeroFilled(int64_t nmemb, int64_t size, void** out) {
+  if (!isLarge(nmemb * size)) {
+    *out = nullptr;
+    delegated_->allocateZeroFilled(nmemb, size, out);
+  } else {
+    *out = allocateLarge(nmemb * size, pageSize(), true);
+  }
+  if (*out == nullptr) {
+    return false;
+  }
+  bytes_ += nmemb * size;
+  return true;
+}
+
+bool NumaMemoryAllocator::allocateAligned(uint64_t alignment, int64_t size, void** out) {
+  if (!isLarge(size)) {
+    *out = nullptr;
+    delegated_->allocateAligned(alignment, size, out);
+  } else {
+    *out = allocateLarge(size, std::max<uint64_t>(alignment, pageSize()), false);
+  }
+  if (*out == nullptr) {
+    return false;
+  }
+  bytes_ += size;
+  return true;
+}
+
+bool NumaMemoryAllocator::reallocate(void* p, int64_t size, int64_t newSize, void** out) {
+  if (!isLarge(size) && !isLarge(newSize)) {
+    if (!delegated_->reallocate(p, size, newSize, out)) {
+      return false;
+    }
+    bytes_ += newSize - size;
+    return true;
+  }
+  if (!allocate(newSize, out)) {
+    return false;
+  }
+  memcpy(*out, p, std::min(size, newSize));
+  return free(p, size);
+}
+
+bool NumaMemoryAllocator::reallocateAligned(void* p, uint64_t alignment, int64_t size, int64_t newSize, void** out) {
+  if (!isLarge(size) && !isLarge(newSize)) {
+    if (!delegated_->reallocateAligned(p, alignment, size, newSize, out)) {
+      return false;
+    }
+    bytes_ += newSize - size;
+    return true;
+  }
+  if (!allocateAligned(alignment, newSize, out)) {
+    return false;
+  }
+  memcpy(*out, p, std::min(size, newSize));
+  return free(p, size);
+}
+
+bool NumaMemoryAllocator::free(void* p, int64_t size) {
+  if (!isLarge(size)) {
+    if (!delegated_->free(p, size)) {
+      return false;
+    }
+  } else {
+    freeLarge(p);
+  }
+  bytes_ -= size;
+  return true;
+}
+
+bool NumaMemoryAllocator::reserveBytes(int64_t size) {
+  bytes_ += size;
+  return true;
+}
+
+bool NumaMemoryAllocator::unreserveBytes(int64_t size) {
+  bytes_ -= size;
+  return true;
+}
+
+int64_t NumaMemoryAllocator::getBytes() const {
+  return bytes_;
+}
+
+int64_t NumaMemoryAllocator::cachedBytes(int32_t node) const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return cachedBytes_[node];
+}
+
+} // namespace gluten
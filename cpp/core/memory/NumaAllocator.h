@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+namespace gluten {
+
+// Places the large allocations, e.g. the chunks of LargeMemoryPool and the buffers of ShuffleBufferPool, on the NUMA
+// node of the allocating thread: they are mmap'ed and bound to the node before any page is touched, so they stay
+// local to the task thread even when another thread zeroes or fills them first. The freed chunks are cached on
+// their home node and only reused by the threads on the same node. The small allocations go to the delegated
+// allocator, whose thread caches are local already. getBytes() counts both.
+class NumaMemoryAllocator final : public MemoryAllocator {
+ public:
+  static constexpr int64_t kMinNumaAllocationSize = 1 << 20;
+  static constexpr int64_t kDefaultMaxCachedBytesPerNode = 64 << 20;
+
+  explicit NumaMemoryAllocator(
+      std::shared_ptr<MemoryAllocator> delegated,
+      int64_t maxCachedBytesPerNode = kDefaultMaxCachedBytesPerNode);
+
+  ~NumaMemoryAllocator() override;
+
+  bool allocate(int64_t size, void** out) override;
+
+  bool allocateZeroFilled(int64_t nmemb, int64_t size, void** out) override;
+
+  bool allocateAligned(uint64_t alignment, int64_t size, void** out) override;
+
+  bool reallocate(void* p, int64_t size, int64_t newSize, void** out) override;
+
+  bool reallocateAligned(void* p, uint64_t alignment, int64_t size, int64_t newSize, void** out) override;
+
+  bool free(void* p, int64_t size) override;
+
+  bool reserveBytes(int64_t size) override;
+
+  bool unreserveBytes(int64_t size) override;
+
+  int64_t getBytes() const override;
+
+  bool numaAware() const override {
+    return true;
+  }
+
+  // The bytes of the freed chunks kept for reuse on node.
+  int64_t cachedBytes(int32_t node) const;
+
+ private:
+  struct Chunk {
+    void* addr;
+    int64_t mappedSize;
+  };
+
+  bool isLarge(int64_t size) const {
+    return size >= kMinNumaAllocationSize;
+  }
+
+  // Returns a chunk of at least size bytes aligned to alignment, local to the calling thread.
+  void* allocateLarge(int64_t size, uint64_t alignment, bool zeroFilled);
+
+  void freeLarge(void* p);
+
+  std::shared_ptr<MemoryAllocator> delegated_;
+  int64_t maxCachedBytesPerNode_;
+  std::atomic_int64_t bytes_{0};
+
+  mutable std::mutex mutex_;
+  // The live chunks, to find the node and the mapping of a freed pointer.
+  std::unordered_map<void*, std::pair<int32_t, Chunk>> chunks_;
+  // The freed chunks of every node, by mapped size.
+  std::vector<std::multimap<int64_t, Chunk>> cached_;
+  std::vector<int64_t> cachedBytes_;
+};
+
+} // namespace gluten
@@ -37,6 +37,9 @@ arrow::Status LocalPartitionWriterBase::setLocalDirs() {
     std::string dataFileTemp;
     ARROW_ASSIGN_OR_RAISE(shuffleWriter_->options().data_file, createTempShuffleFile(configuredDirs_[0]));
   }
+  if (!shuffleWriter_->options().block_index_file.empty()) {
+    blockIndex_ = std::make_shared<ShuffleBlockIndex>(shuffleWriter_->numPartitions());
+  }
   return arrow::Status::OK();
 }
 
@@ -53,6 +56,46 @@ arrow::Status LocalPartitionWriterBase::openDataFile() {
   return arrow::Status::OK();
 }
 
+arrow::Status LocalPartitionWriterBase::writeCachedPayloads(
+    arrow::io::OutputStream* os,
+    int32_t partitionId,
+    std::vector<ShuffleBlock>* blocks) {
+#ifndef SKIPWRITE
+  auto& payloads = shuffleWriter_->partitionCachedRecordbatch()[partitionId];
+  const auto& numRows = shuffleWriter_->partitionCachedRecordbatchNumRows()[partitionId];
+  int32_t metadataLength = 0; // unused
+  for (auto i = 0; i < payloads.size(); ++i) {
+    int64_t start = 0;
+    if (blocks != nullptr) {
+      ARROW_ASSIGN_OR_RAISE(start, os->Tell());
+    }
+    RETURN_NOT_OK(
+        arrow::ipc::WriteIpcPayload(*payloads[i], shuffleWriter_->options().ipc_write_options, os, &metadataLength));
+    // Dismiss payload immediately
+    payloads[i] = nullptr;
+    if (blocks != nullptr) {
+      ARROW_ASSIGN_OR_RAISE(auto end, os->Tell());
+      blocks->push_back({start, end - start, numRows[i]});
+    }
+  }
+#endif
+  shuffleWriter_->clearPartitionCachedRecordbatch(partitionId);
+  return arrow::Status::OK();
+}
+
+void LocalPartitionWriterBase::addBlocks(int32_t partitionId, const std::vector<ShuffleBlock>& blocks, int64_t delta) {
+  for (const auto& block : blocks) {
+    blockIndex_->addBlock(partitionId, {block.offset + delta, block.length, block.numRows});
+  }
+}
+
+arrow::Status LocalPartitionWriterBase::writeBlockIndex() {
+  if (blockIndex_ == nullptr) {
+    return arrow::Status::OK();
+  }
+  return blockIndex_->write(shuffleWriter_->options().block_index_file);
+}
+
 arrow::Status LocalPartitionWriterBase::clearResource() {
   RETURN_NOT_OK(dataFileOs_->Close());
   schemaPayload_.reset();
@@ -73,8 +116,8 @@ class PreferEvictPartitionWriter::LocalPartitionWriterInstance {
 #ifndef SKIPWRITE
     RETURN_NOT_OK(ensureOpened());
 #endif
-    RETURN_NOT_OK(writeRecordBatchPayload(spilledFileOs_.get()));
-    clearCache();
+    RETURN_NOT_OK(
+        partitionWriter_->writeCachedPayloads(spilledFileOs_.get(), partitionId_, blocksOrNull(spilledBlocks_)));
     return arrow::Status::OK();
   }
 
@@ -88,16 +131,23 @@ class PreferEvictPartitionWriter::LocalPartitionWriterInstance {
 
     if (spilledFileOpened_) {
       RETURN_NOT_OK(spilledFileOs_->Close());
+      ARROW_ASSIGN_OR_RAISE(auto mergeStart, dataFileOs->Tell());
       RETURN_NOT_OK(mergeSpilled());
+      if (partitionWriter_->blockIndex_ != nullptr) {
+        partitionWriter_->addBlocks(partitionId_, spilledBlocks_, mergeStart);
+      }
     } else {
       if (shuffleWriter_->partitionCachedRecordbatchSize()[partitionId_] == 0) {
         return arrow::Status::Invalid("Partition writer got empty partition");
       }
     }
 
-    RETURN_NOT_OK(writeRecordBatchPayload(dataFileOs.get()));
+    std::vector<ShuffleBlock> blocks;
+    RETURN_NOT_OK(partitionWriter_->writeCachedPayloads(dataFileOs.get(), partitionId_, blocksOrNull(blocks)));
+    if (partitionWriter_->blockIndex_ != nullptr) {
+      partitionWriter_->addBlocks(partitionId_, blocks, 0);
+    }
     RETURN_NOT_OK(writeEos(dataFileOs.get()));
-    clearCache();
 
     ARROW_ASSIGN_OR_RAISE(auto after_write, dataFileOs->Tell());
     partition_length = after_write - before_write;
@@ -144,16 +194,8 @@ class PreferEvictPartitionWriter::LocalPartitionWriterInstance {
     return arrow::Status::OK();
   }
 
-  arrow::Status writeRecordBatchPayload(arrow::io::OutputStream* os) {
-    int32_t metadataLength = 0; // unused
-#ifndef SKIPWRITE
-    for (auto& payload : shuffleWriter_->partitionCachedRecordbatch()[partitionId_]) {
-      RETURN_NOT_OK(
-          arrow::ipc::WriteIpcPayload(*payload, shuffleWriter_->options().ipc_write_options, os, &metadataLength));
-      payload = nullptr;
-    }
-#endif
-    return arrow::Status::OK();
+  std::vector<ShuffleBlock>* blocksOrNull(std::vector<ShuffleBlock>& blocks) {
+    return partitionWriter_->blocksOrNull(blocks);
   }
 
   arrow::Status writeEos(arrow::io::OutputStream* os) {
@@ -165,16 +207,13 @@ class PreferEvictPartitionWriter::LocalPartitionWriterInstance {
     return arrow::Status::OK();
   }
 
-  void clearCache() {
-    shuffleWriter_->partitionCachedRecordbatch()[partitionId_].clear();
-    shuffleWriter_->setPartitionCachedRecordbatchSize(partitionId_, 0);
-  }
-
   PreferEvictPartitionWriter* partitionWriter_;
   ShuffleWriter* shuffleWriter_;
   uint32_t partitionId_;
   std::string spilledFile_;
   std::shared_ptr<arrow::io::FileOutputStream> spilledFileOs_;
+  // At their positions in the spilled file, only with the block index.
+  std::vector<ShuffleBlock> spilledBlocks_;
 
   bool spilledFileOpened_ = false;
 };
@@ -231,6 +270,7 @@ arrow::Status PreferEvictPartitionWriter::stop() {
       shuffleWriter_->setPartitionLengths(pid, 0);
     }
   }
+  RETURN_NOT_OK(writeBlockIndex());
   RETURN_NOT_OK(clearResource());
   return arrow::Status::OK();
 }
@@ -268,16 +308,14 @@ arrow::Status PreferCachePartitionWriter::evictPartition(int32_t partitionId /*
     auto cachedPayloadSize = shuffleWriter_->partitionCachedRecordbatchSize()[pid];
     if (cachedPayloadSize > 0) {
       ARROW_ASSIGN_OR_RAISE(auto start, spilledFileOs->Tell());
-      RETURN_NOT_OK(flushCachedPayloads(spilledFileOs.get(), shuffleWriter_->partitionCachedRecordbatch()[pid]));
+      std::vector<ShuffleBlock> blocks;
+      RETURN_NOT_OK(writeCachedPayloads(spilledFileOs.get(), pid, blocksOrNull(blocks)));
       ARROW_ASSIGN_OR_RAISE(auto end, spilledFileOs->Tell());
-      spillInfo.partitionSpillInfos.push_back({pid, start, end - start});
+      spillInfo.partitionSpillInfos.push_back({pid, start, end - start, std::move(blocks)});
 #ifdef GLUTEN_PRINT_DEBUG
       std::cout << "Spilled partition " << pid << " file start: " << start << ", file end: " << end
                 << ", cachedPayloadSize: " << cachedPayloadSize << std::endl;
 #endif
-      // clearCache();
-      shuffleWriter_->partitionCachedRecordbatch()[pid].clear();
-      shuffleWriter_->setPartitionCachedRecordbatchSize(pid, 0);
     }
   }
   RETURN_NOT_OK(spilledFileOs->Close());
@@ -321,7 +359,7 @@ arrow::Status PreferCachePartitionWriter::stop() {
     ARROW_ASSIGN_OR_RAISE(auto startInFinalFile, dataFileOs_->Tell());
     // 4. Iterator over all spilled files
     for (auto i = 0; i < spills_.size(); ++i) {
-      auto partitionSpillInfo = spills_[i].partitionSpillInfos[spillInfoOffsets[i]];
+      const auto& partitionSpillInfo = spills_[i].partitionSpillInfos[spillInfoOffsets[i]];
       // 5. read if partition exists in the spilled file and write to the final file
       if (partitionSpillInfo.partitionId == pid) { // A hit
         if (firstWrite) {
@@ -332,6 +370,10 @@ arrow::Status PreferCachePartitionWriter::stop() {
           firstWrite = false;
         }
         ARROW_ASSIGN_OR_RAISE(auto raw, spilledFiles[i]->ReadAt(partitionSpillInfo.start, partitionSpillInfo.length));
+        if (blockIndex_ != nullptr) {
+          ARROW_ASSIGN_OR_RAISE(auto copyStart, dataFileOs_->Tell());
+          addBlocks(pid, partitionSpillInfo.blocks, copyStart - partitionSpillInfo.start);
+        }
         RETURN_NOT_OK(dataFileOs_->Write(raw));
         // Goto next partition in this spillInfo
         spillInfoOffsets[i]++;
@@ -347,10 +389,11 @@ arrow::Status PreferCachePartitionWriter::stop() {
         }
         firstWrite = false;
       }
-      RETURN_NOT_OK(flushCachedPayloads(dataFileOs_.get(), shuffleWriter_->partitionCachedRecordbatch()[pid]));
-      // clearCache();
-      shuffleWriter_->partitionCachedRecordbatch()[pid].clear();
-      shuffleWriter_->setPartitionCachedRecordbatchSize(pid, 0);
+      std::vector<ShuffleBlock> blocks;
+      RETURN_NOT_OK(writeCachedPayloads(dataFileOs_.get(), pid, blocksOrNull(blocks)));
+      if (blockIndex_ != nullptr) {
+        addBlocks(pid, blocks, 0);
+      }
     }
     // 7. Write the last payload.
     ARROW_ASSIGN_OR_RAISE(auto rb, shuffleWriter_->createArrowRecordBatchFromBuffer(pid, true));
@@ -370,7 +413,12 @@ arrow::Status PreferCachePartitionWriter::stop() {
       shuffleWriter_->setRawPartitionLength(
           pid, shuffleWriter_->rawPartitionLengths()[pid] + lastPayload->raw_body_length);
       int32_t metadataLength = 0; // unused
+      ARROW_ASSIGN_OR_RAISE(auto lastPayloadStart, dataFileOs_->Tell());
       RETURN_NOT_OK(flushCachedPayload(dataFileOs_.get(), lastPayload, &metadataLength));
+      if (blockIndex_ != nullptr) {
+        ARROW_ASSIGN_OR_RAISE(auto lastPayloadEnd, dataFileOs_->Tell());
+        blockIndex_->addBlock(pid, {lastPayloadStart, lastPayloadEnd - lastPayloadStart, rb->num_rows()});
+      }
     }
     // 8. Write EOS if any payload written.
     if (!firstWrite) {
@@ -400,7 +448,8 @@ arrow::Status PreferCachePartitionWriter::stop() {
   shuffleWriter_->setTotalBytesEvicted(totalBytesEvicted);
   shuffleWriter_->setTotalBytesWritten(totalBytesWritten);
 
-  // 10. Close Final file, Clear buffered resources.
+  // 10. Write the block index, close Final file, Clear buffered resources.
+  RETURN_NOT_OK(writeBlockIndex());
   RETURN_NOT_OK(clearResource());
 
   return arrow::Status::OK();
@@ -23,6 +23,7 @@
 #include "shuffle/ShuffleWriter.h"
 
 #include "PartitionWriterCreator.h"
+#include "ShuffleBlockIndex.h"
 #include "utils.h"
 #include "utils/macros.h"
 
@@ -40,6 +41,19 @@ class LocalPartitionWriterBase : public ShuffleWriter::PartitionWriter {
 
   arrow::Status openDataFile();
 
+  // Writes and clears the cached payloads of a partition. With the block index, appends their blocks to blocks, at
+  // their positions in os.
+  arrow::Status writeCachedPayloads(arrow::io::OutputStream* os, int32_t partitionId, std::vector<ShuffleBlock>* blocks);
+
+  std::vector<ShuffleBlock>* blocksOrNull(std::vector<ShuffleBlock>& blocks) {
+    return blockIndex_ != nullptr ? &blocks : nullptr;
+  }
+
+  // Adds the blocks, moved by delta bytes, to the block index.
+  void addBlocks(int32_t partitionId, const std::vector<ShuffleBlock>& blocks, int64_t delta);
+
+  arrow::Status writeBlockIndex();
+
   virtual arrow::Status clearResource();
 
   // configured local dirs for spilled file
@@ -50,6 +64,9 @@ class LocalPartitionWriterBase : public ShuffleWriter::PartitionWriter {
   // shared among all partitions
   std::shared_ptr<arrow::ipc::IpcPayload> schemaPayload_;
   std::shared_ptr<arrow::io::OutputStream> dataFileOs_;
+
+  // Null if the options have no block_index_file.
+  std::shared_ptr<ShuffleBlockIndex> blockIndex_;
 };
 
 class PreferEvictPartitionWriter : public LocalPartitionWriterBase {
@@ -105,16 +122,6 @@ class PreferCachePartitionWriter : public LocalPartitionWriterBase {
     return arrow::Status::OK();
   }
 
-  arrow::Status flushCachedPayloads(
-      arrow::io::OutputStream* os,
-      std::vector<std::shared_ptr<arrow::ipc::IpcPayload>>& payloads) {
-    int32_t metadataLength = 0; // unused
-    for (auto& payload : payloads) {
-      RETURN_NOT_OK(flushCachedPayload(os, payload, &metadataLength));
-    }
-    return arrow::Status::OK();
-  }
-
   arrow::Status writeEos(arrow::io::OutputStream* os) {
     // write EOS
     constexpr int32_t kIpcContinuationToken = -1;
@@ -128,6 +135,8 @@ class PreferCachePartitionWriter : public LocalPartitionWriterBase {
     int32_t partitionId;
     int64_t start;
     int64_t length; // in Bytes
+    // At their positions in the spilled file, only with the block index.
+    std::vector<ShuffleBlock> blocks;
   };
 
   struct SpillInfo {
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shuffle/ShuffleBlockIndex.h"
+
+#include <arrow/io/file.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace gluten {
+
+arrow::Status ShuffleBlockIndex::write(const std::string& path) const {
+  std::stringstream ss;
+  for (int32_t pid = 0; pid < blocks_.size(); ++pid) {
+    for (const auto& block : blocks_[pid]) {
+      ss << pid << ' ' << block.offset << ' ' << block.length << ' ' << block.numRows << '\n';
+    }
+  }
+  ARROW_ASSIGN_OR_RAISE(auto os, arrow::io::FileOutputStream::Open(path));
+  auto content = ss.str();
+  RETURN_NOT_OK(os->Write(content.data(), content.size()));
+  return os->Close();
+}
+
+arrow::Result<std::shared_ptr<ShuffleBlockIndex>> ShuffleBlockIndex::read(
+    const std::string& path,
+    int32_t numPartitions) {
+  std::ifstream in(path);
+  if (!in) {
+    return arrow::Status::IOError("Failed to open the shuffle block index ", path);
+  }
+  auto index = std::make_shared<ShuffleBlockIndex>(numPartitions);
+  int32_t pid;
+  ShuffleBlock block;
+  while (in >> pid >> block.offset >> block.length >> block.numRows) {
+    if (pid < 0 || pid >= numPartitions) {
+      return arrow::Status::Invalid("Invalid partition id ", pid, " in the shuffle block index ", path);
+    }
+    index->addBlock(pid, block);
+  }
+  return index;
+}
+
+arrow::Result<std::shared_ptr<arrow::io::InputStream>> ShuffleBlockIndex::openBlocks(
+    const std::shared_ptr<arrow::io::RandomAccessFile>& dataFile,
+    int32_t partitionId,
+    int32_t beginBlock,
+    int32_t endBlock) const {
+  const auto& blocks = blocks_[partitionId];
+  if (beginBlock < 0 || beginBlock >= endBlock || endBlock > blocks.size()) {
+    return arrow::Status::Invalid(
+        "Invalid block range [", beginBlock, ", ", endBlock, ") of partition ", partitionId, " with ", blocks.size(),
+        " blocks");
+  }
+  // The blocks of a partition are contiguous.
+  auto offset = blocks[beginBlock].offset;
+  auto length = blocks[endBlock - 1].offset + blocks[endBlock - 1].length - offset;
+  return arrow::io::RandomAccessFile::GetStream(dataFile, offset, length);
+}
+
+} // namespace gluten
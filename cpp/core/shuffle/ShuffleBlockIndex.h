@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/result.h>
+
+#include <string>
+#include <vector>
+
+namespace gluten {
+
+// A block of a partition in the shuffle data file, i.e. an IPC record batch message.
+struct ShuffleBlock {
+  // The position in the data file.
+  int64_t offset;
+  int64_t length;
+  int64_t numRows;
+};
+
+// The secondary index of a shuffle data file, the blocks of every partition. The shuffle index only has the length
+// of a partition, with the blocks a large partition of a map task can be split between several reducers, each
+// reading a sub-range of its blocks.
+// It's a text file of a line per block, ordered by partition id and offset: "<partition id> <offset> <length> <rows>".
+class ShuffleBlockIndex {
+ public:
+  explicit ShuffleBlockIndex(int32_t numPartitions) : blocks_(numPartitions) {}
+
+  void addBlock(int32_t partitionId, ShuffleBlock block) {
+    blocks_[partitionId].push_back(block);
+  }
+
+  const std::vector<ShuffleBlock>& blocks(int32_t partitionId) const {
+    return blocks_[partitionId];
+  }
+
+  arrow::Status write(const std::string& path) const;
+
+  static arrow::Result<std::shared_ptr<ShuffleBlockIndex>> read(const std::string& path, int32_t numPartitions);
+
+  // The stream of the blocks [beginBlock, endBlock) of a partition, to read with a Reader given the schema of the
+  // shuffle: the stream starts with the first block instead of the schema message.
+  arrow::Result<std::shared_ptr<arrow::io::InputStream>> openBlocks(
+      const std::shared_ptr<arrow::io::RandomAccessFile>& dataFile,
+      int32_t partitionId,
+      int32_t beginBlock,
+      int32_t endBlock) const;
+
+ private:
+  std::vector<std::vector<ShuffleBlock>> blocks_;
+};
+
+} // namespace gluten
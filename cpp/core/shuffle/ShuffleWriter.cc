@@ -40,10 +40,15 @@ arrow::Status ShuffleBufferPool::allocate(std::shared_ptr<arrow::Buffer>& buffer
   if (size > SPLIT_BUFFER_SIZE) {
     ARROW_ASSIGN_OR_RAISE(buffer, arrow::AllocateResizableBuffer(size, pool_.get()));
     return arrow::Status::OK();
-  } else if (combineBuffer_->capacity() - combineBuffer_->size() < size) {
+  }
+  // With a NUMA aware pool, also start a new buffer when the thread moved to another NUMA node, so the partition
+  // buffers are local to the thread splitting into them.
+  auto node = numaAware_ ? NumaTopology::instance().currentNode() : combineBufferNode_;
+  if (combineBuffer_->capacity() - combineBuffer_->size() < size || node != combineBufferNode_) {
     // memory pool is not enough
     ARROW_ASSIGN_OR_RAISE(combineBuffer_, arrow::AllocateResizableBuffer(SPLIT_BUFFER_SIZE, pool_.get()));
     RETURN_NOT_OK(combineBuffer_->Resize(0, /*shrink_to_fit = */ false));
+    combineBufferNode_ = node;
   }
   buffer = arrow::SliceMutableBuffer(combineBuffer_, combineBuffer_->size(), size);
   RETURN_NOT_OK(combineBuffer_->Resize(combineBuffer_->size() + size, /*shrink_to_fit = */ false));
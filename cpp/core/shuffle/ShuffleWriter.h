@@ -23,6 +23,7 @@
 
 #include "memory/ArrowMemoryPool.h"
 #include "memory/ColumnarBatch.h"
+#include "memory/Numa.h"
 
 namespace gluten {
 
@@ -46,12 +47,16 @@ struct ShuffleWriterOptions {
   bool buffered_write = false;
 
   std::string data_file;
+  // If not empty, the local partition writers write the ShuffleBlockIndex of data_file to it.
+  std::string block_index_file;
   std::string partition_writer_type = "local";
 
   int64_t thread_id = -1;
   int64_t task_attempt_id = -1;
 
   std::shared_ptr<arrow::MemoryPool> memory_pool = defaultArrowMemoryPool();
+  // memory_pool places the large buffers on the NUMA node of the allocating thread.
+  bool numa_aware = false;
 
   // For tests.
   std::shared_ptr<arrow::MemoryPool> ipc_memory_pool;
@@ -65,12 +70,14 @@ struct ShuffleWriterOptions {
 
 class ShuffleBufferPool {
  public:
-  explicit ShuffleBufferPool(std::shared_ptr<arrow::MemoryPool> pool) : pool_(pool) {}
+  explicit ShuffleBufferPool(std::shared_ptr<arrow::MemoryPool> pool, bool numaAware = false)
+      : pool_(pool), numaAware_(numaAware) {}
 
   arrow::Status init() {
     // Allocate first buffer for split reducer
     ARROW_ASSIGN_OR_RAISE(combineBuffer_, arrow::AllocateResizableBuffer(0, pool_.get()));
     RETURN_NOT_OK(combineBuffer_->Resize(0, /*shrink_to_fit =*/false));
+    combineBufferNode_ = numaAware_ ? NumaTopology::instance().currentNode() : 0;
     return arrow::Status::OK();
   }
 
@@ -86,9 +93,12 @@ class ShuffleBufferPool {
 
  private:
   std::shared_ptr<arrow::MemoryPool> pool_;
+  bool numaAware_;
   // slice the buffer for each reducer's column, in this way we can combine into
   // large page
   std::shared_ptr<arrow::ResizableBuffer> combineBuffer_;
+  // The NUMA node of the thread allocated combineBuffer_. With a NUMA aware memory pool, it's where its pages are.
+  int32_t combineBufferNode_{0};
 };
 
 class ShuffleWriter {
@@ -169,6 +179,17 @@ class ShuffleWriter {
     return partitionCachedRecordbatch_;
   }
 
+  // The row counts of the cached payloads.
+  const std::vector<std::vector<int64_t>>& partitionCachedRecordbatchNumRows() const {
+    return partitionCachedRecordbatchNumRows_;
+  }
+
+  void clearPartitionCachedRecordbatch(int32_t partitionId) {
+    partitionCachedRecordbatch_[partitionId].clear();
+    partitionCachedRecordbatchNumRows_[partitionId].clear();
+    partitionCachedRecordbatchSize_[partitionId] = 0;
+  }
+
   std::vector<std::vector<std::vector<std::shared_ptr<arrow::Buffer>>>>& partitionBuffer() {
     return partitionBuffers_;
   }
@@ -223,7 +244,7 @@ class ShuffleWriter {
       : numPartitions_(numPartitions),
         partitionWriterCreator_(std::move(partitionWriterCreator)),
         options_(std::move(options)),
-        pool_(std::make_shared<ShuffleBufferPool>(options_.memory_pool)) {}
+        pool_(std::make_shared<ShuffleBufferPool>(options_.memory_pool, options_.numa_aware)) {}
   virtual ~ShuffleWriter() = default;
 
   int32_t numPartitions_;
@@ -247,6 +268,7 @@ class ShuffleWriter {
 
   std::vector<int64_t> partitionCachedRecordbatchSize_; // in bytes
   std::vector<std::vector<std::shared_ptr<arrow::ipc::IpcPayload>>> partitionCachedRecordbatch_;
+  std::vector<std::vector<int64_t>> partitionCachedRecordbatchNumRows_;
 
   // col partid
   std::vector<std::vector<std::vector<std::shared_ptr<arrow::Buffer>>>> partitionBuffers_;
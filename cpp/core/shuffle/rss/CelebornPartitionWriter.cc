@@ -37,8 +37,7 @@ arrow::Status CelebornPartitionWriter::pushPartition(int32_t partitionId) {
   int32_t size = buffer->get()->size();
   char* dst = reinterpret_cast<char*>(buffer->get()->mutable_data());
   celebornClient_->pushPartitonData(partitionId, dst, size);
-  shuffleWriter_->partitionCachedRecordbatch()[partitionId].clear();
-  shuffleWriter_->setPartitionCachedRecordbatchSize(partitionId, 0);
+  shuffleWriter_->clearPartitionCachedRecordbatch(partitionId);
   shuffleWriter_->setPartitionLengths(partitionId, shuffleWriter_->partitionLengths()[partitionId] + size);
   return arrow::Status::OK();
 };
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include "memory/Numa.h"
+#include "memory/NumaAllocator.h"
+
+namespace gluten {
+
+class NumaAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The node of the test thread must not change between the allocations.
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(sched_getcpu(), &cpus);
+    ASSERT_EQ(sched_setaffinity(0, sizeof(cpus), &cpus), 0);
+  }
+
+  std::shared_ptr<NumaMemoryAllocator> allocator_ =
+      std::make_shared<NumaMemoryAllocator>(std::make_shared<StdMemoryAllocator>(), 16 << 20);
+};
+
+TEST_F(NumaAllocatorTest, allocate) {
+  const int64_t largeSize = 8 << 20;
+  void* small = nullptr;
+  void* large = nullptr;
+  ASSERT_TRUE(allocator_->allocate(100, &small));
+  ASSERT_TRUE(allocator_->allocateAligned(2 << 20, largeSize, &large));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(large) % (2 << 20), 0);
+  memset(large, 1, largeSize);
+  ASSERT_EQ(allocator_->getBytes(), largeSize + 100);
+
+  auto& topology = NumaTopology::instance();
+  ASSERT_EQ(topology.nodeOfAddress(large), topology.currentNode());
+
+  ASSERT_TRUE(allocator_->reallocate(small, 100, 200, &small));
+  ASSERT_TRUE(allocator_->free(small, 200));
+  ASSERT_TRUE(allocator_->free(large, largeSize));
+  ASSERT_EQ(allocator_->getBytes(), 0);
+}
+
+TEST_F(NumaAllocatorTest, reuseCachedChunks) {
+  const int64_t largeSize = 8 << 20;
+  auto node = NumaTopology::instance().currentNode();
+  void* first = nullptr;
+  ASSERT_TRUE(allocator_->allocate(largeSize, &first));
+  memset(first, 1, largeSize);
+  ASSERT_TRUE(allocator_->free(first, largeSize));
+  ASSERT_EQ(allocator_->cachedBytes(node), largeSize);
+
+  // Zero filled even when reused.
+  void* second = nullptr;
+  ASSERT_TRUE(allocator_->allocateZeroFilled(1, largeSize, &second));
+  ASSERT_EQ(second, first);
+  ASSERT_EQ(allocator_->cachedBytes(node), 0);
+  for (int64_t i = 0; i < largeSize; i += 4096) {
+    ASSERT_EQ(static_cast<uint8_t*>(second)[i], 0);
+  }
+
+  // Beyond the limit of the cache, the chunks are unmapped.
+  void* third = nullptr;
+  void* fourth = nullptr;
+  ASSERT_TRUE(allocator_->allocate(12 << 20, &third));
+  ASSERT_TRUE(allocator_->free(second, largeSize));
+  ASSERT_TRUE(allocator_->free(third, 12 << 20));
+  ASSERT_EQ(allocator_->cachedBytes(node), largeSize);
+
+  // Growing a chunk moves it to a new one.
+  ASSERT_TRUE(allocator_->allocate(2 << 20, &fourth));
+  memset(fourth, 2, 2 << 20);
+  ASSERT_TRUE(allocator_->reallocate(fourth, 2 << 20, 4 << 20, &fourth));
+  ASSERT_EQ(static_cast<uint8_t*>(fourth)[(2 << 20) - 1], 2);
+  ASSERT_TRUE(allocator_->free(fourth, 4 << 20));
+  ASSERT_EQ(allocator_->getBytes(), 0);
+}
+
+} // namespace gluten
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include "memory/Numa.h"
+#include "shuffle/ShuffleWriter.h"
+
+namespace gluten {
+
+class ShuffleBufferPoolTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    // Runs in its own binary, the simulated nodes would break the checks of the real ones in NumaAllocatorTest.
+    if (NumaTopology::instance().numNodes() == 1) {
+      NumaTopology::instance().simulate(2);
+    }
+  }
+
+  void SetUp() override {
+    if (NumaTopology::instance().cpusOfNode(1).empty()) {
+      GTEST_SKIP() << "Needs a cpu on node 1";
+    }
+  }
+
+  static void pinToNode(int32_t node) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto cpu : NumaTopology::instance().cpusOfNode(node)) {
+      CPU_SET(cpu, &cpus);
+    }
+    ASSERT_EQ(sched_setaffinity(0, sizeof(cpus), &cpus), 0);
+  }
+
+  // Allocates a buffer on node 0, then one on node 1. True if the second one follows the first one in the same
+  // combine buffer.
+  static bool allocatesContiguously(ShuffleBufferPool& pool) {
+    std::shared_ptr<arrow::Buffer> first;
+    std::shared_ptr<arrow::Buffer> second;
+    pinToNode(0);
+    EXPECT_TRUE(pool.init().ok());
+    EXPECT_TRUE(pool.allocate(first, 1024).ok());
+    pinToNode(1);
+    EXPECT_TRUE(pool.allocate(second, 1024).ok());
+    return second->data() == first->data() + 1024;
+  }
+};
+
+TEST_F(ShuffleBufferPoolTest, reuseCombineBufferByDefault) {
+  ShuffleBufferPool pool(defaultArrowMemoryPool());
+  ASSERT_TRUE(allocatesContiguously(pool));
+}
+
+TEST_F(ShuffleBufferPoolTest, newCombineBufferOnNodeChangeWhenNumaAware) {
+  ShuffleBufferPool pool(defaultArrowMemoryPool(), /*numaAware=*/true);
+  ASSERT_FALSE(allocatesContiguously(pool));
+}
+
+} // namespace gluten
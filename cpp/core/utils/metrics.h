@@ -44,6 +44,8 @@ struct Metrics {
   long* spilledRows;
   long* spilledPartitions;
   long* spilledFiles;
+  // The number of spill levels reached, 0 when nothing is spilled.
+  long* spillLevels;
 
   // Runtime metrics.
   long* numDynamicFiltersProduced;
@@ -73,6 +75,7 @@ struct Metrics {
     spilledRows = new long[numMetrics]();
     spilledFiles = new long[numMetrics]();
     spilledPartitions = new long[numMetrics]();
+    spillLevels = new long[numMetrics]();
     numDynamicFiltersProduced = new long[numMetrics]();
     numDynamicFiltersAccepted = new long[numMetrics]();
     numReplacedWithDynamicFilterRows = new long[numMetrics]();
@@ -106,6 +109,7 @@ struct Metrics {
     delete[] spilledRows;
     delete[] spilledFiles;
     delete[] spilledPartitions;
+    delete[] spillLevels;
     delete[] numDynamicFiltersProduced;
     delete[] numDynamicFiltersAccepted;
     delete[] numReplacedWithDynamicFilterRows;
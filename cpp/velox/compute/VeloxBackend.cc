@@ -85,11 +85,19 @@ std::shared_ptr<ResultIterator> VeloxBackend::getResultIterator(
   if (scanInfos.size() == 0) {
     // Source node is not required.
     auto wholestageIter = std::make_unique<WholeStageResultIteratorMiddleStage>(
-        ctxPool, veloxPlan_, streamIds, spillDir, sessionConf, taskInfo_);
+        ctxPool, veloxPlan_, streamIds, spillDir, sessionConf, taskInfo_, veloxPlanConverter->joinBuildSizes());
     return std::make_shared<ResultIterator>(std::move(wholestageIter), shared_from_this());
   } else {
     auto wholestageIter = std::make_unique<WholeStageResultIteratorFirstStage>(
-        ctxPool, veloxPlan_, scanIds, scanInfos, streamIds, spillDir, sessionConf, taskInfo_);
+        ctxPool,
+        veloxPlan_,
+        scanIds,
+        scanInfos,
+        streamIds,
+        spillDir,
+        sessionConf,
+        taskInfo_,
+        veloxPlanConverter->joinBuildSizes());
     return std::make_shared<ResultIterator>(std::move(wholestageIter), shared_from_this());
   }
 }
@@ -19,6 +19,7 @@
 #include "VeloxInitializer.h"
 
 #include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 
 #include "config/GlutenConfig.h"
 #include "operators/functions/RegistrationAllFunctions.h"
@@ -74,6 +75,13 @@ const std::string kVeloxIOThreadsDefault = "0";
 const std::string kVeloxSplitPreloadPerDriver = "spark.gluten.sql.columnar.backend.velox.SplitPreloadPerDriver";
 const std::string kVeloxSplitPreloadPerDriverDefault = "2";
 
+// The threads fetching the input batches of ValueStream ahead of the drivers, 0 to fetch them on the drivers.
+const std::string kVeloxValueStreamPrefetchThreads = "spark.gluten.sql.columnar.backend.velox.valueStreamPrefetchThreads";
+const std::string kVeloxValueStreamPrefetchThreadsDefault = "0";
+// The max bytes of the batches fetched ahead by every ValueStream.
+const std::string kVeloxValueStreamPrefetchBytes = "spark.gluten.sql.columnar.backend.velox.valueStreamPrefetchBytes";
+const std::string kVeloxValueStreamPrefetchBytesDefault = "67108864";
+
 // spill, mem ratios and thresholds
 const std::string kSpillStrategy = "spark.gluten.sql.columnar.backend.velox.spillStrategy";
 const std::string kMemoryCapRatio = "spark.gluten.sql.columnar.backend.velox.memoryCapRatio";
@@ -207,6 +215,7 @@ void VeloxInitializer::init(const std::unordered_map<std::string, std::string>&
 
   initCache(conf);
   initIOExecutor(conf);
+  initValueStreamPrefetch(conf);
   initHWAccelerators(conf);
 
 #ifdef GLUTEN_PRINT_DEBUG
@@ -314,6 +323,25 @@ void VeloxInitializer::initIOExecutor(const std::unordered_map<std::string, std:
   }
 }
 
+void VeloxInitializer::initValueStreamPrefetch(const std::unordered_map<std::string, std::string>& conf) {
+  int32_t prefetchThreads = std::stoi(kVeloxValueStreamPrefetchThreadsDefault);
+  auto got = conf.find(kVeloxValueStreamPrefetchThreads);
+  if (got != conf.end()) {
+    prefetchThreads = std::stoi(got->second);
+  }
+  valueStreamPrefetchBytes_ = std::stol(kVeloxValueStreamPrefetchBytesDefault);
+  got = conf.find(kVeloxValueStreamPrefetchBytes);
+  if (got != conf.end()) {
+    valueStreamPrefetchBytes_ = std::stol(got->second);
+  }
+  if (prefetchThreads > 0) {
+    valueStreamPrefetchExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+        prefetchThreads, std::make_shared<folly::NamedThreadFactory>("ValueStreamPrefetch"));
+    LOG(INFO) << "STARTUP: Prefetching ValueStream input, threads: " << prefetchThreads
+              << ", max bytes per stream: " << valueStreamPrefetchBytes_;
+  }
+}
+
 void VeloxInitializer::initHWAccelerators(const std::unordered_map<std::string, std::string>& conf) {
   auto got = conf.find(kShuffleCompressionCodecBackend);
   if (got != conf.end() && !got->second.empty()) {
@@ -21,6 +21,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <filesystem>
 
@@ -58,6 +59,15 @@ class VeloxInitializer {
     return spillThreshold_;
   }
 
+  // The executor fetching the input batches of ValueStream ahead, nullptr if prefetching is disabled.
+  folly::Executor* getValueStreamPrefetchExecutor() const {
+    return valueStreamPrefetchExecutor_.get();
+  }
+
+  int64_t getValueStreamPrefetchBytes() const {
+    return valueStreamPrefetchBytes_;
+  }
+
  private:
   explicit VeloxInitializer(const std::unordered_map<std::string, std::string>& conf) {
     init(conf);
@@ -66,6 +76,7 @@ class VeloxInitializer {
   void init(const std::unordered_map<std::string, std::string>& conf);
   void initCache(const std::unordered_map<std::string, std::string>& conf);
   void initIOExecutor(const std::unordered_map<std::string, std::string>& conf);
+  void initValueStreamPrefetch(const std::unordered_map<std::string, std::string>& conf);
   void initHWAccelerators(const std::unordered_map<std::string, std::string>& conf);
 
   void printConf(const std::unordered_map<std::string, std::string>& conf);
@@ -87,6 +98,9 @@ class VeloxInitializer {
 
   std::unique_ptr<folly::IOThreadPoolExecutor> ssdCacheExecutor_;
   std::unique_ptr<folly::IOThreadPoolExecutor> ioExecutor_;
+  // Its threads stay attached to the jvm once they called into it, they live as long as the executor.
+  std::unique_ptr<folly::CPUThreadPoolExecutor> valueStreamPrefetchExecutor_;
+  int64_t valueStreamPrefetchBytes_ = 0;
 
   std::string cachePathPrefix_;
   std::string cacheFilePrefix_;
@@ -16,7 +16,10 @@
  */
 
 #include "VeloxPlanConverter.h"
+#include <google/protobuf/wrappers.pb.h>
+#include <charconv>
 #include <filesystem>
+#include <sstream>
 
 #include "arrow/c/bridge.h"
 #include "compute/ResultIterator.h"
@@ -28,6 +31,43 @@ using namespace facebook;
 
 namespace gluten {
 
+namespace {
+// Get the value of a key from the JoinParameters of a join, which are "key=value" lines.
+std::optional<std::string> getJoinParameter(const ::substrait::JoinRel& sjoin, const std::string& key) {
+  if (!sjoin.has_advanced_extension() || !sjoin.advanced_extension().has_optimization()) {
+    return std::nullopt;
+  }
+  google::protobuf::StringValue params;
+  if (!sjoin.advanced_extension().optimization().UnpackTo(&params)) {
+    return std::nullopt;
+  }
+  std::istringstream lines(params.value());
+  std::string line;
+  while (std::getline(lines, line)) {
+    auto pos = line.find(key + "=");
+    if (pos != std::string::npos && (pos == 0 || line[pos - 1] == ':')) {
+      return line.substr(pos + key.size() + 1);
+    }
+  }
+  return std::nullopt;
+}
+
+// The build side size in bytes from the "buildSizeKB" join parameter, -1 if it's unknown or malformed.
+int64_t getJoinBuildSize(const ::substrait::JoinRel& sjoin) {
+  auto buildSizeKB = getJoinParameter(sjoin, "buildSizeKB");
+  if (!buildSizeKB) {
+    return -1;
+  }
+  int64_t kb;
+  const char* end = buildSizeKB->data() + buildSizeKB->size();
+  auto [ptr, ec] = std::from_chars(buildSizeKB->data(), end, kb);
+  if (ec != std::errc() || ptr != end || kb < 0) {
+    return -1;
+  }
+  return kb * 1024;
+}
+} // namespace
+
 void VeloxPlanConverter::setInputPlanNode(const ::substrait::FetchRel& fetchRel) {
   if (fetchRel.has_input()) {
     setInputPlanNode(fetchRel.input());
@@ -85,6 +125,11 @@ void VeloxPlanConverter::setInputPlanNode(const ::substrait::FilterRel& sfilter)
 }
 
 void VeloxPlanConverter::setInputPlanNode(const ::substrait::JoinRel& sjoin) {
+  // Broadcast build sides are not spilled.
+  if (getJoinParameter(sjoin, "isBHJ") != "1") {
+    joinBuildSizes_.emplace_back(getJoinBuildSize(sjoin));
+  }
+
   if (sjoin.has_left()) {
     setInputPlanNode(sjoin.left());
   } else {
@@ -36,6 +36,11 @@ class VeloxPlanConverter {
     return subVeloxPlanConverter_->splitInfos();
   }
 
+  /// The estimated build side size in bytes of each shuffled hash join, -1 if unknown.
+  const std::vector<int64_t>& joinBuildSizes() const {
+    return joinBuildSizes_;
+  }
+
  private:
   void setInputPlanNode(const ::substrait::FetchRel& fetchRel);
 
@@ -63,6 +68,7 @@ class VeloxPlanConverter {
 
   int planNodeId_ = 0;
   std::vector<std::shared_ptr<ResultIterator>> inputIters_;
+  std::vector<int64_t> joinBuildSizes_;
 
   std::shared_ptr<facebook::velox::substrait::SubstraitParser> subParser_ =
       std::make_shared<facebook::velox::substrait::SubstraitParser>();
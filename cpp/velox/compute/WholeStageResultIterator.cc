@@ -37,6 +37,7 @@ const std::string kSpillStartPartitionBit = "spark.gluten.sql.columnar.backend.v
 const std::string kSpillPartitionBits = "spark.gluten.sql.columnar.backend.velox.spillPartitionBits";
 const std::string kSpillableReservationGrowthPct =
     "spark.gluten.sql.columnar.backend.velox.spillableReservationGrowthPct";
+const std::string kJoinSpillMinBuildSize = "spark.gluten.sql.columnar.backend.velox.joinSpillMinBuildSize";
 
 // metrics
 const std::string kDynamicFiltersProduced = "dynamicFiltersProduced";
@@ -52,13 +53,32 @@ const std::string kProcessedStrides = "processedStrides";
 // others
 const std::string kHiveDefaultPartition = "__HIVE_DEFAULT_PARTITION__";
 
+// The max spill partition bits supported by Velox.
+const int32_t kMaxSpillPartitionBits = 3;
+
+// Velox doesn't report the spill level. Estimate the lowest level producing the spilled partitions, every
+// level splits a spilled partition into 2^partitionBits ones.
+int64_t estimateSpillLevel(int64_t spilledPartitions, int32_t partitionBits) {
+  const int64_t fanout = 1L << std::max(partitionBits, 1);
+  int64_t level = 0;
+  int64_t levelPartitions = 1;
+  int64_t totalPartitions = 0;
+  while (totalPartitions < spilledPartitions) {
+    levelPartitions *= fanout;
+    totalPartitions += levelPartitions;
+    level++;
+  }
+  return level;
+}
+
 } // namespace
 
 WholeStageResultIterator::WholeStageResultIterator(
     std::shared_ptr<facebook::velox::memory::MemoryPool> pool,
     const std::shared_ptr<const facebook::velox::core::PlanNode>& planNode,
-    const std::unordered_map<std::string, std::string>& confMap)
-    : veloxPlan_(planNode), confMap_(confMap), pool_(pool) {
+    const std::unordered_map<std::string, std::string>& confMap,
+    const std::vector<int64_t>& joinBuildSizes)
+    : veloxPlan_(planNode), confMap_(confMap), pool_(pool), joinBuildSizes_(joinBuildSizes) {
 #ifdef ENABLE_HDFS
   updateHdfsTokens();
 #endif
@@ -184,6 +204,7 @@ void WholeStageResultIterator::collectMetrics() {
       metrics_->spilledRows[metricsIdx] = entry.second->spilledRows;
       metrics_->spilledPartitions[metricsIdx] = entry.second->spilledPartitions;
       metrics_->spilledFiles[metricsIdx] = entry.second->spilledFiles;
+      metrics_->spillLevels[metricsIdx] = estimateSpillLevel(entry.second->spilledPartitions, spillPartitionBits_);
       metrics_->numDynamicFiltersProduced[metricsIdx] =
           runtimeMetric("sum", entry.second->customStats, kDynamicFiltersProduced);
       metrics_->numDynamicFiltersAccepted[metricsIdx] =
@@ -277,6 +298,8 @@ std::unordered_map<std::string, std::string> WholeStageResultIterator::getQueryC
     configs[velox::core::QueryConfig::kSpillPartitionBits] = getConfigValue(kSpillPartitionBits, "2");
     configs[velox::core::QueryConfig::kSpillableReservationGrowthPct] =
         getConfigValue(kSpillableReservationGrowthPct, "25");
+    setJoinSpillConf(configs, maxMemory);
+    spillPartitionBits_ = std::stoi(configs[velox::core::QueryConfig::kSpillPartitionBits]);
   } catch (const std::invalid_argument& err) {
     std::string errDetails = err.what();
     throw std::runtime_error("Invalid conf arg: " + errDetails);
@@ -284,6 +307,47 @@ std::unordered_map<std::string, std::string> WholeStageResultIterator::getQueryC
   return configs;
 }
 
+void WholeStageResultIterator::setJoinSpillConf(
+    std::unordered_map<std::string, std::string>& configs,
+    int64_t maxMemory) {
+  if (joinBuildSizes_.empty()) {
+    return;
+  }
+  int64_t maxBuildSize = 0;
+  for (auto buildSize : joinBuildSizes_) {
+    if (buildSize < 0) {
+      // No estimate, keep the default settings.
+      return;
+    }
+    maxBuildSize = std::max(maxBuildSize, buildSize);
+  }
+
+  // The build sides fit in memory, skip the spill setup of the joins.
+  auto minBuildSize = std::stol(getConfigValue(kJoinSpillMinBuildSize, std::to_string(32 << 20)));
+  if (maxBuildSize < std::min(minBuildSize, maxMemory / 2)) {
+    if (confMap_.find(kJoinSpillEnabled) == confMap_.end()) {
+      configs[velox::core::QueryConfig::kJoinSpillEnabled] = "false";
+    }
+    return;
+  }
+
+  // Split the build side into partitions which fit in half of the memory, so a spilled partition can be
+  // restored without spilling again. The probe side is partitioned the same way.
+  auto partitionSize = std::max<int64_t>(maxMemory / 2, 1);
+  if (confMap_.find(kSpillPartitionBits) == confMap_.end()) {
+    int32_t partitionBits = 1;
+    while (partitionBits < kMaxSpillPartitionBits && (maxBuildSize >> partitionBits) > partitionSize) {
+      partitionBits++;
+    }
+    configs[velox::core::QueryConfig::kSpillPartitionBits] = std::to_string(partitionBits);
+  }
+  // The build side is known not to fit, let the joins spill once they use their share of memory instead of
+  // waiting for the memory to run out.
+  if (maxBuildSize > maxMemory && confMap_.find(kJoinSpillMemoryThreshold) == confMap_.end()) {
+    configs[velox::core::QueryConfig::kJoinSpillMemoryThreshold] = std::to_string(partitionSize);
+  }
+}
+
 #ifdef ENABLE_HDFS
 void WholeStageResultIterator::updateHdfsTokens() {
   const auto& username = confMap_[kUGIUserName];
@@ -314,8 +378,9 @@ WholeStageResultIteratorFirstStage::WholeStageResultIteratorFirstStage(
     const std::vector<velox::core::PlanNodeId>& streamIds,
     const std::string spillDir,
     const std::unordered_map<std::string, std::string>& confMap,
-    const SparkTaskInfo taskInfo)
-    : WholeStageResultIterator(pool, planNode, confMap),
+    const SparkTaskInfo taskInfo,
+    const std::vector<int64_t>& joinBuildSizes)
+    : WholeStageResultIterator(pool, planNode, confMap, joinBuildSizes),
       scanNodeIds_(scanNodeIds),
       scanInfos_(scanInfos),
       streamIds_(streamIds) {
@@ -430,8 +495,9 @@ WholeStageResultIteratorMiddleStage::WholeStageResultIteratorMiddleStage(
     const std::vector<velox::core::PlanNodeId>& streamIds,
     const std::string spillDir,
     const std::unordered_map<std::string, std::string>& confMap,
-    const SparkTaskInfo taskInfo)
-    : WholeStageResultIterator(pool, planNode, confMap), streamIds_(streamIds) {
+    const SparkTaskInfo taskInfo,
+    const std::vector<int64_t>& joinBuildSizes)
+    : WholeStageResultIterator(pool, planNode, confMap, joinBuildSizes), streamIds_(streamIds) {
   std::unordered_set<velox::core::PlanNodeId> emptySet;
   velox::core::PlanFragment planFragment{planNode, velox::core::ExecutionStrategy::kUngrouped, 1, emptySet};
   std::shared_ptr<velox::core::QueryCtx> queryCtx = createNewVeloxQueryCtx();
@@ -16,7 +16,8 @@ class WholeStageResultIterator : public ColumnarBatchIterator {
   WholeStageResultIterator(
       std::shared_ptr<facebook::velox::memory::MemoryPool> pool,
       const std::shared_ptr<const facebook::velox::core::PlanNode>& planNode,
-      const std::unordered_map<std::string, std::string>& confMap);
+      const std::unordered_map<std::string, std::string>& confMap,
+      const std::vector<int64_t>& joinBuildSizes = {});
 
   virtual ~WholeStageResultIterator() {
     if (task_ != nullptr && task_->isRunning()) {
@@ -53,6 +54,9 @@ class WholeStageResultIterator : public ColumnarBatchIterator {
   /// Get the Spark confs to Velox query context.
   std::unordered_map<std::string, std::string> getQueryContextConf();
 
+  /// Set the join spill configs from the estimated build side sizes, unless they are set by the Spark confs.
+  void setJoinSpillConf(std::unordered_map<std::string, std::string>& configs, int64_t maxMemory);
+
 #ifdef ENABLE_HDFS
   /// Set latest tokens to global HiveConnector
   void updateHdfsTokens();
@@ -79,6 +83,10 @@ class WholeStageResultIterator : public ColumnarBatchIterator {
 
   // spill
   std::string spillStrategy_;
+  int32_t spillPartitionBits_ = 2;
+
+  /// The estimated build side size in bytes of each shuffled hash join, -1 if unknown.
+  std::vector<int64_t> joinBuildSizes_;
 
   std::shared_ptr<Metrics> metrics_ = nullptr;
 
@@ -99,7 +107,8 @@ class WholeStageResultIteratorFirstStage final : public WholeStageResultIterator
       const std::vector<facebook::velox::core::PlanNodeId>& streamIds,
       const std::string spillDir,
       const std::unordered_map<std::string, std::string>& confMap,
-      const SparkTaskInfo taskInfo);
+      const SparkTaskInfo taskInfo,
+      const std::vector<int64_t>& joinBuildSizes = {});
 
  private:
   std::vector<facebook::velox::core::PlanNodeId> scanNodeIds_;
@@ -122,7 +131,8 @@ class WholeStageResultIteratorMiddleStage final : public WholeStageResultIterato
       const std::vector<facebook::velox::core::PlanNodeId>& streamIds,
       const std::string spillDir,
       const std::unordered_map<std::string, std::string>& confMap,
-      const SparkTaskInfo taskInfo);
+      const SparkTaskInfo taskInfo,
+      const std::vector<int64_t>& joinBuildSizes = {});
 
  private:
   bool noMoreSplits_ = false;
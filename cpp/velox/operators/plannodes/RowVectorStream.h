@@ -17,8 +17,15 @@
 
 #pragma once
 
+#include <folly/Executor.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include "compute/ResultIterator.h"
+#include "compute/VeloxInitializer.h"
 #include "memory/VeloxColumnarBatch.h"
+#include "velox/common/future/VeloxPromise.h"
 #include "velox/exec/Driver.h"
 #include "velox/exec/Operator.h"
 
@@ -45,6 +52,124 @@ class RowVectorStream {
   const facebook::velox::RowTypePtr outputType_;
 };
 
+// Pulls the batches of a RowVectorStream on an executor ahead of the consumer, so the driver doesn't sit in
+// the upstream (usually a jni call into a java iterator) and runs other drivers meanwhile. At most one fetch is
+// in flight. Fetching pauses once the queued batches reach maxQueuedBytes or a quarter of the memory left in
+// the root pool, whichever is less, but at least one batch is queued.
+class RowVectorStreamPrefetcher : public std::enable_shared_from_this<RowVectorStreamPrefetcher> {
+ public:
+  RowVectorStreamPrefetcher(
+      std::shared_ptr<RowVectorStream> stream,
+      folly::Executor* executor,
+      facebook::velox::memory::MemoryPool* pool,
+      int64_t maxQueuedBytes)
+      : stream_(std::move(stream)), executor_(executor), pool_(pool), maxQueuedBytes_(maxQueuedBytes) {}
+
+  // Returns the next queued batch, nullptr if none. Rethrows the error of the upstream.
+  facebook::velox::RowVectorPtr next() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      scheduleFetchLocked();
+      return nullptr;
+    }
+    auto [batch, bytes] = std::move(queue_.front());
+    queue_.pop_front();
+    queuedBytes_ -= bytes;
+    scheduleFetchLocked();
+    return batch;
+  }
+
+  facebook::velox::exec::BlockingReason isBlocked(facebook::velox::ContinueFuture* future) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!queue_.empty() || atEnd_) {
+      return facebook::velox::exec::BlockingReason::kNotBlocked;
+    }
+    scheduleFetchLocked();
+    auto [promise, blockingFuture] = facebook::velox::makeVeloxContinuePromiseContract("ValueStream::isBlocked");
+    consumerPromise_ = std::move(promise);
+    *future = std::move(blockingFuture);
+    return facebook::velox::exec::BlockingReason::kWaitForProducer;
+  }
+
+  bool isFinished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty() && atEnd_ && !error_;
+  }
+
+  // Stops fetching and waits for the fetch in flight, the stream must not be used by the executor afterwards.
+  void close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    fetchDone_.wait(lock, [this] { return !fetching_; });
+    queue_.clear();
+    queuedBytes_ = 0;
+  }
+
+ private:
+  void scheduleFetchLocked() {
+    if (fetching_ || atEnd_ || closed_ || (!queue_.empty() && queuedBytes_ >= queueCapacity())) {
+      return;
+    }
+    fetching_ = true;
+    executor_->add([self = shared_from_this()] { self->fetch(); });
+  }
+
+  int64_t queueCapacity() const {
+    auto* root = pool_->root();
+    return std::min(maxQueuedBytes_, std::max<int64_t>(root->capacity() - root->reservedBytes(), 0) / 4);
+  }
+
+  void fetch() {
+    facebook::velox::RowVectorPtr batch;
+    std::exception_ptr error;
+    try {
+      if (stream_->hasNext()) {
+        batch = stream_->next();
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    std::optional<facebook::velox::ContinuePromise> promise;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fetching_ = false;
+      if (batch) {
+        auto bytes = static_cast<int64_t>(batch->retainedSize());
+        queuedBytes_ += bytes;
+        queue_.emplace_back(std::move(batch), bytes);
+      } else {
+        atEnd_ = true;
+        error_ = error;
+      }
+      promise.swap(consumerPromise_);
+      scheduleFetchLocked();
+    }
+    fetchDone_.notify_all();
+    if (promise) {
+      promise->setValue();
+    }
+  }
+
+  std::shared_ptr<RowVectorStream> stream_;
+  folly::Executor* executor_;
+  facebook::velox::memory::MemoryPool* pool_;
+  const int64_t maxQueuedBytes_;
+
+  std::mutex mutex_;
+  std::condition_variable fetchDone_;
+  std::deque<std::pair<facebook::velox::RowVectorPtr, int64_t>> queue_;
+  int64_t queuedBytes_ = 0;
+  bool fetching_ = false;
+  bool atEnd_ = false;
+  bool closed_ = false;
+  std::exception_ptr error_;
+  std::optional<facebook::velox::ContinuePromise> consumerPromise_;
+};
+
 class ValueStreamNode : public facebook::velox::core::PlanNode {
  public:
   ValueStreamNode(
@@ -96,9 +221,19 @@ class ValueStream : public facebook::velox::exec::SourceOperator {
             valueStreamNode->id(),
             "ValueStream") {
     valueStream_ = valueStreamNode->rowVectorStream();
+    auto initializer = VeloxInitializer::get();
+    if (auto* executor = initializer->getValueStreamPrefetchExecutor()) {
+      prefetcher_ = std::make_shared<RowVectorStreamPrefetcher>(
+          valueStream_, executor, pool(), initializer->getValueStreamPrefetchBytes());
+    }
   }
 
   facebook::velox::RowVectorPtr getOutput() override {
+    if (prefetcher_) {
+      auto batch = prefetcher_->next();
+      finished_ = prefetcher_->isFinished();
+      return batch;
+    }
     if (valueStream_->hasNext()) {
       return valueStream_->next();
     } else {
@@ -107,7 +242,10 @@ class ValueStream : public facebook::velox::exec::SourceOperator {
     }
   };
 
-  facebook::velox::exec::BlockingReason isBlocked(facebook::velox::ContinueFuture* /* unused */) override {
+  facebook::velox::exec::BlockingReason isBlocked(facebook::velox::ContinueFuture* future) override {
+    if (prefetcher_) {
+      return prefetcher_->isBlocked(future);
+    }
     return facebook::velox::exec::BlockingReason::kNotBlocked;
   }
 
@@ -115,9 +253,17 @@ class ValueStream : public facebook::velox::exec::SourceOperator {
     return finished_;
   };
 
+  void close() override {
+    if (prefetcher_) {
+      prefetcher_->close();
+    }
+    facebook::velox::exec::SourceOperator::close();
+  }
+
  private:
   bool finished_ = false;
   std::shared_ptr<RowVectorStream> valueStream_;
+  std::shared_ptr<RowVectorStreamPrefetcher> prefetcher_;
 };
 
 class RowVectorStreamOperatorTranslator : public facebook::velox::exec::Operator::PlanNodeTranslator {
@@ -246,6 +246,7 @@ arrow::Status VeloxShuffleWriter::init() {
   partitionBufferIdxBase_.resize(numPartitions_);
 
   partitionCachedRecordbatch_.resize(numPartitions_);
+  partitionCachedRecordbatchNumRows_.resize(numPartitions_);
   partitionCachedRecordbatchSize_.resize(numPartitions_);
 
   partitionLengths_.resize(numPartitions_);
@@ -1308,6 +1309,7 @@ arrow::Status VeloxShuffleWriter::splitFixedWidthValueBuffer(const velox::RowVec
     ARROW_ASSIGN_OR_RAISE(auto payload, createArrowIpcPayload(rb, reuseBuffers));
     partitionCachedRecordbatchSize_[partitionId] += payload->body_length;
     partitionCachedRecordbatch_[partitionId].push_back(std::move(payload));
+    partitionCachedRecordbatchNumRows_[partitionId].push_back(rb.num_rows());
     partitionBufferIdxBase_[partitionId] = 0;
     return arrow::Status::OK();
   }
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/ScopeGuard.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <gtest/gtest.h>
+
+#include "memory/VeloxColumnarBatch.h"
+#include "operators/plannodes/RowVectorStream.h"
+#include "utils/exception.h"
+#include "velox/vector/tests/utils/VectorTestBase.h"
+
+using namespace facebook::velox;
+
+namespace gluten {
+namespace {
+class RowVectorIterator : public ColumnarBatchIterator {
+ public:
+  RowVectorIterator(std::vector<RowVectorPtr> batches, size_t failAt)
+      : batches_(std::move(batches)), failAt_(failAt) {}
+
+  std::shared_ptr<ColumnarBatch> next() override {
+    if (index_ == failAt_) {
+      throw GlutenException("Failed to fetch batch " + std::to_string(index_));
+    }
+    if (index_ == batches_.size()) {
+      return nullptr;
+    }
+    return std::make_shared<VeloxColumnarBatch>(batches_[index_++]);
+  }
+
+ private:
+  std::vector<RowVectorPtr> batches_;
+  size_t failAt_;
+  size_t index_ = 0;
+};
+} // namespace
+
+class RowVectorStreamTest : public ::testing::Test, public test::VectorTestBase {
+ protected:
+  std::vector<RowVectorPtr> makeBatches(size_t numBatches) {
+    std::vector<RowVectorPtr> batches;
+    for (size_t i = 0; i < numBatches; ++i) {
+      batches.emplace_back(makeRowVector({makeFlatVector<int64_t>(100, [i](auto row) { return i * 100 + row; })}));
+    }
+    return batches;
+  }
+
+  // Consumes the prefetcher the way a driver does, waiting on the future when it's blocked.
+  std::vector<RowVectorPtr> consume(
+      const std::vector<RowVectorPtr>& batches,
+      size_t failAt,
+      int64_t maxQueuedBytes) {
+    auto iterator = std::make_shared<ResultIterator>(std::make_unique<RowVectorIterator>(batches, failAt));
+    auto stream = std::make_shared<RowVectorStream>(iterator, asRowType(batches[0]->type()));
+    auto prefetcher = std::make_shared<RowVectorStreamPrefetcher>(stream, &executor_, pool(), maxQueuedBytes);
+    std::vector<RowVectorPtr> results;
+    SCOPE_EXIT {
+      prefetcher->close();
+    };
+    while (!prefetcher->isFinished()) {
+      auto future = ContinueFuture::makeEmpty();
+      if (prefetcher->isBlocked(&future) != exec::BlockingReason::kNotBlocked) {
+        future.wait();
+        continue;
+      }
+      if (auto batch = prefetcher->next()) {
+        results.emplace_back(std::move(batch));
+      }
+    }
+    return results;
+  }
+
+  folly::CPUThreadPoolExecutor executor_{2};
+};
+
+TEST_F(RowVectorStreamTest, prefetch) {
+  auto batches = makeBatches(20);
+  // A budget of one byte still queues a batch at a time.
+  for (int64_t maxQueuedBytes : {1L, 1L << 30}) {
+    auto results = consume(batches, batches.size() + 1, maxQueuedBytes);
+    ASSERT_EQ(results.size(), batches.size());
+    for (size_t i = 0; i < batches.size(); ++i) {
+      test::assertEqualVectors(batches[i], results[i]);
+    }
+  }
+}
+
+TEST_F(RowVectorStreamTest, upstreamError) {
+  auto batches = makeBatches(5);
+  EXPECT_THROW(consume(batches, 3, 1L << 30), GlutenException);
+}
+
+} // namespace gluten
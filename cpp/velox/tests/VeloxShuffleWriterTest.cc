@@ -37,6 +37,7 @@
 #include <iostream>
 
 #include "shuffle/LocalPartitionWriter.h"
+#include "shuffle/ShuffleBlockIndex.h"
 #include "shuffle/VeloxShuffleReader.h"
 
 using namespace facebook;
@@ -591,6 +592,59 @@ TEST_P(VeloxShuffleWriterTest, TestSpillLargestPartition) {
   ASSERT_NOT_OK(shuffleWriter_->stop());
 }
 
+TEST_P(VeloxShuffleWriterTest, blockIndex) {
+  shuffleWriterOptions_.buffer_size = 4;
+  shuffleWriterOptions_.partitioning_name = "hash";
+  shuffleWriterOptions_.block_index_file = tmpDir1_->path().ToString() + "/shuffle.blocks";
+
+  ARROW_ASSIGN_OR_THROW(shuffleWriter_, VeloxShuffleWriter::create(2, partitionWriterCreator_, shuffleWriterOptions_))
+
+  splitRowVector(*shuffleWriter_, hashInputVector1_);
+  splitRowVector(*shuffleWriter_, hashInputVector2_);
+  splitRowVector(*shuffleWriter_, hashInputVector1_);
+  ASSERT_NOT_OK(shuffleWriter_->stop());
+  checkFileExists(shuffleWriterOptions_.block_index_file);
+
+  ARROW_ASSIGN_OR_THROW(auto index, ShuffleBlockIndex::read(shuffleWriterOptions_.block_index_file, 2));
+  const auto& lengths = shuffleWriter_->partitionLengths();
+  const std::vector<int64_t> expectedRows = {12, 10};
+  int64_t partitionStart = 0;
+  for (int32_t pid = 0; pid < 2; ++pid) {
+    const auto& blocks = index->blocks(pid);
+    ASSERT_FALSE(blocks.empty());
+    int64_t numRows = 0;
+    for (const auto& block : blocks) {
+      ASSERT_GE(block.offset, partitionStart);
+      ASSERT_LE(block.offset + block.length, partitionStart + lengths[pid]);
+      numRows += block.numRows;
+    }
+    ASSERT_EQ(numRows, expectedRows[pid]);
+    partitionStart += lengths[pid];
+  }
+
+  // Read the last blocks of the first partition only.
+  const auto& blocks = index->blocks(0);
+  int32_t beginBlock = blocks.size() / 2;
+  ARROW_ASSIGN_OR_THROW(file_, arrow::io::ReadableFile::Open(shuffleWriter_->dataFile()));
+  ARROW_ASSIGN_OR_THROW(auto stream, index->openBlocks(file_, 0, beginBlock, blocks.size()));
+  int64_t numRows = 0;
+  for (int32_t i = beginBlock; i < blocks.size(); ++i) {
+    ARROW_ASSIGN_OR_THROW(auto message, arrow::ipc::ReadMessage(stream.get()));
+    ASSERT_NE(message, nullptr);
+    ARROW_ASSIGN_OR_THROW(
+        auto batch,
+        arrow::ipc::ReadRecordBatch(
+            *message, shuffleWriter_->writeSchema(), nullptr, arrow::ipc::IpcReadOptions::Defaults()));
+    ASSERT_EQ(batch->num_rows(), blocks[i].numRows);
+    numRows += batch->num_rows();
+  }
+  int64_t expectedNumRows = 0;
+  for (int32_t i = beginBlock; i < blocks.size(); ++i) {
+    expectedNumRows += blocks[i].numRows;
+  }
+  ASSERT_EQ(numRows, expectedNumRows);
+}
+
 INSTANTIATE_TEST_SUITE_P(TestPreferEvictParam, VeloxShuffleWriterTest, ::testing::Values(true, false));
 
 } // namespace gluten
@@ -26,4 +26,12 @@ public class ExtensionTableBuilder {
                                                       String relativePath) {
     return new ExtensionTableNode(minPartsNum, maxPartsNum, database, tableName, relativePath);
   }
+
+  public static ExtensionTableNode makeExtensionTable(Long minPartsNum, Long maxPartsNum,
+                                                      String database, String tableName,
+                                                      String relativePath, String orderByKey,
+                                                      String primaryKey, String skipIndexes) {
+    return new ExtensionTableNode(minPartsNum, maxPartsNum, database, tableName, relativePath,
+        orderByKey, primaryKey, skipIndexes);
+  }
 }
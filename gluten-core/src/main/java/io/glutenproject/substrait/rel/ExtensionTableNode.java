@@ -34,6 +34,12 @@ public class ExtensionTableNode implements Serializable {
 
   ExtensionTableNode(Long minPartsNum, Long maxPartsNum, String database, String tableName,
                      String relativePath) {
+    this(minPartsNum, maxPartsNum, database, tableName, relativePath, "", "", "");
+  }
+
+  ExtensionTableNode(Long minPartsNum, Long maxPartsNum, String database, String tableName,
+                     String relativePath, String orderByKey, String primaryKey,
+                     String skipIndexes) {
     this.minPartsNum = minPartsNum;
     this.maxPartsNum = maxPartsNum;
     this.database = database;
@@ -44,6 +50,12 @@ public class ExtensionTableNode implements Serializable {
         .append(relativePath).append("\n")
         .append(this.minPartsNum).append("\n")
         .append(this.maxPartsNum).append("\n");
+    // Optional: {order_by_key}\n{primary_key}\n{skip_indexes}\n
+    if (!orderByKey.isEmpty() || !primaryKey.isEmpty() || !skipIndexes.isEmpty()) {
+      extensionTableStr.append(orderByKey).append("\n")
+          .append(primaryKey).append("\n")
+          .append(skipIndexes).append("\n");
+    }
   }
 
   public ReadRel.ExtensionTable toProtobuf() {
@@ -77,6 +77,9 @@ case class GlutenMergeTreePartition(index: Int,
                                     tablePath: String,
                                     minParts: Long,
                                     maxParts: Long,
+                                    orderByKey: String = "",
+                                    primaryKey: String = "",
+                                    skipIndexes: String = "",
                                     plan: Plan = PlanBuilder.empty().toProtobuf)
   extends BaseGlutenPartition {
   override def preferredLocations(): Array[String] = {
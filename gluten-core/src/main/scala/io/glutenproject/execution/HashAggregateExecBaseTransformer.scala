@@ -18,7 +18,7 @@
 package io.glutenproject.execution
 
 import com.google.common.collect.Lists
-import com.google.protobuf.Any
+import com.google.protobuf.{Any, StringValue}
 import io.glutenproject.GlutenConfig
 import io.glutenproject.backendsapi.BackendsApiManager
 import io.glutenproject.expression._
@@ -27,7 +27,7 @@ import io.glutenproject.metrics.MetricsUpdater
 import io.glutenproject.substrait.{AggregationParams, SubstraitContext}
 import io.glutenproject.substrait.`type`.{TypeBuilder, TypeNode}
 import io.glutenproject.substrait.expression.{AggregateFunctionNode, ExpressionBuilder, ExpressionNode}
-import io.glutenproject.substrait.extensions.ExtensionBuilder
+import io.glutenproject.substrait.extensions.{AdvancedExtensionNode, ExtensionBuilder}
 import io.glutenproject.substrait.plan.PlanBuilder
 import io.glutenproject.substrait.rel.{RelBuilder, RelNode}
 import org.apache.spark.rdd.RDD
@@ -378,8 +378,52 @@ abstract class HashAggregateExecBaseTransformer(
       }
     })
 
-    RelBuilder.makeAggregateRel(
-      inputRel, groupingList, aggregateFunctionList, aggFilterList, context, operatorId)
+    RelBuilder.makeAggregateRel(inputRel, groupingList, aggregateFunctionList, aggFilterList,
+      genAggregateExtensionNode(), context, operatorId)
+  }
+
+  /**
+   * The ordering of the grouping keys as (grouping key index, substrait sort direction) pairs,
+   * when the child output is sorted by all of them. Empty otherwise.
+   */
+  protected lazy val groupingKeysOrdering: Seq[(Int, Int)] = {
+    val ordering = child.outputOrdering.take(groupingExpressions.size).map {
+      order =>
+        val index = groupingExpressions.indexWhere(
+          key => order.children.exists(_.semanticEquals(key)))
+        (index, SortExecTransformer.transformSortDirection(
+          order.direction.sql, order.nullOrdering.sql))
+    }
+    if (groupingExpressions.nonEmpty && ordering.size == groupingExpressions.size &&
+      ordering.forall(_._1 >= 0) && ordering.map(_._1).distinct.size == ordering.size) {
+      ordering
+    } else {
+      Seq.empty
+    }
+  }
+
+  /**
+   * The extension of the AggregateRel, telling the native side the input is sorted by the grouping
+   * keys, so it can emit each group once the keys change instead of keeping all the groups in
+   * memory. Null if the input is not sorted by the grouping keys.
+   */
+  protected def genAggregateExtensionNode(): AdvancedExtensionNode = {
+    if (groupingKeysOrdering.isEmpty) {
+      return null
+    }
+    // Start with "AggregateParameters:"
+    val parameters = new StringBuffer("AggregateParameters:")
+    parameters.append("groupingKeysOrdering=")
+      .append(groupingKeysOrdering.map { case (index, direction) => s"$index:$direction" }
+        .mkString(","))
+      .append("\n")
+    val message = StringValue.newBuilder().setValue(parameters.toString).build()
+    ExtensionBuilder.makeAdvancedExtension(
+      Any.newBuilder
+        .setValue(message.toByteString)
+        .setTypeUrl("/google.protobuf.StringValue")
+        .build(),
+      null)
   }
 
   protected def addFunctionNode(args: java.lang.Object,
@@ -664,8 +708,8 @@ abstract class HashAggregateExecBaseTransformer(
       addFunctionNode(args, aggregateFunc, childrenNodeList, aggExpr.mode, aggregateFunctionList)
     })
     if (!validation) {
-      RelBuilder.makeAggregateRel(
-        input, groupingList, aggregateFunctionList, aggFilterList, context, operatorId)
+      RelBuilder.makeAggregateRel(input, groupingList, aggregateFunctionList, aggFilterList,
+        genAggregateExtensionNode(), context, operatorId)
     } else {
       // Use a extension node to send the input types through Substrait plan for validation.
       val inputTypeNodeList = new java.util.ArrayList[TypeNode]()
@@ -342,6 +342,9 @@ trait HashJoinLikeExecTransformer
       .append("buildHashTableId=").append(buildHashTableId).append("\n")
       .append("isExistenceJoin=").append(
       if (joinType.isInstanceOf[ExistenceJoin]) 1 else 0).append("\n")
+    genExtraJoinParameters().foreach {
+      case (key, value) => joinParametersStr.append(key).append("=").append(value).append("\n")
+    }
     val message = StringValue
       .newBuilder()
       .setValue(joinParametersStr.toString)
@@ -355,6 +358,9 @@ trait HashJoinLikeExecTransformer
     (0, 0, "")
   }
 
+  /** Backend specific join parameters, appended after the common ones. */
+  def genExtraJoinParameters(): Seq[(String, Int)] = Seq.empty
+
   override protected def doExecute(): RDD[InternalRow] = {
     throw new UnsupportedOperationException(
       s"${
@@ -24,6 +24,8 @@ package io.glutenproject.memory.alloc;
 public class NativeMemoryAllocator {
   enum Type {
     DEFAULT,
+    // Places the large allocations on the NUMA node of the allocating thread
+    NUMA_AWARE,
   }
 
   private final long nativeInstanceId;
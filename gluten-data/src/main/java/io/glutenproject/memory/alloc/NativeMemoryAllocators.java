@@ -17,6 +17,7 @@
 
 package io.glutenproject.memory.alloc;
 
+import io.glutenproject.GlutenConfig;
 import io.glutenproject.memory.GlutenMemoryConsumer;
 import io.glutenproject.memory.Spiller;
 import io.glutenproject.memory.TaskMemoryMetrics;
@@ -50,6 +51,10 @@ public final class NativeMemoryAllocators {
   }
 
   public static NativeMemoryAllocators getDefault() {
+    // The task threads are bound to the cpus of a NUMA node, keep their memory on the node as well
+    if (GlutenConfig.getConf().numaBindingInfo().enableNumaBinding()) {
+      return forType(NativeMemoryAllocator.Type.NUMA_AWARE);
+    }
     return forType(NativeMemoryAllocator.Type.DEFAULT);
   }
 
@@ -35,6 +35,7 @@ public class Metrics implements IMetrics {
   public long[] spilledRows;
   public long[] spilledPartitions;
   public long[] spilledFiles;
+  public long[] spillLevels;
   public long[] numDynamicFiltersProduced;
   public long[] numDynamicFiltersAccepted;
   public long[] numReplacedWithDynamicFilterRows;
@@ -66,6 +67,7 @@ public class Metrics implements IMetrics {
       long[] spilledRows,
       long[] spilledPartitions,
       long[] spilledFiles,
+      long[] spillLevels,
       long[] numDynamicFiltersProduced,
       long[] numDynamicFiltersAccepted,
       long[] numReplacedWithDynamicFilterRows,
@@ -93,6 +95,7 @@ public class Metrics implements IMetrics {
     this.spilledRows = spilledRows;
     this.spilledPartitions = spilledPartitions;
     this.spilledFiles = spilledFiles;
+    this.spillLevels = spillLevels;
     this.numDynamicFiltersProduced = numDynamicFiltersProduced;
     this.numDynamicFiltersAccepted = numDynamicFiltersAccepted;
     this.numReplacedWithDynamicFilterRows = numReplacedWithDynamicFilterRows;
@@ -125,6 +128,7 @@ public class Metrics implements IMetrics {
         spilledRows[index],
         spilledPartitions[index],
         spilledFiles[index],
+        spillLevels[index],
         numDynamicFiltersProduced[index],
         numDynamicFiltersAccepted[index],
         numReplacedWithDynamicFilterRows[index],
@@ -35,6 +35,7 @@ public class OperatorMetrics implements IOperatorMetrics {
   public long spilledRows;
   public long spilledPartitions;
   public long spilledFiles;
+  public long spillLevels;
   public long numDynamicFiltersProduced;
   public long numDynamicFiltersAccepted;
   public long numReplacedWithDynamicFilterRows;
@@ -64,6 +65,7 @@ public class OperatorMetrics implements IOperatorMetrics {
       long spilledRows,
       long spilledPartitions,
       long spilledFiles,
+      long spillLevels,
       long numDynamicFiltersProduced,
       long numDynamicFiltersAccepted,
       long numReplacedWithDynamicFilterRows,
@@ -90,6 +92,7 @@ public class OperatorMetrics implements IOperatorMetrics {
     this.spilledRows = spilledRows;
     this.spilledPartitions = spilledPartitions;
     this.spilledFiles = spilledFiles;
+    this.spillLevels = spillLevels;
     this.numDynamicFiltersProduced = numDynamicFiltersProduced;
     this.numDynamicFiltersAccepted = numDynamicFiltersAccepted;
     this.numReplacedWithDynamicFilterRows = numReplacedWithDynamicFilterRows;
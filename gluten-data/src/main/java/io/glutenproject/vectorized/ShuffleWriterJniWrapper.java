@@ -44,10 +44,23 @@ public class ShuffleWriterJniWrapper extends JniInitialized {
                    String codecBackend, int batchCompressThreshold, String dataFile,
                    int subDirsPerLocalDir, String localDirs, boolean preferEvict, long memoryPoolId,
                    boolean writeSchema, long handle, long taskAttemptId) {
+    return make(part, offheapPerTask, bufferSize, codec, codecBackend, batchCompressThreshold,
+        dataFile, subDirsPerLocalDir, localDirs, preferEvict, memoryPoolId, writeSchema, handle,
+        taskAttemptId, null);
+  }
+
+  /**
+   * Same as above, also writes the block index of the data file to blockIndexFile if it's not
+   * null, so a large partition can be read by several reducers.
+   */
+  public long make(NativePartitioning part, long offheapPerTask, int bufferSize, String codec,
+                   String codecBackend, int batchCompressThreshold, String dataFile,
+                   int subDirsPerLocalDir, String localDirs, boolean preferEvict, long memoryPoolId,
+                   boolean writeSchema, long handle, long taskAttemptId, String blockIndexFile) {
     return nativeMake(part.getShortName(), part.getNumPartitions(),
         offheapPerTask, bufferSize, codec, codecBackend, batchCompressThreshold, dataFile,
         subDirsPerLocalDir, localDirs, preferEvict, memoryPoolId,
-        writeSchema, handle, taskAttemptId, 0, null, "local");
+        writeSchema, handle, taskAttemptId, 0, null, "local", blockIndexFile);
   }
 
   /**
@@ -67,7 +80,7 @@ public class ShuffleWriterJniWrapper extends JniInitialized {
     return nativeMake(part.getShortName(), part.getNumPartitions(),
         offheapPerTask, bufferSize, codec, null, batchCompressThreshold, null,
         0, null, true, memoryPoolId,
-        false, handle, taskAttemptId, pushBufferMaxSize, pusher, partitionWriterType);
+        false, handle, taskAttemptId, pushBufferMaxSize, pusher, partitionWriterType, null);
   }
 
   public native long nativeMake(String shortName, int numPartitions,
@@ -76,7 +89,8 @@ public class ShuffleWriterJniWrapper extends JniInitialized {
                                 String dataFile, int subDirsPerLocalDir, String localDirs,
                                 boolean preferEvict, long memoryPoolId, boolean writeSchema,
                                 long handle, long taskAttemptId, int pushBufferMaxSize,
-                                Object pusher, String partitionWriterType);
+                                Object pusher, String partitionWriterType,
+                                String blockIndexFile);
 
   /**
    * Evict partition data.
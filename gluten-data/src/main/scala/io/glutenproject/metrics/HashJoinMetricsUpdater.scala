@@ -40,6 +40,7 @@ class HashJoinMetricsUpdaterImpl(
   val hashBuildSpilledRows: SQLMetric = metrics("hashBuildSpilledRows")
   val hashBuildSpilledPartitions: SQLMetric = metrics("hashBuildSpilledPartitions")
   val hashBuildSpilledFiles: SQLMetric = metrics("hashBuildSpilledFiles")
+  val hashBuildSpillLevels: SQLMetric = metrics("hashBuildSpillLevels")
 
   val hashProbeInputRows: SQLMetric = metrics("hashProbeInputRows")
   val hashProbeOutputRows: SQLMetric = metrics("hashProbeOutputRows")
@@ -53,6 +54,7 @@ class HashJoinMetricsUpdaterImpl(
   val hashProbeSpilledRows: SQLMetric = metrics("hashProbeSpilledRows")
   val hashProbeSpilledPartitions: SQLMetric = metrics("hashProbeSpilledPartitions")
   val hashProbeSpilledFiles: SQLMetric = metrics("hashProbeSpilledFiles")
+  val hashProbeSpillLevels: SQLMetric = metrics("hashProbeSpillLevels")
 
   // The number of rows which were passed through without any processing
   // after filter was pushed down.
@@ -111,6 +113,7 @@ class HashJoinMetricsUpdaterImpl(
     hashProbeSpilledRows += hashProbeMetrics.spilledRows
     hashProbeSpilledPartitions += hashProbeMetrics.spilledPartitions
     hashProbeSpilledFiles += hashProbeMetrics.spilledFiles
+    hashProbeSpillLevels += hashProbeMetrics.spillLevels
     hashProbeReplacedWithDynamicFilterRows += hashProbeMetrics.numReplacedWithDynamicFilterRows
     hashProbeDynamicFiltersProduced += hashProbeMetrics.numDynamicFiltersProduced
     idx += 1
@@ -129,6 +132,7 @@ class HashJoinMetricsUpdaterImpl(
     hashBuildSpilledRows += hashBuildMetrics.spilledRows
     hashBuildSpilledPartitions += hashBuildMetrics.spilledPartitions
     hashBuildSpilledFiles += hashBuildMetrics.spilledFiles
+    hashBuildSpillLevels += hashBuildMetrics.spillLevels
     idx += 1
 
     if (joinParams.buildPreProjectionNeeded) {
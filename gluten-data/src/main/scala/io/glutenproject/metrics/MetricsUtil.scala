@@ -97,6 +97,7 @@ object MetricsUtil extends Logging {
     var spilledRows: Long = 0
     var spilledPartitions: Long = 0
     var spilledFiles: Long = 0
+    var spillLevels: Long = 0
     var numDynamicFiltersProduced: Long = 0
     var numDynamicFiltersAccepted: Long = 0
     var numReplacedWithDynamicFilterRows: Long = 0
@@ -118,6 +119,7 @@ object MetricsUtil extends Logging {
       spilledRows += metrics.spilledRows
       spilledPartitions += metrics.spilledPartitions
       spilledFiles += metrics.spilledFiles
+      spillLevels = spillLevels.max(metrics.spillLevels)
       numDynamicFiltersProduced += metrics.numDynamicFiltersProduced
       numDynamicFiltersAccepted += metrics.numDynamicFiltersAccepted
       numReplacedWithDynamicFilterRows += metrics.numReplacedWithDynamicFilterRows
@@ -146,6 +148,7 @@ object MetricsUtil extends Logging {
       spilledRows,
       spilledPartitions,
       spilledFiles,
+      spillLevels,
       numDynamicFiltersProduced,
       numDynamicFiltersAccepted,
       numReplacedWithDynamicFilterRows,